@@ -0,0 +1,462 @@
+// End-to-end benchmark over the bundled data/ corpus, run in-process.
+//
+//   bench_corpus [--data DIR] [--sets real,gen,generated] [--filter TEXT]
+//                [--modes 5,8] [--min-size K] [--warmup N] [--repeat N]
+//                [--out FILE] [--baseline FILE] [--max-median-ratio R]
+//                [--max-p95-ratio R] [--min-ms MS] [--generate SPEC]...
+//                [--counters off|counters|timers]
+//
+// Each selected file is parsed once. Its core decomposition and adjacency
+// hash are built once and timed as the prepare phase, so the engine timings
+// measure the search alone. Every mode then runs warmup + repeat times. The
+// report records for each (dataset, mode) the median, p95 and extreme run
+// times, the peak RSS of the mode's runs and the engine counters of the last
+// run. It is written as JSON to --out (default stdout). Runs go through
+// enumerateCliques (clique_enumeration.h), which prints nothing.
+//
+// With --baseline, each result is compared to the same (dataset, mode) entry
+// of an earlier report. A clique count that differs is always a regression.
+// A median or p95 time above the given ratio is a regression unless the
+// baseline time is below --min-ms, where timer noise dominates. The
+// comparison goes to stderr, and the exit code is 3 when anything regressed.
+//
+// Sets: real = data/real/*, gen = data/gen_*.txt, generated =
+// data/generated_random_*.txt. Each --generate adds a synthetic graph built
+// in memory from a graph_generators.h spec (e.g. gnp:n=20000,p=0.001); its
+// build time is reported as loadMs, and without --sets only synthetic graphs
+// run. Mode 4 runs the adaptive engine choice
+// directly, without main's per-component dispatch, and mode 1 runs its
+// hybrid FastListBK lane.
+//
+// --counters sets the runtime counter level; each result then carries the
+// runtime counter and timer totals of its measured runs as runtimeCounters.
+#include "../inc/clique_enumeration.h"
+#include "../inc/graph.h"
+#include "../inc/graph_generators.h"
+#include "../inc/json.h"
+#include "../inc/parallel_for.h"
+#include "../inc/runtime_counters.h"
+
+#include <chrono>
+#include <dirent.h>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+#include <sys/resource.h>
+
+namespace {
+
+using BenchClock = std::chrono::steady_clock;
+using Counters = std::vector<std::pair<std::string, ull>>;
+
+const std::string SYNTHETIC_PREFIX = "synthetic:";
+
+struct CorpusOptions {
+  std::string dataRoot = "data";
+  std::vector<std::string> sets = {"real", "gen", "generated"};
+  std::vector<std::string> generatorSpecs;
+  std::string filter;
+  std::vector<int> modes = {5};
+  ui minCliqueSize = 3;
+  ui warmup = 1;
+  ui repeat = 5;
+  std::string outPath;
+  std::string baselinePath;
+  double maxMedianRatio = 1.10;
+  double maxP95Ratio = 1.25;
+  double minMs = 1.0;
+  CounterLevel counterLevel = CounterLevel::OFF;
+};
+
+struct CorpusResult {
+  std::string dataset;
+  int mode = 0;
+  ui n = 0;
+  ui m = 0;
+  double loadMs = 0;
+  double prepareMs = 0;
+  std::vector<double> samplesMs;
+  double medianMs = 0;
+  double p95Ms = 0;
+  ull peakRssKb = 0;
+  Counters counters;
+  // Runtime counter totals over the measured runs, with --counters.
+  std::vector<CounterTotal> runtimeCounters;
+};
+
+double elapsedMs(BenchClock::time_point start) {
+  return std::chrono::duration<double, std::milli>(BenchClock::now() - start)
+      .count();
+}
+
+// Linux resets VmHWM to the current RSS on "5" > clear_refs, so each mode's
+// peak is its own; elsewhere the process-wide ru_maxrss is reported.
+void resetPeakRss() {
+  std::ofstream clearRefs("/proc/self/clear_refs");
+  if (clearRefs)
+    clearRefs << "5";
+}
+
+ull peakRssKb() {
+  std::ifstream status("/proc/self/status");
+  std::string line;
+  while (std::getline(status, line)) {
+    if (line.rfind("VmHWM:", 0) == 0)
+      return std::strtoull(line.c_str() + 6, nullptr, 10);
+  }
+  struct rusage usage {};
+  getrusage(RUSAGE_SELF, &usage);
+  return static_cast<ull>(usage.ru_maxrss);
+}
+
+std::vector<std::string> splitList(const std::string &list) {
+  std::vector<std::string> parts;
+  std::stringstream stream(list);
+  std::string part;
+  while (std::getline(stream, part, ',')) {
+    if (!part.empty())
+      parts.push_back(part);
+  }
+  return parts;
+}
+
+std::vector<std::string> listDirectory(const std::string &directory) {
+  std::vector<std::string> names;
+  DIR *dir = opendir(directory.c_str());
+  if (dir == nullptr)
+    return names;
+  while (const dirent *entry = readdir(dir)) {
+    const std::string name = entry->d_name;
+    struct stat info {};
+    if (name[0] != '.' &&
+        stat((directory + "/" + name).c_str(), &info) == 0 &&
+        S_ISREG(info.st_mode))
+      names.push_back(name);
+  }
+  closedir(dir);
+  std::sort(names.begin(), names.end());
+  return names;
+}
+
+bool hasPrefix(const std::string &text, const std::string &prefix) {
+  return text.compare(0, prefix.size(), prefix) == 0;
+}
+
+bool hasSuffix(const std::string &text, const std::string &suffix) {
+  return text.size() >= suffix.size() &&
+         text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Dataset names relative to the data root, in set order.
+std::vector<std::string> selectDatasets(const CorpusOptions &options) {
+  std::vector<std::string> datasets;
+  const std::vector<std::string> topLevel = listDirectory(options.dataRoot);
+  for (const std::string &set : options.sets) {
+    if (set == "real") {
+      for (const std::string &name :
+           listDirectory(options.dataRoot + "/real"))
+        datasets.push_back("real/" + name);
+    } else if (set == "gen" || set == "generated") {
+      const std::string prefix = set == "gen" ? "gen_" : "generated_random_";
+      for (const std::string &name : topLevel) {
+        if (hasPrefix(name, prefix) && hasSuffix(name, ".txt"))
+          datasets.push_back(name);
+      }
+    } else {
+      throw std::invalid_argument("unknown dataset set: " + set);
+    }
+  }
+  for (const std::string &spec : options.generatorSpecs)
+    datasets.push_back(SYNTHETIC_PREFIX + spec);
+  if (!options.filter.empty()) {
+    datasets.erase(std::remove_if(datasets.begin(), datasets.end(),
+                                  [&](const std::string &name) {
+                                    return name.find(options.filter) ==
+                                           std::string::npos;
+                                  }),
+                   datasets.end());
+  }
+  return datasets;
+}
+
+// One run of mode on g (sorted is g with sorted rows, for mode 8); returns
+// the engine's counters.
+Counters runMode(int mode, Graph &g, Graph *sorted, ui minCliqueSize) {
+  EnumerationOptions options;
+  options.engine = static_cast<EnumerationEngine>(mode);
+  // Modes 0 and 2-4 keep their fixed threshold.
+  if (mode == 1 || mode == 5 || mode == 7 || mode == 8)
+    options.minCliqueSize = minCliqueSize;
+  return enumerateCliques(mode == 8 ? *sorted : g, options).counters;
+}
+
+double percentile(std::vector<double> samples, double fraction) {
+  std::sort(samples.begin(), samples.end());
+  const size_t rank = static_cast<size_t>(
+      std::ceil(fraction * static_cast<double>(samples.size())));
+  return samples[std::min(samples.size() - 1, rank == 0 ? 0 : rank - 1)];
+}
+
+std::vector<CorpusResult> runCorpus(const CorpusOptions &options) {
+  std::vector<CorpusResult> results;
+  const bool needsSorted =
+      std::find(options.modes.begin(), options.modes.end(), 8) !=
+      options.modes.end();
+  for (const std::string &dataset : selectDatasets(options)) {
+    cerr << "bench_corpus: " << dataset << endl;
+    const auto loadStart = BenchClock::now();
+    Graph g = hasPrefix(dataset, SYNTHETIC_PREFIX)
+                  ? generateGraphFromSpec(
+                        dataset.substr(SYNTHETIC_PREFIX.size()))
+                  : Graph(options.dataRoot + "/" + dataset);
+    const double loadMs = elapsedMs(loadStart);
+    const auto prepareStart = BenchClock::now();
+    g.coreDecomposition();
+    g.adjacencyHash();
+    const double prepareMs = elapsedMs(prepareStart);
+    // Mode 8 re-sorts the rows in place, which would change the CSR order
+    // the other modes see; it gets its own copy.
+    std::unique_ptr<Graph> sorted;
+    if (needsSorted) {
+      sorted = std::make_unique<Graph>(g);
+      sorted->sortAdjacency();
+      sorted->coreDecomposition();
+      sorted->adjacencyHash();
+    }
+
+    for (int mode : options.modes) {
+      CorpusResult result;
+      result.dataset = dataset;
+      result.mode = mode;
+      result.n = g.n;
+      result.m = g.m;
+      result.loadMs = loadMs;
+      result.prepareMs = prepareMs;
+      resetPeakRss();
+      for (ui run = 0; run < options.warmup + options.repeat; ++run) {
+        if (run == options.warmup)
+          resetCounters();
+        const auto start = BenchClock::now();
+        Counters counters =
+            runMode(mode, g, sorted.get(), options.minCliqueSize);
+        const double ms = elapsedMs(start);
+        if (run >= options.warmup) {
+          result.samplesMs.push_back(ms);
+          result.counters = std::move(counters);
+        }
+      }
+      result.peakRssKb = peakRssKb();
+      if (countersEnabled())
+        result.runtimeCounters = collectCounters();
+      result.medianMs = percentile(result.samplesMs, 0.5);
+      result.p95Ms = percentile(result.samplesMs, 0.95);
+      results.push_back(std::move(result));
+    }
+  }
+  return results;
+}
+
+void writeReport(std::ostream &out, const CorpusOptions &options,
+                 const std::vector<CorpusResult> &results) {
+  JsonWriter json(out);
+  json.beginObject();
+  json.field("tool", "bench_corpus").field("version", 1);
+  json.key("config").beginObject();
+  json.field("warmup", options.warmup)
+      .field("repeat", options.repeat)
+      .field("minCliqueSize", options.minCliqueSize)
+      .field("threads", configuredThreadCount());
+  json.endObject();
+  json.key("results").beginArray();
+  for (const CorpusResult &result : results) {
+    json.beginObject();
+    json.field("dataset", result.dataset)
+        .field("mode", result.mode)
+        .field("n", result.n)
+        .field("m", result.m)
+        .field("loadMs", result.loadMs)
+        .field("prepareMs", result.prepareMs)
+        .field("medianMs", result.medianMs)
+        .field("p95Ms", result.p95Ms)
+        .field("minMs", *std::min_element(result.samplesMs.begin(),
+                                          result.samplesMs.end()))
+        .field("maxMs", *std::max_element(result.samplesMs.begin(),
+                                          result.samplesMs.end()))
+        .field("peakRssKb", result.peakRssKb);
+    json.key("samplesMs").beginArray();
+    for (double ms : result.samplesMs)
+      json.value(ms);
+    json.endArray();
+    json.key("counters").beginObject();
+    for (const auto &[name, value] : result.counters)
+      json.field(name, value);
+    json.endObject();
+    if (options.counterLevel != CounterLevel::OFF) {
+      json.key("runtimeCounters").beginObject();
+      writeCounterTotals(json, result.runtimeCounters);
+      json.endObject();
+    }
+    json.endObject();
+  }
+  json.endArray();
+  json.endObject();
+  out << '\n';
+}
+
+// Compares results with a stored report; returns the number of regressions.
+size_t compareWithBaseline(const CorpusOptions &options,
+                           const std::vector<CorpusResult> &results) {
+  std::ifstream in(options.baselinePath);
+  if (!in)
+    throw std::runtime_error("cannot open baseline " + options.baselinePath);
+  std::stringstream text;
+  text << in.rdbuf();
+  const JsonValue baseline = parseJson(text.str());
+  const JsonValue *entries = baseline.find("results");
+  if (entries == nullptr || !entries->isArray())
+    throw std::runtime_error("baseline has no results array");
+
+  size_t regressions = 0;
+  cerr << std::fixed << std::setprecision(3);
+  for (const CorpusResult &result : results) {
+    const JsonValue *match = nullptr;
+    for (const JsonValue &entry : entries->items) {
+      const JsonValue *dataset = entry.find("dataset");
+      const JsonValue *mode = entry.find("mode");
+      if (dataset != nullptr && mode != nullptr &&
+          dataset->asString() == result.dataset &&
+          mode->asNumber() == result.mode) {
+        match = &entry;
+        break;
+      }
+    }
+    cerr << result.dataset << " mode=" << result.mode;
+    if (match == nullptr) {
+      cerr << "  no baseline\n";
+      continue;
+    }
+    std::vector<std::string> failures;
+    const JsonValue *baseCounters = match->find("counters");
+    const JsonValue *baseCliques =
+        baseCounters == nullptr ? nullptr : baseCounters->find("cliques");
+    if (baseCliques != nullptr &&
+        baseCliques->asUnsigned() != result.counters.front().second)
+      failures.push_back("cliques " + baseCliques->text + " -> " +
+                         std::to_string(result.counters.front().second));
+    auto checkTime = [&](const char *field, double now, double maxRatio) {
+      const JsonValue *stored = match->find(field);
+      const double before = stored == nullptr ? 0.0 : stored->asNumber();
+      const double ratio = before > 0 ? now / before : 1.0;
+      cerr << "  " << field << '=' << now << " (base " << before << ", x"
+           << ratio << ')';
+      if (before >= options.minMs && ratio > maxRatio)
+        failures.push_back(std::string(field) + " ratio above " +
+                           std::to_string(maxRatio));
+    };
+    checkTime("medianMs", result.medianMs, options.maxMedianRatio);
+    checkTime("p95Ms", result.p95Ms, options.maxP95Ratio);
+    if (failures.empty()) {
+      cerr << "  ok\n";
+      continue;
+    }
+    ++regressions;
+    cerr << "  REGRESSION:";
+    for (const std::string &failure : failures)
+      cerr << ' ' << failure << ';';
+    cerr << '\n';
+  }
+  return regressions;
+}
+
+[[noreturn]] void usage(const char *problem) {
+  cerr << problem << "\nUsage: bench_corpus [--data DIR] "
+          "[--sets real,gen,generated] [--filter TEXT] [--modes 5,8] "
+          "[--min-size K] [--warmup N] [--repeat N] [--out FILE] "
+          "[--baseline FILE] [--max-median-ratio R] [--max-p95-ratio R] "
+          "[--min-ms MS] [--generate SPEC]... [--counters LEVEL]"
+       << endl;
+  exit(1);
+}
+
+CorpusOptions parseOptions(int argc, const char *argv[]) {
+  CorpusOptions options;
+  bool setsGiven = false;
+  for (int i = 1; i < argc; ++i) {
+    const std::string flag = argv[i];
+    if (i + 1 >= argc)
+      usage(("missing value for " + flag).c_str());
+    const std::string value = argv[++i];
+    if (flag == "--data")
+      options.dataRoot = value;
+    else if (flag == "--sets") {
+      options.sets = splitList(value);
+      setsGiven = true;
+    } else if (flag == "--generate")
+      options.generatorSpecs.push_back(value);
+    else if (flag == "--filter")
+      options.filter = value;
+    else if (flag == "--modes") {
+      options.modes.clear();
+      for (const std::string &mode : splitList(value))
+        options.modes.push_back(std::stoi(mode));
+    } else if (flag == "--min-size")
+      options.minCliqueSize = static_cast<ui>(std::stoul(value));
+    else if (flag == "--warmup")
+      options.warmup = static_cast<ui>(std::stoul(value));
+    else if (flag == "--repeat")
+      options.repeat = static_cast<ui>(std::stoul(value));
+    else if (flag == "--out")
+      options.outPath = value;
+    else if (flag == "--baseline")
+      options.baselinePath = value;
+    else if (flag == "--max-median-ratio")
+      options.maxMedianRatio = std::stod(value);
+    else if (flag == "--max-p95-ratio")
+      options.maxP95Ratio = std::stod(value);
+    else if (flag == "--min-ms")
+      options.minMs = std::stod(value);
+    else if (flag == "--counters") {
+      try {
+        options.counterLevel = parseCounterLevel(value);
+      } catch (const std::invalid_argument &error) {
+        usage(error.what());
+      }
+    }
+    else
+      usage(("unknown option " + flag).c_str());
+  }
+  if (!setsGiven && !options.generatorSpecs.empty())
+    options.sets.clear();
+  if (options.repeat == 0)
+    usage("--repeat must be positive");
+  for (int mode : options.modes) {
+    if (mode < 0 || mode > 8 || mode == 6)
+      usage("--modes accepts 0-5, 7 and 8");
+  }
+  return options;
+}
+
+} // namespace
+
+int main(int argc, const char *argv[]) {
+  const CorpusOptions options = parseOptions(argc, argv);
+  setCounterLevel(options.counterLevel);
+  try {
+    const std::vector<CorpusResult> results = runCorpus(options);
+    if (options.outPath.empty()) {
+      writeReport(cout, options, results);
+    } else {
+      std::ofstream out(options.outPath);
+      if (!out)
+        throw std::runtime_error("cannot write " + options.outPath);
+      writeReport(out, options, results);
+    }
+    if (!options.baselinePath.empty() &&
+        compareWithBaseline(options, results) != 0)
+      return 3;
+  } catch (const std::exception &error) {
+    cerr << "bench_corpus: " << error.what() << endl;
+    return 1;
+  }
+  return 0;
+}
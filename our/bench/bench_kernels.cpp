@@ -0,0 +1,410 @@
+// Microbenchmarks for the bk_core hot paths on synthetic inputs, so kernel
+// regressions show up in seconds instead of in full end-to-end runs.
+//
+//   bench_kernels [filter] [sampleMillis]
+//
+// Only benchmarks whose name contains filter run. Each benchmark is
+// calibrated until one sample takes at least sampleMillis (default 50 ms);
+// the median of five samples is reported as ns/op and items/s, where an op
+// is one kernel call (one query for the batched adjacency lookups) and items
+// are the elements that call scans.
+#include "../inc/fast_adj_hash.h"
+#include "../inc/fast_list_bk.h"
+#include "../inc/fast_local_bitset.h"
+#include "../inc/fast_plex3.h"
+#include "../inc/graph.h"
+#include "../inc/graph_generators.h"
+#include "../inc/helpers.h"
+
+#include <chrono>
+#include <functional>
+#include <iomanip>
+#include <random>
+#include <stdexcept>
+
+struct FastListBKTestAccess {
+  static void prepare(FastListBK &engine, bool advancedRules) {
+    engine.buildDegeneracyOrder();
+    engine.enableAdvancedRules = advancedRules;
+  }
+  // Labels the synthetic state as a depth-1 node: P at 1, X at -1.
+  static void labelState(FastListBK &engine, const std::vector<ui> &p,
+                         const std::vector<ui> &x) {
+    std::fill(engine.label.begin(), engine.label.end(), 0);
+    for (ui v : p)
+      engine.label[v] = 1;
+    for (ui v : x)
+      engine.label[v] = -1;
+  }
+  static ui neighborsInP(FastListBK &engine, ui u, const std::vector<ui> &p,
+                         bool candidateFromX, ui incumbent) {
+    return engine.neighborsInP(u, 1, p, candidateFromX, incumbent,
+                               candidateFromX);
+  }
+  static ull intersectInto(FastListBK &engine, ui u,
+                           const std::vector<ui> &p,
+                           const std::vector<ui> &x) {
+    FastListBK::Level &parent = engine.levels[1];
+    FastListBK::Level &child = engine.levels[2];
+    parent.p = p;
+    parent.x = x;
+    engine.intersectInto(u, 1, parent, child);
+    // Put the moved vertices back under their parent labels, as the search
+    // does when it leaves the child.
+    for (ui v : child.p)
+      engine.label[v] = 1;
+    for (ui v : child.x)
+      engine.label[v] = -1;
+    return child.p.size() + child.x.size();
+  }
+};
+
+struct BitsetBKTestAccess {
+  static ui words(const BitsetBK &engine) { return engine.words; }
+  static ui choosePivot(const BitsetBK &engine, const std::vector<ull> &p,
+                        const std::vector<ull> &x,
+                        const std::vector<ui> &active) {
+    ui pSize = 0;
+    int minPScore = 0;
+    bool xExtendsP = false;
+    return engine.choosePivot(p, x, active, pSize, minPScore, xExtendsP) +
+           pSize;
+  }
+  static bool hasEdgeInP(const BitsetBK &engine, const std::vector<ull> &p,
+                         const std::vector<ui> &active) {
+    return engine.hasEdgeInP(p, active);
+  }
+};
+
+struct ReorderSibTestAccess {
+  static size_t efficientHittingSet(
+      ReorderSib &engine, const std::vector<ui> &e,
+      const std::vector<std::vector<ui>> &hitSets) {
+    return engine.efficientHittingSet(e, hitSets).size();
+  }
+};
+
+namespace {
+
+using BenchClock = std::chrono::steady_clock;
+
+constexpr int SAMPLE_COUNT = 5;
+
+// Results are folded in here so the optimizer cannot drop the kernel calls.
+volatile ull benchSink = 0;
+
+struct BenchCase {
+  std::string name;
+  ull itemsPerOp;
+  std::function<ull()> op;
+  // Ops performed by one call of op, for kernels timed in batches.
+  ull opsPerCall = 1;
+  // Runs once before calibration, e.g. to label a shared engine's state.
+  std::function<void()> setup;
+};
+
+double sampleNanoseconds(const BenchCase &bench, ull iterations) {
+  ull folded = 0;
+  const auto start = BenchClock::now();
+  for (ull i = 0; i < iterations; ++i)
+    folded += bench.op();
+  const auto stop = BenchClock::now();
+  benchSink = benchSink + folded;
+  return std::chrono::duration<double, std::nano>(stop - start).count();
+}
+
+void runBench(const BenchCase &bench, double sampleMillis) {
+  if (bench.setup)
+    bench.setup();
+  ull iterations = 1;
+  double elapsed = sampleNanoseconds(bench, iterations);
+  while (elapsed < sampleMillis * 1e6 && iterations < (1ULL << 40)) {
+    const double scale =
+        elapsed <= 0 ? 10.0 : std::min(10.0, 1.2 * sampleMillis * 1e6 / elapsed);
+    iterations = std::max<ull>(iterations + 1,
+                               static_cast<ull>(iterations * scale));
+    elapsed = sampleNanoseconds(bench, iterations);
+  }
+  std::vector<double> perOp;
+  for (int sample = 0; sample < SAMPLE_COUNT; ++sample)
+    perOp.push_back(sampleNanoseconds(bench, iterations) /
+                    (static_cast<double>(iterations) * bench.opsPerCall));
+  std::sort(perOp.begin(), perOp.end());
+  const double nsPerOp = perOp[SAMPLE_COUNT / 2];
+  const double itemsPerSecond =
+      nsPerOp > 0 ? bench.itemsPerOp * 1e9 / nsPerOp : 0.0;
+  cout << std::left << std::setw(44) << bench.name << std::right
+       << std::setw(14) << std::fixed << std::setprecision(2) << nsPerOp
+       << std::setw(16) << std::scientific << std::setprecision(3)
+       << itemsPerSecond << '\n';
+}
+
+Graph randomGraph(ui n, double p, std::mt19937_64 &random) {
+  return generateErdosRenyi(n, p, random());
+}
+
+// The complete graph on n vertices minus a Hamiltonian cycle: its complement
+// has maximum degree two, the shape the 3-plex terminal solves.
+Graph cycleComplement(ui n) {
+  std::vector<std::pair<ui, ui>> edges;
+  for (ui u = 0; u < n; ++u) {
+    for (ui v = u + 1; v < n; ++v) {
+      if (v != u + 1 && !(u == 0 && v == n - 1))
+        edges.emplace_back(u, v);
+    }
+  }
+  return Graph(n, edges);
+}
+
+std::vector<ui> sampleVertices(ui n, ui count, std::mt19937_64 &random) {
+  std::vector<ui> all(n);
+  for (ui v = 0; v < n; ++v)
+    all[v] = v;
+  std::shuffle(all.begin(), all.end(), random);
+  all.resize(count);
+  return all;
+}
+
+// Batches of membership queries that all hit or all miss.
+std::vector<std::pair<ui, ui>> adjacencyQueries(const Graph &g, bool hits,
+                                                size_t count,
+                                                std::mt19937_64 &random) {
+  std::uniform_int_distribution<ui> vertex(0, g.n - 1);
+  const FastAdjacencyHash &adjacency = g.adjacencyHash();
+  std::vector<std::pair<ui, ui>> queries;
+  while (queries.size() < count) {
+    const ui u = vertex(random);
+    if (g.degree[u] == 0)
+      continue;
+    if (hits) {
+      std::uniform_int_distribution<ui> slot(g.offset[u], g.offset[u + 1] - 1);
+      queries.emplace_back(u, g.neighbors[slot(random)]);
+    } else {
+      const ui v = vertex(random);
+      if (v != u && !adjacency.contains(u, v))
+        queries.emplace_back(u, v);
+    }
+  }
+  return queries;
+}
+
+void addAdjacencyCases(std::vector<BenchCase> &cases,
+                       std::vector<std::shared_ptr<Graph>> &graphs,
+                       std::mt19937_64 &random) {
+  constexpr ui N = 4096;
+  constexpr size_t QUERIES = 4096;
+  for (ui degree : {8u, 64u, 512u}) {
+    auto g = std::make_shared<Graph>(
+        randomGraph(N, static_cast<double>(degree) / N, random));
+    graphs.push_back(g);
+    for (bool hits : {true, false}) {
+      auto queries = std::make_shared<std::vector<std::pair<ui, ui>>>(
+          adjacencyQueries(*g, hits, QUERIES, random));
+      const FastAdjacencyHash *adjacency = &g->adjacencyHash();
+      cases.push_back({"adjacency.contains/" +
+                           std::string(hits ? "hit" : "miss") + "/deg" +
+                           std::to_string(degree),
+                       1,
+                       [adjacency, queries] {
+                         ull found = 0;
+                         for (const auto &[u, v] : *queries)
+                           found += adjacency->contains(u, v);
+                         return found;
+                       },
+                       QUERIES, {}});
+    }
+  }
+}
+
+void addFastListCases(std::vector<BenchCase> &cases,
+                      std::vector<std::shared_ptr<Graph>> &graphs,
+                      std::mt19937_64 &random) {
+  constexpr ui N = 4096;
+  auto g = std::make_shared<Graph>(randomGraph(N, 256.0 / N, random));
+  graphs.push_back(g);
+  auto engine = std::make_shared<FastListBK>(*g);
+  FastListBKTestAccess::prepare(*engine, true);
+
+  // Small P and X take the hash path, large ones the labelled CSR scan.
+  for (ui pSize : {32u, 1024u}) {
+    const std::vector<ui> vertices = sampleVertices(N, pSize + 64, random);
+    auto p = std::make_shared<std::vector<ui>>(vertices.begin(),
+                                               vertices.begin() + pSize);
+    auto x = std::make_shared<std::vector<ui>>(vertices.begin() + pSize,
+                                               vertices.end());
+    const ui u = vertices[pSize + 63];
+    const std::string path = g->degree[u] > pSize ? "hash" : "csr";
+    const ull pItems = path == "hash" ? pSize : g->degree[u];
+    const ull childItems = g->degree[u] > p->size() + x->size()
+                               ? p->size() + x->size()
+                               : g->degree[u];
+    const std::string suffix = "/" + path + "/P" + std::to_string(pSize);
+    // Half the best possible score, so the X scan stops midway.
+    const ui incumbent = std::min<ui>(g->degree[u], pSize) / 2;
+
+    const auto labelState = [engine, p, x] {
+      FastListBKTestAccess::labelState(*engine, *p, *x);
+    };
+
+    cases.push_back({"FastListBK.neighborsInP" + suffix, pItems,
+                     [engine, p, u] {
+                       return static_cast<ull>(
+                           FastListBKTestAccess::neighborsInP(*engine, u, *p,
+                                                              false, 0));
+                     },
+                     1, labelState});
+    cases.push_back({"FastListBK.neighborsInP/xEarlyExit" + suffix, pItems,
+                     [engine, p, u, incumbent] {
+                       return static_cast<ull>(
+                           FastListBKTestAccess::neighborsInP(
+                               *engine, u, *p, true,
+                               incumbent));
+                     },
+                     1, labelState});
+    cases.push_back({"FastListBK.intersectInto" + suffix, childItems,
+                     [engine, p, x, u] {
+                       return FastListBKTestAccess::intersectInto(*engine, u,
+                                                                  *p, *x);
+                     },
+                     1, labelState});
+  }
+}
+
+void addTerminalCases(std::vector<BenchCase> &cases,
+                      std::vector<std::shared_ptr<Graph>> &graphs,
+                      std::mt19937_64 &random) {
+  auto dense = std::make_shared<Graph>(randomGraph(64, 0.5, random));
+  graphs.push_back(dense);
+  for (ui pSize : {24u, 48u}) {
+    const std::vector<ui> vertices = sampleVertices(64, pSize + 8, random);
+    auto p = std::make_shared<std::vector<ui>>(vertices.begin(),
+                                               vertices.begin() + pSize);
+    auto x = std::make_shared<std::vector<ui>>(vertices.begin() + pSize,
+                                               vertices.end());
+    const FastAdjacencyHash *adjacency = &dense->adjacencyHash();
+    if (!solveFastLocalBitsetSubtree(*adjacency, *p, *x, 1, nullptr).handled)
+      throw std::logic_error("local bitset bench state was not handled");
+    cases.push_back({"solveFastLocalBitsetSubtree/P" + std::to_string(pSize),
+                     pSize, [adjacency, p, x] {
+                       return solveFastLocalBitsetSubtree(*adjacency, *p, *x,
+                                                          1, nullptr)
+                           .checksCount;
+                     },
+                     1, {}});
+  }
+
+  for (ui pSize : {16u, 64u}) {
+    auto plex = std::make_shared<Graph>(cycleComplement(pSize));
+    graphs.push_back(plex);
+    auto p = std::make_shared<std::vector<ui>>(sampleVertices(pSize, pSize,
+                                                              random));
+    const FastAdjacencyHash *adjacency = &plex->adjacencyHash();
+    if (!solveFastPlex3Subtree(*adjacency, *p, 1).handled)
+      throw std::logic_error("3-plex bench state was not handled");
+    cases.push_back({"solveFastPlex3Subtree/cycle" + std::to_string(pSize),
+                     pSize, [adjacency, p] {
+                       return solveFastPlex3Subtree(*adjacency, *p, 1)
+                           .cliqueCount;
+                     },
+                     1, {}});
+  }
+}
+
+void addBitsetCases(std::vector<BenchCase> &cases,
+                    std::vector<std::shared_ptr<Graph>> &graphs,
+                    std::mt19937_64 &random) {
+  constexpr ui N = 2048;
+  auto g = std::make_shared<Graph>(randomGraph(N, 0.1, random));
+  graphs.push_back(g);
+  auto engine = std::make_shared<BitsetBK>(*g);
+  const ui words = BitsetBKTestAccess::words(*engine);
+  for (ui pSize : {64u, 512u}) {
+    const std::vector<ui> vertices = sampleVertices(N, pSize + 64, random);
+    auto p = std::make_shared<std::vector<ull>>(words, 0);
+    auto x = std::make_shared<std::vector<ull>>(words, 0);
+    for (ui i = 0; i < vertices.size(); ++i) {
+      std::vector<ull> &bits = i < pSize ? *p : *x;
+      bits[vertices[i] >> 6] |= 1ULL << (vertices[i] & 63);
+    }
+    auto active = std::make_shared<std::vector<ui>>();
+    for (ui wi = 0; wi < words; ++wi) {
+      if ((*p)[wi] != 0 || (*x)[wi] != 0)
+        active->push_back(wi);
+    }
+    const ull scoredWords =
+        static_cast<ull>(vertices.size()) * active->size();
+    cases.push_back({"BitsetBK.choosePivot/P" + std::to_string(pSize),
+                     scoredWords, [engine, p, x, active] {
+                       return static_cast<ull>(BitsetBKTestAccess::choosePivot(
+                           *engine, *p, *x, *active));
+                     },
+                     1, {}});
+    // The first P vertex usually has a P neighbor, so this measures the
+    // word loop of one row rather than the full quadratic scan.
+    cases.push_back({"BitsetBK.hasEdgeInP/P" + std::to_string(pSize),
+                     active->size(), [engine, p, active] {
+                       return static_cast<ull>(
+                           BitsetBKTestAccess::hasEdgeInP(*engine, *p,
+                                                          *active));
+                     },
+                     1, {}});
+  }
+}
+
+void addHittingSetCases(std::vector<BenchCase> &cases,
+                        std::vector<std::shared_ptr<Graph>> &graphs,
+                        std::mt19937_64 &random) {
+  auto g = std::make_shared<Graph>(randomGraph(256, 0.2, random));
+  graphs.push_back(g);
+  auto engine = std::make_shared<ReorderSib>(*g);
+  for (ui eSize : {16u, 48u}) {
+    auto e = std::make_shared<std::vector<ui>>(sampleVertices(256, eSize,
+                                                              random));
+    auto hitSets = std::make_shared<std::vector<std::vector<ui>>>();
+    std::uniform_int_distribution<ui> setSize(3, 6);
+    ull items = 0;
+    for (ui h = 0; h < eSize / 2; ++h) {
+      std::vector<ui> members = *e;
+      std::shuffle(members.begin(), members.end(), random);
+      members.resize(setSize(random));
+      items += members.size();
+      hitSets->push_back(std::move(members));
+    }
+    cases.push_back({"ReorderSib.efficientHittingSet/E" +
+                         std::to_string(eSize),
+                     items, [engine, e, hitSets] {
+                       return static_cast<ull>(
+                           ReorderSibTestAccess::efficientHittingSet(
+                               *engine, *e, *hitSets));
+                     },
+                     1, {}});
+  }
+}
+
+} // namespace
+
+int main(int argc, const char *argv[]) {
+  const std::string filter = argc > 1 ? argv[1] : "";
+  const double sampleMillis = argc > 2 ? std::atof(argv[2]) : 50.0;
+  if (sampleMillis <= 0) {
+    cerr << "Usage: bench_kernels [filter] [sampleMillis>0]" << endl;
+    return 1;
+  }
+
+  std::mt19937_64 random(20240601);
+  std::vector<std::shared_ptr<Graph>> graphs;
+  std::vector<BenchCase> cases;
+  addAdjacencyCases(cases, graphs, random);
+  addFastListCases(cases, graphs, random);
+  addTerminalCases(cases, graphs, random);
+  addBitsetCases(cases, graphs, random);
+  addHittingSetCases(cases, graphs, random);
+
+  cout << std::left << std::setw(44) << "benchmark" << std::right
+       << std::setw(14) << "ns/op" << std::setw(16) << "items/s" << '\n';
+  for (const BenchCase &bench : cases) {
+    if (bench.name.find(filter) != std::string::npos)
+      runBench(bench, sampleMillis);
+  }
+  return 0;
+}
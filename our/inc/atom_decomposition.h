@@ -0,0 +1,71 @@
+#pragma once
+
+#include "fast_list_bk.h"
+
+// One clique-separator cut: interior C is a connected component of the
+// remaining graph minus a clique, separator is N(C) in the remaining graph,
+// and the atom is C union N(C). The final remainder is the last cut, with an
+// empty separator.
+struct AtomCut {
+  std::vector<ui> interior;
+  std::vector<ui> separator;
+  bool cliqueAtom = false;
+};
+
+struct AtomDecomposition {
+  std::vector<AtomCut> cuts;
+  ull simplicialCuts = 0;
+  ull separatorCuts = 0;
+  // The core left after simplicial peeling exceeded the MCS-M work budget,
+  // so no cut was made and cuts is empty.
+  bool mcsmSkipped = false;
+};
+
+// Clique-separator decomposition in two passes. Simplicial vertices of
+// degree at most SIMPLICIAL_DEGREE_LIMIT are peeled first, each cutting off
+// the clique atom N[v]. MCS-M (Berry et al.) then computes a minimal
+// triangulation of the remaining core, and the Atoms pass cuts at every
+// generator's higher neighborhood that is a clique. MCS-M costs
+// O(n (n + m)) on the core even with its bucket queue on weights, so it only
+// runs while that stays within MCSM_WORK_PER_EDGE times the input size and
+// below MCSM_WORK_LIMIT. A larger core skips the whole decomposition: the
+// peel alone leaves the clique search no cheaper than plain FastListBK.
+AtomDecomposition decomposeCliqueSeparators(const Graph &g,
+                                            const FastAdjacencyHash &adjacency);
+
+// Maximal cliques through an atom decomposition. Vertices are ordered cut by
+// cut, so each maximal clique is reported at the first cut whose interior it
+// meets, and it lies inside that cut's atom. Clique atoms contribute their
+// atom when no earlier-cut vertex extends it; the interiors of the other
+// atoms run as FastListBK roots under the same order. Without a
+// decomposition every vertex is a root in degeneracy order.
+class AtomCliqueSolver {
+private:
+  static constexpr ui SIMPLICIAL_DEGREE_LIMIT = 64;
+  static constexpr ull MCSM_WORK_LIMIT = 30000000ULL;
+  static constexpr ull MCSM_WORK_PER_EDGE = 32;
+  friend AtomDecomposition
+  decomposeCliqueSeparators(const Graph &g,
+                            const FastAdjacencyHash &adjacency);
+
+  const Graph &graph;
+  FastListBK engine;
+  ui minCliqueSize;
+  ull cliqueCount;
+  ui maxCliqueSize;
+  CliqueSizeHistogram cliqueSizeHistogram;
+  FastCliqueSink cliqueSink;
+
+  bool cliqueAtomIsMaximal(const std::vector<ui> &atom, ui anchor,
+                           const std::vector<ui> &order, ui cutStart) const;
+
+public:
+  explicit AtomCliqueSolver(const Graph &g, ui minCliqueSize = 3);
+  void setCliqueSink(FastCliqueSink sink);
+  void findAllMaximalCliques();
+  ull getCliqueCount() const { return cliqueCount; }
+  ui getMaxCliqueSize() const { return maxCliqueSize; }
+  const CliqueSizeHistogram &getCliqueSizeHistogram() const {
+    return cliqueSizeHistogram;
+  }
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "clique_histogram.h"
+#include "fast_clique_sink.h"
+#include "graph.h"
+#include "helpers.h"
+#include "root_costs.h"
+#include "search_budget.h"
+
+// Library entry point for programs that link bk_core and run enumerations
+// in-process: one call runs one engine on a caller-owned Graph and returns
+// its results instead of printing them. A Graph comes from a file, an edge
+// list or CSR arrays (graph.h) and can serve any number of runs, which share
+// its cached core decomposition and adjacency hash. Nothing here reads the
+// environment; BK_THREADS only seeds the k-clique worker default.
+
+// The engines, numbered like bk_algorithm's modes.
+enum class EnumerationEngine {
+  PIVOT = 0,
+  HYBRID_REORDER = 1,
+  BITSET = 2,
+  LOCAL_BITSET = 3,
+  ADAPTIVE = 4,
+  FAST_LIST = 5,
+  PURE_REORDER = 6,
+  K_CLIQUES = 7,
+  EDGE_FAST_LIST = 8
+};
+
+// Lower-case names, e.g. "fast_list"; parseEnumerationEngine also accepts
+// mode numbers and throws invalid_argument on anything else.
+const char *enumerationEngineName(EnumerationEngine engine);
+EnumerationEngine parseEnumerationEngine(const std::string &text);
+
+struct EnumerationOptions {
+  EnumerationEngine engine = EnumerationEngine::FAST_LIST;
+  // Smallest clique reported; for K_CLIQUES, the size listed. PIVOT, BITSET,
+  // LOCAL_BITSET and ADAPTIVE have a fixed threshold of 3.
+  ui minCliqueSize = 3;
+  // Vertex order of PIVOT and PURE_REORDER.
+  DegOrder order = DegOrder::ASCENDING;
+  // PURE_REORDER's sibling solver and its per-call work budget (0: none).
+  SibMethod method = SibMethod::OPTIMIZED;
+  ull solverWorkBudget = 0;
+  // K_CLIQUES workers; 0 keeps the BK_THREADS default.
+  unsigned threads = 0;
+  // Per-root accounting and root order (root_costs.h), for BITSET,
+  // LOCAL_BITSET, ADAPTIVE, FAST_LIST and K_CLIQUES.
+  RootCostRecorder *rootCosts = nullptr;
+  std::vector<ui> rootSchedule;
+  // Wall time (from the call), search states and reported cliques after
+  // which the run stops with partial results; all zero runs to completion.
+  // K_CLIQUES applies the check limit to each worker's recursion calls.
+  SearchBudgetLimits budget;
+};
+
+struct EnumerationResult {
+  ull cliqueCount = 0;
+  ui maxCliqueSize = 0;
+  // Search states; K_CLIQUES has no check counter and reports 0.
+  ull checks = 0;
+  CliqueSizeHistogram sizeHistogram;
+  // Engine construction (and EDGE_FAST_LIST's truss decomposition), then
+  // the enumeration itself.
+  double setupMs = 0;
+  double searchMs = 0;
+  // Every counter the engine exposes, by name, starting with the totals
+  // above; the set depends on the engine.
+  std::vector<std::pair<std::string, ull>> counters;
+  // False when the budget stopped the run; the counts above then cover only
+  // what was reported before the stop, and completedRoots lists the roots
+  // whose cliques are all among them (in run order, by vertex id for
+  // K_CLIQUES). PIVOT and EDGE_FAST_LIST report no roots.
+  bool complete = true;
+  SearchBudgetStop stopReason = SearchBudgetStop::NONE;
+  std::vector<ui> completedRoots;
+};
+
+// Runs one enumeration of g. With a sink, every reported clique reaches it
+// sorted, one call at a time; PIVOT, BITSET, LOCAL_BITSET and ADAPTIVE only
+// count and reject a sink, and PURE_REORDER replays its stored cliques after
+// the search. LOCAL_BITSET, ADAPTIVE and EDGE_FAST_LIST sort g's rows in
+// place, so concurrent runs may share g once Graph::sortAdjacency has run.
+// Throws invalid_argument for an option the engine does not support and
+// overflow_error when a count leaves the 64-bit range.
+EnumerationResult enumerateCliques(Graph &g, const EnumerationOptions &options,
+                                   const FastCliqueSink &sink = {});
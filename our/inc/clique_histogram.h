@@ -0,0 +1,31 @@
+#pragma once
+
+#include "checked_count.h"
+
+// Exact maximal-clique counts indexed by clique size. Engines accumulate one
+// in count-only mode; closed-form terminals add a whole size class per call,
+// so the histogram never requires materializing cliques.
+using CliqueSizeHistogram = std::vector<ull>;
+
+inline void addCliqueSizeCountOrThrow(CliqueSizeHistogram &histogram,
+                                      size_t size, ull count) {
+  if (count == 0)
+    return;
+  if (histogram.size() <= size)
+    histogram.resize(size + 1, 0);
+  addCliqueCountOrThrow(histogram[size], count);
+}
+
+inline void mergeCliqueSizeHistogramOrThrow(
+    CliqueSizeHistogram &destination, const CliqueSizeHistogram &source) {
+  if (destination.size() < source.size())
+    destination.resize(source.size(), 0);
+  for (size_t size = 0; size < source.size(); ++size)
+    addCliqueCountOrThrow(destination[size], source[size]);
+}
+
+// Drops trailing empty size classes so equal distributions compare equal.
+inline void trimCliqueSizeHistogram(CliqueSizeHistogram &histogram) {
+  while (!histogram.empty() && histogram.back() == 0)
+    histogram.pop_back();
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "clique_histogram.h"
+#include "graph.h"
+
+// One connected component as a standalone graph; vertices[i] is the original
+// id of local vertex i.
+struct GraphComponent {
+  Graph graph;
+  std::vector<ui> vertices;
+};
+
+// Labels every vertex with its connected component (BFS, O(n + m)) and
+// returns the component count.
+ui labelConnectedComponents(const Graph &g, std::vector<ui> &componentOf);
+
+// Materializes the components with at least minVertices vertices, in
+// component-label order.
+std::vector<GraphComponent>
+buildComponentGraphs(const Graph &g, const std::vector<ui> &componentOf,
+                     ui componentCount, ui minVertices = 1);
+
+struct ComponentDispatchResult {
+  ull cliqueCount = 0;
+  ui maxCliqueSize = 0;
+  CliqueSizeHistogram cliqueSizeHistogram;
+  ull components = 0;
+  ull trivialComponents = 0;
+  ull closedFormComponents = 0;
+  ull bitsetComponents = 0;
+  ull localBitsetComponents = 0;
+};
+
+// Mode 4 per component, with mode 4's size-3 output threshold. Components
+// with fewer than three vertices are trivial; complete, max-degree-two and
+// bipartite components are solved in closed form. The rest run, largest
+// first over threads workers, on the engine adaptiveUsesBitsetBK picks for
+// that component alone, whose own whole-graph detectors (chordal, clique
+// components, twin quotients, ...) now apply per component. Returns false
+// without solving when fewer than two components can hold a triangle or one
+// component carries at least 3/4 of the edges.
+bool solveAdaptiveByComponents(const Graph &g, unsigned threads,
+                               ComponentDispatchResult &result);
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "common.h"
+
+class Graph;
+
+// Core decomposition of a graph; the graph itself is never modified.
+// peelOrder lists the vertices in removal order (smallest core first), rank
+// is its inverse, core[v] is v's core number and degeneracy the largest one.
+// Every vertex has at most degeneracy neighbors of larger rank.
+struct CoreDecomposition {
+  vector<ui> peelOrder;
+  vector<ui> rank;
+  vector<ui> core;
+  ui degeneracy = 0;
+};
+
+// Graphs below PARALLEL_CORE_MIN_VERTICES use the serial Matula-Beck bin
+// peel in O(n + m). Larger ones peel by levels on configuredThreadCount()
+// workers: each level jumps to the least live degree and removes its
+// frontier in rounds sorted by vertex id, so the order does not depend on the
+// worker count.
+constexpr ui PARALLEL_CORE_MIN_VERTICES = 1U << 20;
+
+CoreDecomposition computeCoreDecomposition(const Graph &graph);
@@ -4,6 +4,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <limits>
 #include <stdexcept>
 
@@ -165,6 +166,27 @@ public:
     }
   }
 
+  // Raw layout for the on-disk artifact cache: the row table and the bucket
+  // array are trivially copyable, so a table is saved and restored as two
+  // byte ranges of rowBytes() and bucketBytes().
+  static constexpr size_t ROW_BYTES = sizeof(Row);
+  static constexpr size_t BUCKET_BYTES = sizeof(Bucket);
+  size_t rowCount() const { return rows.size(); }
+  size_t bucketCount() const { return buckets.size(); }
+  const void *rowBytes() const { return rows.data(); }
+  const void *bucketBytes() const { return buckets.data(); }
+
+  FastAdjacencyHash(const void *rowData, size_t rowCount,
+                    const void *bucketData, size_t bucketCount)
+      : rows(rowCount), buckets(bucketCount) {
+    std::memcpy(rows.data(), rowData, rowCount * ROW_BYTES);
+    std::memcpy(buckets.data(), bucketData, bucketCount * BUCKET_BYTES);
+    for (const Row &row : rows) {
+      if (row.offset + static_cast<size_t>(row.mask) + 1 > buckets.size())
+        throw std::invalid_argument("adjacency hash layout is truncated");
+    }
+  }
+
   bool contains(ui u, ui v) const {
     const Row &row = rows[u];
     const Bucket &first = buckets[row.offset + firstSlot(v, row.mask)];
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "fast_clique_sink.h"
+
+#include <stdexcept>
+#include <utility>
+
+// One connected component of the complement of a 3-plex P. vertices lists the
+// component in path/cycle order, so consecutive entries (and, for a cycle, the
+// last and first) are the non-adjacent pairs of G[P].
+struct FastFactorizedComponent {
+  std::vector<ui> vertices;
+  bool cycle = false;
+};
+
+// A family of maximal cliques described as a product instead of a list:
+//
+//   prefix x forced x (one endpoint of each pair) x (one maximal independent
+//   set of each complement path/cycle component).
+//
+// prefix is the R of the emitting BK state, forced holds the P vertices that
+// belong to every continuation, and each pair is a missing edge of G[P]. Only
+// members of size at least minCliqueSize belong to the family. cliqueCount is
+// the exact number of such members and maxCliqueSize the largest member size,
+// so a consumer can count, filter, or sample without expanding the product.
+// A single clique is a record whose pairs and components are empty.
+struct FastFactorizedCliques {
+  std::vector<ui> prefix;
+  std::vector<ui> forced;
+  std::vector<std::pair<ui, ui>> pairs;
+  std::vector<FastFactorizedComponent> components;
+  ui minCliqueSize = 1;
+  ull cliqueCount = 0;
+  ui maxCliqueSize = 0;
+};
+
+// Opt-in factorized output hook. Terminals that can describe their outputs as
+// one product report a single record here instead of materializing 2^k or
+// path/cycle-product cliques through FastCliqueSink.
+using FastFactorizedSink = std::function<void(const FastFactorizedCliques &)>;
+
+// Lazily expands one record. Each next() call produces one member clique in
+// canonical sorted order while retaining only one selection per factor, so
+// memory stays linear in the record size independent of cliqueCount.
+class FastFactorizedExpander {
+private:
+  struct ComponentCursor {
+    const FastFactorizedComponent *component = nullptr;
+    std::vector<unsigned char> selected;
+    size_t assigned = 0;
+  };
+
+  const FastFactorizedCliques &record;
+  std::vector<unsigned char> pairChoice;
+  std::vector<ComponentCursor> cursors;
+  bool started;
+  bool exhausted;
+
+  static bool prefixIsFeasible(const ComponentCursor &cursor);
+  static bool selectionIsMaximal(const ComponentCursor &cursor);
+  static bool advanceCursor(ComponentCursor &cursor, bool resume);
+  bool advanceProduct();
+  size_t selectedSize() const;
+
+public:
+  explicit FastFactorizedExpander(const FastFactorizedCliques &record);
+  // Writes the next member into clique and returns true, or returns false
+  // once every member of the family has been produced.
+  bool next(std::vector<ui> &clique);
+};
+
+// Expands every member of record into cliqueSink. Intended for validation and
+// for callers that install a factorized sink but still need the plain stream.
+ull expandFactorizedCliques(const FastFactorizedCliques &record,
+                            const FastCliqueSink &cliqueSink);
+
+// Builds the record for an X-empty state whose P has complement degree at most
+// one: complement-isolated vertices are forced and every missing edge becomes
+// one pair. containsEdge(u, v) reports adjacency in G. Throws overflow_error
+// when the 2^pairs members do not fit in cliqueCount.
+template <typename Contains>
+FastFactorizedCliques factorizeComplementMatching(
+    const std::vector<ui> &prefix, const std::vector<ui> &p,
+    Contains containsEdge) {
+  FastFactorizedCliques record;
+  record.prefix = prefix;
+  std::vector<unsigned char> paired(p.size(), 0);
+  for (size_t i = 0; i < p.size(); ++i) {
+    if (paired[i] != 0)
+      continue;
+    size_t mate = p.size();
+    for (size_t j = i + 1; j < p.size(); ++j) {
+      if (paired[j] == 0 && !containsEdge(p[i], p[j])) {
+        mate = j;
+        break;
+      }
+    }
+    if (mate == p.size()) {
+      record.forced.push_back(p[i]);
+    } else {
+      paired[i] = paired[mate] = 1;
+      record.pairs.push_back({p[i], p[mate]});
+    }
+  }
+  record.maxCliqueSize = static_cast<ui>(
+      prefix.size() + record.forced.size() + record.pairs.size());
+  if (record.pairs.size() >= 64)
+    throw std::overflow_error(
+        "complement-matching clique count exceeds uint64_t");
+  record.cliqueCount = 1ULL << record.pairs.size();
+  return record;
+}
@@ -2,7 +2,13 @@
 
 #include "fast_adj_hash.h"
 #include "checked_count.h"
+#include "clique_histogram.h"
 #include "fast_clique_sink.h"
+#include "fast_factorized_clique.h"
+#include "root_costs.h"
+#include "search_budget.h"
+#include "search_trace.h"
+#include "truss_decomposition.h"
 
 struct FastListBKTestAccess;
 
@@ -21,10 +27,16 @@ private:
     std::vector<ui> branch;
     std::vector<ui> processedRoots;
     std::vector<ui> witness;
+    // Scratch for the dynamic reduction: P vertices scored with no or one P
+    // neighbor, and X vertices with none (collected by enumerate only; the
+    // baseline lane keeps its X).
+    std::vector<ui> isolatedP;
+    std::vector<ui> pendantP;
+    std::vector<ui> idleX;
   };
 
   const Graph &graph;
-  FastAdjacencyHash adjacency;
+  const FastAdjacencyHash &adjacency;
   std::vector<ui> rank;
   std::vector<int> label;
   std::vector<Level> levels;
@@ -32,11 +44,14 @@ private:
   ui minCliqueSize;
   ull cliqueCount;
   ui maxCliqueSize;
+  CliqueSizeHistogram cliqueSizeHistogram;
   ull checksCount;
   bool hybridReorderSibling;
+  bool summaryOutput;
   bool enableAdvancedRules;
   bool enableTailKernels;
   bool enableLocalBitset;
+  bool portfolioReady;
   ui siblingEventBudget;
   ui siblingEvents;
   ull siblingBranchesBefore;
@@ -51,9 +66,30 @@ private:
   ull universalPForces;
   ull degreeZeroTerminals;
   ull degreeOneTerminals;
+  ull dynamicDegreeZero;
+  ull dynamicDegreeOne;
+  ull idleXRemoved;
+  ull edgeRootsFiltered;
+  ull ownedEdgeNodes;
+  ui maxEdgeRootP;
   FastCliqueSink cliqueSink;
+  FastFactorizedSink factorizedSink;
+  // The installed trace writer, and the same writer while the current root
+  // is sampled (null otherwise); the search consults only the latter.
+  SearchTraceWriter *traceWriter;
+  SearchTraceWriter *trace;
+  RootCostRecorder *rootCosts;
+  std::vector<ui> rootSchedule;
+  SearchBudget *budget;
+  // Check count at which this engine next reads the budget's clock.
+  ull nextBudgetClock;
+  std::vector<ui> completedRoots;
 
 #ifdef FASTLIST_OPPORTUNITY_PROFILE
+  // Research build: what-if measurements of the search tree (cutover
+  // frontiers, sampled X dominance, graph-level rules). They reshape the
+  // recursion, so they stay compiled out; at a counter level other than off
+  // they are reported as fastlist.profile.* runtime counters.
   static constexpr size_t PROFILE_BUCKET_COUNT = 13;
   static constexpr size_t PROFILE_THRESHOLD_COUNT = 7;
   inline static constexpr std::array<ui, PROFILE_THRESHOLD_COUNT>
@@ -158,24 +194,48 @@ private:
   ull profileIntersectItemsTotal() const;
   void profileGraphRules();
   void profileXDominance(ui depth, const Level &level);
-  void printOpportunityProfile() const;
+  void reportOpportunityProfile() const;
 #endif
 
+  void recordCliques(ui size, ull count) {
+    addCliqueCountOrThrow(cliqueCount, count);
+    addCliqueSizeCountOrThrow(cliqueSizeHistogram, size, count);
+    maxCliqueSize = std::max(maxCliqueSize, size);
+  }
   void buildDegeneracyOrder();
+  void resetSearchStatistics();
+  void selectPortfolio();
+  void enumerateRoot(ui cliqueSize, ui depth = 1);
+  void runOrderedRoot(ui u, const std::vector<ui> &order);
+  void runOwnedEdge(ui e, const TrussDecomposition &truss);
+  bool ownedCandidatesClean(const std::vector<ui> &p, ui ownerRank,
+                            const TrussDecomposition &truss) const;
+  void enumerateOwned(ui depth, ui cliqueSize, ui ownerRank,
+                      const TrussDecomposition &truss);
+  void reportRuntimeCounters(double ms) const;
+  void printSummary(const std::string &outputLabel, double ms) const;
+  void runAnchoredQuery(const std::vector<ui> &anchor);
   ui neighborsInP(ui u, ui depth, const std::vector<ui> &p,
                   bool haveIncumbent, ui incumbent, bool candidateFromX);
   ui neighborsInPBaseline(ui u, ui depth,
                           const std::vector<ui> &p) const;
   bool solveTinyP(ui cliqueSize, Level &level);
   void reduceDominatedX(ui depth, Level &level);
-  bool solveLowDegreeChild(ui cliqueSize, Level &child, bool &found);
+  ui livePNeighbors(ui v, ui depth, const std::vector<ui> &p,
+                    ui &partner) const;
+  bool reduceLowDegreeP(ui depth, ui cliqueSize, Level &level, bool &found);
+  bool solveLowDegreeChild(ui depth, ui cliqueSize, Level &child,
+                           bool &found);
   void intersectInto(ui u, ui depth, const Level &parent, Level &child);
   bool enumerateBaseline(ui depth, ui cliqueSize);
   bool enumerate(ui depth, ui cliqueSize);
   bool trySiblingEffect(ui depth, size_t nextBranch,
                         const std::vector<ui> &witness);
+  bool hasOutputSink() const {
+    return static_cast<bool>(cliqueSink) || static_cast<bool>(factorizedSink);
+  }
   bool needsCliqueStack() const {
-    return hybridReorderSibling || static_cast<bool>(cliqueSink);
+    return hybridReorderSibling || hasOutputSink();
   }
   void emitClique(const std::vector<ui> &extension = {}) const;
   void emitComplementMatching(const std::vector<ui> &p) const;
@@ -186,12 +246,90 @@ public:
   // Installs an opt-in validation/output hook. The default empty sink keeps
   // production enumeration count-only and avoids clique materialization.
   void setCliqueSink(FastCliqueSink sink) { cliqueSink = std::move(sink); }
+  // Installs the factorized output hook. While set it receives every output:
+  // closed-form complement-matching and 3-plex terminals report one product
+  // record each, all other maximal cliques arrive as single-clique records,
+  // and the plain clique sink is bypassed.
+  void setFactorizedSink(FastFactorizedSink sink) {
+    factorizedSink = std::move(sink);
+  }
+  // Records every search node below the vertex roots the writer samples, in
+  // findAllMaximalCliques and findMaximalCliquesFromRoots. Null (the
+  // default) disables tracing.
+  void setSearchTrace(SearchTraceWriter *writer) { traceWriter = writer; }
+  // Charges every vertex root's checks, cliques and time to the recorder.
+  // Null (the default) disables the accounting.
+  void setRootCostRecorder(RootCostRecorder *recorder) {
+    rootCosts = recorder;
+  }
+  // The sequence findAllMaximalCliques runs the roots in, e.g. a cost-sorted
+  // order from readRootOrder; it must list every vertex once. The P/X split
+  // of a root follows the degeneracy order either way, so the cliques found
+  // are the same. Empty (the default) runs the roots in id order.
+  void setRootSchedule(std::vector<ui> schedule) {
+    rootSchedule = std::move(schedule);
+  }
+  // Polls the budget at every list-recursion node and stops cleanly once it
+  // is exhausted; the counters then hold the partial run. Null (the default)
+  // runs to completion.
+  void setSearchBudget(SearchBudget *searchBudget) {
+    budget = searchBudget;
+    nextBudgetClock = 0;
+  }
   void findAllMaximalCliques(const std::string &outputLabel = "FastListBK");
+  // Disables the summary line, e.g. when a pipeline stage reports the run.
+  void setSummaryOutput(bool enabled) { summaryOutput = enabled; }
+  // Anchored queries: enumerate only the maximal cliques that contain v (or
+  // the edge uv) by running the kernels from R = {v}, P = N(v), X = empty
+  // (R = {u, v}, P = N(u) intersect N(v)). The degeneracy order and
+  // portfolio are built on the first query and reused, so one engine serves
+  // many queries. Each call resets the counters and histogram and returns
+  // the clique count; outputs reach the installed sinks. A non-edge uv has
+  // no cliques.
+  ull findMaximalCliquesContaining(ui v);
+  // Root loop under a caller-supplied order (order[v] is v's position): root
+  // r runs with P = its later and X = its earlier neighbors, so it reports
+  // the maximal cliques whose first vertex is r. Only the listed roots run;
+  // counters are reset first and accumulate over them.
+  ull findMaximalCliquesFromRoots(const std::vector<ui> &order,
+                                  const std::vector<ui> &roots);
+  ull findMaximalCliquesContaining(ui u, ui v);
+  // Edge-oriented root loop (HBBMC's EBBMC branching): edge e = uv in truss
+  // order runs with R = {u, v}, P = the common neighbors w whose edges uw
+  // and vw both come later, and X = the other common neighbors, so |P| is
+  // bounded by the truss number of e instead of the degeneracy. Root e owns
+  // the maximal cliques whose earliest edge is e; when P still spans an
+  // earlier edge, an ownership-aware branch moves such neighbors to X until
+  // the candidate graph is clean and the kernels take over. Isolated
+  // vertices run as single-vertex roots.
+  void findAllMaximalCliquesFromEdges(
+      const TrussDecomposition &truss,
+      const std::string &outputLabel = "EdgeFastListBK");
   ull getCliqueCount() const { return cliqueCount; }
   ui getMaxCliqueSize() const { return maxCliqueSize; }
+  ull getChecksCount() const { return checksCount; }
+  const CliqueSizeHistogram &getCliqueSizeHistogram() const {
+    return cliqueSizeHistogram;
+  }
+  const FastAdjacencyHash &getAdjacency() const { return adjacency; }
   ull getTinyKernelCalls() const { return tinyKernelCalls; }
   ull getLocalBitsetHandoffs() const { return localBitsetHandoffs; }
+  ull getLocalBitsetChecks() const { return localBitsetChecks; }
+  ui getSiblingEvents() const { return siblingEvents; }
+  ull getXDominanceRemoved() const { return xDominanceRemoved; }
+  ull getUniversalPForces() const { return universalPForces; }
   ull getPlex3Terminals() const { return plex3Terminals; }
+  ull getPlex3Cliques() const { return plex3Cliques; }
   ull getDegreeZeroTerminals() const { return degreeZeroTerminals; }
   ull getDegreeOneTerminals() const { return degreeOneTerminals; }
+  ull getDynamicDegreeZero() const { return dynamicDegreeZero; }
+  ull getDynamicDegreeOne() const { return dynamicDegreeOne; }
+  ull getIdleXRemoved() const { return idleXRemoved; }
+  ull getEdgeRootsFiltered() const { return edgeRootsFiltered; }
+  ull getOwnedEdgeNodes() const { return ownedEdgeNodes; }
+  ui getMaxEdgeRootP() const { return maxEdgeRootP; }
+  // Under a budget, the vertex roots of the last findAllMaximalCliques whose
+  // subtrees finished before the stop, in run order. Edge roots are not
+  // tracked.
+  const std::vector<ui> &getCompletedRoots() const { return completedRoots; }
 };
@@ -2,6 +2,7 @@
 
 #include "fast_adj_hash.h"
 #include "fast_clique_sink.h"
+#include "fast_factorized_clique.h"
 
 struct FastLocalBitsetResult {
   bool handled = false;
@@ -10,16 +11,21 @@ struct FastLocalBitsetResult {
   ui maxCliqueSize = 0;
   ull checksCount = 0;
   std::vector<ui> witness;
+  // Exact counts of the reported cliques indexed by clique size.
+  std::vector<ull> sizeHistogram;
 };
 
 // Solve one Bron--Kerbosch subtree in a single machine word. The input state
 // is read-only: P and X keep their full BK meaning, cliqueSize is |R|, and
 // cliquePrefix is the materialized R used only when a sibling witness is
 // requested. When cliqueSink is supplied, cliquePrefix must contain R and
-// every output is sent to the sink in canonical sorted order. handled=false
-// asks the caller to retain its list recursion.
+// every output is sent to the sink in canonical sorted order. A factorizedSink
+// replaces cliqueSink: complement-matching leaves become one record each and
+// every other output a single-clique record. handled=false asks the caller to
+// retain its list recursion.
 FastLocalBitsetResult solveFastLocalBitsetSubtree(
     const FastAdjacencyHash &adjacency, const std::vector<ui> &p,
     const std::vector<ui> &x, ui cliqueSize,
     const std::vector<ui> *cliquePrefix, ui minCliqueSize = 3,
-    const FastCliqueSink *cliqueSink = nullptr);
+    const FastCliqueSink *cliqueSink = nullptr,
+    const FastFactorizedSink *factorizedSink = nullptr);
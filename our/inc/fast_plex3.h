@@ -2,6 +2,7 @@
 
 #include "fast_adj_hash.h"
 #include "fast_clique_sink.h"
+#include "fast_factorized_clique.h"
 
 #include <unordered_set>
 
@@ -12,6 +13,9 @@ struct FastPlex3Result {
   ui maxCliqueSize = 0;
   ull checksCount = 0;
   std::vector<ui> witness;
+  // Exact counts of the reported cliques indexed by clique size (|R| plus the
+  // selected P vertices); sizes below minCliqueSize are always zero.
+  std::vector<ull> sizeHistogram;
 };
 
 // Solve an X-empty Bron--Kerbosch subtree when the complement of P has
@@ -22,13 +26,17 @@ struct FastPlex3Result {
 // cliqueSize is |R|.  When cliquePrefix is supplied, it is prepended to the
 // materialized maximum-size witness; otherwise witness contains only its P
 // portion. When cliqueSink is supplied, cliquePrefix must contain R and every
-// output is sent to the sink in canonical sorted order. handled=false asks the
+// output is sent to the sink in canonical sorted order. When factorizedSink is
+// supplied instead (cliquePrefix again containing R), the whole family is reported as one record (R x isolated
+// complement vertices x one endpoint per missing edge x one MIS per longer
+// complement path/cycle) and nothing is materialized. handled=false asks the
 // caller to retain ordinary recursion. It is returned for non-3-plex states
 // and whenever a result would overflow the public ull/ui counters.
 FastPlex3Result solveFastPlex3Subtree(
     const FastAdjacencyHash &adjacency, const std::vector<ui> &p,
     ui cliqueSize, const std::vector<ui> *cliquePrefix = nullptr,
-    ui minCliqueSize = 3, const FastCliqueSink *cliqueSink = nullptr);
+    ui minCliqueSize = 3, const FastCliqueSink *cliqueSink = nullptr,
+    const FastFactorizedSink *factorizedSink = nullptr);
 
 // ReorderSib stores its permuted graph as adjacency sets. This overload lets
 // Pure PXR reuse the exact terminal without retaining a second graph copy.
@@ -36,4 +44,5 @@ FastPlex3Result solveFastPlex3Subtree(
     const std::vector<std::unordered_set<ui>> &adjacency,
     const std::vector<ui> &p, ui cliqueSize,
     const std::vector<ui> *cliquePrefix = nullptr, ui minCliqueSize = 3,
-    const FastCliqueSink *cliqueSink = nullptr);
+    const FastCliqueSink *cliqueSink = nullptr,
+    const FastFactorizedSink *factorizedSink = nullptr);
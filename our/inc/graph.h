@@ -1,26 +1,66 @@
 #pragma once
 
 #include "common.h"
+#include "core_decomposition.h"
+#include "graph_derived.h"
+
+class FastAdjacencyHash;
 
 class Graph {
 public:
   ui n;
   ui m;
-  ui kmax;
 
   std::vector<ui> offset;
   std::vector<ui> neighbors;
   std::vector<ui> degree;
-  std::vector<ui> core;
-  std::vector<ui> corePeelSequence;
   std::string filePath;
   bool adjacencySorted;
 
 public:
   Graph();
+  // Reads the "n m" header and rows "v nbr nbr ..." for v = 0..n-1. Exits on
+  // an unreadable file; throws invalid_argument when a row is out of order,
+  // a neighbor is not below n or the rows hold more than 2m entries.
   Graph(std::string path);
   Graph(ui vertexCount, const std::vector<std::pair<ui, ui>> &edges);
+  // Adopts a CSR adjacency built in memory: rowOffsets has vertexCount + 1
+  // entries and each undirected edge is listed in both endpoint rows. Rows
+  // are sorted in place. Throws invalid_argument on malformed offsets, an
+  // out-of-range or repeated neighbor, a self-loop or a one-sided edge.
+  Graph(ui vertexCount, std::vector<ui> rowOffsets,
+        std::vector<ui> adjacency);
   void sortAdjacency();
-  void getListingOrder(std::vector<ui> &arr);
-  void coreDecompose(std::vector<ui> &arr);
+  // Core numbers and degeneracy order, computed on first use and then shared
+  // by every engine and query on this graph.
+  const CoreDecomposition &coreDecomposition() const {
+    return coreCache.get([this] { return computeCoreDecomposition(*this); });
+  }
+  // Adjacency membership table shared by the FastListBK-family engines.
+  const FastAdjacencyHash &adjacencyHash() const;
+  // Whole-graph detector verdicts. Bipartiteness is computed on first use;
+  // chordality is recorded by the detector that tests it, and knownChordal
+  // is nullptr until then.
+  bool isBipartite() const;
+  const bool *knownChordal() const { return chordalVerdict.peek(); }
+  void recordChordal(bool chordal) const;
+
+  // Derived structures restored by the artifact cache (graph_artifacts.h),
+  // and their presence for writing an artifact back.
+  const CoreDecomposition *cachedCoreDecomposition() const {
+    return coreCache.peek();
+  }
+  const FastAdjacencyHash *cachedAdjacencyHash() const {
+    return adjacencyCache.peek();
+  }
+  const bool *knownBipartite() const { return bipartiteVerdict.peek(); }
+  void adoptCoreDecomposition(CoreDecomposition cores);
+  void adoptAdjacencyHash(std::shared_ptr<const FastAdjacencyHash> adjacency);
+  void recordBipartite(bool bipartite) const;
+
+private:
+  mutable GraphDerived<CoreDecomposition> coreCache;
+  mutable GraphDerived<FastAdjacencyHash> adjacencyCache;
+  mutable GraphDerived<bool> bipartiteVerdict;
+  mutable GraphDerived<bool> chordalVerdict;
 };
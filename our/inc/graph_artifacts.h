@@ -0,0 +1,33 @@
+#pragma once
+
+#include "graph.h"
+
+// On-disk cache of parsed graphs and their derived structures, enabled with
+// BK_ARTIFACT_CACHE=<directory>. An artifact is keyed by a 64-bit content
+// hash and the byte size of the input file and holds the binary CSR plus
+// whatever runs on that file have derived so far: the core decomposition,
+// the FastAdjacencyHash layout and the bipartite/chordal verdicts. load()
+// maps a present artifact and restores every stored structure into the
+// Graph's derived caches, so engines skip parsing and rebuilding; store()
+// rewrites the artifact only when the Graph now holds something it lacks.
+// Writes go through a temporary file and a rename, so concurrent runs never
+// read a torn artifact.
+class GraphArtifactCache {
+private:
+  std::string directory;
+  ull contentHash;
+  ull contentBytes;
+  unsigned storedSections;
+  bool loadedSorted;
+  bool hit;
+
+  std::string artifactPath() const;
+  bool restore(Graph &graph);
+
+public:
+  explicit GraphArtifactCache(std::string directory);
+  Graph load(const std::string &path);
+  void store(const Graph &graph) const;
+  bool wasHit() const { return hit; }
+  ull getContentHash() const { return contentHash; }
+};
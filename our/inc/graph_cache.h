@@ -0,0 +1,49 @@
+#pragma once
+
+#include "graph.h"
+
+#include <list>
+#include <memory>
+
+// In-memory cache of loaded graphs for long-running processes that serve
+// many enumerations (bk_batch). A graph is keyed by its path and reloaded
+// when the file's size or modification time changes. On a miss it is
+// parsed, through the on-disk artifact cache when one is configured (see
+// graph_artifacts.h), and prepared: rows sorted, core decomposition and
+// adjacency hash built. Jobs on different threads can therefore share it.
+// At most capacity graphs are kept and the least recently used is evicted
+// first. An evicted graph stays alive while a job still holds it.
+class GraphCache {
+private:
+  struct Entry {
+    std::string path;
+    ull bytes;
+    long long modifiedNs;
+    std::shared_ptr<Graph> graph;
+  };
+
+  size_t capacity;
+  std::string artifactDirectory;
+  std::list<Entry> entries; // Most recently used first.
+  std::unordered_map<std::string, std::list<Entry>::iterator> index;
+  mutable std::mutex mutex;
+  ull hits;
+  ull misses;
+
+public:
+  // An empty artifactDirectory parses every miss from its text file.
+  explicit GraphCache(size_t capacity, std::string artifactDirectory = "");
+
+  // The prepared graph at path; *hit reports whether it came from the
+  // cache. Throws runtime_error when the file cannot be read. Two threads
+  // that miss on the same path at the same time may both load it. The
+  // first one to finish is kept.
+  std::shared_ptr<Graph> acquire(const std::string &path,
+                                 bool *hit = nullptr);
+  // Sorts g's rows and builds the derived structures the engines share.
+  static void prepare(Graph &g);
+
+  size_t size() const;
+  ull getHits() const;
+  ull getMisses() const;
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <utility>
+
+// Lazily filled, shared structure derived from a Graph (core order,
+// adjacency hash, detector verdicts). The first caller builds it and every
+// later engine or query reuses it; racing first callers may both build, and
+// the first stored result wins. Copies start empty, so a copied graph that
+// is edited afterwards never sees a stale result; moves keep the value.
+template <typename T> class GraphDerived {
+private:
+  std::shared_ptr<const T> value;
+
+public:
+  GraphDerived() = default;
+  GraphDerived(const GraphDerived &) {}
+  GraphDerived(GraphDerived &&other) noexcept
+      : value(std::move(other.value)) {}
+  GraphDerived &operator=(const GraphDerived &) {
+    value.reset();
+    return *this;
+  }
+  GraphDerived &operator=(GraphDerived &&other) noexcept {
+    value = std::move(other.value);
+    return *this;
+  }
+
+  template <typename Build> const T &get(Build build) {
+    std::shared_ptr<const T> cached = std::atomic_load(&value);
+    if (!cached) {
+      std::shared_ptr<const T> built = std::make_shared<const T>(build());
+      if (std::atomic_compare_exchange_strong(&value, &cached, built))
+        cached = std::move(built);
+    }
+    return *cached;
+  }
+
+  // The stored value, or nullptr while nothing has been built.
+  const T *peek() const { return std::atomic_load(&value).get(); }
+
+  void set(std::shared_ptr<const T> computed) {
+    std::atomic_store(&value, std::move(computed));
+  }
+};
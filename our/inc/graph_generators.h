@@ -0,0 +1,58 @@
+#pragma once
+
+#include "graph.h"
+
+// Seeded synthetic graph families built directly as Graph objects, for
+// benchmark sweeps beyond the bundled files. Every generator is
+// deterministic in its arguments, including the seed, and returns a graph
+// with sorted, duplicate-free rows.
+
+// G(n, p): each pair is an edge independently with probability p, sampled
+// by geometric skipping in O(n + m).
+Graph generateErdosRenyi(ui n, double p, ull seed);
+
+// Barabasi-Albert preferential attachment: vertices arrive one by one and
+// attach to edgesPerVertex distinct earlier vertices chosen proportionally
+// to degree, starting from a clique on edgesPerVertex + 1 vertices.
+Graph generateBarabasiAlbert(ui n, ui edgesPerVertex, ull seed);
+
+// R-MAT (stochastic Kronecker) on 2^scale vertices with edgeFactor * 2^scale
+// sampled edges: each edge descends the adjacency quadrants with
+// probabilities a, b, c and 1 - a - b - c. Vertex ids are randomly permuted
+// afterwards, and duplicates and self-loops are dropped.
+Graph generateRmat(ui scale, ui edgeFactor, double a, double b, double c,
+                   ull seed);
+
+// G(n, backgroundP) with coreCount disjoint random vertex sets of coreSize
+// vertices, each of whose internal pairs is an edge with probability
+// coreDensity.
+Graph generatePlantedCores(ui n, double backgroundP, ui coreCount,
+                           ui coreSize, double coreDensity, ull seed);
+
+// Moon-Moser graph: the complete multipartite graph with parts classes of
+// three vertices, which has the maximum possible 3^parts maximal cliques for
+// its 3 * parts vertices.
+Graph generateMoonMoser(ui parts);
+
+// A G(baseN, baseP) base graph with every vertex blown up into classSize
+// twins: a class is a clique (true twins) with probability trueTwinFraction
+// and an independent set (false twins) otherwise; twins of adjacent base
+// vertices are all adjacent.
+Graph generateTwinHeavy(ui baseN, double baseP, ui classSize,
+                        double trueTwinFraction, ull seed);
+
+// Random chordal graph: vertex v attaches to a random earlier vertex u and a
+// random subset of u's earlier clique, so every vertex's earlier neighbors
+// form a clique of at most maxCliqueSize - 1 vertices and the insertion
+// order reversed is a perfect elimination order.
+Graph generateChordal(ui n, ui maxCliqueSize, ull seed);
+
+// Builds a graph from a "family:key=value,..." spec, e.g.
+//   gnp:n=10000,p=0.001,seed=7
+//   ba:n=50000,k=8        rmat:scale=16,ef=16,a=0.57,b=0.19,c=0.19
+//   planted:n=20000,p=0.0005,cores=10,size=40,density=0.9
+//   moonmoser:parts=12    twins:n=2000,p=0.01,size=4,true=0.5
+//   chordal:n=100000,omega=12
+// seed defaults to 1. Throws invalid_argument on an unknown family or key
+// or a missing required key.
+Graph generateGraphFromSpec(const std::string &spec);
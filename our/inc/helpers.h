@@ -1,8 +1,11 @@
 #pragma once
 
 #include "checked_count.h"
+#include "clique_histogram.h"
 #include "common.h"
 #include "graph.h"
+#include "root_costs.h"
+#include "search_budget.h"
 
 enum class DegOrder { ORIGINAL, ASCENDING, DESCENDING };
 enum class SibMethod {
@@ -11,6 +14,10 @@ enum class SibMethod {
 };
 
 ui graphDegeneracy(const Graph &g);
+// Mode 4's engine choice: true selects the dense BitsetBK, false the
+// LocalBitsetBK, from the size, degree profile and degeneracy of g.
+bool adaptiveUsesBitsetBK(const Graph &g);
+struct BitsetBKTestAccess;
 struct ReorderSibTestAccess;
 
 // Optimized Adjacency List based Bron-Kerbosch with Pivoting and Pruning
@@ -21,6 +28,11 @@ private:
   ui cliqueCount;
   ui maxCliqueSize;
   ui checksCount;
+  CliqueSizeHistogram cliqueSizeHistogram;
+  bool summaryOutput;
+  SearchBudget *budget;
+  // Check count at which this engine next reads the budget's clock.
+  ull nextBudgetClock;
 
   vector<ui> intersect(const vector<ui> &set1, const vector<ui> &neighbors);
   bool isEmpty(const vector<ui> &set);
@@ -32,10 +44,26 @@ public:
   PivotBK(Graph &g, DegOrder order = DegOrder::ASCENDING);
 
   void findAllMaximalCliques();
+  void setSummaryOutput(bool enabled) { summaryOutput = enabled; }
+  // Stops the search once the budget is exhausted, keeping the partial
+  // counts. The whole graph is one pivoted call tree over relabelled
+  // vertices, so no completed roots are reported.
+  void setSearchBudget(SearchBudget *searchBudget) {
+    budget = searchBudget;
+    nextBudgetClock = 0;
+  }
+  ull getCliqueCount() const { return cliqueCount; }
+  ui getMaxCliqueSize() const { return maxCliqueSize; }
+  ull getChecksCount() const { return checksCount; }
+  const CliqueSizeHistogram &getCliqueSizeHistogram() const {
+    return cliqueSizeHistogram;
+  }
 };
 
 class BitsetBK {
 private:
+  friend struct BitsetBKTestAccess;
+
   ui n;
   ui words;
   ui degeneracy;
@@ -71,13 +99,27 @@ private:
   ull cliqueCount;
   ui maxCliqueSize;
   ull checksCount;
+  // Filled by whichever closed-form detector claims the graph, otherwise by
+  // the search itself.
+  CliqueSizeHistogram cliqueSizeHistogram;
+  bool summaryOutput;
+  RootCostRecorder *rootCosts;
+  vector<ui> rootSchedule;
+  SearchBudget *budget;
+  // Check count at which this engine next reads the budget's clock.
+  ull nextBudgetClock;
+  vector<ui> completedRoots;
 
+  void printSummary(double ms) const;
   const ull *neighbors(ui v) const;
   void ensureDepth(ui depth);
   bool isConnected(ui u, ui v) const;
-  bool solveTwinModuleQuotient(ull &quotientCount, ui &quotientMaxSize) const;
-  bool solveFalseTwinQuotient(ull &quotientCount, ui &quotientMaxSize) const;
-  bool solveTrueTwinQuotient(ull &quotientCount, ui &quotientMaxSize) const;
+  bool solveTwinModuleQuotient(ull &quotientCount, ui &quotientMaxSize,
+                               CliqueSizeHistogram &histogram) const;
+  bool solveFalseTwinQuotient(ull &quotientCount, ui &quotientMaxSize,
+                              CliqueSizeHistogram &histogram) const;
+  bool solveTrueTwinQuotient(ull &quotientCount, ui &quotientMaxSize,
+                             CliqueSizeHistogram &histogram) const;
   void detectCompleteMultipartite();
   bool isEmpty(const vector<ull> &bits, const vector<ui> &active) const;
   bool hasEdgeInP(const vector<ull> &P, const vector<ui> &active) const;
@@ -94,6 +136,33 @@ private:
 public:
   BitsetBK(Graph &g);
   void findAllMaximalCliques();
+  // Disables the per-run summary line, e.g. for per-component runs.
+  void setSummaryOutput(bool enabled) { summaryOutput = enabled; }
+  // Charges each root's checks, cliques and time to the recorder; closed-form
+  // detectors that claim the graph charge nothing. Null (the default)
+  // disables the accounting.
+  void setRootCostRecorder(RootCostRecorder *recorder) {
+    rootCosts = recorder;
+  }
+  // Runs the roots in this sequence, which must list every vertex once,
+  // instead of the degeneracy order; P/X still follow the degeneracy order.
+  void setRootSchedule(vector<ui> schedule) {
+    rootSchedule = std::move(schedule);
+  }
+  // Stops the root loop and the recursion once the budget is exhausted; the
+  // counts are then partial and getCompletedRoots lists the roots that
+  // finished, in run order. Null (the default) runs to completion.
+  void setSearchBudget(SearchBudget *searchBudget) {
+    budget = searchBudget;
+    nextBudgetClock = 0;
+  }
+  const vector<ui> &getCompletedRoots() const { return completedRoots; }
+  ull getCliqueCount() const { return cliqueCount; }
+  ui getMaxCliqueSize() const { return maxCliqueSize; }
+  ull getChecksCount() const { return checksCount; }
+  const CliqueSizeHistogram &getCliqueSizeHistogram() const {
+    return cliqueSizeHistogram;
+  }
 };
 
 class LocalBitsetBK {
@@ -143,7 +212,18 @@ private:
   ull cliqueCount;
   ui maxCliqueSize;
   ull checksCount;
+  // Filled by whichever closed-form detector claims the graph, otherwise by
+  // the search itself.
+  CliqueSizeHistogram cliqueSizeHistogram;
+  bool summaryOutput;
+  RootCostRecorder *rootCosts;
+  vector<ui> rootSchedule;
+  SearchBudget *budget;
+  // Check count at which this engine next reads the budget's clock.
+  ull nextBudgetClock;
+  vector<ui> completedRoots;
 
+  void printSummary(double ms) const;
   void ensureDepth(ui depth);
   bool shouldDetectCliqueComponents(const Graph &g) const;
   bool detectCliqueComponents(const Graph &g);
@@ -162,6 +242,32 @@ private:
 public:
   LocalBitsetBK(Graph &g);
   void findAllMaximalCliques();
+  void setSummaryOutput(bool enabled) { summaryOutput = enabled; }
+  // Charges each root's checks, cliques and time to the recorder; closed-form
+  // detectors that claim the graph charge nothing. Null (the default)
+  // disables the accounting.
+  void setRootCostRecorder(RootCostRecorder *recorder) {
+    rootCosts = recorder;
+  }
+  // Runs the roots in this sequence, which must list every vertex once,
+  // instead of the degeneracy order; P/X still follow the degeneracy order.
+  void setRootSchedule(vector<ui> schedule) {
+    rootSchedule = std::move(schedule);
+  }
+  // Stops the root loop and the recursion once the budget is exhausted; the
+  // counts are then partial and getCompletedRoots lists the roots that
+  // finished, in run order. Null (the default) runs to completion.
+  void setSearchBudget(SearchBudget *searchBudget) {
+    budget = searchBudget;
+    nextBudgetClock = 0;
+  }
+  const vector<ui> &getCompletedRoots() const { return completedRoots; }
+  ull getCliqueCount() const { return cliqueCount; }
+  ui getMaxCliqueSize() const { return maxCliqueSize; }
+  ull getChecksCount() const { return checksCount; }
+  const CliqueSizeHistogram &getCliqueSizeHistogram() const {
+    return cliqueSizeHistogram;
+  }
 };
 
 class ReorderSib {
@@ -182,9 +288,16 @@ private:
   size_t maxCliqueSize;
   ull externalCliqueCount;
   size_t externalMaxCliqueSize;
+  CliqueSizeHistogram cliqueSizeHistogram;
+  CliqueSizeHistogram externalCliqueSizeHistogram;
   ull checksCount;
   ull solverWorkBudget;
   ull solverBudgetFallbacks;
+  SearchBudget *searchBudget;
+  // Check count at which this engine next reads the budget's clock.
+  ull nextBudgetClock;
+  vector<ui> completedRoots;
+  bool summaryOutput;
   SibMethod method;
   ui minCliqueSize;
   ui hitSetLimit;
@@ -305,13 +418,30 @@ public:
              ui minCliqueSize = 3);
   void findAllMaximalCliques();
   void findAllMaximalCliquesPure();
-  void setExternalResults(ull count, size_t maximumSize) {
+  void setExternalResults(ull count, size_t maximumSize,
+                          const CliqueSizeHistogram &histogram = {}) {
     externalCliqueCount = count;
     externalMaxCliqueSize = maximumSize;
+    externalCliqueSizeHistogram = histogram;
   }
   void setSolverWorkBudget(ull budget) { solverWorkBudget = budget; }
+  // Pure search only: stops the worklist and the pivot fallback once the
+  // budget is exhausted, keeping the cliques recorded so far. Roots run in
+  // canonical order; getCompletedRoots lists the finished ones as original
+  // vertex ids. Null (the default) runs to completion.
+  void setSearchBudget(SearchBudget *budget) {
+    searchBudget = budget;
+    nextBudgetClock = 0;
+  }
+  const vector<ui> &getCompletedRoots() const { return completedRoots; }
+  void setSummaryOutput(bool enabled) { summaryOutput = enabled; }
   ull getCliqueCount() const { return cliqueCount; }
   ull getDuplicateCount() const { return dupBlocked; }
+  ull getChecksCount() const { return checksCount; }
+  ull getSolverBudgetFallbacks() const { return solverBudgetFallbacks; }
   ui getMaxCliqueSize() const { return maxCliqueSize; }
+  const CliqueSizeHistogram &getCliqueSizeHistogram() const {
+    return cliqueSizeHistogram;
+  }
   vector<vector<ui>> getCliques() const;
 };
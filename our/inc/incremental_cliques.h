@@ -0,0 +1,96 @@
+#pragma once
+
+#include "clique_histogram.h"
+#include "graph.h"
+
+struct IncrementalCliqueDelta {
+  ull insertedEdges = 0;
+  ull deletedEdges = 0;
+  ull affectedVertices = 0;
+  ull removedCliques = 0;
+  ull addedCliques = 0;
+};
+
+// Maintains the maximal cliques (of at least minCliqueSize vertices) of a
+// graph under batches of edge insertions and deletions. A clique that gains
+// or loses maximality always contains an endpoint of a changed edge, so a
+// batch drops the stored cliques touching those endpoints and re-enumerates
+// only the cliques through them with anchored queries: endpoint a_i runs
+// from R = {a_i}, P = N'(a_i), X = {a_0..a_{i-1}} so each new clique is found
+// once. The adjacency is kept as sorted rows that a batch patches in place,
+// and the anchored Tomita search runs on the anchor's induced neighborhood
+// with buffers kept across batches, so a batch costs in proportion to the
+// changed endpoints' neighborhoods rather than to the whole graph.
+class IncrementalCliqueIndex {
+private:
+  struct SearchLevel {
+    std::vector<ui> p;
+    std::vector<ui> x;
+    std::vector<ui> candidates;
+    // Bit-row search: P, then the branch candidates, then X.
+    std::vector<ull> bits;
+  };
+
+  ui n;
+  ull edgeCount;
+  std::vector<std::vector<ui>> rows;
+  ui minCliqueSize;
+  std::vector<std::vector<ui>> cliques;
+  // cliquesByVertex[v] lists the ids of the stored cliques containing v.
+  std::vector<std::vector<ui>> cliquesByVertex;
+  CliqueSizeHistogram cliqueSizeHistogram;
+  // Scratch flags of the clique ids a batch removes; all zero between
+  // batches.
+  std::vector<char> deadMark;
+  // Anchors of at most this degree search bit rows of their neighborhood;
+  // larger ones fall back to sorted local rows.
+  static constexpr ui LOCAL_BITSET_LIMIT = 4096;
+
+  // Search state of the current anchored query: its neighborhood (the row
+  // of the anchor), that neighborhood's induced rows in local ids, and the
+  // per-depth P/X buffers. All of it is reused by the next query.
+  const std::vector<ui> *localVertices;
+  ui localWords;
+  std::vector<ull> localBits;
+  std::vector<std::vector<ui>> localRows;
+  std::vector<SearchLevel> levels;
+  std::vector<ui> cliqueStack;
+  std::vector<std::vector<ui>> found;
+
+  bool hasEdge(ui u, ui v) const;
+  void addClique(std::vector<ui> clique);
+  // Removes every stored clique containing one of the vertices and returns
+  // how many were removed.
+  ull removeCliquesTouching(const std::vector<ui> &vertices);
+  // Appends to found every maximal clique through v that avoids the sorted
+  // excluded vertices.
+  void findCliquesContaining(ui v, const std::vector<ui> &excluded);
+  void expand(ui depth);
+  void expandBits(ui depth);
+
+public:
+  // initialCliques must be the maximal cliques of g with at least
+  // minCliqueSize vertices, e.g. a previous run's "clique" output lines or a
+  // ReorderSib clique index. They are trusted, not re-verified.
+  IncrementalCliqueIndex(const Graph &g,
+                         std::vector<std::vector<ui>> initialCliques,
+                         ui minCliqueSize = 3);
+  // Deletions apply before insertions. Self-loops, inserted edges already
+  // present and deleted edges already absent are ignored; vertex ids must lie
+  // in [0, n).
+  IncrementalCliqueDelta
+  applyEdgeDelta(const std::vector<std::pair<ui, ui>> &inserted,
+                 const std::vector<std::pair<ui, ui>> &deleted);
+  ui getVertexCount() const { return n; }
+  ull getEdgeCount() const { return edgeCount; }
+  const std::vector<std::vector<ui>> &getCliques() const { return cliques; }
+  ull getCliqueCount() const { return cliques.size(); }
+  ui getMaxCliqueSize() const {
+    return static_cast<ui>(cliqueSizeHistogram.empty()
+                               ? 0
+                               : cliqueSizeHistogram.size() - 1);
+  }
+  const CliqueSizeHistogram &getCliqueSizeHistogram() const {
+    return cliqueSizeHistogram;
+  }
+};
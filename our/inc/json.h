@@ -0,0 +1,76 @@
+#pragma once
+
+#include "common.h"
+
+#include <ostream>
+
+// Streaming JSON writer for the tools' machine-readable output. Commas and
+// key/value separators are inserted automatically; nesting errors throw
+// logic_error. Doubles are written with up to 17 significant digits so
+// baselines round-trip; non-finite values become null.
+class JsonWriter {
+private:
+  std::ostream &out;
+  // One entry per open container: true while it has no element yet.
+  std::vector<bool> firstInScope;
+  std::vector<bool> objectScope;
+  bool awaitingValue;
+
+  void beforeValue();
+
+public:
+  explicit JsonWriter(std::ostream &output);
+
+  JsonWriter &beginObject();
+  JsonWriter &endObject();
+  JsonWriter &beginArray();
+  JsonWriter &endArray();
+  JsonWriter &key(const std::string &name);
+  JsonWriter &value(const std::string &text);
+  JsonWriter &value(const char *text);
+  JsonWriter &value(double number);
+  JsonWriter &value(ull number);
+  JsonWriter &value(long long number);
+  JsonWriter &value(ui number) { return value(static_cast<ull>(number)); }
+  JsonWriter &value(int number) {
+    return value(static_cast<long long>(number));
+  }
+  JsonWriter &value(bool flag);
+  // Writes an already valid JSON number token verbatim, such as the source
+  // text of a parsed number, so integers beyond 2^53 keep every digit.
+  JsonWriter &rawNumber(const std::string &token);
+  JsonWriter &null();
+  // key(name).value(v) in one call.
+  template <typename T> JsonWriter &field(const std::string &name, T v) {
+    key(name);
+    return value(v);
+  }
+};
+
+void writeJsonString(std::ostream &out, const std::string &text);
+
+// Parsed JSON document node. Numbers keep their source text so 64-bit
+// counters survive exactly; asNumber() converts to double on demand.
+struct JsonValue {
+  enum class Type { NUL, BOOLEAN, NUMBER, STRING, ARRAY, OBJECT };
+
+  Type type = Type::NUL;
+  bool boolean = false;
+  std::string text;
+  std::vector<JsonValue> items;
+  std::vector<std::pair<std::string, JsonValue>> members;
+
+  bool isObject() const { return type == Type::OBJECT; }
+  bool isArray() const { return type == Type::ARRAY; }
+  // Member lookup on an object; nullptr when absent or not an object.
+  const JsonValue *find(const std::string &name) const;
+  // Typed accessors; they throw invalid_argument on a type mismatch.
+  double asNumber() const;
+  ull asUnsigned() const;
+  const std::string &asString() const;
+  bool asBool() const;
+};
+
+// Parses one JSON document; throws invalid_argument with the byte offset of
+// the first syntax error.
+JsonValue parseJson(const std::string &document);
@@ -0,0 +1,84 @@
+#pragma once
+
+#include "fast_adj_hash.h"
+#include "fast_clique_sink.h"
+#include "root_costs.h"
+#include "search_budget.h"
+
+#include <atomic>
+#include <mutex>
+
+// Counts or lists every k-clique (maximal or not) by oriented recursion on
+// the degeneracy DAG: each edge points from the lower to the higher
+// FastListBK degeneracy rank, so a k-clique is reached exactly once, from its
+// lowest-ranked vertex, and every candidate set has at most degeneracy
+// vertices. Roots are independent and are distributed over BK_THREADS
+// workers.
+class KCliqueLister {
+private:
+  // Out-neighborhoods up to this size are re-encoded as per-level bitsets;
+  // larger ones keep candidate lists filtered through FastAdjacencyHash.
+  static constexpr ui BITSET_LIMIT = 1024;
+
+  struct Worker;
+
+  const Graph &graph;
+  const FastAdjacencyHash &adjacency;
+  ui k;
+  ui degeneracy;
+  unsigned threads;
+  std::vector<ui> rank;
+  std::vector<ui> outOffset;
+  std::vector<ui> outNeighbors;
+  ull cliqueCount;
+  ull bitsetRoots;
+  ull listRoots;
+  bool summaryOutput;
+  FastCliqueSink cliqueSink;
+  std::mutex sinkMutex;
+  RootCostRecorder *rootCosts;
+  std::vector<ui> rootSchedule;
+  SearchBudget *budget;
+  // Cliques of the roots that have finished, for the budget's clique limit.
+  std::atomic<ull> committedCliques;
+  std::vector<ui> completedRoots;
+
+  void buildOrientation();
+  bool budgetExhausted(Worker &worker);
+  void processRoot(Worker &worker, ui root);
+  void buildRootBitsets(Worker &worker, ui root);
+  void countBitsets(Worker &worker, ui depth, ui need);
+  void countLists(Worker &worker, ui depth, ui need);
+  void emit(Worker &worker);
+
+public:
+  KCliqueLister(const Graph &g, ui k);
+  // Lists every k-clique in canonical sorted order. Calls are serialized, so
+  // the sink need not be thread-safe; their order depends on scheduling.
+  void setCliqueSink(FastCliqueSink sink) { cliqueSink = std::move(sink); }
+  void setThreadCount(unsigned count) { threads = count == 0 ? 1 : count; }
+  void setSummaryOutput(bool enabled) { summaryOutput = enabled; }
+  // Charges each root's k-cliques and time to the recorder (the lister has
+  // no check counter). Null (the default) disables the accounting.
+  void setRootCostRecorder(RootCostRecorder *recorder) {
+    rootCosts = recorder;
+  }
+  // Hands the roots to the workers in this sequence, which must list every
+  // vertex once; heaviest-first keeps a heavy root from finishing last.
+  // Empty (the default) runs the roots in id order.
+  void setRootSchedule(std::vector<ui> schedule) {
+    rootSchedule = std::move(schedule);
+  }
+  // Stops every worker once the budget is exhausted, keeping the k-cliques
+  // counted so far; the lister has no check counter, so the check limit
+  // applies to each worker's recursion calls. Null (the default) runs to
+  // completion.
+  void setSearchBudget(SearchBudget *searchBudget) { budget = searchBudget; }
+  void listAllCliques();
+  ull getCliqueCount() const { return cliqueCount; }
+  ui getDegeneracy() const { return degeneracy; }
+  ull getBitsetRoots() const { return bitsetRoots; }
+  ull getListRoots() const { return listRoots; }
+  // Under a budget, the roots that finished before the stop, by vertex id.
+  const std::vector<ui> &getCompletedRoots() const { return completedRoots; }
+};
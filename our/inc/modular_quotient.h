@@ -0,0 +1,66 @@
+#pragma once
+
+#include "clique_histogram.h"
+#include "fast_clique_sink.h"
+#include "graph.h"
+
+// A node of the twin-module tree. Leaves are original vertices; a series
+// node joins its children (they were true twins, pairwise fully adjacent),
+// a parallel node unions them (false twins, no edges between them).
+struct TwinModuleNode {
+  enum Kind : unsigned char { LEAF, SERIES, PARALLEL };
+  Kind kind = LEAF;
+  ui vertex = 0;
+  std::vector<ui> children;
+};
+
+// Quotient of g by iterated twin collapsing. Every round groups the current
+// vertices by hashed open and closed neighborhoods (O(m + n log n)),
+// verifies each class exactly, and merges it into one module vertex. Rounds
+// repeat while they still shrink the graph by at least 1/64, so nested
+// modules of cograph shape (twins of twins) collapse as well. moduleRoot[q]
+// is the tree node of quotient vertex q and moduleCliques[q] the
+// maximal-clique size histogram of the module's induced subgraph, left empty
+// for a single vertex.
+struct TwinModuleQuotient {
+  Graph quotient;
+  std::vector<TwinModuleNode> nodes;
+  std::vector<ui> moduleRoot;
+  std::vector<CliqueSizeHistogram> moduleCliques;
+  ui rounds = 0;
+  ull trueTwinMerges = 0;
+  ull falseTwinMerges = 0;
+};
+
+TwinModuleQuotient buildTwinModuleQuotient(const Graph &g);
+
+// Maximal cliques of g are exactly the unions, over a maximal clique K of
+// the quotient, of one maximal clique per module in K. The solver lists the
+// quotient with FastListBK at threshold 1 and convolves the module
+// histograms of each quotient clique, keeping sizes >= minCliqueSize; with
+// a sink installed it expands each product into original cliques.
+class ModularQuotientSolver {
+private:
+  const Graph &graph;
+  ui minCliqueSize;
+  TwinModuleQuotient decomposition;
+  ull cliqueCount;
+  ui maxCliqueSize;
+  ull quotientCliques;
+  CliqueSizeHistogram cliqueSizeHistogram;
+  FastCliqueSink cliqueSink;
+
+  void expandModules(std::vector<ui> &pending, std::vector<ui> &clique) const;
+
+public:
+  ModularQuotientSolver(const Graph &g, ui minCliqueSize);
+  void setCliqueSink(FastCliqueSink sink) { cliqueSink = std::move(sink); }
+  const TwinModuleQuotient &getDecomposition() const { return decomposition; }
+  void findAllMaximalCliques();
+  ull getCliqueCount() const { return cliqueCount; }
+  ui getMaxCliqueSize() const { return maxCliqueSize; }
+  ull getQuotientCliqueCount() const { return quotientCliques; }
+  const CliqueSizeHistogram &getCliqueSizeHistogram() const {
+    return cliqueSizeHistogram;
+  }
+};
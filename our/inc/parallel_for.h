@@ -0,0 +1,74 @@
+#pragma once
+
+#include "common.h"
+
+#include <atomic>
+#include <exception>
+#include <thread>
+
+// Worker count for the root-parallel lanes: BK_THREADS when it is a positive
+// integer, otherwise the hardware concurrency (at least one).
+inline unsigned configuredThreadCount() {
+  if (const char *value = std::getenv("BK_THREADS")) {
+    char *end = nullptr;
+    const unsigned long parsed = std::strtoul(value, &end, 10);
+    if (end != value && *end == '\0' && parsed != 0 && parsed <= 1024)
+      return static_cast<unsigned>(parsed);
+  }
+  const unsigned hardware = std::thread::hardware_concurrency();
+  return hardware == 0 ? 1 : hardware;
+}
+
+// Calls body(worker, index) for every index in [0, count). Workers claim
+// chunks of consecutive indices from a shared cursor, so skewed per-index
+// costs balance dynamically. With one worker the loop runs on the calling
+// thread. The first exception thrown by any call stops further claims and is
+// rethrown here after every worker has joined.
+template <typename Body>
+void parallelFor(size_t count, unsigned threads, size_t chunk, Body body) {
+  if (chunk == 0)
+    chunk = 1;
+  if (threads <= 1 || count <= chunk) {
+    for (size_t index = 0; index < count; ++index)
+      body(0u, index);
+    return;
+  }
+
+  const size_t chunks = (count + chunk - 1) / chunk;
+  if (threads > chunks)
+    threads = static_cast<unsigned>(chunks);
+
+  std::atomic<size_t> cursor(0);
+  std::atomic<bool> failed(false);
+  std::exception_ptr failure;
+  std::mutex failureMutex;
+  auto work = [&](unsigned worker) {
+    try {
+      for (;;) {
+        if (failed.load(std::memory_order_relaxed))
+          return;
+        const size_t begin = cursor.fetch_add(chunk);
+        if (begin >= count)
+          return;
+        const size_t end = std::min(count, begin + chunk);
+        for (size_t index = begin; index < end; ++index)
+          body(worker, index);
+      }
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(failureMutex);
+      if (!failure)
+        failure = std::current_exception();
+      failed.store(true, std::memory_order_relaxed);
+    }
+  };
+
+  std::vector<std::thread> pool;
+  pool.reserve(threads - 1);
+  for (unsigned worker = 1; worker < threads; ++worker)
+    pool.emplace_back(work, worker);
+  work(0);
+  for (std::thread &thread : pool)
+    thread.join();
+  if (failure)
+    std::rethrow_exception(failure);
+}
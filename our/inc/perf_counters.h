@@ -0,0 +1,100 @@
+#pragma once
+
+#include "common.h"
+
+#include <array>
+#include <atomic>
+#include <ostream>
+
+// Hardware counters for engine phases and kernels through perf_event_open(2),
+// enabled at runtime (BK_PERF=1 in bk_algorithm). Each thread opens one event
+// group on first use: task clock, cycles, instructions, last-level cache
+// misses and branch misses. Events the kernel or hypervisor does not expose
+// are left out and reported as unavailable. Region totals live in the
+// runtime counter registry (runtime_counters.h) as perf.<region>.<event>.
+enum class PerfEvent {
+  TASK_CLOCK,
+  CYCLES,
+  INSTRUCTIONS,
+  LLC_MISSES,
+  BRANCH_MISSES
+};
+constexpr size_t PERF_EVENT_COUNT = 5;
+
+const char *perfEventName(PerfEvent event);
+
+// Opens the calling thread's group and, when at least one event opened,
+// enables region measurement process-wide and returns true. When any event
+// failed to open, *reason (if given) names the missing events and the first
+// error.
+bool enablePerfCounters(std::string *reason = nullptr);
+void disablePerfCounters();
+
+namespace perf_counters_detail {
+extern std::atomic<bool> enabled;
+} // namespace perf_counters_detail
+
+inline bool perfCountersEnabled() {
+  return perf_counters_detail::enabled.load(std::memory_order_relaxed);
+}
+
+// Whether the event opened on the thread that enabled measurement.
+bool perfEventAvailable(PerfEvent event);
+
+// A named region. A phase region reads the counters on every entry; a kernel
+// region counts every entry but reads the counters on one entry in
+// PERF_KERNEL_SAMPLE_PERIOD per thread, since two reads cost more than most
+// kernel calls. Regions are inclusive: a kernel inside the search phase is
+// counted in both.
+class PerfRegion {
+private:
+  std::array<ui, PERF_EVENT_COUNT> eventIds;
+  ui entriesId;
+  ui samplesId;
+  bool kernel;
+
+  friend class ScopedPerfRegion;
+
+public:
+  PerfRegion(const std::string &name, bool isKernel);
+};
+
+constexpr ui PERF_KERNEL_SAMPLE_PERIOD = 64;
+
+class ScopedPerfRegion {
+private:
+  const PerfRegion *region;
+  std::array<ull, PERF_EVENT_COUNT> start;
+
+  void begin(const PerfRegion &measured);
+  void finish();
+
+public:
+  explicit ScopedPerfRegion(const PerfRegion &measured) : region(nullptr) {
+    if (perfCountersEnabled())
+      begin(measured);
+  }
+  ~ScopedPerfRegion() { stop(); }
+  // Ends the region before the end of the enclosing scope.
+  void stop() {
+    if (region != nullptr)
+      finish();
+  }
+  ScopedPerfRegion(const ScopedPerfRegion &) = delete;
+  ScopedPerfRegion &operator=(const ScopedPerfRegion &) = delete;
+};
+
+struct PerfRegionTotals {
+  std::string name;
+  ull entries;
+  // Entries whose counters were read; equal to entries for phases.
+  ull samples;
+  std::array<ull, PERF_EVENT_COUNT> values;
+};
+
+// Regions entered at least once, in registration order.
+std::vector<PerfRegionTotals> collectPerfRegions();
+// One "PerfCounters: region=..." line per entered region with the event
+// totals over its samples, the IPC and the mean cycles per sample;
+// unavailable events are printed as n/a.
+void printPerfRegions(std::ostream &out);
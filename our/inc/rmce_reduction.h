@@ -1,5 +1,6 @@
 #pragma once
 
+#include "clique_histogram.h"
 #include "graph.h"
 
 struct RmceReductionCounters {
@@ -17,6 +18,7 @@ struct RmceReductionResult {
   vector<ui> residualToOriginal;
   ull directlyEmittedCount = 0;
   size_t maximumCliqueSize = 0;
+  CliqueSizeHistogram directlyEmittedHistogram;
   vector<vector<ui>> directlyEmittedCliques;
   RmceReductionCounters counters;
 };
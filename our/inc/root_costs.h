@@ -0,0 +1,94 @@
+#pragma once
+
+#include "common.h"
+
+#include <chrono>
+#include <ostream>
+
+// Per-root cost accounting (BK_ROOT_COSTS in bk_algorithm). Root costs are
+// heavily skewed: a few roots of a large graph often carry most of the
+// search. An engine with a recorder installed charges each root's search
+// states, maximal cliques and elapsed time to that root's slot; the report
+// lists the heaviest roots and how concentrated the cost is, and the dump is
+// a cost-sorted root order that later runs on the same graph can schedule by
+// (BK_ROOT_ORDER).
+struct RootCost {
+  ull checks = 0;
+  ull cliques = 0;
+  ull ns = 0;
+};
+
+// One slot per vertex. Distinct roots may be charged from different threads;
+// a root is charged by one thread at a time.
+class RootCostRecorder {
+private:
+  std::vector<RootCost> costs;
+
+public:
+  explicit RootCostRecorder(ui n) : costs(n) {}
+
+  void charge(ui root, ull checks, ull cliques,
+              std::chrono::nanoseconds elapsed) {
+    RootCost &cost = costs[root];
+    cost.checks += checks;
+    cost.cliques += cliques;
+    cost.ns += static_cast<ull>(std::max<long long>(0, elapsed.count()));
+  }
+  void reset() { std::fill(costs.begin(), costs.end(), RootCost{}); }
+  const std::vector<RootCost> &getCosts() const { return costs; }
+};
+
+// Charges the growth of an engine's check and clique counters over its
+// lifetime to one root. With a null recorder it does nothing.
+template <typename Count> class RootCostScope {
+private:
+  using Clock = std::chrono::steady_clock;
+
+  RootCostRecorder *recorder;
+  ui root;
+  const Count &checks;
+  const Count &cliques;
+  Count checksAtStart;
+  Count cliquesAtStart;
+  Clock::time_point start;
+
+public:
+  RootCostScope(RootCostRecorder *costRecorder, ui measuredRoot,
+                const Count &checkCount, const Count &cliqueCount)
+      : recorder(costRecorder), root(measuredRoot), checks(checkCount),
+        cliques(cliqueCount), checksAtStart(checkCount),
+        cliquesAtStart(cliqueCount) {
+    if (recorder != nullptr)
+      start = Clock::now();
+  }
+  ~RootCostScope() {
+    if (recorder != nullptr)
+      recorder->charge(root, static_cast<ull>(checks - checksAtStart),
+                       static_cast<ull>(cliques - cliquesAtStart),
+                       Clock::now() - start);
+  }
+  RootCostScope(const RootCostScope &) = delete;
+  RootCostScope &operator=(const RootCostScope &) = delete;
+};
+
+// Roots that were charged anything, heaviest first: by time, then checks,
+// then vertex id.
+std::vector<ui> costSortedRoots(const std::vector<RootCost> &costs);
+
+// "RootCosts:" totals, how many of the heaviest roots cover 50/90/99% of the
+// time and the time share of the top 1% and 10% of charged roots, then one
+// "RootCost:" line for each of the topN heaviest roots.
+void printRootCostReport(std::ostream &out, const std::vector<RootCost> &costs,
+                         size_t topN);
+
+// Writes the charged roots in cost order as "root checks cliques ns" lines
+// under a "# bk root costs n=<vertices>" header; throws runtime_error when
+// the file cannot be written.
+void writeRootCosts(const std::string &path,
+                    const std::vector<RootCost> &costs);
+
+// Reads a dump back as a schedule over all n vertices: the listed roots in
+// file order, then every unlisted vertex in id order, so a partial or stale
+// hint never drops a root. Throws runtime_error on a malformed file, a
+// repeated root or a dump taken on a graph with a different vertex count.
+std::vector<ui> readRootOrder(const std::string &path, ui n);
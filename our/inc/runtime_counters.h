@@ -0,0 +1,156 @@
+#pragma once
+
+#include "common.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <ostream>
+
+class JsonWriter;
+
+// Process-wide named counters and timers that the engines report into. The
+// level is chosen at runtime (BK_COUNTERS in bk_algorithm): at OFF a report
+// site costs one relaxed load and a predictable branch, COUNTERS adds event
+// counts, and TIMERS also charges scoped timers. Every thread writes only its
+// own shard; totals are summed over the shards when they are collected.
+enum class CounterLevel { OFF = 0, COUNTERS = 1, TIMERS = 2 };
+
+// Accepts "off", "counters" or "timers"; throws invalid_argument otherwise.
+CounterLevel parseCounterLevel(const std::string &text);
+const char *counterLevelName(CounterLevel level);
+void setCounterLevel(CounterLevel level);
+
+namespace runtime_counters_detail {
+extern std::atomic<int> level;
+} // namespace runtime_counters_detail
+
+inline CounterLevel counterLevel() {
+  return static_cast<CounterLevel>(
+      runtime_counters_detail::level.load(std::memory_order_relaxed));
+}
+inline bool countersEnabled() { return counterLevel() != CounterLevel::OFF; }
+inline bool timersEnabled() { return counterLevel() == CounterLevel::TIMERS; }
+
+constexpr size_t RUNTIME_COUNTER_CAPACITY = 1024;
+
+// One thread's slots, indexed by registration id. Shards are cache-line
+// aligned and written only by their owning thread, so reporting never
+// contends; collect after the reporting threads have finished.
+struct alignas(64) CounterShard {
+  // Counter totals, or nanoseconds for timers.
+  std::array<ull, RUNTIME_COUNTER_CAPACITY> values{};
+  // Completed scopes for timers; unused by counters.
+  std::array<ull, RUNTIME_COUNTER_CAPACITY> events{};
+};
+
+// The calling thread's shard, leased on first use. When the thread exits the
+// shard goes back to a free list with its totals intact, so short-lived
+// workers neither lose counts nor grow the registry without bound.
+CounterShard &localCounterShard();
+
+// Id of the named counter or timer, registering it on first use. Throws
+// length_error past RUNTIME_COUNTER_CAPACITY names and logic_error when a
+// name is reused for the other kind.
+ui registerCounter(const std::string &name, bool timer);
+
+class RuntimeCounter {
+private:
+  ui id;
+
+public:
+  explicit RuntimeCounter(const std::string &name)
+      : id(registerCounter(name, false)) {}
+
+  void add(ull amount = 1) const {
+    if (countersEnabled())
+      localCounterShard().values[id] += amount;
+  }
+  // For hot loops that fetched the shard once and checked the level.
+  void add(CounterShard &shard, ull amount) const {
+    shard.values[id] += amount;
+  }
+};
+
+class RuntimeTimer {
+private:
+  ui id;
+
+public:
+  explicit RuntimeTimer(const std::string &name)
+      : id(registerCounter(name, true)) {}
+
+  ui getId() const { return id; }
+  // Charges an externally measured interval as one event at level TIMERS.
+  void record(std::chrono::nanoseconds elapsed) const;
+  void recordMillis(double ms) const;
+};
+
+// Charges its lifetime to a timer at level TIMERS. Nested scopes on one
+// thread are exclusive: an enclosing scope is charged only the time not
+// spent in the scopes it contains, so timer totals add up to wall time.
+class ScopedRuntimeTimer {
+private:
+  using Clock = std::chrono::steady_clock;
+
+  CounterShard *shard;
+  ui id;
+  ScopedRuntimeTimer *parent;
+  Clock::time_point start;
+  Clock::duration nested;
+
+  void begin();
+  void finish();
+
+public:
+  explicit ScopedRuntimeTimer(const RuntimeTimer &timer)
+      : shard(nullptr), id(timer.getId()), parent(nullptr),
+        nested(Clock::duration::zero()) {
+    if (timersEnabled())
+      begin();
+  }
+  ~ScopedRuntimeTimer() {
+    if (shard != nullptr)
+      finish();
+  }
+  ScopedRuntimeTimer(const ScopedRuntimeTimer &) = delete;
+  ScopedRuntimeTimer &operator=(const ScopedRuntimeTimer &) = delete;
+};
+
+// The per-run totals every enumeration engine reports under its own prefix:
+// <engine>.runs, <engine>.checks, <engine>.cliques and the <engine>.search
+// timer.
+class EngineRunCounters {
+private:
+  RuntimeCounter runs;
+  RuntimeCounter checks;
+  RuntimeCounter cliques;
+  RuntimeTimer search;
+
+public:
+  explicit EngineRunCounters(const std::string &engine);
+  void report(ull checksCount, ull cliqueCount, double ms) const;
+};
+
+struct CounterTotal {
+  std::string name;
+  bool timer;
+  // Counter total, or nanoseconds for a timer.
+  ull value;
+  ull events;
+};
+
+// Totals over every shard in registration order; names never reported are
+// left out.
+std::vector<CounterTotal> collectCounters();
+void resetCounters();
+
+// Writes the members "counters": {name: total, ...} and
+// "timers": {name: {"ms": ..., "calls": ...}, ...} into the open object.
+void writeCounterTotals(JsonWriter &json,
+                        const std::vector<CounterTotal> &totals);
+// The current totals as {"level": ..., "threads": ..., "counters": ...,
+// "timers": ...}.
+void writeCountersJson(JsonWriter &json);
+// One "counter <name> <total>" or "timer <name> <ms> ms calls=<n>" per line.
+void printCounters(std::ostream &out);
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "common.h"
+
+#include <atomic>
+#include <chrono>
+
+// Cooperative search budgets (BK_BUDGET_* in bk_algorithm, the budget of
+// EnumerationOptions and bk_batch jobs). An engine with a budget installed
+// polls it at every recursion node with its running check and clique
+// counts; once a limit is reached the search unwinds without opening new
+// nodes and the engine keeps the partial counts of everything it reported
+// so far, plus the roots whose subtrees finished before the stop. Word-sized
+// kernels (local bitset handoffs, tiny and plex3 terminals) run to
+// completion, so a limit can be overshot by one such kernel.
+struct SearchBudgetLimits {
+  // Zero disables a limit.
+  double wallMs = 0;
+  ull checks = 0;
+  ull cliques = 0;
+
+  bool any() const { return wallMs > 0 || checks != 0 || cliques != 0; }
+};
+
+enum class SearchBudgetStop { NONE = 0, TIME, CHECKS, CLIQUES };
+
+// "none", "time", "checks" or "cliques".
+const char *searchBudgetStopName(SearchBudgetStop stop);
+
+// Shared by every worker of a run. The wall clock starts at construction and
+// is read once per CLOCK_INTERVAL of each caller's own checks: every engine
+// or worker passes its own check count together with its own next-reading
+// threshold (zero when its budget is installed), so a caller whose count
+// lags the others still reads the clock on schedule. Polling costs three
+// compares and a relaxed load per node. The first limit reached is the stop
+// reason.
+class SearchBudget {
+private:
+  using Clock = std::chrono::steady_clock;
+  static constexpr ull CLOCK_INTERVAL = 256;
+
+  ull checkLimit;
+  ull cliqueLimit;
+  bool timed;
+  Clock::time_point deadline;
+  std::atomic<int> stop;
+
+  bool expire(SearchBudgetStop reason);
+  bool clockExpired(ull checks, ull &nextClockCheck);
+
+public:
+  explicit SearchBudget(const SearchBudgetLimits &limits);
+  SearchBudget(const SearchBudget &) = delete;
+  SearchBudget &operator=(const SearchBudget &) = delete;
+
+  // True once any limit is reached; a caller that sees true must return
+  // without expanding its node.
+  bool exhausted(ull checks, ull cliques, ull &nextClockCheck) {
+    if (stop.load(std::memory_order_relaxed) != 0)
+      return true;
+    if (checks >= checkLimit)
+      return expire(SearchBudgetStop::CHECKS);
+    if (cliques >= cliqueLimit)
+      return expire(SearchBudgetStop::CLIQUES);
+    return timed && checks >= nextClockCheck &&
+           clockExpired(checks, nextClockCheck);
+  }
+  bool isExhausted() const {
+    return stop.load(std::memory_order_relaxed) != 0;
+  }
+  SearchBudgetStop getStop() const {
+    return static_cast<SearchBudgetStop>(stop.load());
+  }
+};
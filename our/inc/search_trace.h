@@ -0,0 +1,180 @@
+#pragma once
+
+#include "common.h"
+
+#include <chrono>
+#include <cstdint>
+#include <limits>
+
+// Per-node search-tree trace for offline analysis of where the time goes
+// inside a root (bk_algorithm mode 5 with BK_TRACE=<path>). Sampled roots are
+// traced completely, one fixed-size record per search node, so the tree shape
+// survives; bk_trace converts a trace to Chrome trace JSON or CSV.
+//
+// File layout, native byte order: a SearchTraceHeader followed by records in
+// the order their nodes finished (postorder within a root). A node's ordinal
+// is its preorder position within its root and parent refers to that
+// ordinal, so a root's records end with its root node.
+
+// How a node was resolved. BRANCH is ordinary pivot branching; the others
+// are terminals or kernels that consumed the node without traced children,
+// except UNIVERSAL_P, which recurses into exactly one child.
+enum class SearchTraceKernel : std::uint8_t {
+  BRANCH,
+  LEAF,
+  BLOCKED,
+  X_UNIVERSAL,
+  P_CLIQUE,
+  MATCHING,
+  REDUCED,
+  LOW_DEGREE,
+  TINY,
+  PLEX3,
+  UNIVERSAL_P,
+  LOCAL_BITSET
+};
+constexpr size_t SEARCH_TRACE_KERNEL_COUNT = 12;
+
+const char *searchTraceKernelName(SearchTraceKernel kernel);
+
+// Which recursion produced the node: FastListBK's rule-checking enumerate()
+// or its baseline list recursion.
+enum class SearchTraceLane : std::uint8_t { ENUMERATE, BASELINE };
+
+constexpr ui SEARCH_TRACE_NONE = std::numeric_limits<ui>::max();
+
+struct SearchTraceRecord {
+  // Nanoseconds since the writer was opened, and inclusive of the subtree.
+  std::uint64_t startNs;
+  std::uint64_t durationNs;
+  // Search states and maximal cliques in the subtree, kernels included.
+  std::uint64_t checks;
+  std::uint64_t cliques;
+  std::uint32_t root;
+  std::uint32_t node;
+  // Parent ordinal, or SEARCH_TRACE_NONE for the root node.
+  std::uint32_t parent;
+  std::uint32_t p;
+  std::uint32_t x;
+  // Best pivot score (P neighbors), or SEARCH_TRACE_NONE when the node was
+  // resolved before pivot selection.
+  std::uint32_t pivotScore;
+  // Traced child nodes.
+  std::uint32_t children;
+  // Saturates at 65535.
+  std::uint16_t depth;
+  SearchTraceKernel kernel;
+  SearchTraceLane lane;
+};
+static_assert(sizeof(SearchTraceRecord) == 64,
+              "search trace records are one cache line");
+
+struct SearchTraceHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t recordSize;
+  std::uint32_t rootSamplePeriod;
+  std::uint32_t rootListSize;
+  std::uint64_t records;
+  std::uint64_t tracedRoots;
+  // Nodes past maxRecords that were not recorded; their ancestors were.
+  std::uint64_t droppedNodes;
+};
+
+struct SearchTraceOptions {
+  // Roots to trace; when empty, one root in rootSamplePeriod is chosen by a
+  // hash of its id, so a rerun traces the same roots.
+  std::vector<ui> roots;
+  ui rootSamplePeriod = 1;
+  // No root starts once this many nodes were recorded, and nodes past it
+  // are dropped, which bounds the file at 64 bytes per record.
+  ull maxRecords = 1ULL << 22;
+};
+
+class SearchTraceScope;
+
+// Writes one trace file for one serial engine. The header is rewritten with
+// the final totals by close(), which the destructor calls as well.
+class SearchTraceWriter {
+private:
+  using Clock = std::chrono::steady_clock;
+
+  std::ofstream out;
+  std::string path;
+  SearchTraceOptions options;
+  Clock::time_point origin;
+  std::vector<SearchTraceRecord> buffer;
+  std::vector<SearchTraceScope *> open;
+  ui currentRoot;
+  ui nextNode;
+  ull records;
+  ull tracedRoots;
+  ull droppedNodes;
+  bool closed;
+
+  void flush();
+  void writeHeader();
+
+  friend class SearchTraceScope;
+
+public:
+  SearchTraceWriter(const std::string &path, SearchTraceOptions options);
+  ~SearchTraceWriter();
+  SearchTraceWriter(const SearchTraceWriter &) = delete;
+  SearchTraceWriter &operator=(const SearchTraceWriter &) = delete;
+
+  // Whether root is sampled; when it is, nodes opened until endRoot() are
+  // recorded under it.
+  bool beginRoot(ui root);
+  void endRoot();
+  void close();
+  ull getRecords() const { return records; }
+  ull getTracedRoots() const { return tracedRoots; }
+  ull getDroppedNodes() const { return droppedNodes; }
+};
+
+// One traced node, recorded when the scope ends. With a null writer every
+// member is a single branch, so untraced roots pay nothing else.
+class SearchTraceScope {
+private:
+  SearchTraceWriter *writer;
+  const ull *checks;
+  const ull *cliques;
+  SearchTraceRecord record;
+
+  void begin(ui depth, size_t p, size_t x, SearchTraceLane lane);
+  void finish();
+
+public:
+  SearchTraceScope(SearchTraceWriter *traceWriter, ui depth, size_t p,
+                   size_t x, SearchTraceLane lane, const ull &checkCount,
+                   const ull &cliqueCount)
+      : writer(traceWriter), checks(&checkCount), cliques(&cliqueCount) {
+    if (writer != nullptr)
+      begin(depth, p, x, lane);
+  }
+  ~SearchTraceScope() {
+    if (writer != nullptr)
+      finish();
+  }
+  SearchTraceScope(const SearchTraceScope &) = delete;
+  SearchTraceScope &operator=(const SearchTraceScope &) = delete;
+
+  void setKernel(SearchTraceKernel kernel) {
+    if (writer != nullptr)
+      record.kernel = kernel;
+  }
+  void setPivotScore(ui score) {
+    if (writer != nullptr)
+      record.pivotScore = score;
+  }
+};
+
+struct SearchTrace {
+  SearchTraceHeader header;
+  std::vector<SearchTraceRecord> records;
+};
+
+// Reads a whole trace; throws runtime_error on a foreign, newer or truncated
+// file.
+SearchTrace readSearchTrace(const std::string &path);
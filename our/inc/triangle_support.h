@@ -0,0 +1,23 @@
+#pragma once
+
+#include "common.h"
+
+#include <functional>
+
+// Numbers the undirected edges of the CSR graph offset/neighbors, whose rows
+// must be sorted and duplicate-free: the edge {u, v} (u < v) gets the next
+// id when the u < v pass reaches it, and slotEdge[at] maps both of its CSR
+// positions to that id. When edges is given, the endpoints (u, v) of each id
+// are appended to it. Returns the edge count.
+ui numberCsrEdges(const vector<ui> &offset, const vector<ui> &neighbors,
+                  vector<ui> &slotEdge, vector<pair<ui, ui>> *edges = nullptr);
+
+// Adds to support[e] the number of triangles on every edge e of the CSR
+// graph offset/neighbors, where slotEdge[at] is the id of the edge stored at
+// position at. Each triangle is found once from its lowest vertex along
+// edges oriented by ranksBelow, which must be a strict total order on the
+// vertices; the workers share support through relaxed atomic increments.
+void countEdgeTriangles(const vector<ui> &offset, const vector<ui> &neighbors,
+                        const vector<ui> &slotEdge,
+                        const std::function<bool(ui, ui)> &ranksBelow,
+                        vector<ui> &support, unsigned threads);
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "graph.h"
+
+// Truss decomposition of a graph with sorted, duplicate-free rows. Edge ids
+// are aligned to the CSR: the edge {u, v} (u < v) gets the next id when the
+// u < v pass reaches it, and slotEdge[at] maps both of its CSR positions to
+// that id. Edges are peeled in nondecreasing triangle support; order lists
+// the ids in removal order and rank is its inverse. trussNumber[e] is the
+// peel level at which e left plus two, so every triangle that is still live
+// when e is removed has both other edges later in the order, and there are
+// at most trussNumber[e] - 2 of them. Support counting and each peel round
+// run on configuredThreadCount() workers; the result does not depend on the
+// worker count.
+struct TrussDecomposition {
+  vector<ui> slotEdge;
+  vector<pair<ui, ui>> edges;
+  vector<ui> trussNumber;
+  vector<ui> order;
+  vector<ui> rank;
+  ui maxTruss = 0;
+
+  // Id of the edge {u, v}, or UINT_MAX for a non-edge.
+  ui edgeId(const Graph &graph, ui u, ui v) const;
+};
+
+TrussDecomposition computeTrussDecomposition(const Graph &graph);
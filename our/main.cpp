@@ -1,13 +1,29 @@
+#include "inc/atom_decomposition.h"
 #include "inc/common.h"
+#include "inc/component_dispatch.h"
+#include "inc/fast_factorized_clique.h"
 #include "inc/fast_list_bk.h"
 #include "inc/graph.h"
+#include "inc/graph_artifacts.h"
 #include "inc/helpers.h"
+#include "inc/incremental_cliques.h"
+#include "inc/json.h"
+#include "inc/k_clique_lister.h"
+#include "inc/modular_quotient.h"
+#include "inc/parallel_for.h"
+#include "inc/perf_counters.h"
 #include "inc/rmce_reduction.h"
+#include "inc/root_costs.h"
+#include "inc/runtime_counters.h"
+#include "inc/search_budget.h"
+#include "inc/search_trace.h"
+#include "inc/truss_decomposition.h"
 
 #include <cerrno>
 #include <chrono>
 #include <cstring>
 #include <iomanip>
+#include <sstream>
 #include <stdexcept>
 
 namespace {
@@ -17,13 +33,205 @@ bool environmentFlagIsOne(const char *name) {
   return value != nullptr && std::strcmp(value, "1") == 0;
 }
 
+ull parseEnvironmentCount(const char *name, const string &text) {
+  char *end = nullptr;
+  errno = 0;
+  const unsigned long long parsed = strtoull(text.c_str(), &end, 10);
+  if (text.empty() || text[0] < '0' || text[0] > '9' || errno == ERANGE ||
+      *end != '\0')
+    throw std::invalid_argument(string(name) +
+                                " must be an unsigned integer: " + text);
+  return parsed;
+}
+
+// The sampling of a BK_TRACE run: BK_TRACE_ROOTS=v,v,... traces exactly those
+// roots, otherwise BK_TRACE_SAMPLE=N traces one root in N (default all);
+// BK_TRACE_MAX_RECORDS caps the recorded nodes.
+SearchTraceOptions searchTraceOptions() {
+  SearchTraceOptions options;
+  if (const char *roots = getenv("BK_TRACE_ROOTS")) {
+    stringstream list(roots);
+    string root;
+    while (getline(list, root, ',')) {
+      const ull parsed = parseEnvironmentCount("BK_TRACE_ROOTS", root);
+      if (parsed >= SEARCH_TRACE_NONE)
+        throw std::invalid_argument("BK_TRACE_ROOTS vertex out of range: " +
+                                    root);
+      options.roots.push_back(static_cast<ui>(parsed));
+    }
+  }
+  if (const char *sample = getenv("BK_TRACE_SAMPLE")) {
+    const ull period = parseEnvironmentCount("BK_TRACE_SAMPLE", sample);
+    if (period == 0 || period > UINT_MAX)
+      throw std::invalid_argument(string("BK_TRACE_SAMPLE must be in 1..") +
+                                  to_string(UINT_MAX) + ": " + sample);
+    options.rootSamplePeriod = static_cast<ui>(period);
+  }
+  if (const char *limit = getenv("BK_TRACE_MAX_RECORDS"))
+    options.maxRecords = parseEnvironmentCount("BK_TRACE_MAX_RECORDS", limit);
+  return options;
+}
+
+// Writes whatever a run derived back to the artifact cache on every return
+// path of runMain; a failed write only costs the next run its warm start.
+class ArtifactWriteBack {
+private:
+  const GraphArtifactCache *cache;
+  const Graph &graph;
+
+public:
+  ArtifactWriteBack(const GraphArtifactCache *artifactCache,
+                    const Graph &loaded)
+      : cache(artifactCache), graph(loaded) {}
+  ~ArtifactWriteBack() {
+    if (cache == nullptr)
+      return;
+    try {
+      cache->store(graph);
+    } catch (const std::exception &error) {
+      cerr << "Graph artifact not written: " << error.what() << endl;
+    }
+  }
+};
+
+const RuntimeTimer graphLoadTimer("main.graph_load");
+const PerfRegion loadPerfRegion("load", false);
+const PerfRegion outputPerfRegion("output", true);
+
+// Exports the runtime counters on every return path of runMain: as JSON to
+// BK_COUNTERS_JSON when that is set, otherwise as text on stderr so the
+// summary lines on stdout keep their shape. BK_PERF region lines follow the
+// summary lines on stdout.
+class RuntimeCounterReport {
+private:
+  std::string jsonPath;
+
+public:
+  explicit RuntimeCounterReport(const char *path)
+      : jsonPath(path == nullptr ? "" : path) {}
+  ~RuntimeCounterReport() {
+    if (perfCountersEnabled())
+      printPerfRegions(cout);
+    if (!countersEnabled())
+      return;
+    try {
+      if (jsonPath.empty()) {
+        printCounters(cerr);
+        return;
+      }
+      ofstream out(jsonPath);
+      JsonWriter json(out);
+      writeCountersJson(json);
+      out << '\n';
+      if (!out)
+        cerr << "Cannot write counter report " << jsonPath << endl;
+    } catch (const std::exception &error) {
+      cerr << "Counter report not written: " << error.what() << endl;
+    }
+  }
+};
+
+// Prints the BK_ROOT_COSTS report and writes the cost dump on every return
+// path of runMain once the engine has run. Nothing is written when no vertex
+// root ran, e.g. when a reduction stage or closed-form detector claimed the
+// graph, so an earlier dump is not replaced by an empty one.
+class RootCostReport {
+private:
+  const RootCostRecorder *recorder;
+  std::string path;
+  size_t topN;
+
+public:
+  RootCostReport(const RootCostRecorder *costs, const char *dumpPath,
+                 size_t heaviest)
+      : recorder(costs), path(dumpPath == nullptr ? "" : dumpPath),
+        topN(heaviest) {}
+  ~RootCostReport() {
+    if (recorder == nullptr)
+      return;
+    const vector<RootCost> &costs = recorder->getCosts();
+    if (costSortedRoots(costs).empty()) {
+      cerr << "Root costs not written: no vertex roots were run" << endl;
+      return;
+    }
+    try {
+      printRootCostReport(cout, costs, topN);
+      writeRootCosts(path, costs);
+    } catch (const std::exception &error) {
+      cerr << "Root costs not written: " << error.what() << endl;
+    }
+  }
+};
+
+// BK_BUDGET_MS, BK_BUDGET_CHECKS and BK_BUDGET_CLIQUES; unset or zero leaves
+// a limit off.
+SearchBudgetLimits searchBudgetLimits() {
+  SearchBudgetLimits limits;
+  if (const char *ms = getenv("BK_BUDGET_MS"))
+    limits.wallMs =
+        static_cast<double>(parseEnvironmentCount("BK_BUDGET_MS", ms));
+  if (const char *checks = getenv("BK_BUDGET_CHECKS"))
+    limits.checks = parseEnvironmentCount("BK_BUDGET_CHECKS", checks);
+  if (const char *cliques = getenv("BK_BUDGET_CLIQUES"))
+    limits.cliques = parseEnvironmentCount("BK_BUDGET_CLIQUES", cliques);
+  return limits;
+}
+
+// Follows the engine's summary line, whose counts are partial when
+// complete=0. completedRoots is null for engines that do not track roots.
+void printBudgetOutcome(const SearchBudget *budget,
+                        const vector<ui> *completedRoots, ui n) {
+  if (budget == nullptr)
+    return;
+  cout << "Budget: complete=" << !budget->isExhausted()
+       << "  stop=" << searchBudgetStopName(budget->getStop());
+  if (completedRoots != nullptr && budget->isExhausted())
+    cout << "  completedRoots=" << completedRoots->size() << "/" << n;
+  cout << endl;
+}
+
 void printCanonicalClique(const vector<ui> &clique) {
+  ScopedPerfRegion perf(outputPerfRegion);
   cout << "clique";
   for (ui vertex : clique)
     cout << ' ' << vertex;
   cout << '\n';
 }
 
+void printVertexList(const char *name, const vector<ui> &vertices) {
+  cout << " | " << name;
+  for (ui vertex : vertices)
+    cout << ' ' << vertex;
+}
+
+// One line per record; with clique identities also requested, the record is
+// followed by its lazily expanded members so validation scripts can diff them.
+void printFactorizedCliques(const FastFactorizedCliques &record,
+                            bool expandMembers) {
+  ScopedPerfRegion perf(outputPerfRegion);
+  cout << "factorized count=" << record.cliqueCount
+       << " maxSize=" << record.maxCliqueSize
+       << " minSize=" << record.minCliqueSize;
+  printVertexList("prefix", record.prefix);
+  printVertexList("forced", record.forced);
+  for (const pair<ui, ui> &missingEdge : record.pairs)
+    printVertexList("pair", {missingEdge.first, missingEdge.second});
+  for (const FastFactorizedComponent &component : record.components)
+    printVertexList(component.cycle ? "cycle" : "path", component.vertices);
+  cout << '\n';
+  if (expandMembers)
+    expandFactorizedCliques(record, printCanonicalClique);
+}
+
+// "size:count" pairs for every non-empty size class, in increasing size.
+void printCliqueSizeHistogram(const CliqueSizeHistogram &histogram) {
+  cout << "sizeHistogram:";
+  for (size_t size = 0; size < histogram.size(); ++size)
+    if (histogram[size] != 0)
+      cout << ' ' << size << ':' << histogram[size];
+  cout << endl;
+}
+
 void printStoredCanonicalCliques(const vector<vector<ui>> &cliques) {
   for (vector<ui> clique : cliques) {
     sort(clique.begin(), clique.end());
@@ -42,6 +250,295 @@ void printReducedCanonicalCliques(const RmceReductionResult &reduced,
   }
 }
 
+// Serves one anchored query per line of queryPath ("v" or "u v") from a
+// single FastListBK engine, so the order and portfolio are built once.
+int runAnchoredQueries(FastListBK &engine, const string &queryPath) {
+  ifstream in(queryPath);
+  if (!in) {
+    cerr << "Cannot open anchored query file " << queryPath << endl;
+    return 1;
+  }
+  ull queries = 0;
+  ull totalCliques = 0;
+  const auto start = chrono::steady_clock::now();
+  string line;
+  while (getline(in, line)) {
+    istringstream fields(line);
+    vector<ui> anchor;
+    ull vertex = 0;
+    while (anchor.size() < 3 && fields >> vertex)
+      anchor.push_back(static_cast<ui>(vertex));
+    if (anchor.empty())
+      continue;
+    if (anchor.size() > 2) {
+      cerr << "Anchored queries take one vertex or one edge: " << line << endl;
+      return 1;
+    }
+    const ull count = anchor.size() == 1
+                          ? engine.findMaximalCliquesContaining(anchor[0])
+                          : engine.findMaximalCliquesContaining(anchor[0],
+                                                                anchor[1]);
+    cout << "anchor";
+    for (ui v : anchor)
+      cout << ' ' << v;
+    cout << ": cliques=" << count
+         << "  maxSize=" << engine.getMaxCliqueSize() << '\n';
+    ++queries;
+    addCliqueCountOrThrow(totalCliques, count);
+  }
+  const double ms = chrono::duration<double, milli>(
+                        chrono::steady_clock::now() - start)
+                        .count();
+  cout << "AnchoredQueries: queries=" << queries
+       << "  cliques=" << totalCliques << "  time=" << fixed
+       << setprecision(3) << ms << " ms" << endl;
+  return 0;
+}
+
+// Reads the "clique v1 v2 ..." lines of a previous VLDB_PRINT_CLIQUES run.
+bool readCliqueFile(const string &path, vector<vector<ui>> &cliques) {
+  ifstream in(path);
+  if (!in)
+    return false;
+  string line;
+  while (getline(in, line)) {
+    istringstream fields(line);
+    string tag;
+    if (!(fields >> tag) || tag != "clique")
+      continue;
+    vector<ui> clique;
+    ull vertex = 0;
+    while (fields >> vertex)
+      clique.push_back(static_cast<ui>(vertex));
+    cliques.push_back(std::move(clique));
+  }
+  return true;
+}
+
+// Applies the edge batches of deltaPath ("+ u v" inserts, "- u v" deletes,
+// blank lines separate batches) to an IncrementalCliqueIndex seeded from
+// previousPath, or from a full FastListBK run when previousPath is null.
+int runIncrementalDelta(const Graph &g, ui minCliqueSize,
+                        const string &deltaPath, const char *previousPath,
+                        bool printCliques) {
+  vector<vector<ui>> seed;
+  if (previousPath != nullptr) {
+    if (!readCliqueFile(previousPath, seed)) {
+      cerr << "Cannot open previous clique file " << previousPath << endl;
+      return 1;
+    }
+  } else {
+    FastListBK fastListBk(g, false, minCliqueSize);
+    fastListBk.setCliqueSink(
+        [&](const vector<ui> &clique) { seed.push_back(clique); });
+    fastListBk.findAllMaximalCliques("IncrementalSeed");
+  }
+  IncrementalCliqueIndex index(g, std::move(seed), minCliqueSize);
+
+  ifstream in(deltaPath);
+  if (!in) {
+    cerr << "Cannot open edge delta file " << deltaPath << endl;
+    return 1;
+  }
+  vector<pair<ui, ui>> inserted;
+  vector<pair<ui, ui>> deleted;
+  auto applyBatch = [&]() {
+    if (inserted.empty() && deleted.empty())
+      return;
+    const auto start = chrono::steady_clock::now();
+    const IncrementalCliqueDelta delta =
+        index.applyEdgeDelta(inserted, deleted);
+    const double ms = chrono::duration<double, milli>(
+                          chrono::steady_clock::now() - start)
+                          .count();
+    cout << "IncrementalDelta: inserted=" << delta.insertedEdges
+         << "  deleted=" << delta.deletedEdges
+         << "  affected=" << delta.affectedVertices
+         << "  removed=" << delta.removedCliques
+         << "  added=" << delta.addedCliques
+         << "  cliques=" << index.getCliqueCount()
+         << "  maxSize=" << index.getMaxCliqueSize() << "  time=" << fixed
+         << setprecision(3) << ms << " ms" << endl;
+    inserted.clear();
+    deleted.clear();
+  };
+  string line;
+  while (getline(in, line)) {
+    istringstream fields(line);
+    char op = 0;
+    ull u = 0;
+    ull v = 0;
+    if (!(fields >> op)) {
+      applyBatch();
+      continue;
+    }
+    if ((op != '+' && op != '-') || !(fields >> u >> v)) {
+      cerr << "Edge delta lines are \"+ u v\" or \"- u v\": " << line << endl;
+      return 1;
+    }
+    (op == '+' ? inserted : deleted)
+        .emplace_back(static_cast<ui>(u), static_cast<ui>(v));
+  }
+  applyBatch();
+  if (printCliques)
+    printStoredCanonicalCliques(index.getCliques());
+  return 0;
+}
+
+// Mode 4's connected-component stage. Returns false, having printed nothing,
+// when the graph is better left to one whole-graph engine.
+bool runAdaptiveByComponents(const Graph &g, bool printSizeHistogram) {
+  const auto start = chrono::steady_clock::now();
+  ComponentDispatchResult result;
+  if (!solveAdaptiveByComponents(g, configuredThreadCount(), result))
+    return false;
+  const double ms = chrono::duration<double, milli>(
+                        chrono::steady_clock::now() - start)
+                        .count();
+  cout << "Running Adaptive BK (per-component dispatch)..." << endl;
+  cout << "AdaptiveComponents: cliques=" << result.cliqueCount
+       << "  maxSize=" << result.maxCliqueSize
+       << "  components=" << result.components
+       << "  trivial=" << result.trivialComponents
+       << "  closedForm=" << result.closedFormComponents
+       << "  bitset=" << result.bitsetComponents
+       << "  local=" << result.localBitsetComponents << "  time=" << fixed
+       << setprecision(3) << ms << " ms" << endl;
+  if (printSizeHistogram)
+    printCliqueSizeHistogram(result.cliqueSizeHistogram);
+  return true;
+}
+
+// The shared twin-module quotient stage for modes 2-5, enabled with
+// BK_MODULAR_QUOTIENT=1. Returns false, having printed nothing, when the
+// stage is off or g has no twins.
+bool runModularQuotient(const Graph &g, ui minCliqueSize, bool printCliques,
+                        bool printSizeHistogram) {
+  if (!environmentFlagIsOne("BK_MODULAR_QUOTIENT"))
+    return false;
+  const auto start = chrono::steady_clock::now();
+  ModularQuotientSolver solver(g, minCliqueSize);
+  const Graph &quotient = solver.getDecomposition().quotient;
+  if (quotient.n == g.n)
+    return false;
+  const double decomposeMs = chrono::duration<double, milli>(
+                                 chrono::steady_clock::now() - start)
+                                 .count();
+  cout << "Running Fast List BK on the twin-module quotient..." << endl;
+  if (printCliques)
+    solver.setCliqueSink(printCanonicalClique);
+  solver.findAllMaximalCliques();
+  const double ms = chrono::duration<double, milli>(
+                        chrono::steady_clock::now() - start)
+                        .count();
+  const TwinModuleQuotient &decomposition = solver.getDecomposition();
+  cout << "ModularQuotient: cliques=" << solver.getCliqueCount()
+       << "  maxSize=" << solver.getMaxCliqueSize()
+       << "  minSize=" << minCliqueSize << "  quotientN=" << quotient.n
+       << "  quotientM=" << quotient.m
+       << "  rounds=" << decomposition.rounds
+       << "  trueTwinClasses=" << decomposition.trueTwinMerges
+       << "  falseTwinClasses=" << decomposition.falseTwinMerges
+       << "  quotientCliques=" << solver.getQuotientCliqueCount()
+       << "  decomposeTime=" << fixed << setprecision(3) << decomposeMs
+       << " ms  time=" << ms << " ms" << endl;
+  if (printSizeHistogram)
+    printCliqueSizeHistogram(solver.getCliqueSizeHistogram());
+  return true;
+}
+
+// The shared RMCE reduction stage for modes 0 and 2-5, enabled with
+// BK_RMCE=1. The degree-0/1/2 and non-triangle-edge rules emit their
+// cliques directly, the mode's engine runs on the residual graph with its
+// own summary muted, and both halves are merged into one summary line.
+// Returns false, having printed nothing, when the stage is off or the rules
+// remove nothing.
+bool runRmceReduced(const Graph &g, int mode, DegOrder order,
+                    ui minCliqueSize, bool printCliques,
+                    bool printSizeHistogram) {
+  if (!environmentFlagIsOne("BK_RMCE"))
+    return false;
+  const auto start = chrono::steady_clock::now();
+  RmceReductionResult reduced =
+      applyRmceReduction(g, minCliqueSize, printCliques);
+  if (reduced.graph.n == g.n && reduced.graph.m == g.m)
+    return false;
+  const double reductionMs = chrono::duration<double, milli>(
+                                 chrono::steady_clock::now() - start)
+                                 .count();
+
+  Graph &residual = reduced.graph;
+  const bool useBitset =
+      mode == 2 || (mode == 4 && adaptiveUsesBitsetBK(residual));
+  const char *engine = mode == 0    ? "PivotBK"
+                       : useBitset ? "BitsetBK"
+                       : mode == 5 ? "FastListBK"
+                                   : "LocalBitsetBK";
+  cout << "Running " << engine << " on the RMCE residual..." << endl;
+  ull residualCliques = 0;
+  ui residualMaxSize = 0;
+  CliqueSizeHistogram histogram = reduced.directlyEmittedHistogram;
+  auto collect = [&](auto &solver) {
+    residualCliques = solver.getCliqueCount();
+    residualMaxSize = solver.getMaxCliqueSize();
+    mergeCliqueSizeHistogramOrThrow(histogram,
+                                    solver.getCliqueSizeHistogram());
+  };
+  if (mode == 0) {
+    PivotBK solver(residual, order);
+    solver.setSummaryOutput(false);
+    solver.findAllMaximalCliques();
+    collect(solver);
+  } else if (useBitset) {
+    BitsetBK solver(residual);
+    solver.setSummaryOutput(false);
+    solver.findAllMaximalCliques();
+    collect(solver);
+  } else if (mode == 5) {
+    FastListBK solver(residual, false, minCliqueSize);
+    solver.setSummaryOutput(false);
+    if (printCliques) {
+      printStoredCanonicalCliques(reduced.directlyEmittedCliques);
+      solver.setCliqueSink([&](const vector<ui> &clique) {
+        vector<ui> original(clique.size());
+        for (size_t i = 0; i < clique.size(); ++i)
+          original[i] = reduced.residualToOriginal[clique[i]];
+        sort(original.begin(), original.end());
+        printCanonicalClique(original);
+      });
+    }
+    solver.findAllMaximalCliques();
+    collect(solver);
+  } else {
+    LocalBitsetBK solver(residual);
+    solver.setSummaryOutput(false);
+    solver.findAllMaximalCliques();
+    collect(solver);
+  }
+
+  ull cliqueCount = reduced.directlyEmittedCount;
+  addCliqueCountOrThrow(cliqueCount, residualCliques);
+  const size_t maxCliqueSize =
+      max(reduced.maximumCliqueSize, static_cast<size_t>(residualMaxSize));
+  const double ms = chrono::duration<double, milli>(
+                        chrono::steady_clock::now() - start)
+                        .count();
+  cout << "RmceReduced: engine=" << engine << "  cliques=" << cliqueCount
+       << "  maxSize=" << maxCliqueSize << "  minSize=" << minCliqueSize
+       << "  direct=" << reduced.directlyEmittedCount
+       << "  residualN=" << residual.n << "  residualM=" << residual.m
+       << "  residualCliques=" << residualCliques
+       << "  d0=" << reduced.counters.degree0Vertices
+       << "  d1=" << reduced.counters.degree1Vertices
+       << "  d2=" << reduced.counters.degree2Vertices
+       << "  nontriangle=" << reduced.counters.nontriangleEdges << fixed
+       << setprecision(3) << "  reductionTime=" << reductionMs
+       << " ms  time=" << ms << " ms" << endl;
+  if (printSizeHistogram)
+    printCliqueSizeHistogram(histogram);
+  return true;
+}
+
 } // namespace
 
 int runMain(int argc, const char *argv[]) {
@@ -51,13 +548,15 @@ int runMain(int argc, const char *argv[]) {
             "[minCliqueSize]"
          << endl;
     cout << "  mode: 0=PivotBK  1=HybridReorder  2=BitsetBK  3=LocalBitsetBK  "
-            "4=AdaptiveBK  5=FastListBK  6=PureReorderExact"
+            "4=AdaptiveBK  5=FastListBK  6=PureReorderExact  7=KCliques  "
+            "8=EdgeFastListBK"
          << endl;
     cout << "  ord:  0=Original  1=Ascending  2=Descending" << endl;
     cout << "  meth: 0=Backtracking  1=Optimized  (ReorderSib modes only)"
          << endl;
-    cout << "  minCliqueSize: mode-1/5/6 output threshold (default 3; use 1 "
-            "for conventional MCE)"
+    cout << "  minCliqueSize: mode-1/5/6/8 output threshold (default 3; use 1 "
+            "for conventional MCE); mode 7 lists all cliques of exactly this "
+            "size"
          << endl;
     exit(1);
   }
@@ -90,6 +589,8 @@ int runMain(int argc, const char *argv[]) {
   const bool minCliqueSizeExplicit = argc > 14;
   const bool printCliqueIdentities = environmentFlagIsOne("VLDB_VALIDATION") ||
                                      environmentFlagIsOne("VLDB_PRINT_CLIQUES");
+  const bool printFactorized = environmentFlagIsOne("VLDB_PRINT_FACTORIZED");
+  const bool printSizeHistogram = environmentFlagIsOne("VLDB_SIZE_HISTOGRAM");
   ui minCliqueSize = 3;
   if (argc > 14) {
     char *end = nullptr;
@@ -101,16 +602,123 @@ int runMain(int argc, const char *argv[]) {
            << endl;
       return 1;
     }
-    if (mode != 1 && mode != 5 && mode != 6) {
-      cerr << "minCliqueSize is supported only by modes 1, 5, and 6; other "
-              "modes retain their existing threshold."
+    if (mode != 1 && mode != 5 && mode != 6 && mode != 7 && mode != 8) {
+      cerr << "minCliqueSize is supported only by modes 1, 5, 6, 7, and 8; "
+              "other modes retain their existing threshold."
            << endl;
       return 1;
     }
     minCliqueSize = static_cast<ui>(parsed);
   }
 
-  Graph g(filepath);
+  if (const char *level = getenv("BK_COUNTERS")) {
+    try {
+      setCounterLevel(parseCounterLevel(level));
+    } catch (const std::invalid_argument &error) {
+      cerr << "Invalid BK_COUNTERS: " << error.what() << endl;
+      return 1;
+    }
+  }
+  if (environmentFlagIsOne("BK_PERF")) {
+    string missing;
+    if (!enablePerfCounters(&missing))
+      cerr << "Perf counters disabled: " << missing << endl;
+    else if (!missing.empty())
+      cerr << "Perf counters: " << missing << endl;
+  }
+  RuntimeCounterReport counterReport(getenv("BK_COUNTERS_JSON"));
+
+  std::unique_ptr<SearchTraceWriter> searchTrace;
+  if (const char *tracePath = getenv("BK_TRACE")) {
+    if (mode != 5) {
+      cerr << "BK_TRACE is supported only by mode 5." << endl;
+      return 1;
+    }
+    try {
+      searchTrace =
+          std::make_unique<SearchTraceWriter>(tracePath, searchTraceOptions());
+    } catch (const std::exception &error) {
+      cerr << "Invalid search trace: " << error.what() << endl;
+      return 1;
+    }
+  }
+
+  // BK_ROOT_COSTS=<path> reports the heaviest roots and dumps every root's
+  // cost; BK_ROOT_ORDER=<dump> runs the roots heaviest-first from such a dump.
+  const char *rootCostPath = getenv("BK_ROOT_COSTS");
+  const char *rootOrderPath = getenv("BK_ROOT_ORDER");
+  size_t rootCostTop = 10;
+  if (rootCostPath != nullptr || rootOrderPath != nullptr) {
+    if (mode != 2 && mode != 3 && mode != 4 && mode != 5 && mode != 7) {
+      cerr << "BK_ROOT_COSTS and BK_ROOT_ORDER are supported only by modes "
+              "2, 3, 4, 5, and 7."
+           << endl;
+      return 1;
+    }
+    if (const char *top = getenv("BK_ROOT_COSTS_TOP")) {
+      try {
+        rootCostTop = parseEnvironmentCount("BK_ROOT_COSTS_TOP", top);
+      } catch (const std::invalid_argument &error) {
+        cerr << "Invalid root costs: " << error.what() << endl;
+        return 1;
+      }
+    }
+  }
+
+  // The budget stops the engine's own search; stages that run other engines
+  // on a derived graph would escape it, so they are rejected, and mode 4
+  // skips its per-component dispatch.
+  SearchBudgetLimits budgetLimits;
+  try {
+    budgetLimits = searchBudgetLimits();
+  } catch (const std::invalid_argument &error) {
+    cerr << "Invalid budget: " << error.what() << endl;
+    return 1;
+  }
+  if (budgetLimits.any()) {
+    for (const char *stage :
+         {"BK_RMCE", "BK_MODULAR_QUOTIENT", "FASTLIST_ATOMS", "PURE_RMCE"}) {
+      if (environmentFlagIsOne(stage)) {
+        cerr << "BK_BUDGET_* cannot be combined with " << stage << "=1."
+             << endl;
+        return 1;
+      }
+    }
+    if (getenv("VLDB_EDGE_DELTA") != nullptr ||
+        getenv("VLDB_ANCHOR_QUERIES") != nullptr) {
+      cerr << "BK_BUDGET_* applies only to whole-graph enumeration." << endl;
+      return 1;
+    }
+  }
+
+  std::unique_ptr<GraphArtifactCache> artifacts;
+  if (const char *cacheDirectory = getenv("BK_ARTIFACT_CACHE"))
+    artifacts = std::make_unique<GraphArtifactCache>(cacheDirectory);
+  const auto loadStart = chrono::steady_clock::now();
+  ScopedPerfRegion loadPerf(loadPerfRegion);
+  Graph g = artifacts ? artifacts->load(filepath) : Graph(filepath);
+  loadPerf.stop();
+  graphLoadTimer.record(chrono::steady_clock::now() - loadStart);
+  ArtifactWriteBack artifactWriteBack(artifacts.get(), g);
+
+  std::unique_ptr<RootCostRecorder> rootCosts;
+  if (rootCostPath != nullptr)
+    rootCosts = std::make_unique<RootCostRecorder>(g.n);
+  RootCostReport rootCostReport(rootCosts.get(), rootCostPath, rootCostTop);
+  vector<ui> rootOrder;
+  if (rootOrderPath != nullptr) {
+    try {
+      rootOrder = readRootOrder(rootOrderPath, g.n);
+    } catch (const std::exception &error) {
+      cerr << "Invalid root order: " << error.what() << endl;
+      return 1;
+    }
+  }
+  // Started once the graph is loaded, so engine setup counts against the
+  // wall-time limit.
+  std::unique_ptr<SearchBudget> budget;
+  if (budgetLimits.any())
+    budget = std::make_unique<SearchBudget>(budgetLimits);
 
   if (mode == 0) {
     cout << "Running Pivot BK ";
@@ -125,59 +733,122 @@ int runMain(int argc, const char *argv[]) {
       exit(1);
     }
     cout << endl;
+    if (runRmceReduced(g, mode, static_cast<DegOrder>(ord), 3, false,
+                       printSizeHistogram))
+      return 0;
     PivotBK pivotBk(g, static_cast<DegOrder>(ord));
+    pivotBk.setSearchBudget(budget.get());
     pivotBk.findAllMaximalCliques();
+    printBudgetOutcome(budget.get(), nullptr, g.n);
+    if (printSizeHistogram)
+      printCliqueSizeHistogram(pivotBk.getCliqueSizeHistogram());
   } else if (mode == 2) {
+    if (runRmceReduced(g, mode, DegOrder::ASCENDING, 3, false,
+                       printSizeHistogram) ||
+        runModularQuotient(g, 3, false, printSizeHistogram))
+      return 0;
     cout << "Running Bitset BK..." << endl;
     BitsetBK bitsetBk(g);
+    bitsetBk.setRootCostRecorder(rootCosts.get());
+    bitsetBk.setRootSchedule(std::move(rootOrder));
+    bitsetBk.setSearchBudget(budget.get());
     bitsetBk.findAllMaximalCliques();
+    printBudgetOutcome(budget.get(), &bitsetBk.getCompletedRoots(), g.n);
+    if (printSizeHistogram)
+      printCliqueSizeHistogram(bitsetBk.getCliqueSizeHistogram());
   } else if (mode == 3) {
+    if (runRmceReduced(g, mode, DegOrder::ASCENDING, 3, false,
+                       printSizeHistogram) ||
+        runModularQuotient(g, 3, false, printSizeHistogram))
+      return 0;
     cout << "Running Local Bitset BK..." << endl;
     LocalBitsetBK localBitsetBk(g);
+    localBitsetBk.setRootCostRecorder(rootCosts.get());
+    localBitsetBk.setRootSchedule(std::move(rootOrder));
+    localBitsetBk.setSearchBudget(budget.get());
     localBitsetBk.findAllMaximalCliques();
+    printBudgetOutcome(budget.get(), &localBitsetBk.getCompletedRoots(), g.n);
+    if (printSizeHistogram)
+      printCliqueSizeHistogram(localBitsetBk.getCliqueSizeHistogram());
   } else if (mode == 4) {
-    const ull words = (g.n + 63) >> 6;
-    const ull denseBytes = (ull)g.n * words * sizeof(ull);
-    const double avgDegree =
-        g.n == 0 ? 0.0 : (2.0 * static_cast<double>(g.m)) / g.n;
-    ui maxDegree = 0;
-    ui zeroDegree = 0;
-    for (ui d : g.degree) {
-      maxDegree = max(maxDegree, d);
-      if (d == 0)
-        zeroDegree++;
-    }
-    const bool cheapModuleDense = g.n <= 16000 && avgDegree >= 6.0 &&
-                                  maxDegree >= 90 && zeroDegree * 4 >= g.n;
-    const bool denseCoreCandidate = !cheapModuleDense &&
-                                    denseBytes <= (64ULL << 20) &&
-                                    avgDegree >= 3.0 && maxDegree >= 90;
-    const ui degeneracy = denseCoreCandidate ? graphDegeneracy(g) : 0;
-    const bool useDense =
-        denseBytes <= (64ULL << 20) &&
-        (g.n <= 1000 || (g.n <= 8000 && avgDegree >= 10.0) ||
-         (g.n <= 10000 && avgDegree >= 14.0) || cheapModuleDense ||
-         (g.n <= 16000 && avgDegree >= 6.0 && maxDegree >= 90 &&
-          degeneracy >= 45) ||
-         (g.n <= 16000 && avgDegree >= 40.0) ||
-         (g.n <= 18000 && avgDegree >= 44.0) || avgDegree >= 46.0 ||
-         degeneracy >= 64);
-
+    if (runRmceReduced(g, mode, DegOrder::ASCENDING, 3, false,
+                       printSizeHistogram) ||
+        runModularQuotient(g, 3, false, printSizeHistogram) ||
+        (budget == nullptr &&
+         runAdaptiveByComponents(g, printSizeHistogram)))
+      return 0;
+    const bool useDense = adaptiveUsesBitsetBK(g);
     if (useDense) {
       cout << "Running Adaptive BK (BitsetBK)..." << endl;
       BitsetBK bitsetBk(g);
+      bitsetBk.setRootCostRecorder(rootCosts.get());
+      bitsetBk.setRootSchedule(std::move(rootOrder));
+      bitsetBk.setSearchBudget(budget.get());
       bitsetBk.findAllMaximalCliques();
+      printBudgetOutcome(budget.get(), &bitsetBk.getCompletedRoots(), g.n);
+      if (printSizeHistogram)
+        printCliqueSizeHistogram(bitsetBk.getCliqueSizeHistogram());
     } else {
       cout << "Running Adaptive BK (LocalBitsetBK)..." << endl;
       LocalBitsetBK localBitsetBk(g);
+      localBitsetBk.setRootCostRecorder(rootCosts.get());
+      localBitsetBk.setRootSchedule(std::move(rootOrder));
+      localBitsetBk.setSearchBudget(budget.get());
       localBitsetBk.findAllMaximalCliques();
+      printBudgetOutcome(budget.get(), &localBitsetBk.getCompletedRoots(),
+                         g.n);
+      if (printSizeHistogram)
+        printCliqueSizeHistogram(localBitsetBk.getCliqueSizeHistogram());
     }
   } else if (mode == 5) {
-    cout << "Running Fast List BK..." << endl;
+    if (const char *deltaPath = getenv("VLDB_EDGE_DELTA")) {
+      cout << "Running Fast List BK incremental maintenance..." << endl;
+      return runIncrementalDelta(g, minCliqueSize, deltaPath,
+                                 getenv("VLDB_PREVIOUS_CLIQUES"),
+                                 printCliqueIdentities);
+    }
+    if (environmentFlagIsOne("FASTLIST_ATOMS")) {
+      cout << "Running Fast List BK over clique-separator atoms..." << endl;
+      AtomCliqueSolver atomSolver(g, minCliqueSize);
+      if (printCliqueIdentities)
+        atomSolver.setCliqueSink(printCanonicalClique);
+      atomSolver.findAllMaximalCliques();
+      if (printSizeHistogram)
+        printCliqueSizeHistogram(atomSolver.getCliqueSizeHistogram());
+      return 0;
+    }
+    if (!printFactorized && getenv("VLDB_ANCHOR_QUERIES") == nullptr &&
+        (runRmceReduced(g, mode, DegOrder::ASCENDING, minCliqueSize,
+                        printCliqueIdentities, printSizeHistogram) ||
+         runModularQuotient(g, minCliqueSize, printCliqueIdentities,
+                            printSizeHistogram)))
+      return 0;
     FastListBK fastListBk(g, false, minCliqueSize);
-    if (printCliqueIdentities)
+    if (printFactorized)
+      fastListBk.setFactorizedSink([&](const FastFactorizedCliques &record) {
+        printFactorizedCliques(record, printCliqueIdentities);
+      });
+    else if (printCliqueIdentities)
       fastListBk.setCliqueSink(printCanonicalClique);
+    if (const char *queryPath = getenv("VLDB_ANCHOR_QUERIES")) {
+      cout << "Running Fast List BK anchored queries..." << endl;
+      return runAnchoredQueries(fastListBk, queryPath);
+    }
+    cout << "Running Fast List BK..." << endl;
+    fastListBk.setSearchTrace(searchTrace.get());
+    fastListBk.setRootCostRecorder(rootCosts.get());
+    fastListBk.setRootSchedule(std::move(rootOrder));
+    fastListBk.setSearchBudget(budget.get());
     fastListBk.findAllMaximalCliques();
+    printBudgetOutcome(budget.get(), &fastListBk.getCompletedRoots(), g.n);
+    if (searchTrace) {
+      searchTrace->close();
+      cout << "SearchTrace: roots=" << searchTrace->getTracedRoots()
+           << "  records=" << searchTrace->getRecords()
+           << "  droppedNodes=" << searchTrace->getDroppedNodes() << endl;
+    }
+    if (printSizeHistogram)
+      printCliqueSizeHistogram(fastListBk.getCliqueSizeHistogram());
   } else if (mode == 1 || mode == 6) {
     if (ord < 0 || ord > 2) {
       cout << "Invalid order! Use 0..2." << endl;
@@ -208,10 +879,23 @@ int runMain(int argc, const char *argv[]) {
       cout << "Running ReorderSib (Hybrid reorder/sibling + pivot expansion)..."
            << endl;
       FastListBK fastListBk(g, true, minCliqueSize);
-      if (printCliqueIdentities)
+      if (printFactorized)
+        fastListBk.setFactorizedSink([&](const FastFactorizedCliques &record) {
+          printFactorizedCliques(record, printCliqueIdentities);
+        });
+      else if (printCliqueIdentities)
         fastListBk.setCliqueSink(printCanonicalClique);
+      fastListBk.setSearchBudget(budget.get());
       fastListBk.findAllMaximalCliques("ReorderSib");
+      printBudgetOutcome(budget.get(), &fastListBk.getCompletedRoots(), g.n);
+      if (printSizeHistogram)
+        printCliqueSizeHistogram(fastListBk.getCliqueSizeHistogram());
     } else {
+      if (mode == 1 && budget != nullptr) {
+        cerr << "BK_BUDGET_* is not supported by the legacy ReorderSib lane."
+             << endl;
+        return 1;
+      }
       // Mode 6 is the theorem-aligned Pure worklist.  Mode 1 retains the
       // original recursive implementation on configurations that do not route
       // to FastListBK, preserving the legacy lane for ablations.
@@ -258,11 +942,16 @@ int runMain(int argc, const char *argv[]) {
         reorder.setSolverWorkBudget(strtoull(budget, nullptr, 10));
       if (useRmce)
         reorder.setExternalResults(reduced.directlyEmittedCount,
-                                   reduced.maximumCliqueSize);
+                                   reduced.maximumCliqueSize,
+                                   reduced.directlyEmittedHistogram);
+      reorder.setSearchBudget(budget.get());
       if (mode == 6)
         reorder.findAllMaximalCliquesPure();
       else
         reorder.findAllMaximalCliques();
+      printBudgetOutcome(budget.get(), &reorder.getCompletedRoots(), g.n);
+      if (printSizeHistogram)
+        printCliqueSizeHistogram(reorder.getCliqueSizeHistogram());
       if (mode == 6 && printCliqueIdentities) {
         if (useRmce)
           printReducedCanonicalCliques(reduced, reorder.getCliques());
@@ -270,8 +959,45 @@ int runMain(int argc, const char *argv[]) {
           printStoredCanonicalCliques(reorder.getCliques());
       }
     }
+  } else if (mode == 7) {
+    cout << "Running k-clique lister..." << endl;
+    KCliqueLister lister(g, minCliqueSize);
+    if (printCliqueIdentities)
+      lister.setCliqueSink(printCanonicalClique);
+    lister.setRootCostRecorder(rootCosts.get());
+    lister.setRootSchedule(std::move(rootOrder));
+    lister.setSearchBudget(budget.get());
+    lister.listAllCliques();
+    printBudgetOutcome(budget.get(), &lister.getCompletedRoots(), g.n);
+  } else if (mode == 8) {
+    cout << "Running Edge Fast List BK (truss-ordered roots)..." << endl;
+    g.sortAdjacency();
+    const auto trussStart = chrono::steady_clock::now();
+    const TrussDecomposition truss = computeTrussDecomposition(g);
+    const auto trussEnd = chrono::steady_clock::now();
+    FastListBK fastListBk(g, false, minCliqueSize);
+    if (printFactorized)
+      fastListBk.setFactorizedSink([&](const FastFactorizedCliques &record) {
+        printFactorizedCliques(record, printCliqueIdentities);
+      });
+    else if (printCliqueIdentities)
+      fastListBk.setCliqueSink(printCanonicalClique);
+    fastListBk.setSearchBudget(budget.get());
+    fastListBk.findAllMaximalCliquesFromEdges(truss);
+    cout << fixed << setprecision(3)
+         << "EdgeRoots: edges=" << truss.edges.size()
+         << "  maxTruss=" << truss.maxTruss
+         << "  maxRootP=" << fastListBk.getMaxEdgeRootP()
+         << "  filteredRoots=" << fastListBk.getEdgeRootsFiltered()
+         << "  ownedNodes=" << fastListBk.getOwnedEdgeNodes()
+         << "  trussTime="
+         << chrono::duration<double, milli>(trussEnd - trussStart).count()
+         << " ms" << endl;
+    printBudgetOutcome(budget.get(), nullptr, g.n);
+    if (printSizeHistogram)
+      printCliqueSizeHistogram(fastListBk.getCliqueSizeHistogram());
   } else {
-    cout << "Invalid mode! Use 0..6." << endl;
+    cout << "Invalid mode! Use 0..8." << endl;
     exit(1);
   }
 
@@ -0,0 +1,415 @@
+#include "../inc/atom_decomposition.h"
+
+#include <chrono>
+#include <iomanip>
+
+namespace {
+// Live neighbors of v in the remaining graph.
+void liveNeighbors(const Graph &g, const vector<char> &removed, ui v,
+                   vector<ui> &out) {
+  out.clear();
+  for (ui at = g.offset[v]; at < g.offset[v + 1]; ++at) {
+    if (!removed[g.neighbors[at]])
+      out.push_back(g.neighbors[at]);
+  }
+}
+
+bool isClique(const FastAdjacencyHash &adjacency, const vector<ui> &vertices) {
+  for (size_t i = 0; i < vertices.size(); ++i) {
+    for (size_t j = i + 1; j < vertices.size(); ++j) {
+      if (!adjacency.contains(vertices[i], vertices[j]))
+        return false;
+    }
+  }
+  return true;
+}
+} // namespace
+
+AtomDecomposition decomposeCliqueSeparators(const Graph &g,
+                                            const FastAdjacencyHash &adjacency) {
+  constexpr ui degreeLimit = AtomCliqueSolver::SIMPLICIAL_DEGREE_LIMIT;
+  AtomDecomposition result;
+  vector<char> removed(g.n, 0);
+  vector<ui> liveDegree(g.degree.begin(), g.degree.end());
+  vector<ui> neighborhood;
+
+  // Simplicial peeling. A vertex is retested whenever a neighbor leaves,
+  // since only a shrinking neighborhood can turn into a clique. The cuts are
+  // only materialized once the core is known to fit the MCS-M budget.
+  vector<ui> peeled;
+  vector<char> queued(g.n, 0);
+  vector<ui> queue;
+  for (ui v = 0; v < g.n; ++v) {
+    if (liveDegree[v] <= degreeLimit) {
+      queued[v] = 1;
+      queue.push_back(v);
+    }
+  }
+  for (size_t head = 0; head < queue.size(); ++head) {
+    const ui v = queue[head];
+    queued[v] = 0;
+    if (removed[v] || liveDegree[v] > degreeLimit)
+      continue;
+    liveNeighbors(g, removed, v, neighborhood);
+    // N(v) can only be a clique if each member has degree |N(v)| or more.
+    bool feasible = true;
+    for (ui w : neighborhood) {
+      if (liveDegree[w] < neighborhood.size()) {
+        feasible = false;
+        break;
+      }
+    }
+    if (!feasible || !isClique(adjacency, neighborhood))
+      continue;
+    removed[v] = 1;
+    peeled.push_back(v);
+    for (ui w : neighborhood) {
+      --liveDegree[w];
+      if (!queued[w] && liveDegree[w] <= degreeLimit) {
+        queued[w] = 1;
+        queue.push_back(w);
+      }
+    }
+  }
+
+  vector<ui> core;
+  ull coreEdgeEnds = 0;
+  vector<ui> coreIndex(g.n, UINT_MAX);
+  for (ui v = 0; v < g.n; ++v) {
+    if (!removed[v]) {
+      coreIndex[v] = static_cast<ui>(core.size());
+      core.push_back(v);
+      coreEdgeEnds += liveDegree[v];
+    }
+  }
+  const ull coreN = core.size();
+  const ull mcsmBudget =
+      min(AtomCliqueSolver::MCSM_WORK_LIMIT,
+          AtomCliqueSolver::MCSM_WORK_PER_EDGE *
+              (static_cast<ull>(g.n) + g.m));
+  result.mcsmSkipped = coreN * (coreN + coreEdgeEnds / 2) > mcsmBudget;
+  if (result.mcsmSkipped)
+    return result;
+
+  // Each peeled vertex's separator is its neighbors still live when it left.
+  vector<char> gone(g.n, 0);
+  for (ui v : peeled) {
+    AtomCut cut;
+    cut.interior.push_back(v);
+    for (ui at = g.offset[v]; at < g.offset[v + 1]; ++at) {
+      if (!gone[g.neighbors[at]])
+        cut.separator.push_back(g.neighbors[at]);
+    }
+    cut.cliqueAtom = true;
+    result.cuts.push_back(std::move(cut));
+    gone[v] = 1;
+  }
+  result.simplicialCuts = peeled.size();
+
+  if (!core.empty()) {
+    // MCS-M numbers the core from n down to 1. Unnumbered u joins the fill
+    // set of the picked vertex v when some path v..u runs through unnumbered
+    // vertices of weight below w(u); madj[u] collects those v, which is u's
+    // higher neighborhood in the minimal triangulation H.
+    const ui n = static_cast<ui>(coreN);
+    vector<ui> weight(n, 0);
+    vector<char> numbered(n, 0);
+    vector<ui> visited(n, 0);
+    ui stamp = 0;
+    vector<vector<ui>> madj(n);
+    vector<vector<ui>> reach;
+    vector<ui> fill;
+    vector<ui> alphaInverse(n);
+    vector<char> generator(n, 0);
+    // Unnumbered vertices sit in doubly linked buckets by weight. Weights
+    // only grow, one step at a time, so the top bucket is found by moving
+    // maxWeight up on increments and down past emptied buckets.
+    vector<ui> bucketHead(n, UINT_MAX);
+    vector<ui> bucketNext(n);
+    vector<ui> bucketPrev(n);
+    auto bucketInsert = [&](ui u) {
+      const ui head = bucketHead[weight[u]];
+      bucketPrev[u] = UINT_MAX;
+      bucketNext[u] = head;
+      if (head != UINT_MAX)
+        bucketPrev[head] = u;
+      bucketHead[weight[u]] = u;
+    };
+    auto bucketErase = [&](ui u) {
+      if (bucketPrev[u] != UINT_MAX)
+        bucketNext[bucketPrev[u]] = bucketNext[u];
+      else
+        bucketHead[weight[u]] = bucketNext[u];
+      if (bucketNext[u] != UINT_MAX)
+        bucketPrev[bucketNext[u]] = bucketPrev[u];
+    };
+    for (ui c = n; c-- > 0;)
+      bucketInsert(c);
+    ui maxWeight = 0;
+    long long previousWeight = -1;
+    for (ui i = n; i-- > 0;) {
+      while (bucketHead[maxWeight] == UINT_MAX)
+        --maxWeight;
+      const ui v = bucketHead[maxWeight];
+      bucketErase(v);
+      if (static_cast<long long>(weight[v]) <= previousWeight)
+        generator[v] = 1;
+      previousWeight = weight[v];
+      numbered[v] = 1;
+      alphaInverse[i] = v;
+
+      ++stamp;
+      visited[v] = stamp;
+      fill.clear();
+      while (maxWeight > 0 && bucketHead[maxWeight] == UINT_MAX)
+        --maxWeight;
+      if (reach.size() < static_cast<size_t>(maxWeight) + 1)
+        reach.resize(static_cast<size_t>(maxWeight) + 1);
+      const ui original = core[v];
+      for (ui at = g.offset[original]; at < g.offset[original + 1]; ++at) {
+        const ui u = coreIndex[g.neighbors[at]];
+        if (u == UINT_MAX || numbered[u])
+          continue;
+        visited[u] = stamp;
+        fill.push_back(u);
+        reach[weight[u]].push_back(u);
+      }
+      for (ui level = 0; level <= maxWeight; ++level) {
+        while (!reach[level].empty()) {
+          const ui y = reach[level].back();
+          reach[level].pop_back();
+          const ui yOriginal = core[y];
+          for (ui at = g.offset[yOriginal]; at < g.offset[yOriginal + 1];
+               ++at) {
+            const ui z = coreIndex[g.neighbors[at]];
+            if (z == UINT_MAX || numbered[z] || visited[z] == stamp)
+              continue;
+            visited[z] = stamp;
+            if (weight[z] > level) {
+              fill.push_back(z);
+              reach[weight[z]].push_back(z);
+            } else {
+              reach[level].push_back(z);
+            }
+          }
+        }
+      }
+      for (ui u : fill) {
+        bucketErase(u);
+        ++weight[u];
+        bucketInsert(u);
+        maxWeight = max(maxWeight, weight[u]);
+        madj[u].push_back(original);
+      }
+    }
+
+    // Atoms: in increasing alpha, cut the component of each generator x
+    // below its higher neighborhood when that neighborhood is a clique.
+    vector<ui> component;
+    vector<ui> boundary;
+    vector<ui> inComponent(g.n, 0);
+    ui componentStamp = 0;
+    ui liveCore = n;
+    for (ui i = 0; i < n; ++i) {
+      const ui x = alphaInverse[i];
+      const ui xOriginal = core[x];
+      if (!generator[x] || removed[xOriginal])
+        continue;
+      vector<ui> separator;
+      for (ui y : madj[x]) {
+        if (!removed[y])
+          separator.push_back(y);
+      }
+      if (!isClique(adjacency, separator))
+        continue;
+
+      ++componentStamp;
+      for (ui y : separator)
+        inComponent[y] = componentStamp;
+      component.clear();
+      boundary.clear();
+      component.push_back(xOriginal);
+      inComponent[xOriginal] = componentStamp;
+      for (size_t head = 0; head < component.size(); ++head) {
+        const ui u = component[head];
+        for (ui at = g.offset[u]; at < g.offset[u + 1]; ++at) {
+          const ui w = g.neighbors[at];
+          if (removed[w] || inComponent[w] == componentStamp)
+            continue;
+          inComponent[w] = componentStamp;
+          component.push_back(w);
+        }
+      }
+      // The component already covers everything outside the separator.
+      if (component.size() + separator.size() >= liveCore)
+        continue;
+
+      // The actual separator is N(C), a sub-clique of the tested one.
+      ++componentStamp;
+      for (ui u : component)
+        inComponent[u] = componentStamp;
+      for (ui u : component) {
+        for (ui at = g.offset[u]; at < g.offset[u + 1]; ++at) {
+          const ui w = g.neighbors[at];
+          if (!removed[w] && inComponent[w] != componentStamp) {
+            inComponent[w] = componentStamp;
+            boundary.push_back(w);
+          }
+        }
+      }
+      const ui atomSize =
+          static_cast<ui>(component.size() + boundary.size());
+      bool cliqueAtom = true;
+      for (ui u : component) {
+        if (liveDegree[u] + 1 != atomSize) {
+          cliqueAtom = false;
+          break;
+        }
+      }
+      for (ui u : component)
+        removed[u] = 1;
+      for (ui u : component) {
+        for (ui at = g.offset[u]; at < g.offset[u + 1]; ++at) {
+          const ui w = g.neighbors[at];
+          if (!removed[w])
+            --liveDegree[w];
+        }
+      }
+      liveCore -= static_cast<ui>(component.size());
+      AtomCut cut;
+      cut.interior = component;
+      cut.separator = boundary;
+      cut.cliqueAtom = cliqueAtom;
+      result.cuts.push_back(std::move(cut));
+      ++result.separatorCuts;
+    }
+  }
+
+  AtomCut remainder;
+  for (ui v : core) {
+    if (!removed[v])
+      remainder.interior.push_back(v);
+  }
+  if (!remainder.interior.empty()) {
+    const ui size = static_cast<ui>(remainder.interior.size());
+    remainder.cliqueAtom = true;
+    for (ui v : remainder.interior) {
+      if (liveDegree[v] + 1 != size) {
+        remainder.cliqueAtom = false;
+        break;
+      }
+    }
+    result.cuts.push_back(std::move(remainder));
+  }
+  return result;
+}
+
+AtomCliqueSolver::AtomCliqueSolver(const Graph &g, ui outputThreshold)
+    : graph(g), engine(g, false, outputThreshold),
+      minCliqueSize(std::max<ui>(1, outputThreshold)), cliqueCount(0),
+      maxCliqueSize(0) {}
+
+void AtomCliqueSolver::setCliqueSink(FastCliqueSink sink) {
+  engine.setCliqueSink(sink);
+  cliqueSink = std::move(sink);
+}
+
+// A clique atom is a maximal clique of G unless an earlier-cut vertex, which
+// must then neighbor the anchor, is adjacent to the whole atom.
+bool AtomCliqueSolver::cliqueAtomIsMaximal(const std::vector<ui> &atom,
+                                           ui anchor,
+                                           const std::vector<ui> &order,
+                                           ui cutStart) const {
+  const FastAdjacencyHash &adjacency = engine.getAdjacency();
+  for (ui at = graph.offset[anchor]; at < graph.offset[anchor + 1]; ++at) {
+    const ui w = graph.neighbors[at];
+    if (order[w] >= cutStart)
+      continue;
+    bool extends = true;
+    for (ui a : atom) {
+      if (a != anchor && !adjacency.contains(w, a)) {
+        extends = false;
+        break;
+      }
+    }
+    if (extends)
+      return false;
+  }
+  return true;
+}
+
+void AtomCliqueSolver::findAllMaximalCliques() {
+  cliqueCount = 0;
+  maxCliqueSize = 0;
+  cliqueSizeHistogram.clear();
+
+  const auto start = std::chrono::high_resolution_clock::now();
+  const AtomDecomposition decomposition =
+      decomposeCliqueSeparators(graph, engine.getAdjacency());
+  const auto decomposed = std::chrono::high_resolution_clock::now();
+
+  const std::vector<ui> &degeneracyRank = graph.coreDecomposition().rank;
+  std::vector<ui> order(graph.n, 0);
+  std::vector<ui> roots;
+  std::vector<ui> atom;
+  ull cliqueAtoms = 0;
+  ui position = 0;
+  if (decomposition.mcsmSkipped) {
+    order = degeneracyRank;
+    roots.resize(graph.n);
+    for (ui v = 0; v < graph.n; ++v)
+      roots[v] = v;
+  }
+  for (const AtomCut &cut : decomposition.cuts) {
+    const ui cutStart = position;
+    std::vector<ui> interior = cut.interior;
+    std::sort(interior.begin(), interior.end(), [&](ui a, ui b) {
+      return degeneracyRank[a] < degeneracyRank[b];
+    });
+    for (ui v : interior)
+      order[v] = position++;
+    if (!cut.cliqueAtom) {
+      roots.insert(roots.end(), interior.begin(), interior.end());
+      continue;
+    }
+
+    ++cliqueAtoms;
+    atom = cut.interior;
+    atom.insert(atom.end(), cut.separator.begin(), cut.separator.end());
+    if (atom.size() < minCliqueSize ||
+        !cliqueAtomIsMaximal(atom, cut.interior.front(), order, cutStart))
+      continue;
+    addCliqueCountOrThrow(cliqueCount, 1);
+    addCliqueSizeCountOrThrow(cliqueSizeHistogram, atom.size(), 1);
+    maxCliqueSize = std::max(maxCliqueSize, static_cast<ui>(atom.size()));
+    if (cliqueSink) {
+      std::sort(atom.begin(), atom.end());
+      cliqueSink(atom);
+    }
+  }
+
+  engine.findMaximalCliquesFromRoots(order, roots);
+  addCliqueCountOrThrow(cliqueCount, engine.getCliqueCount());
+  mergeCliqueSizeHistogramOrThrow(cliqueSizeHistogram,
+                                  engine.getCliqueSizeHistogram());
+  maxCliqueSize = std::max(maxCliqueSize, engine.getMaxCliqueSize());
+  trimCliqueSizeHistogram(cliqueSizeHistogram);
+
+  const auto finish = std::chrono::high_resolution_clock::now();
+  std::cout << "AtomFastListBK: cliques=" << cliqueCount
+            << "  maxSize=" << maxCliqueSize
+            << "  minSize=" << minCliqueSize
+            << "  atoms=" << decomposition.cuts.size()
+            << "  cliqueAtoms=" << cliqueAtoms
+            << "  simplicial=" << decomposition.simplicialCuts
+            << "  separators=" << decomposition.separatorCuts
+            << "  mcsm=" << (decomposition.mcsmSkipped ? "skipped" : "on")
+            << "  roots=" << roots.size() << "  decomposeTime=" << std::fixed
+            << std::setprecision(3)
+            << std::chrono::duration<double, std::milli>(decomposed - start)
+                   .count()
+            << " ms  time="
+            << std::chrono::duration<double, std::milli>(finish - start)
+                   .count()
+            << " ms" << std::endl;
+}
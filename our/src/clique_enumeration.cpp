@@ -0,0 +1,297 @@
+#include "../inc/clique_enumeration.h"
+#include "../inc/fast_list_bk.h"
+#include "../inc/k_clique_lister.h"
+#include "../inc/truss_decomposition.h"
+
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+using Counters = std::vector<std::pair<std::string, ull>>;
+
+const char *const ENGINE_NAMES[] = {
+    "pivot",        "hybrid_reorder", "bitset",
+    "local_bitset", "adaptive",       "fast_list",
+    "pure_reorder", "k_cliques",      "edge_fast_list"};
+constexpr int ENGINE_COUNT = 9;
+
+double elapsedMs(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
+bool countsOnly(EnumerationEngine engine) {
+  return engine == EnumerationEngine::PIVOT ||
+         engine == EnumerationEngine::BITSET ||
+         engine == EnumerationEngine::LOCAL_BITSET ||
+         engine == EnumerationEngine::ADAPTIVE;
+}
+
+bool recordsRoots(EnumerationEngine engine) {
+  return engine == EnumerationEngine::BITSET ||
+         engine == EnumerationEngine::LOCAL_BITSET ||
+         engine == EnumerationEngine::ADAPTIVE ||
+         engine == EnumerationEngine::FAST_LIST ||
+         engine == EnumerationEngine::K_CLIQUES;
+}
+
+void validateOptions(const EnumerationOptions &options,
+                     const FastCliqueSink &sink) {
+  const char *name = enumerationEngineName(options.engine);
+  if (options.minCliqueSize == 0)
+    throw std::invalid_argument("minCliqueSize must be at least 1");
+  if (countsOnly(options.engine) && options.minCliqueSize != 3)
+    throw std::invalid_argument(std::string(name) +
+                                " has a fixed minCliqueSize of 3");
+  if (countsOnly(options.engine) && sink)
+    throw std::invalid_argument(std::string(name) +
+                                " counts cliques and takes no sink");
+  if (!recordsRoots(options.engine) &&
+      (options.rootCosts != nullptr || !options.rootSchedule.empty()))
+    throw std::invalid_argument(std::string(name) +
+                                " does not take root costs or a root order");
+}
+
+Counters fastListCounters(const FastListBK &engine) {
+  return {{"cliques", engine.getCliqueCount()},
+          {"maxSize", engine.getMaxCliqueSize()},
+          {"checks", engine.getChecksCount()},
+          {"siblingEvents", engine.getSiblingEvents()},
+          {"tiny", engine.getTinyKernelCalls()},
+          {"localHandoffs", engine.getLocalBitsetHandoffs()},
+          {"localChecks", engine.getLocalBitsetChecks()},
+          {"plex3Terminals", engine.getPlex3Terminals()},
+          {"plex3Cliques", engine.getPlex3Cliques()},
+          {"xDominanceRemoved", engine.getXDominanceRemoved()},
+          {"universalPForces", engine.getUniversalPForces()},
+          {"degreeZeroTerminals", engine.getDegreeZeroTerminals()},
+          {"degreeOneTerminals", engine.getDegreeOneTerminals()},
+          {"dynamicDegreeZero", engine.getDynamicDegreeZero()},
+          {"dynamicDegreeOne", engine.getDynamicDegreeOne()},
+          {"idleXRemoved", engine.getIdleXRemoved()},
+          {"edgeRootsFiltered", engine.getEdgeRootsFiltered()},
+          {"ownedEdgeNodes", engine.getOwnedEdgeNodes()},
+          {"maxEdgeRootP", engine.getMaxEdgeRootP()}};
+}
+
+// Totals, histogram and the three counters every engine has.
+template <typename Engine>
+void collectTotals(const Engine &engine, EnumerationResult &result) {
+  result.cliqueCount = engine.getCliqueCount();
+  result.maxCliqueSize = static_cast<ui>(engine.getMaxCliqueSize());
+  result.checks = engine.getChecksCount();
+  result.sizeHistogram = engine.getCliqueSizeHistogram();
+  result.counters = {{"cliques", result.cliqueCount},
+                     {"maxSize", result.maxCliqueSize},
+                     {"checks", result.checks}};
+}
+
+// Builds the engine with its summary line muted and runs search(engine),
+// timing both halves.
+template <typename Engine, typename Build, typename Search>
+void runTimed(EnumerationResult &result, Build build, Search search) {
+  const auto setupStart = Clock::now();
+  Engine engine = build();
+  engine.setSummaryOutput(false);
+  result.setupMs = elapsedMs(setupStart);
+  const auto searchStart = Clock::now();
+  search(engine);
+  result.searchMs = elapsedMs(searchStart);
+  collectTotals(engine, result);
+}
+
+// Copies the completed roots of a run the budget cut short.
+template <typename Engine>
+void collectCompletedRoots(const Engine &engine, const SearchBudget *budget,
+                           EnumerationResult &result) {
+  if (budget != nullptr && budget->isExhausted())
+    result.completedRoots = engine.getCompletedRoots();
+}
+
+template <typename Engine>
+void runRootEngine(Graph &g, const EnumerationOptions &options,
+                   SearchBudget *budget, EnumerationResult &result) {
+  runTimed<Engine>(
+      result, [&] { return Engine(g); },
+      [&](Engine &engine) {
+        engine.setRootCostRecorder(options.rootCosts);
+        engine.setRootSchedule(options.rootSchedule);
+        engine.setSearchBudget(budget);
+        engine.findAllMaximalCliques();
+        collectCompletedRoots(engine, budget, result);
+      });
+}
+
+void runFastList(Graph &g, const EnumerationOptions &options,
+                 const FastCliqueSink &sink, SearchBudget *budget,
+                 EnumerationResult &result) {
+  const auto setupStart = Clock::now();
+  const bool hybrid = options.engine == EnumerationEngine::HYBRID_REORDER;
+  const bool edgeRoots = options.engine == EnumerationEngine::EDGE_FAST_LIST;
+  std::unique_ptr<TrussDecomposition> truss;
+  double trussMs = 0;
+  if (edgeRoots) {
+    g.sortAdjacency();
+    const auto trussStart = Clock::now();
+    truss =
+        std::make_unique<TrussDecomposition>(computeTrussDecomposition(g));
+    trussMs = elapsedMs(trussStart);
+  }
+  FastListBK engine(g, hybrid, options.minCliqueSize);
+  engine.setSummaryOutput(false);
+  if (sink)
+    engine.setCliqueSink(sink);
+  if (!hybrid && !edgeRoots) {
+    engine.setRootCostRecorder(options.rootCosts);
+    engine.setRootSchedule(options.rootSchedule);
+  }
+  engine.setSearchBudget(budget);
+  result.setupMs = elapsedMs(setupStart);
+
+  const auto searchStart = Clock::now();
+  if (edgeRoots) {
+    engine.findAllMaximalCliquesFromEdges(*truss);
+  } else {
+    engine.findAllMaximalCliques();
+    collectCompletedRoots(engine, budget, result);
+  }
+  result.searchMs = elapsedMs(searchStart);
+  result.cliqueCount = engine.getCliqueCount();
+  result.maxCliqueSize = engine.getMaxCliqueSize();
+  result.checks = engine.getChecksCount();
+  result.sizeHistogram = engine.getCliqueSizeHistogram();
+  result.counters = fastListCounters(engine);
+  if (edgeRoots) {
+    result.counters.emplace_back("maxTruss", truss->maxTruss);
+    result.counters.emplace_back("trussUs",
+                                 static_cast<ull>(trussMs * 1000.0));
+  }
+}
+
+void runPureReorder(Graph &g, const EnumerationOptions &options,
+                    const FastCliqueSink &sink, SearchBudget *budget,
+                    EnumerationResult &result) {
+  ull duplicates = 0;
+  ull budgetFallbacks = 0;
+  runTimed<ReorderSib>(
+      result,
+      [&] {
+        return ReorderSib(g, options.order, options.method, UINT_MAX, true,
+                          true, true, true, true, true, true, true,
+                          options.minCliqueSize);
+      },
+      [&](ReorderSib &engine) {
+        engine.setSolverWorkBudget(options.solverWorkBudget);
+        engine.setSearchBudget(budget);
+        engine.findAllMaximalCliquesPure();
+        collectCompletedRoots(engine, budget, result);
+        duplicates = engine.getDuplicateCount();
+        budgetFallbacks = engine.getSolverBudgetFallbacks();
+        if (sink) {
+          for (const vector<ui> &clique : engine.getCliques())
+            sink(clique);
+        }
+      });
+  result.counters.emplace_back("duplicates", duplicates);
+  result.counters.emplace_back("budgetFallbacks", budgetFallbacks);
+}
+
+void runKCliques(Graph &g, const EnumerationOptions &options,
+                 const FastCliqueSink &sink, SearchBudget *budget,
+                 EnumerationResult &result) {
+  const auto setupStart = Clock::now();
+  KCliqueLister lister(g, options.minCliqueSize);
+  lister.setSummaryOutput(false);
+  if (options.threads != 0)
+    lister.setThreadCount(options.threads);
+  if (sink)
+    lister.setCliqueSink(sink);
+  lister.setRootCostRecorder(options.rootCosts);
+  lister.setRootSchedule(options.rootSchedule);
+  lister.setSearchBudget(budget);
+  result.setupMs = elapsedMs(setupStart);
+
+  const auto searchStart = Clock::now();
+  lister.listAllCliques();
+  collectCompletedRoots(lister, budget, result);
+  result.searchMs = elapsedMs(searchStart);
+  result.cliqueCount = lister.getCliqueCount();
+  result.maxCliqueSize = result.cliqueCount == 0 ? 0 : options.minCliqueSize;
+  result.sizeHistogram.clear();
+  addCliqueSizeCountOrThrow(result.sizeHistogram, options.minCliqueSize,
+                            result.cliqueCount);
+  result.counters = {{"cliques", result.cliqueCount},
+                     {"degeneracy", lister.getDegeneracy()},
+                     {"bitsetRoots", lister.getBitsetRoots()},
+                     {"listRoots", lister.getListRoots()}};
+}
+
+} // namespace
+
+const char *enumerationEngineName(EnumerationEngine engine) {
+  const int index = static_cast<int>(engine);
+  return index >= 0 && index < ENGINE_COUNT ? ENGINE_NAMES[index] : "unknown";
+}
+
+EnumerationEngine parseEnumerationEngine(const std::string &text) {
+  for (int index = 0; index < ENGINE_COUNT; ++index) {
+    if (text == ENGINE_NAMES[index] || text == std::to_string(index))
+      return static_cast<EnumerationEngine>(index);
+  }
+  throw std::invalid_argument("unknown engine: " + text);
+}
+
+EnumerationResult enumerateCliques(Graph &g, const EnumerationOptions &options,
+                                   const FastCliqueSink &sink) {
+  validateOptions(options, sink);
+  // The clock starts here, so setup counts against the wall-time limit.
+  std::unique_ptr<SearchBudget> budget;
+  if (options.budget.any())
+    budget = std::make_unique<SearchBudget>(options.budget);
+  SearchBudget *searchBudget = budget.get();
+
+  EnumerationResult result;
+  switch (options.engine) {
+  case EnumerationEngine::PIVOT:
+    runTimed<PivotBK>(
+        result, [&] { return PivotBK(g, options.order); },
+        [&](PivotBK &engine) {
+          engine.setSearchBudget(searchBudget);
+          engine.findAllMaximalCliques();
+        });
+    break;
+  case EnumerationEngine::BITSET:
+    runRootEngine<BitsetBK>(g, options, searchBudget, result);
+    break;
+  case EnumerationEngine::LOCAL_BITSET:
+    runRootEngine<LocalBitsetBK>(g, options, searchBudget, result);
+    break;
+  case EnumerationEngine::ADAPTIVE:
+    if (adaptiveUsesBitsetBK(g))
+      runRootEngine<BitsetBK>(g, options, searchBudget, result);
+    else
+      runRootEngine<LocalBitsetBK>(g, options, searchBudget, result);
+    break;
+  case EnumerationEngine::HYBRID_REORDER:
+  case EnumerationEngine::FAST_LIST:
+  case EnumerationEngine::EDGE_FAST_LIST:
+    runFastList(g, options, sink, searchBudget, result);
+    break;
+  case EnumerationEngine::PURE_REORDER:
+    runPureReorder(g, options, sink, searchBudget, result);
+    break;
+  case EnumerationEngine::K_CLIQUES:
+    runKCliques(g, options, sink, searchBudget, result);
+    break;
+  default:
+    throw std::invalid_argument("unknown engine");
+  }
+  if (budget != nullptr && budget->isExhausted()) {
+    result.complete = false;
+    result.stopReason = budget->getStop();
+  }
+  return result;
+}
@@ -0,0 +1,216 @@
+#include "../inc/component_dispatch.h"
+#include "../inc/helpers.h"
+#include "../inc/parallel_for.h"
+
+namespace {
+constexpr ui MIN_CLIQUE_VERTICES = 3;
+
+bool componentIsBipartite(const Graph &g) {
+  vector<int> color(g.n, -1);
+  vector<ui> queue;
+  queue.reserve(g.n);
+  color[0] = 0;
+  queue.push_back(0);
+  for (size_t head = 0; head < queue.size(); ++head) {
+    const ui u = queue[head];
+    for (ui at = g.offset[u]; at < g.offset[u + 1]; ++at) {
+      const ui v = g.neighbors[at];
+      if (color[v] == -1) {
+        color[v] = color[u] ^ 1;
+        queue.push_back(v);
+      } else if (color[v] == color[u]) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Closed forms for a connected component with at least three vertices.
+// Returns false when the component needs a search engine.
+bool solveComponentClosedForm(const Graph &g, ComponentDispatchResult &out) {
+  const ull n = g.n;
+  if (static_cast<ull>(g.m) * 2 == n * (n - 1)) {
+    addCliqueCountOrThrow(out.cliqueCount, 1);
+    addCliqueSizeCountOrThrow(out.cliqueSizeHistogram, g.n, 1);
+    out.maxCliqueSize = max(out.maxCliqueSize, g.n);
+    return true;
+  }
+  // A connected max-degree-two graph is a path or a cycle; the only one with
+  // a triangle is K3, handled above. Bipartite graphs are triangle-free.
+  ui maxDegree = 0;
+  for (ui d : g.degree)
+    maxDegree = max(maxDegree, d);
+  return maxDegree <= 2 || componentIsBipartite(g);
+}
+} // namespace
+
+ui labelConnectedComponents(const Graph &g, vector<ui> &componentOf) {
+  componentOf.assign(g.n, UINT_MAX);
+  vector<ui> queue;
+  queue.reserve(g.n);
+  ui count = 0;
+  for (ui start = 0; start < g.n; ++start) {
+    if (componentOf[start] != UINT_MAX)
+      continue;
+    componentOf[start] = count;
+    queue.clear();
+    queue.push_back(start);
+    for (size_t head = 0; head < queue.size(); ++head) {
+      const ui u = queue[head];
+      for (ui at = g.offset[u]; at < g.offset[u + 1]; ++at) {
+        const ui v = g.neighbors[at];
+        if (componentOf[v] == UINT_MAX) {
+          componentOf[v] = count;
+          queue.push_back(v);
+        }
+      }
+    }
+    ++count;
+  }
+  return count;
+}
+
+vector<GraphComponent> buildComponentGraphs(const Graph &g,
+                                            const vector<ui> &componentOf,
+                                            ui componentCount,
+                                            ui minVertices) {
+  vector<ui> sizes(componentCount, 0);
+  for (ui c : componentOf)
+    ++sizes[c];
+
+  vector<ui> slot(componentCount, UINT_MAX);
+  vector<GraphComponent> components;
+  for (ui c = 0; c < componentCount; ++c) {
+    if (sizes[c] >= minVertices) {
+      slot[c] = static_cast<ui>(components.size());
+      components.emplace_back();
+      components.back().vertices.reserve(sizes[c]);
+    }
+  }
+
+  // Local ids follow original ids, so each row keeps its CSR order (and
+  // sortedness) and the component CSR is filled directly.
+  vector<ui> local(g.n, 0);
+  for (ui v = 0; v < g.n; ++v) {
+    const ui s = slot[componentOf[v]];
+    if (s == UINT_MAX)
+      continue;
+    GraphComponent &component = components[s];
+    local[v] = static_cast<ui>(component.vertices.size());
+    component.vertices.push_back(v);
+    component.graph.degree.push_back(g.degree[v]);
+  }
+  for (GraphComponent &component : components) {
+    Graph &cg = component.graph;
+    cg.n = static_cast<ui>(component.vertices.size());
+    cg.offset.assign(cg.n + 1, 0);
+    for (ui i = 0; i < cg.n; ++i)
+      cg.offset[i + 1] = cg.offset[i] + cg.degree[i];
+    cg.neighbors.resize(cg.offset[cg.n]);
+    cg.m = cg.offset[cg.n] / 2;
+    cg.adjacencySorted = g.adjacencySorted;
+  }
+  for (ui u = 0; u < g.n; ++u) {
+    const ui s = slot[componentOf[u]];
+    if (s == UINT_MAX)
+      continue;
+    Graph &cg = components[s].graph;
+    ui *row = cg.neighbors.data() + cg.offset[local[u]];
+    for (ui at = g.offset[u]; at < g.offset[u + 1]; ++at)
+      *row++ = local[g.neighbors[at]];
+  }
+  return components;
+}
+
+bool solveAdaptiveByComponents(const Graph &g, unsigned threads,
+                               ComponentDispatchResult &result) {
+  result = ComponentDispatchResult{};
+  vector<ui> componentOf;
+  const ui count = labelConnectedComponents(g, componentOf);
+  if (count < 2)
+    return false;
+  vector<ui> sizes(count, 0);
+  vector<ull> edgeEnds(count, 0);
+  for (ui v = 0; v < g.n; ++v) {
+    ++sizes[componentOf[v]];
+    edgeEnds[componentOf[v]] += g.degree[v];
+  }
+  ui searchable = 0;
+  ull largestEdgeEnds = 0;
+  for (ui c = 0; c < count; ++c) {
+    searchable += sizes[c] >= MIN_CLIQUE_VERTICES;
+    largestEdgeEnds = max(largestEdgeEnds, edgeEnds[c]);
+  }
+  // A giant component would run alone on the same engine mode 4 picks for
+  // the whole graph, so the split would only add copying.
+  if (searchable < 2 || largestEdgeEnds * 4 >= static_cast<ull>(g.m) * 2 * 3)
+    return false;
+
+  vector<GraphComponent> components =
+      buildComponentGraphs(g, componentOf, count, MIN_CLIQUE_VERTICES);
+  result.components = count;
+  result.trivialComponents = count - components.size();
+
+  vector<ui> pending;
+  for (ui i = 0; i < components.size(); ++i) {
+    if (solveComponentClosedForm(components[i].graph, result))
+      ++result.closedFormComponents;
+    else
+      pending.push_back(i);
+  }
+  // Largest first, so the heaviest component does not start last.
+  sort(pending.begin(), pending.end(), [&](ui a, ui b) {
+    const Graph &ga = components[a].graph;
+    const Graph &gb = components[b].graph;
+    if (ga.m != gb.m)
+      return ga.m > gb.m;
+    return ga.n > gb.n;
+  });
+
+  if (threads == 0)
+    threads = 1;
+  vector<ComponentDispatchResult> partial(
+      min<size_t>(threads, max<size_t>(pending.size(), 1)));
+  parallelFor(pending.size(), static_cast<unsigned>(partial.size()), 1,
+              [&](unsigned worker, size_t index) {
+                Graph &component = components[pending[index]].graph;
+                ComponentDispatchResult &out = partial[worker];
+                if (adaptiveUsesBitsetBK(component)) {
+                  BitsetBK engine(component);
+                  engine.setSummaryOutput(false);
+                  engine.findAllMaximalCliques();
+                  addCliqueCountOrThrow(out.cliqueCount,
+                                        engine.getCliqueCount());
+                  mergeCliqueSizeHistogramOrThrow(
+                      out.cliqueSizeHistogram,
+                      engine.getCliqueSizeHistogram());
+                  out.maxCliqueSize =
+                      max(out.maxCliqueSize, engine.getMaxCliqueSize());
+                  ++out.bitsetComponents;
+                } else {
+                  LocalBitsetBK engine(component);
+                  engine.setSummaryOutput(false);
+                  engine.findAllMaximalCliques();
+                  addCliqueCountOrThrow(out.cliqueCount,
+                                        engine.getCliqueCount());
+                  mergeCliqueSizeHistogramOrThrow(
+                      out.cliqueSizeHistogram,
+                      engine.getCliqueSizeHistogram());
+                  out.maxCliqueSize =
+                      max(out.maxCliqueSize, engine.getMaxCliqueSize());
+                  ++out.localBitsetComponents;
+                }
+              });
+
+  for (const ComponentDispatchResult &part : partial) {
+    addCliqueCountOrThrow(result.cliqueCount, part.cliqueCount);
+    mergeCliqueSizeHistogramOrThrow(result.cliqueSizeHistogram,
+                                    part.cliqueSizeHistogram);
+    result.maxCliqueSize = max(result.maxCliqueSize, part.maxCliqueSize);
+    result.bitsetComponents += part.bitsetComponents;
+    result.localBitsetComponents += part.localBitsetComponents;
+  }
+  trimCliqueSizeHistogram(result.cliqueSizeHistogram);
+  return true;
+}
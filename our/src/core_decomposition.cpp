@@ -0,0 +1,141 @@
+#include "../inc/core_decomposition.h"
+#include "../inc/graph.h"
+#include "../inc/parallel_for.h"
+#include "../inc/perf_counters.h"
+
+namespace {
+
+void serialPeel(const Graph &graph, CoreDecomposition &result) {
+  const ui n = graph.n;
+  vector<ui> degree(graph.degree.begin(), graph.degree.end());
+  ui maxDegree = 0;
+  for (ui d : degree)
+    maxDegree = max(maxDegree, d);
+
+  // Matula-Beck bin peeling with the tie order the engines were tuned on.
+  vector<ui> bin(maxDegree + 1, 0);
+  vector<ui> position(n);
+  vector<ui> &vertices = result.peelOrder;
+  for (ui d : degree)
+    ++bin[d];
+  ui start = 0;
+  for (ui d = 0; d <= maxDegree; ++d) {
+    const ui count = bin[d];
+    bin[d] = start;
+    start += count;
+  }
+  for (ui u = 0; u < n; ++u) {
+    position[u] = bin[degree[u]]++;
+    vertices[position[u]] = u;
+  }
+  for (ui d = maxDegree; d > 0; --d)
+    bin[d] = bin[d - 1];
+  bin[0] = 0;
+
+  for (ui i = 0; i < n; ++i) {
+    const ui u = vertices[i];
+    result.core[u] = degree[u];
+    result.degeneracy = max(result.degeneracy, degree[u]);
+    for (ui at = graph.offset[u]; at < graph.offset[u + 1]; ++at) {
+      const ui v = graph.neighbors[at];
+      if (degree[v] > degree[u]) {
+        const ui dv = degree[v];
+        const ui pv = position[v];
+        const ui pw = bin[dv];
+        const ui w = vertices[pw];
+        if (v != w) {
+          position[v] = pw;
+          position[w] = pv;
+          vertices[pv] = w;
+          vertices[pw] = v;
+        }
+        ++bin[dv];
+        --degree[v];
+      }
+    }
+  }
+}
+
+// Level-synchronous peel. A round removes its frontier at once: a frontier
+// vertex lowers only the degrees of live neighbors outside the frontier, and
+// never below the level, so a vertex joins the next round exactly when its
+// degree falls from level + 1 to level.
+void frontierPeel(const Graph &graph, CoreDecomposition &result) {
+  const ui n = graph.n;
+  const unsigned threads = max(1u, configuredThreadCount());
+  constexpr unsigned char LIVE = 0, FRONTIER = 1, PEELED = 2;
+  vector<ui> degree(graph.degree.begin(), graph.degree.end());
+  vector<unsigned char> state(n, LIVE);
+  vector<ui> live(n);
+  for (ui u = 0; u < n; ++u)
+    live[u] = u;
+  vector<ui> frontier;
+  vector<vector<ui>> nextByWorker(threads);
+  result.peelOrder.clear();
+
+  while (!live.empty()) {
+    ui level = UINT_MAX;
+    for (ui u : live)
+      level = min(level, degree[u]);
+    frontier.clear();
+    for (ui u : live) {
+      if (degree[u] == level)
+        frontier.push_back(u);
+    }
+    result.degeneracy = max(result.degeneracy, level);
+
+    while (!frontier.empty()) {
+      sort(frontier.begin(), frontier.end());
+      for (ui u : frontier)
+        state[u] = FRONTIER;
+      parallelFor(frontier.size(), threads, 256,
+                  [&](unsigned worker, size_t index) {
+        const ui u = frontier[index];
+        for (ui at = graph.offset[u]; at < graph.offset[u + 1]; ++at) {
+          const ui v = graph.neighbors[at];
+          if (state[v] != LIVE ||
+              __atomic_load_n(&degree[v], __ATOMIC_RELAXED) <= level)
+            continue;
+          const ui before = __atomic_fetch_sub(&degree[v], 1, __ATOMIC_RELAXED);
+          if (before == level + 1)
+            nextByWorker[worker].push_back(v);
+          else if (before <= level)
+            __atomic_fetch_add(&degree[v], 1, __ATOMIC_RELAXED);
+        }
+      });
+
+      for (ui u : frontier) {
+        state[u] = PEELED;
+        result.core[u] = level;
+        result.peelOrder.push_back(u);
+      }
+      frontier.clear();
+      for (vector<ui> &next : nextByWorker) {
+        frontier.insert(frontier.end(), next.begin(), next.end());
+        next.clear();
+      }
+    }
+
+    live.erase(remove_if(live.begin(), live.end(),
+                         [&](ui u) { return state[u] == PEELED; }),
+               live.end());
+  }
+}
+
+} // namespace
+
+CoreDecomposition computeCoreDecomposition(const Graph &graph) {
+  static const PerfRegion orderingPerfRegion("ordering", false);
+  ScopedPerfRegion perf(orderingPerfRegion);
+  CoreDecomposition result;
+  result.peelOrder.resize(graph.n);
+  result.core.assign(graph.n, 0);
+  if (graph.n < PARALLEL_CORE_MIN_VERTICES)
+    serialPeel(graph, result);
+  else
+    frontierPeel(graph, result);
+  result.rank.resize(graph.n);
+  for (ui i = 0; i < graph.n; ++i)
+    result.rank[result.peelOrder[i]] = i;
+  return result;
+}
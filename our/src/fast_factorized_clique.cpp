@@ -0,0 +1,172 @@
+#include "../inc/fast_factorized_clique.h"
+#include "../inc/checked_count.h"
+
+#include <algorithm>
+
+FastFactorizedExpander::FastFactorizedExpander(
+    const FastFactorizedCliques &factorized)
+    : record(factorized), pairChoice(factorized.pairs.size(), 0),
+      started(false), exhausted(false) {
+  cursors.resize(record.components.size());
+  for (size_t i = 0; i < cursors.size(); ++i) {
+    cursors[i].component = &record.components[i];
+    cursors[i].selected.assign(record.components[i].vertices.size(), 0);
+  }
+}
+
+// The newest assignment may only be rejected by a vertex that can no longer
+// gain a selected neighbor: an internal zero between two zeros, or a zero
+// path endpoint followed by a zero. Wraparound vertices of a cycle are checked
+// once the selection is complete.
+bool FastFactorizedExpander::prefixIsFeasible(const ComponentCursor &cursor) {
+  const std::vector<unsigned char> &selected = cursor.selected;
+  const size_t at = cursor.assigned;
+  if (at >= 3 && selected[at - 1] == 0 && selected[at - 2] == 0 &&
+      selected[at - 3] == 0)
+    return false;
+  if (at == 2 && !cursor.component->cycle && selected[0] == 0 &&
+      selected[1] == 0)
+    return false;
+  return true;
+}
+
+bool FastFactorizedExpander::selectionIsMaximal(
+    const ComponentCursor &cursor) {
+  const std::vector<unsigned char> &selected = cursor.selected;
+  const bool cycle = cursor.component->cycle;
+  const size_t length = selected.size();
+  if (cycle && selected.front() != 0 && selected.back() != 0)
+    return false;
+  for (size_t i = 0; i < length; ++i) {
+    if (selected[i] != 0)
+      continue;
+    const bool left =
+        i != 0 ? selected[i - 1] != 0 : cycle && selected.back() != 0;
+    const bool right = i + 1 != length ? selected[i + 1] != 0
+                                       : cycle && selected.front() != 0;
+    if (!left && !right)
+      return false;
+  }
+  return true;
+}
+
+// Iterative depth-first search over independent selections, trying 0 before
+// 1 at every position. resume=false yields the first maximal independent set;
+// resume=true backtracks from the current leaf to the next one.
+bool FastFactorizedExpander::advanceCursor(ComponentCursor &cursor,
+                                           bool resume) {
+  std::vector<unsigned char> &selected = cursor.selected;
+  const size_t length = selected.size();
+  if (!resume)
+    cursor.assigned = 0;
+  bool backtrack = resume;
+
+  for (;;) {
+    if (backtrack) {
+      bool switched = false;
+      while (cursor.assigned != 0) {
+        const size_t at = --cursor.assigned;
+        if (selected[at] == 0 && (at == 0 || selected[at - 1] == 0)) {
+          selected[at] = 1;
+          ++cursor.assigned;
+          switched = true;
+          break;
+        }
+        selected[at] = 0;
+      }
+      if (!switched)
+        return false;
+      backtrack = !prefixIsFeasible(cursor);
+      continue;
+    }
+
+    if (cursor.assigned == length) {
+      if (selectionIsMaximal(cursor))
+        return true;
+      backtrack = true;
+      continue;
+    }
+
+    selected[cursor.assigned++] = 0;
+    backtrack = !prefixIsFeasible(cursor);
+  }
+}
+
+// Advances the mixed-radix product of pair choices and component selections
+// with the last factor varying fastest.
+bool FastFactorizedExpander::advanceProduct() {
+  for (size_t i = cursors.size(); i-- != 0;) {
+    if (advanceCursor(cursors[i], true))
+      return true;
+    advanceCursor(cursors[i], false);
+  }
+  for (size_t i = pairChoice.size(); i-- != 0;) {
+    if (pairChoice[i] == 0) {
+      pairChoice[i] = 1;
+      return true;
+    }
+    pairChoice[i] = 0;
+  }
+  return false;
+}
+
+size_t FastFactorizedExpander::selectedSize() const {
+  size_t size =
+      record.prefix.size() + record.forced.size() + record.pairs.size();
+  for (const ComponentCursor &cursor : cursors)
+    size += static_cast<size_t>(
+        std::count(cursor.selected.begin(), cursor.selected.end(), 1));
+  return size;
+}
+
+bool FastFactorizedExpander::next(std::vector<ui> &clique) {
+  if (exhausted)
+    return false;
+
+  // Product members below the record threshold are skipped here; the
+  // record's cliqueCount already excludes them.
+  for (;;) {
+    if (!started) {
+      started = true;
+      for (ComponentCursor &cursor : cursors) {
+        if (!advanceCursor(cursor, false)) {
+          exhausted = true;
+          return false;
+        }
+      }
+    } else if (!advanceProduct()) {
+      exhausted = true;
+      return false;
+    }
+    if (selectedSize() >= record.minCliqueSize)
+      break;
+  }
+
+  clique.clear();
+  clique.insert(clique.end(), record.prefix.begin(), record.prefix.end());
+  clique.insert(clique.end(), record.forced.begin(), record.forced.end());
+  for (size_t i = 0; i < record.pairs.size(); ++i)
+    clique.push_back(pairChoice[i] == 0 ? record.pairs[i].first
+                                        : record.pairs[i].second);
+  for (const ComponentCursor &cursor : cursors) {
+    const std::vector<ui> &vertices = cursor.component->vertices;
+    for (size_t i = 0; i < vertices.size(); ++i)
+      if (cursor.selected[i] != 0)
+        clique.push_back(vertices[i]);
+  }
+  std::sort(clique.begin(), clique.end());
+  return true;
+}
+
+ull expandFactorizedCliques(const FastFactorizedCliques &record,
+                            const FastCliqueSink &cliqueSink) {
+  FastFactorizedExpander expander(record);
+  std::vector<ui> clique;
+  ull expanded = 0;
+  while (expander.next(clique)) {
+    addCliqueCountOrThrow(expanded, 1);
+    if (cliqueSink)
+      cliqueSink(clique);
+  }
+  return expanded;
+}
@@ -1,9 +1,45 @@
 #include "../inc/fast_list_bk.h"
 #include "../inc/fast_local_bitset.h"
 #include "../inc/fast_plex3.h"
+#include "../inc/perf_counters.h"
+#include "../inc/runtime_counters.h"
 
 #include <chrono>
 #include <iomanip>
+#include <stdexcept>
+
+namespace {
+struct FastListCounters {
+  EngineRunCounters run{"fastlist"};
+  RuntimeTimer selectPortfolio{"fastlist.select_portfolio"};
+  RuntimeCounter siblingEvents{"fastlist.sibling_events"};
+  RuntimeCounter siblingBranchesBefore{"fastlist.sibling_branches_before"};
+  RuntimeCounter siblingBranchesAfter{"fastlist.sibling_branches_after"};
+  RuntimeCounter tinyKernelCalls{"fastlist.tiny_kernel_calls"};
+  RuntimeCounter localBitsetHandoffs{"fastlist.local_bitset_handoffs"};
+  RuntimeCounter localBitsetChecks{"fastlist.local_bitset_checks"};
+  RuntimeCounter plex3Terminals{"fastlist.plex3_terminals"};
+  RuntimeCounter plex3Cliques{"fastlist.plex3_cliques"};
+  RuntimeCounter xDominanceRemoved{"fastlist.x_dominance_removed"};
+  RuntimeCounter universalPForces{"fastlist.universal_p_forces"};
+  RuntimeCounter degreeZeroTerminals{"fastlist.degree0_terminals"};
+  RuntimeCounter degreeOneTerminals{"fastlist.degree1_terminals"};
+  RuntimeCounter dynamicDegreeZero{"fastlist.dynamic_degree0"};
+  RuntimeCounter dynamicDegreeOne{"fastlist.dynamic_degree1"};
+  RuntimeCounter idleXRemoved{"fastlist.idle_x_removed"};
+  RuntimeCounter edgeRootsFiltered{"fastlist.edge_roots_filtered"};
+  RuntimeCounter ownedEdgeNodes{"fastlist.owned_edge_nodes"};
+  // Hardware counter regions of the enumerate() lane; the baseline
+  // recursion stays unmeasured.
+  PerfRegion searchPerf{"fastlist.search", false};
+  PerfRegion pivotPerf{"fastlist.pivot", true};
+  PerfRegion intersectPerf{"fastlist.intersect", true};
+  PerfRegion tinyPerf{"fastlist.tiny", true};
+  PerfRegion plex3Perf{"fastlist.plex3", true};
+  PerfRegion localBitsetPerf{"fastlist.local_bitset", true};
+};
+const FastListCounters fastListCounters;
+} // namespace
 
 #ifdef FASTLIST_OPPORTUNITY_PROFILE
 namespace {
@@ -124,128 +160,106 @@ void FastListBK::profileXDominance(ui depth, const Level &level) {
   profile.xDomNodesWithRemoval += removed != 0;
 }
 
-void FastListBK::printOpportunityProfile() const {
-  std::cout << "OPROF_META"
-            << " nodes=" << checksCount
-            << " degeneracy=" << degeneracy
-            << " sibling=" << hybridReorderSibling << std::endl;
-  std::cout << "OPROF_GLOBAL"
-            << " degree0=" << profile.graphDegree0
-            << " degree1=" << profile.graphDegree1
-            << " degree2=" << profile.graphDegree2
-            << " edges=" << profile.graphUndirectedEdges
-            << " nontriangle_edges=" << profile.graphNonTriangleEdges
-            << " nontriangle_probes=" << profile.graphNonTriangleProbes
-            << std::endl;
-  std::cout << "OPROF_TERMINALS"
-            << " leaf_maximal=" << profile.leafMaximal
-            << " leaf_blocked_x=" << profile.leafBlockedX
-            << " x_universal=" << profile.xUniversalPrune
-            << " p_clique=" << profile.pCliqueSolved
-            << " matching=" << profile.matchingSolved
-            << " matching_overflow=" << profile.matchingOverflowFallback
-            << " tiny_nodes=" << profile.tinyKernelNodes
-            << " tiny_cliques=" << profile.tinyKernelCliques
-            << " ordinary_nodes=" << profile.ordinaryBranchNodes
-            << " ordinary_branches=" << profile.ordinaryBranchVertices
-            << " ordinary_tiny3=" << profile.ordinaryTiny3Nodes << std::endl;
-  std::cout << "OPROF_RULES"
-            << " d0_nodes=" << profile.pDeg0Nodes
-            << " d0_vertices=" << profile.pDeg0Vertices
-            << " d0_outside_tiny3=" << profile.pDeg0OutsideTiny3
-            << " d1_nodes=" << profile.pDeg1Nodes
-            << " d1_vertices=" << profile.pDeg1Vertices
-            << " d1_outside_tiny3=" << profile.pDeg1OutsideTiny3
-            << " universal_nodes=" << profile.universalPNodes
-            << " universal_vertices=" << profile.universalPVertices
-            << " universal_outside_tiny3="
-            << profile.universalPOutsideTiny3 << std::endl;
-  std::cout << "OPROF_PLEX3"
-            << " nodes=" << profile.plex3Nodes
-            << " p_vertices=" << profile.plex3PVertices
-            << " complement_edges=" << profile.plex3ComplementEdges
-            << " topmost_nodes=" << profile.plex3TopmostNodes
-            << " descendant_checks=" << profile.plex3DescendantChecks
-            << " descendant_cliques=" << profile.plex3DescendantCliques
-            << " descendant_pivot_items="
-            << profile.plex3DescendantPivotItems
-            << " subtree_intersect_items="
-            << profile.plex3SubtreeIntersectItems << std::endl;
-  std::cout << "OPROF_PIVOT"
-            << " candidates_x=" << profile.pivotCandidatesX
-            << " candidates_p=" << profile.pivotCandidatesP
-            << " hash_items_x=" << profile.pivotHashItemsX
-            << " hash_items_p=" << profile.pivotHashItemsP
-            << " csr_items_x=" << profile.pivotCsrItemsX
-            << " csr_items_p=" << profile.pivotCsrItemsP
-            << " abortable_x=" << profile.pivotAbortableX
-            << " abortable_p=" << profile.pivotAbortableP
-            << " abort_saved_x=" << profile.pivotAbortSavedX
-            << " abort_saved_p=" << profile.pivotAbortSavedP
-            << " naude_width2_nodes=" << profile.naudeWidth2Nodes
-            << " naude_tail_candidates=" << profile.naudeTailCandidates
-            << " naude_tail_items=" << profile.naudeTailItems
-            << " p_improved_nodes=" << profile.pImprovedPivotNodes
-            << " winner_x=" << profile.pivotWinnerX
-            << " winner_p=" << profile.pivotWinnerP << std::endl;
-  std::cout << "OPROF_INTERSECT"
-            << " hash_calls=" << profile.intersectHashCalls
-            << " hash_items=" << profile.intersectHashItems
-            << " csr_calls=" << profile.intersectCsrCalls
-            << " csr_items=" << profile.intersectCsrItems << std::endl;
-  std::cout << "OPROF_XDOM"
-            << " eligible_small_nodes=" << profile.xDomEligibleSmallNodes
-            << " sampled_nodes=" << profile.xDomSampledNodes
-            << " warmup_nodes=" << profile.xDomWarmupNodes
-            << " nodes_with_removal=" << profile.xDomNodesWithRemoval
-            << " x_before=" << profile.xDomBefore
-            << " x_removed=" << profile.xDomRemoved
-            << " subset_tests=" << profile.xDomSubsetTests
-            << " random_sample_rate=8192"
-            << " state_limit=64" << std::endl;
+void FastListBK::reportOpportunityProfile() const {
+  if (!countersEnabled())
+    return;
+  CounterShard &shard = localCounterShard();
+  auto add = [&](const std::string &name, ull value) {
+    shard.values[registerCounter("fastlist.profile." + name, false)] += value;
+  };
+  add("global.degree0", profile.graphDegree0);
+  add("global.degree1", profile.graphDegree1);
+  add("global.degree2", profile.graphDegree2);
+  add("global.edges", profile.graphUndirectedEdges);
+  add("global.nontriangle_edges", profile.graphNonTriangleEdges);
+  add("global.nontriangle_probes", profile.graphNonTriangleProbes);
+  add("terminals.leaf_maximal", profile.leafMaximal);
+  add("terminals.leaf_blocked_x", profile.leafBlockedX);
+  add("terminals.x_universal", profile.xUniversalPrune);
+  add("terminals.p_clique", profile.pCliqueSolved);
+  add("terminals.matching", profile.matchingSolved);
+  add("terminals.matching_overflow", profile.matchingOverflowFallback);
+  add("terminals.tiny_nodes", profile.tinyKernelNodes);
+  add("terminals.tiny_cliques", profile.tinyKernelCliques);
+  add("terminals.ordinary_nodes", profile.ordinaryBranchNodes);
+  add("terminals.ordinary_branches", profile.ordinaryBranchVertices);
+  add("terminals.ordinary_tiny3", profile.ordinaryTiny3Nodes);
+  add("rules.d0_nodes", profile.pDeg0Nodes);
+  add("rules.d0_vertices", profile.pDeg0Vertices);
+  add("rules.d0_outside_tiny3", profile.pDeg0OutsideTiny3);
+  add("rules.d1_nodes", profile.pDeg1Nodes);
+  add("rules.d1_vertices", profile.pDeg1Vertices);
+  add("rules.d1_outside_tiny3", profile.pDeg1OutsideTiny3);
+  add("rules.universal_nodes", profile.universalPNodes);
+  add("rules.universal_vertices", profile.universalPVertices);
+  add("rules.universal_outside_tiny3", profile.universalPOutsideTiny3);
+  add("plex3.nodes", profile.plex3Nodes);
+  add("plex3.p_vertices", profile.plex3PVertices);
+  add("plex3.complement_edges", profile.plex3ComplementEdges);
+  add("plex3.topmost_nodes", profile.plex3TopmostNodes);
+  add("plex3.descendant_checks", profile.plex3DescendantChecks);
+  add("plex3.descendant_cliques", profile.plex3DescendantCliques);
+  add("plex3.descendant_pivot_items", profile.plex3DescendantPivotItems);
+  add("plex3.subtree_intersect_items", profile.plex3SubtreeIntersectItems);
+  add("pivot.candidates_x", profile.pivotCandidatesX);
+  add("pivot.candidates_p", profile.pivotCandidatesP);
+  add("pivot.hash_items_x", profile.pivotHashItemsX);
+  add("pivot.hash_items_p", profile.pivotHashItemsP);
+  add("pivot.csr_items_x", profile.pivotCsrItemsX);
+  add("pivot.csr_items_p", profile.pivotCsrItemsP);
+  add("pivot.abortable_x", profile.pivotAbortableX);
+  add("pivot.abortable_p", profile.pivotAbortableP);
+  add("pivot.abort_saved_x", profile.pivotAbortSavedX);
+  add("pivot.abort_saved_p", profile.pivotAbortSavedP);
+  add("pivot.naude_width2_nodes", profile.naudeWidth2Nodes);
+  add("pivot.naude_tail_candidates", profile.naudeTailCandidates);
+  add("pivot.naude_tail_items", profile.naudeTailItems);
+  add("pivot.p_improved_nodes", profile.pImprovedPivotNodes);
+  add("pivot.winner_x", profile.pivotWinnerX);
+  add("pivot.winner_p", profile.pivotWinnerP);
+  add("intersect.hash_calls", profile.intersectHashCalls);
+  add("intersect.hash_items", profile.intersectHashItems);
+  add("intersect.csr_calls", profile.intersectCsrCalls);
+  add("intersect.csr_items", profile.intersectCsrItems);
+  add("xdom.eligible_small_nodes", profile.xDomEligibleSmallNodes);
+  add("xdom.sampled_nodes", profile.xDomSampledNodes);
+  add("xdom.warmup_nodes", profile.xDomWarmupNodes);
+  add("xdom.nodes_with_removal", profile.xDomNodesWithRemoval);
+  add("xdom.x_before", profile.xDomBefore);
+  add("xdom.x_removed", profile.xDomRemoved);
+  add("xdom.subset_tests", profile.xDomSubsetTests);
 
   for (size_t i = 0; i < PROFILE_BUCKET_COUNT; ++i) {
-    std::cout << "OPROF_BUCKET"
-              << " bucket=" << i << " nodes=" << profile.stateNodes[i]
-              << " pivot_items=" << profile.pivotItems[i]
-              << " intersect_items=" << profile.intersectItems[i]
-              << std::endl;
+    const std::string bucket = "bucket" + std::to_string(i) + ".";
+    add(bucket + "nodes", profile.stateNodes[i]);
+    add(bucket + "pivot_items", profile.pivotItems[i]);
+    add(bucket + "intersect_items", profile.intersectItems[i]);
   }
   for (size_t i = 0; i < PROFILE_THRESHOLD_COUNT; ++i) {
-    const ull fullCovered =
-        profile.fullEligible[i] - profile.fullEmptyCrossings[i];
-    const ull partialCovered =
-        profile.partialEligible[i] - profile.partialEmptyCrossings[i];
-    std::cout << "OPROF_CUTOVER"
-              << " kind=full threshold=" << PROFILE_THRESHOLDS[i]
-              << " eligible=" << profile.fullEligible[i]
-              << " empty_crossings=" << profile.fullEmptyCrossings[i]
-              << " frontiers=" << profile.fullFrontiers[i]
-              << " descendant_calls="
-              << (fullCovered - profile.fullFrontiers[i])
-              << " frontier_p=" << profile.fullFrontierP[i]
-              << " frontier_x=" << profile.fullFrontierX[i]
-              << " cells=" << profile.fullCells[i]
-              << " words=" << profile.fullWords[i] << std::endl;
-    std::cout << "OPROF_CUTOVER"
-              << " kind=partial threshold=" << PROFILE_THRESHOLDS[i]
-              << " eligible=" << profile.partialEligible[i]
-              << " empty_crossings=" << profile.partialEmptyCrossings[i]
-              << " frontiers=" << profile.partialFrontiers[i]
-              << " descendant_calls="
-              << (partialCovered - profile.partialFrontiers[i])
-              << " frontier_p=" << profile.partialFrontierP[i]
-              << " frontier_x=" << profile.partialFrontierX[i]
-              << " cells=" << profile.partialCells[i]
-              << " words=" << profile.partialWords[i] << std::endl;
+    const std::string threshold = std::to_string(PROFILE_THRESHOLDS[i]);
+    const std::string full = "cutover_full" + threshold + ".";
+    add(full + "eligible", profile.fullEligible[i]);
+    add(full + "empty_crossings", profile.fullEmptyCrossings[i]);
+    add(full + "frontiers", profile.fullFrontiers[i]);
+    add(full + "frontier_p", profile.fullFrontierP[i]);
+    add(full + "frontier_x", profile.fullFrontierX[i]);
+    add(full + "cells", profile.fullCells[i]);
+    add(full + "words", profile.fullWords[i]);
+    const std::string partial = "cutover_partial" + threshold + ".";
+    add(partial + "eligible", profile.partialEligible[i]);
+    add(partial + "empty_crossings", profile.partialEmptyCrossings[i]);
+    add(partial + "frontiers", profile.partialFrontiers[i]);
+    add(partial + "frontier_p", profile.partialFrontierP[i]);
+    add(partial + "frontier_x", profile.partialFrontierX[i]);
+    add(partial + "cells", profile.partialCells[i]);
+    add(partial + "words", profile.partialWords[i]);
   }
   for (size_t p = 0; p <= 16; ++p) {
     for (size_t x = 0; x <= 16; ++x) {
       const ull nodes = profile.tinyPX[p * 17 + x];
       if (nodes != 0)
-        std::cout << "OPROF_TINYPX"
-                  << " p=" << p << " x=" << x << " nodes=" << nodes
-                  << std::endl;
+        add("tinypx.p" + std::to_string(p) + "_x" + std::to_string(x),
+            nodes);
     }
   }
 }
@@ -253,19 +267,34 @@ void FastListBK::printOpportunityProfile() const {
 
 FastListBK::FastListBK(const Graph &g, bool useHybridReorderSibling,
                        ui outputThreshold)
-    : graph(g), adjacency(g), rank(g.n), label(g.n, 0), degeneracy(0),
+    : graph(g), adjacency(g.adjacencyHash()), rank(g.n), label(g.n, 0), degeneracy(0),
       minCliqueSize(std::max<ui>(1, outputThreshold)), cliqueCount(0),
       maxCliqueSize(0), checksCount(0),
-      hybridReorderSibling(useHybridReorderSibling),
+      hybridReorderSibling(useHybridReorderSibling), summaryOutput(true),
       enableAdvancedRules(false), enableTailKernels(false),
-      enableLocalBitset(false),
+      enableLocalBitset(false), portfolioReady(false),
       siblingEventBudget(g.n < 50000 ? 8 : 64),
       siblingEvents(0), siblingBranchesBefore(0), siblingBranchesAfter(0),
       tinyKernelCalls(0), localBitsetHandoffs(0), localBitsetChecks(0),
       plex3Terminals(0), plex3Cliques(0), xDominanceRemoved(0),
-      universalPForces(0), degreeZeroTerminals(0), degreeOneTerminals(0) {}
+      universalPForces(0), degreeZeroTerminals(0), degreeOneTerminals(0),
+      dynamicDegreeZero(0), dynamicDegreeOne(0), idleXRemoved(0),
+      edgeRootsFiltered(0), ownedEdgeNodes(0), maxEdgeRootP(0),
+      traceWriter(nullptr), trace(nullptr), rootCosts(nullptr),
+      budget(nullptr) {}
 
 void FastListBK::emitClique(const std::vector<ui> &extension) const {
+  if (factorizedSink) {
+    FastFactorizedCliques record;
+    record.prefix = cliqueStack;
+    record.forced = extension;
+    record.minCliqueSize = minCliqueSize;
+    record.cliqueCount = 1;
+    record.maxCliqueSize =
+        static_cast<ui>(cliqueStack.size() + extension.size());
+    factorizedSink(record);
+    return;
+  }
   if (!cliqueSink)
     return;
 
@@ -276,98 +305,29 @@ void FastListBK::emitClique(const std::vector<ui> &extension) const {
 }
 
 void FastListBK::emitComplementMatching(const std::vector<ui> &p) const {
-  if (!cliqueSink)
+  if (!hasOutputSink())
     return;
 
-  std::vector<ui> forced;
-  std::vector<std::pair<ui, ui>> missingEdges;
-  std::vector<unsigned char> paired(p.size(), 0);
-  for (size_t i = 0; i < p.size(); ++i) {
-    if (paired[i] != 0)
-      continue;
-    size_t mate = p.size();
-    for (size_t j = i + 1; j < p.size(); ++j) {
-      if (paired[j] == 0 && !adjacency.contains(p[i], p[j])) {
-        mate = j;
-        break;
-      }
-    }
-    if (mate == p.size()) {
-      forced.push_back(p[i]);
-    } else {
-      paired[i] = paired[mate] = 1;
-      missingEdges.push_back({p[i], p[mate]});
-    }
-  }
-
-  std::vector<ui> extension = forced;
-  std::function<void(size_t)> materialize = [&](size_t at) {
-    if (at == missingEdges.size()) {
-      emitClique(extension);
-      return;
-    }
-    extension.push_back(missingEdges[at].first);
-    materialize(at + 1);
-    extension.back() = missingEdges[at].second;
-    materialize(at + 1);
-    extension.pop_back();
-  };
-  materialize(0);
+  // Callers have already rejected 64 or more missing edges, so the record
+  // carries the exact 2^k family count.
+  FastFactorizedCliques record = factorizeComplementMatching(
+      cliqueStack, p,
+      [&](ui u, ui v) { return adjacency.contains(u, v); });
+  record.minCliqueSize = minCliqueSize;
+  if (factorizedSink)
+    factorizedSink(record);
+  else
+    expandFactorizedCliques(record, cliqueSink);
 }
 
 void FastListBK::buildDegeneracyOrder() {
-  std::vector<ui> degree(graph.degree.begin(), graph.degree.end());
-  degeneracy = 0;
+  const CoreDecomposition &cores = graph.coreDecomposition();
+  rank = cores.rank;
+  degeneracy = cores.degeneracy;
   ui maxDegree = 0;
-  for (ui d : degree)
+  for (ui d : graph.degree)
     maxDegree = std::max(maxDegree, d);
 
-  if (graph.n != 0) {
-    // Matula-Beck bin peeling: O(n + m), with no mutation of Graph::degree.
-    std::vector<ui> bin(maxDegree + 1, 0);
-    std::vector<ui> position(graph.n);
-    std::vector<ui> vertices(graph.n);
-    for (ui d : degree)
-      ++bin[d];
-
-    ui start = 0;
-    for (ui d = 0; d <= maxDegree; ++d) {
-      const ui count = bin[d];
-      bin[d] = start;
-      start += count;
-    }
-    for (ui u = 0; u < graph.n; ++u) {
-      position[u] = bin[degree[u]]++;
-      vertices[position[u]] = u;
-    }
-    for (ui d = maxDegree; d > 0; --d)
-      bin[d] = bin[d - 1];
-    bin[0] = 0;
-
-    for (ui i = 0; i < graph.n; ++i) {
-      const ui u = vertices[i];
-      rank[u] = i;
-      degeneracy = std::max(degeneracy, degree[u]);
-      for (ui at = graph.offset[u]; at < graph.offset[u + 1]; ++at) {
-        const ui v = graph.neighbors[at];
-        if (degree[v] > degree[u]) {
-          const ui dv = degree[v];
-          const ui pv = position[v];
-          const ui pw = bin[dv];
-          const ui w = vertices[pw];
-          if (v != w) {
-            position[v] = pw;
-            position[w] = pv;
-            vertices[pv] = w;
-            vertices[pw] = v;
-          }
-          ++bin[dv];
-          --degree[v];
-        }
-      }
-    }
-  }
-
   levels.clear();
   levels.resize(static_cast<size_t>(degeneracy) + 2);
 #ifdef FASTLIST_OPPORTUNITY_PROFILE
@@ -510,6 +470,7 @@ ui FastListBK::neighborsInPBaseline(ui u, ui depth,
 }
 
 bool FastListBK::solveTinyP(ui cliqueSize, Level &level) {
+  ScopedPerfRegion perf(fastListCounters.tinyPerf);
   ++tinyKernelCalls;
   const ui pSize = static_cast<ui>(level.p.size());
   const ui subsetCount = 1U << pSize;
@@ -577,10 +538,9 @@ bool FastListBK::solveTinyP(ui cliqueSize, Level &level) {
     if (maximalSize < minCliqueSize)
       continue;
 
-    addCliqueCountOrThrow(cliqueCount, 1);
+    recordCliques(maximalSize, 1);
     ++foundHere;
-    maxCliqueSize = std::max(maxCliqueSize, maximalSize);
-    if (cliqueSink) {
+    if (hasOutputSink()) {
       std::vector<ui> extension;
       extension.reserve(__builtin_popcount(subset));
       for (ui i = 0; i < pSize; ++i)
@@ -649,11 +609,139 @@ void FastListBK::reduceDominatedX(ui depth, Level &level) {
   level.x.swap(active);
 }
 
-bool FastListBK::solveLowDegreeChild(ui cliqueSize, Level &child,
+ui FastListBK::livePNeighbors(ui v, ui depth, const std::vector<ui> &p,
+                               ui &partner) const {
+  // Counts v's live P neighbors, stopping at two; partner is the last seen.
+  const int liveLabel = static_cast<int>(depth);
+  ui count = 0;
+  if (graph.degree[v] > p.size()) {
+    for (ui w : p) {
+      if (label[w] != liveLabel || w == v || !adjacency.contains(v, w))
+        continue;
+      partner = w;
+      if (++count == 2)
+        break;
+    }
+  } else {
+    for (ui at = graph.offset[v]; at < graph.offset[v + 1]; ++at) {
+      const ui w = graph.neighbors[at];
+      if (label[w] != liveLabel)
+        continue;
+      partner = w;
+      if (++count == 2)
+        break;
+    }
+  }
+  return count;
+}
+
+// RMCE's dynamic rules at a search node. A P vertex v without live P
+// neighbors lies in exactly one maximal continuation, R + v; with a single
+// one, u, in exactly one, R + v + u. That clique is reported unless an X
+// vertex extends it, and v leaves P since it extends no other continuation.
+// Dropping a leaf lowers its partner's degree, so partners are rechecked
+// until every P vertex left has two live P neighbors; a partner left with
+// none goes too, as v extends R + u. X vertices without P neighbors block
+// nothing and are dropped. Returns whether P changed.
+bool FastListBK::reduceLowDegreeP(ui depth, ui cliqueSize, Level &level,
+                                  bool &found) {
+  found = false;
+  const int liveLabel = static_cast<int>(depth);
+  const int restoredLabel = depth == 1 ? 0 : static_cast<int>(depth - 1);
+  if (!level.idleX.empty()) {
+    for (ui x : level.idleX)
+      label[x] = -restoredLabel;
+    idleXRemoved += level.idleX.size();
+    size_t kept = 0;
+    for (ui x : level.x) {
+      if (label[x] == -liveLabel)
+        level.x[kept++] = x;
+    }
+    level.x.resize(kept);
+  }
+
+  // Whether an X vertex is adjacent to both a and b, scanning whichever of
+  // X and a's adjacency row is shorter.
+  auto blockedByX = [&](ui a, ui b) {
+    if (graph.degree[a] > level.x.size()) {
+      for (ui x : level.x) {
+        if (adjacency.contains(x, a) && (a == b || adjacency.contains(x, b)))
+          return true;
+      }
+      return false;
+    }
+    for (ui at = graph.offset[a]; at < graph.offset[a + 1]; ++at) {
+      const ui x = graph.neighbors[at];
+      if (label[x] == -liveLabel && (a == b || adjacency.contains(x, b)))
+        return true;
+    }
+    return false;
+  };
+  auto report = [&](std::initializer_list<ui> extension) {
+    const ui size = cliqueSize + static_cast<ui>(extension.size());
+    if (size < minCliqueSize)
+      return;
+    recordCliques(size, 1);
+    if (hasOutputSink())
+      emitClique(extension);
+    found = true;
+    if (hybridReorderSibling && siblingEvents < siblingEventBudget &&
+        level.witness.empty()) {
+      level.witness = cliqueStack;
+      level.witness.insert(level.witness.end(), extension);
+    }
+  };
+
+  // Scores only fall as P shrinks, so isolated vertices need no rescan.
+  for (ui v : level.isolatedP) {
+    label[v] = restoredLabel;
+    if (!blockedByX(v, v))
+      report({v});
+  }
+  dynamicDegreeZero += level.isolatedP.size();
+  bool changed = !level.isolatedP.empty();
+  for (size_t i = 0; i < level.pendantP.size(); ++i) {
+    const ui v = level.pendantP[i];
+    if (label[v] != liveLabel)
+      continue;
+    ui partner = v;
+    if (livePNeighbors(v, depth, level.p, partner) != 1)
+      continue;
+    label[v] = restoredLabel;
+    changed = true;
+    ++dynamicDegreeOne;
+    if (!blockedByX(v, partner))
+      report({v, partner});
+    ui next = partner;
+    const ui partnerDegree = livePNeighbors(partner, depth, level.p, next);
+    if (partnerDegree == 0) {
+      label[partner] = restoredLabel;
+      ++dynamicDegreeOne;
+    } else if (partnerDegree == 1) {
+      level.pendantP.push_back(partner);
+    }
+  }
+
+  if (changed) {
+    size_t kept = 0;
+    for (ui v : level.p) {
+      if (label[v] == liveLabel)
+        level.p[kept++] = v;
+    }
+    level.p.resize(kept);
+  }
+  return changed;
+}
+
+bool FastListBK::solveLowDegreeChild(ui depth, ui cliqueSize, Level &child,
                                      bool &found) {
   if (child.p.size() > 1)
     return false;
 
+  SearchTraceScope traceNode(trace, depth, child.p.size(), child.x.size(),
+                             SearchTraceLane::ENUMERATE, checksCount,
+                             cliqueCount);
+  traceNode.setKernel(SearchTraceKernel::LOW_DEGREE);
   incrementSearchStateOrThrow(checksCount);
   child.witness.clear();
   found = false;
@@ -661,9 +749,8 @@ bool FastListBK::solveLowDegreeChild(ui cliqueSize, Level &child,
     ++degreeZeroTerminals;
     if (!child.x.empty() || cliqueSize < minCliqueSize)
       return true;
-    addCliqueCountOrThrow(cliqueCount, 1);
-    maxCliqueSize = std::max(maxCliqueSize, cliqueSize);
-    if (cliqueSink)
+    recordCliques(cliqueSize, 1);
+    if (hasOutputSink())
       emitClique();
     found = true;
     if (hybridReorderSibling && siblingEvents < siblingEventBudget)
@@ -681,9 +768,8 @@ bool FastListBK::solveLowDegreeChild(ui cliqueSize, Level &child,
   const ui maximalSize = cliqueSize + 1;
   if (maximalSize < minCliqueSize)
     return true;
-  addCliqueCountOrThrow(cliqueCount, 1);
-  maxCliqueSize = std::max(maxCliqueSize, maximalSize);
-  if (cliqueSink)
+  recordCliques(maximalSize, 1);
+  if (hasOutputSink())
     emitClique({extension});
   found = true;
   if (hybridReorderSibling && siblingEvents < siblingEventBudget) {
@@ -695,6 +781,7 @@ bool FastListBK::solveLowDegreeChild(ui cliqueSize, Level &child,
 
 void FastListBK::intersectInto(ui u, ui depth, const Level &parent,
                                Level &child) {
+  ScopedPerfRegion perf(fastListCounters.intersectPerf);
   child.p.clear();
   child.x.clear();
   const int pLabel = static_cast<int>(depth);
@@ -787,14 +874,21 @@ bool FastListBK::trySiblingEffect(ui depth, size_t nextBranch,
 }
 
 bool FastListBK::enumerateBaseline(ui depth, ui cliqueSize) {
-  incrementSearchStateOrThrow(checksCount);
   Level &level = levels[depth];
+  SearchTraceScope traceNode(trace, depth, level.p.size(), level.x.size(),
+                             SearchTraceLane::BASELINE, checksCount,
+                             cliqueCount);
+  incrementSearchStateOrThrow(checksCount);
+  if (budget != nullptr &&
+      budget->exhausted(checksCount, cliqueCount, nextBudgetClock))
+    return false;
   level.witness.clear();
   if (level.p.empty()) {
+    traceNode.setKernel(level.x.empty() ? SearchTraceKernel::LEAF
+                                        : SearchTraceKernel::BLOCKED);
     if (level.x.empty() && cliqueSize >= minCliqueSize) {
-      addCliqueCountOrThrow(cliqueCount, 1);
-      maxCliqueSize = std::max(maxCliqueSize, cliqueSize);
-      if (cliqueSink)
+      recordCliques(cliqueSize, 1);
+      if (hasOutputSink())
         emitClique();
       if (hybridReorderSibling && siblingEvents < siblingEventBudget)
         level.witness = cliqueStack;
@@ -807,11 +901,17 @@ bool FastListBK::enumerateBaseline(ui depth, ui cliqueSize) {
   ui best = 0;
   bool havePivot = false;
   const ui pSize = static_cast<ui>(level.p.size());
+  ui universalCandidate = std::numeric_limits<ui>::max();
+  level.isolatedP.clear();
+  level.pendantP.clear();
+  level.idleX.clear();
   for (ui u : level.x) {
     const ui score = neighborsInPBaseline(u, depth, level.p);
     // An X vertex adjacent to all of P proves every continuation non-maximal.
-    if (score == pSize)
+    if (score == pSize) {
+      traceNode.setKernel(SearchTraceKernel::X_UNIVERSAL);
       return false;
+    }
     if (!havePivot || score > best) {
       pivot = u;
       best = score;
@@ -826,21 +926,29 @@ bool FastListBK::enumerateBaseline(ui depth, ui cliqueSize) {
     minPScore = std::min(minPScore, score);
     if (pSize >= 2 && score + 2 == pSize)
       ++deficientByOne;
+    if (score == 0)
+      level.isolatedP.push_back(u);
+    else if (score == 1)
+      level.pendantP.push_back(u);
+    if (score + 1 == pSize &&
+        universalCandidate == std::numeric_limits<ui>::max())
+      universalCandidate = u;
     if (!havePivot || score > best) {
       pivot = u;
       best = score;
       havePivot = true;
     }
   }
+  traceNode.setPivotScore(best);
 
   // P is a clique. Since no X vertex was universal, R union P is the one
   // maximal continuation from this state.
   if (minPScore + 1 == pSize) {
+    traceNode.setKernel(SearchTraceKernel::P_CLIQUE);
     const ui maximalSize = cliqueSize + pSize;
     if (maximalSize >= minCliqueSize) {
-      addCliqueCountOrThrow(cliqueCount, 1);
-      maxCliqueSize = std::max(maxCliqueSize, maximalSize);
-      if (cliqueSink)
+      recordCliques(maximalSize, 1);
+      if (hasOutputSink())
         emitClique(level.p);
       if (hybridReorderSibling && siblingEvents < siblingEventBudget) {
         level.witness = cliqueStack;
@@ -857,6 +965,7 @@ bool FastListBK::enumerateBaseline(ui depth, ui cliqueSize) {
   // choice, so there are exactly 2^k maximal continuations of equal size.
   if (level.x.empty() && pSize >= 2 && minPScore + 2 >= pSize &&
       (deficientByOne & 1U) == 0) {
+    traceNode.setKernel(SearchTraceKernel::MATCHING);
     const ui missingEdges = deficientByOne >> 1;
     const ui maximalSize = cliqueSize + pSize - missingEdges;
     if (maximalSize < minCliqueSize)
@@ -865,15 +974,33 @@ bool FastListBK::enumerateBaseline(ui depth, ui cliqueSize) {
       throw std::overflow_error(
           "complement-matching clique count exceeds uint64_t");
     const ull add = 1ULL << missingEdges;
-    addCliqueCountOrThrow(cliqueCount, add);
-    maxCliqueSize = std::max(maxCliqueSize, maximalSize);
-    if (cliqueSink)
+    recordCliques(maximalSize, add);
+    if (hasOutputSink())
       emitComplementMatching(level.p);
     // The closed form counts several cliques. Do not drive sibling
     // reordering without materializing one proven representative.
     return true;
   }
 
+  bool foundAny = false;
+#ifndef FASTLIST_DISABLE_DYNAMIC_REDUCTION
+  if ((!level.isolatedP.empty() || !level.pendantP.empty()) &&
+      reduceLowDegreeP(depth, cliqueSize, level, foundAny) &&
+      level.p.empty()) {
+    traceNode.setKernel(SearchTraceKernel::REDUCED);
+    return foundAny;
+  }
+#endif
+
+  // A P-universal candidate belongs to every maximal continuation. As the
+  // pivot it leaves itself as the only branch.
+#ifndef FASTLIST_DISABLE_UNIVERSAL_P
+  if (universalCandidate != std::numeric_limits<ui>::max()) {
+    ++universalPForces;
+    pivot = universalCandidate;
+  }
+#endif
+
   level.branch.clear();
   level.processedRoots.clear();
   for (ui u : level.p) {
@@ -881,7 +1008,6 @@ bool FastListBK::enumerateBaseline(ui depth, ui cliqueSize) {
       level.branch.push_back(u);
   }
 
-  bool foundAny = false;
   size_t nextBranch = 0;
   while (nextBranch < level.branch.size()) {
     const ui u = level.branch[nextBranch++];
@@ -937,8 +1063,14 @@ bool FastListBK::enumerate(ui depth, ui cliqueSize) {
   if (!enableAdvancedRules && !enableTailKernels && !canReachLocalBitset)
     return enumerateBaseline(depth, cliqueSize);
 #endif
-  incrementSearchStateOrThrow(checksCount);
   Level &level = levels[depth];
+  SearchTraceScope traceNode(trace, depth, level.p.size(), level.x.size(),
+                             SearchTraceLane::ENUMERATE, checksCount,
+                             cliqueCount);
+  incrementSearchStateOrThrow(checksCount);
+  if (budget != nullptr &&
+      budget->exhausted(checksCount, cliqueCount, nextBudgetClock))
+    return false;
   level.witness.clear();
 
 #ifdef FASTLIST_OPPORTUNITY_PROFILE
@@ -1015,13 +1147,14 @@ bool FastListBK::enumerate(ui depth, ui cliqueSize) {
 #endif
 
   if (level.p.empty()) {
+    traceNode.setKernel(level.x.empty() ? SearchTraceKernel::LEAF
+                                        : SearchTraceKernel::BLOCKED);
     if (level.x.empty() && cliqueSize >= minCliqueSize) {
 #ifdef FASTLIST_OPPORTUNITY_PROFILE
       ++profile.leafMaximal;
 #endif
-      addCliqueCountOrThrow(cliqueCount, 1);
-      maxCliqueSize = std::max(maxCliqueSize, cliqueSize);
-      if (cliqueSink)
+      recordCliques(cliqueSize, 1);
+      if (hasOutputSink())
         emitClique();
       if (hybridReorderSibling && siblingEvents < siblingEventBudget)
         level.witness = cliqueStack;
@@ -1037,8 +1170,10 @@ bool FastListBK::enumerate(ui depth, ui cliqueSize) {
   // construction, and recursion at the overwhelmingly common tail states.
 #ifndef FASTLIST_DISABLE_TINY_KERNEL
   if (enableTailKernels && level.p.size() <= TINY_P_LIMIT &&
-      level.p.size() + level.x.size() <= TINY_P_LIMIT)
+      level.p.size() + level.x.size() <= TINY_P_LIMIT) {
+    traceNode.setKernel(SearchTraceKernel::TINY);
     FASTLIST_PROFILE_RETURN(solveTinyP(cliqueSize, level));
+  }
 #endif
 
 #ifdef FASTLIST_OPPORTUNITY_PROFILE
@@ -1065,19 +1200,29 @@ bool FastListBK::enumerate(ui depth, ui cliqueSize) {
   ui pUniversal = 0;
   ull complementDegreeSum = 0;
 #endif
+  ScopedPerfRegion pivotPerf(fastListCounters.pivotPerf);
+  level.isolatedP.clear();
+  level.pendantP.clear();
+  level.idleX.clear();
   for (ui u : level.x) {
 #ifdef FASTLIST_OPPORTUNITY_PROFILE
     const ull candidateItemsBefore = profilePivotItemsTotal();
 #endif
+    // Early exit may cut a score short once it cannot beat a positive
+    // incumbent, so only a zero scored against no such incumbent is exact.
+    const bool exactZero = !havePivot || best == 0;
     const ui score =
         neighborsInP(u, depth, level.p, havePivot, best, true);
     // An X vertex adjacent to all of P proves every continuation non-maximal.
     if (score == pSize) {
+      traceNode.setKernel(SearchTraceKernel::X_UNIVERSAL);
 #ifdef FASTLIST_OPPORTUNITY_PROFILE
       ++profile.xUniversalPrune;
 #endif
       FASTLIST_PROFILE_RETURN(false);
     }
+    if (score == 0 && exactZero)
+      level.idleX.push_back(u);
 #ifdef FASTLIST_OPPORTUNITY_PROFILE
     const ull candidateItems =
         profilePivotItemsTotal() - candidateItemsBefore;
@@ -1113,7 +1258,11 @@ bool FastListBK::enumerate(ui depth, ui cliqueSize) {
     minPScore = std::min(minPScore, score);
     if (pSize >= 2 && score + 2 == pSize)
       ++deficientByOne;
-    if (enableAdvancedRules && score + 1 == pSize &&
+    if (score == 0)
+      level.isolatedP.push_back(u);
+    else if (score == 1)
+      level.pendantP.push_back(u);
+    if (score + 1 == pSize &&
         universalCandidate == std::numeric_limits<ui>::max())
       universalCandidate = u;
 #ifdef FASTLIST_OPPORTUNITY_PROFILE
@@ -1150,18 +1299,20 @@ bool FastListBK::enumerate(ui depth, ui cliqueSize) {
   profile.pivotWinnerX += pivotFromX;
   profile.pivotWinnerP += !pivotFromX;
 #endif
+  pivotPerf.stop();
+  traceNode.setPivotScore(best);
 
   // P is a clique. Since no X vertex was universal, R union P is the one
   // maximal continuation from this state.
   if (minPScore + 1 == pSize) {
+    traceNode.setKernel(SearchTraceKernel::P_CLIQUE);
 #ifdef FASTLIST_OPPORTUNITY_PROFILE
     ++profile.pCliqueSolved;
 #endif
     const ui maximalSize = cliqueSize + pSize;
     if (maximalSize >= minCliqueSize) {
-      addCliqueCountOrThrow(cliqueCount, 1);
-      maxCliqueSize = std::max(maxCliqueSize, maximalSize);
-      if (cliqueSink)
+      recordCliques(maximalSize, 1);
+      if (hasOutputSink())
         emitClique(level.p);
       if (hybridReorderSibling && siblingEvents < siblingEventBudget) {
         level.witness = cliqueStack;
@@ -1178,6 +1329,7 @@ bool FastListBK::enumerate(ui depth, ui cliqueSize) {
   // choice, so there are exactly 2^k maximal continuations of equal size.
   if (level.x.empty() && pSize >= 2 && minPScore + 2 >= pSize &&
       (deficientByOne & 1U) == 0) {
+    traceNode.setKernel(SearchTraceKernel::MATCHING);
     const ui missingEdges = deficientByOne >> 1;
     const ui maximalSize = cliqueSize + pSize - missingEdges;
     if (maximalSize < minCliqueSize) {
@@ -1191,9 +1343,8 @@ bool FastListBK::enumerate(ui depth, ui cliqueSize) {
 #ifdef FASTLIST_OPPORTUNITY_PROFILE
       ++profile.matchingSolved;
 #endif
-      addCliqueCountOrThrow(cliqueCount, add);
-      maxCliqueSize = std::max(maxCliqueSize, maximalSize);
-      if (cliqueSink)
+      recordCliques(maximalSize, add);
+      if (hasOutputSink())
         emitComplementMatching(level.p);
       // The closed form counts several cliques. Do not drive sibling
       // reordering without materializing one proven representative.
@@ -1241,30 +1392,56 @@ bool FastListBK::enumerate(ui depth, ui cliqueSize) {
     }
   }
 
+#endif
+
+  // The scores above describe P before the reduction. The pivot stays valid
+  // for the smaller P, while the score-gated 3-plex terminal is skipped.
+  bool reducedFound = false;
+  [[maybe_unused]] bool reducedP = false;
+#ifndef FASTLIST_DISABLE_DYNAMIC_REDUCTION
+  if (!level.isolatedP.empty() || !level.pendantP.empty()) {
+    reducedP = reduceLowDegreeP(depth, cliqueSize, level, reducedFound);
+    if (level.p.empty()) {
+      traceNode.setKernel(SearchTraceKernel::REDUCED);
+      FASTLIST_PROFILE_RETURN(reducedFound);
+    }
+  }
 #endif
 
   // HBBMC's 3-plex terminal: with X empty and complement degree at most two,
   // maximal clique continuations are maximal independent sets of disjoint
   // complement paths/cycles and can be counted without BK branching.
 #ifndef FASTLIST_DISABLE_PLEX3
-  if (enableAdvancedRules && level.x.empty() && minPScore + 3 >= pSize) {
+  if (enableAdvancedRules && !reducedP && level.x.empty() &&
+      minPScore + 3 >= pSize) {
     std::vector<std::vector<ui>> materializedCliques;
+    std::vector<FastFactorizedCliques> factorizedRecords;
     FastCliqueSink bufferedSink;
-    if (cliqueSink) {
+    FastFactorizedSink bufferedRecordSink;
+    if (factorizedSink) {
+      bufferedRecordSink = [&](const FastFactorizedCliques &record) {
+        factorizedRecords.push_back(record);
+      };
+    } else if (cliqueSink) {
       bufferedSink = [&](const std::vector<ui> &clique) {
         materializedCliques.push_back(clique);
       };
     }
     const std::vector<ui> *prefix =
-        cliqueSink ||
+        hasOutputSink() ||
                 (hybridReorderSibling && siblingEvents < siblingEventBudget)
             ? &cliqueStack
             : nullptr;
+    ScopedPerfRegion plex3Perf(fastListCounters.plex3Perf);
     FastPlex3Result plex =
         solveFastPlex3Subtree(adjacency, level.p, cliqueSize, prefix,
                               minCliqueSize,
-                              cliqueSink ? &bufferedSink : nullptr);
+                              bufferedSink ? &bufferedSink : nullptr,
+                              bufferedRecordSink ? &bufferedRecordSink
+                                                 : nullptr);
+    plex3Perf.stop();
     if (plex.handled) {
+      traceNode.setKernel(SearchTraceKernel::PLEX3);
       ull combinedCliqueCount = 0;
       ull combinedPlex3Cliques = 0;
       if (!tryAddUll(cliqueCount, plex.cliqueCount, combinedCliqueCount) ||
@@ -1275,7 +1452,11 @@ bool FastListBK::enumerate(ui depth, ui cliqueSize) {
       ++plex3Terminals;
       plex3Cliques = combinedPlex3Cliques;
       cliqueCount = combinedCliqueCount;
+      mergeCliqueSizeHistogramOrThrow(cliqueSizeHistogram,
+                                      plex.sizeHistogram);
       maxCliqueSize = std::max(maxCliqueSize, plex.maxCliqueSize);
+      for (const FastFactorizedCliques &record : factorizedRecords)
+        factorizedSink(record);
       if (cliqueSink)
         for (const std::vector<ui> &clique : materializedCliques)
           cliqueSink(clique);
@@ -1290,6 +1471,7 @@ bool FastListBK::enumerate(ui depth, ui cliqueSize) {
 #ifndef FASTLIST_DISABLE_UNIVERSAL_P
   if (enableAdvancedRules &&
       universalCandidate != std::numeric_limits<ui>::max()) {
+    traceNode.setKernel(SearchTraceKernel::UNIVERSAL_P);
     ++universalPForces;
     Level &child = levels[depth + 1];
     intersectInto(universalCandidate, depth, level, child);
@@ -1306,7 +1488,7 @@ bool FastListBK::enumerate(ui depth, ui cliqueSize) {
       label[v] = -parentLabel;
     if (childFound)
       level.witness = child.witness;
-    FASTLIST_PROFILE_RETURN(childFound);
+    FASTLIST_PROFILE_RETURN(childFound || reducedFound);
   }
 #endif
 
@@ -1331,23 +1513,33 @@ bool FastListBK::enumerate(ui depth, ui cliqueSize) {
 #ifndef FASTLIST_DISABLE_LOCAL_BITSET
   if (tinyBitsetState || adaptiveBitsetState) {
     std::vector<std::vector<ui>> materializedCliques;
+    std::vector<FastFactorizedCliques> factorizedRecords;
     FastCliqueSink bufferedSink;
-    if (cliqueSink) {
+    FastFactorizedSink bufferedRecordSink;
+    if (factorizedSink) {
+      bufferedRecordSink = [&](const FastFactorizedCliques &record) {
+        factorizedRecords.push_back(record);
+      };
+    } else if (cliqueSink) {
       bufferedSink = [&](const std::vector<ui> &clique) {
         materializedCliques.push_back(clique);
       };
     }
     const std::vector<ui> *prefix =
-        cliqueSink ||
+        hasOutputSink() ||
                 (hybridReorderSibling && siblingEvents < siblingEventBudget)
             ? &cliqueStack
             : nullptr;
+    ScopedPerfRegion localBitsetPerf(fastListCounters.localBitsetPerf);
     FastLocalBitsetResult local = solveFastLocalBitsetSubtree(
         adjacency, level.p, level.x, cliqueSize, prefix, minCliqueSize,
-        cliqueSink ? &bufferedSink : nullptr);
+        bufferedSink ? &bufferedSink : nullptr,
+        bufferedRecordSink ? &bufferedRecordSink : nullptr);
+    localBitsetPerf.stop();
     const ull extraChecks =
         local.checksCount == 0 ? 0 : local.checksCount - 1;
     if (local.handled) {
+      traceNode.setKernel(SearchTraceKernel::LOCAL_BITSET);
       ull combinedCliqueCount = 0;
       if (!tryAddUll(cliqueCount, local.cliqueCount, combinedCliqueCount))
         throw std::overflow_error(
@@ -1362,12 +1554,17 @@ bool FastListBK::enumerate(ui depth, ui cliqueSize) {
       localBitsetChecks += local.checksCount;
       checksCount += extraChecks;
       cliqueCount = combinedCliqueCount;
+      mergeCliqueSizeHistogramOrThrow(cliqueSizeHistogram,
+                                      local.sizeHistogram);
       maxCliqueSize = std::max(maxCliqueSize, local.maxCliqueSize);
+      for (const FastFactorizedCliques &record : factorizedRecords)
+        factorizedSink(record);
       if (cliqueSink)
         for (const std::vector<ui> &clique : materializedCliques)
           cliqueSink(clique);
-      level.witness = std::move(local.witness);
-      FASTLIST_PROFILE_RETURN(local.found);
+      if (!local.witness.empty())
+        level.witness = std::move(local.witness);
+      FASTLIST_PROFILE_RETURN(local.found || reducedFound);
     }
   }
 #endif
@@ -1377,6 +1574,15 @@ bool FastListBK::enumerate(ui depth, ui cliqueSize) {
   profile.ordinaryTiny3Nodes += entryState <= 3;
 #endif
 
+  // Without the forced recursion above, a P-universal candidate still
+  // absorbs the node as the pivot: it is then the only branch.
+#ifndef FASTLIST_DISABLE_UNIVERSAL_P
+  if (universalCandidate != std::numeric_limits<ui>::max()) {
+    ++universalPForces;
+    pivot = universalCandidate;
+  }
+#endif
+
   level.branch.clear();
   level.processedRoots.clear();
   for (ui u : level.p) {
@@ -1387,7 +1593,7 @@ bool FastListBK::enumerate(ui depth, ui cliqueSize) {
   profile.ordinaryBranchVertices += level.branch.size();
 #endif
 
-  bool foundAny = false;
+  bool foundAny = reducedFound;
   size_t nextBranch = 0;
   while (nextBranch < level.branch.size()) {
     const ui u = level.branch[nextBranch++];
@@ -1400,7 +1606,7 @@ bool FastListBK::enumerate(ui depth, ui cliqueSize) {
     bool childFound = false;
 #ifndef FASTLIST_DISABLE_LOW_DEGREE
     if (!enableTailKernels ||
-        !solveLowDegreeChild(cliqueSize + 1, child, childFound))
+        !solveLowDegreeChild(depth + 1, cliqueSize + 1, child, childFound))
       childFound = enumerate(depth + 1, cliqueSize + 1);
 #else
     childFound = enumerate(depth + 1, cliqueSize + 1);
@@ -1434,9 +1640,10 @@ bool FastListBK::enumerate(ui depth, ui cliqueSize) {
 #undef FASTLIST_PROFILE_RETURN
 }
 
-void FastListBK::findAllMaximalCliques(const std::string &outputLabel) {
+void FastListBK::resetSearchStatistics() {
   cliqueCount = 0;
   maxCliqueSize = 0;
+  cliqueSizeHistogram.clear();
   checksCount = 0;
   siblingEvents = 0;
   siblingBranchesBefore = 0;
@@ -1450,16 +1657,18 @@ void FastListBK::findAllMaximalCliques(const std::string &outputLabel) {
   universalPForces = 0;
   degreeZeroTerminals = 0;
   degreeOneTerminals = 0;
+  dynamicDegreeZero = 0;
+  dynamicDegreeOne = 0;
+  idleXRemoved = 0;
+  edgeRootsFiltered = 0;
+  ownedEdgeNodes = 0;
+  maxEdgeRootP = 0;
   cliqueStack.clear();
-  std::fill(label.begin(), label.end(), 0);
-
-#ifdef FASTLIST_OPPORTUNITY_PROFILE
-  profile = OpportunityProfile{};
-  profilePlex3Active = false;
-  profileGraphRules();
-#endif
+  completedRoots.clear();
+}
 
-  const auto start = std::chrono::high_resolution_clock::now();
+void FastListBK::selectPortfolio() {
+  ScopedRuntimeTimer timer(fastListCounters.selectPortfolio);
   buildDegeneracyOrder();
 
   const ull possibleEdges =
@@ -1478,75 +1687,401 @@ void FastListBK::findAllMaximalCliques(const std::string &outputLabel) {
   enableAdvancedRules = hardDenseGraph;
   enableTailKernels = hardDenseGraph || giantLowDegeneracyGraph;
   enableLocalBitset = enableTailKernels || sparseDenseCoreGraph;
+  portfolioReady = true;
+}
 
-  if (graph.n != 0) {
-    Level &root = levels[1];
-    for (ui u = 0; u < graph.n; ++u) {
-      root.p.clear();
-      root.x.clear();
-      for (ui at = graph.offset[u]; at < graph.offset[u + 1]; ++at) {
-        const ui v = graph.neighbors[at];
-        if (rank[v] < rank[u]) {
-          root.x.push_back(v);
-          label[v] = -1;
-        } else {
-          root.p.push_back(v);
-          label[v] = 1;
-        }
-      }
-
-      if (needsCliqueStack())
-        cliqueStack.push_back(u);
+void FastListBK::enumerateRoot(ui cliqueSize, ui depth) {
 #ifndef FASTLIST_OPPORTUNITY_PROFILE
 #if defined(FASTLIST_DISABLE_LOCAL_BITSET) ||                              \
     defined(FASTLIST_DISABLE_LOCAL_ADAPTIVE)
-      constexpr bool localAdaptiveCompiled = false;
+  constexpr bool localAdaptiveCompiled = false;
 #else
-      constexpr bool localAdaptiveCompiled = true;
+  constexpr bool localAdaptiveCompiled = true;
 #endif
-      const bool rootCanReachLocalBitset =
-          localAdaptiveCompiled && enableLocalBitset && root.p.size() >= 12;
-      if (!enableAdvancedRules && !enableTailKernels &&
-          !rootCanReachLocalBitset)
-        enumerateBaseline(1, 1);
-      else
-        enumerate(1, 1);
+  const bool rootCanReachLocalBitset =
+      localAdaptiveCompiled && enableLocalBitset &&
+      levels[depth].p.size() >= 12;
+  if (!enableAdvancedRules && !enableTailKernels && !rootCanReachLocalBitset)
+    enumerateBaseline(depth, cliqueSize);
+  else
+    enumerate(depth, cliqueSize);
 #else
-      enumerate(1, 1);
+  enumerate(depth, cliqueSize);
 #endif
-      if (needsCliqueStack())
-        cliqueStack.pop_back();
-      for (ui at = graph.offset[u]; at < graph.offset[u + 1]; ++at)
-        label[graph.neighbors[at]] = 0;
+}
+
+void FastListBK::runOrderedRoot(ui u, const std::vector<ui> &order) {
+  RootCostScope cost(rootCosts, u, checksCount, cliqueCount);
+  Level &root = levels[1];
+  root.p.clear();
+  root.x.clear();
+  for (ui at = graph.offset[u]; at < graph.offset[u + 1]; ++at) {
+    const ui v = graph.neighbors[at];
+    if (order[v] < order[u]) {
+      root.x.push_back(v);
+      label[v] = -1;
+    } else {
+      root.p.push_back(v);
+      label[v] = 1;
     }
   }
 
+  if (needsCliqueStack())
+    cliqueStack.push_back(u);
+  trace = traceWriter != nullptr && traceWriter->beginRoot(u) ? traceWriter
+                                                               : nullptr;
+  enumerateRoot(1);
+  if (trace != nullptr) {
+    trace->endRoot();
+    trace = nullptr;
+  }
+  if (needsCliqueStack())
+    cliqueStack.pop_back();
+  for (ui at = graph.offset[u]; at < graph.offset[u + 1]; ++at)
+    label[graph.neighbors[at]] = 0;
+}
+
+void FastListBK::findAllMaximalCliques(const std::string &outputLabel) {
+  resetSearchStatistics();
+  std::fill(label.begin(), label.end(), 0);
+
+#ifdef FASTLIST_OPPORTUNITY_PROFILE
+  profile = OpportunityProfile{};
+  profilePlex3Active = false;
+  profileGraphRules();
+#endif
+
+  const auto start = std::chrono::high_resolution_clock::now();
+  selectPortfolio();
+
+  if (!rootSchedule.empty() && rootSchedule.size() != graph.n)
+    throw std::invalid_argument("root schedule must list every vertex once");
+  ScopedPerfRegion perf(fastListCounters.searchPerf);
+  for (ui at = 0; at < graph.n; ++at) {
+    const ui u = rootSchedule.empty() ? at : rootSchedule[at];
+    if (budget == nullptr) {
+      runOrderedRoot(u, rank);
+      continue;
+    }
+    if (budget->exhausted(checksCount, cliqueCount, nextBudgetClock))
+      break;
+    runOrderedRoot(u, rank);
+    if (!budget->isExhausted())
+      completedRoots.push_back(u);
+  }
+  perf.stop();
+
   const auto finish = std::chrono::high_resolution_clock::now();
-  const double ms =
-      std::chrono::duration<double, std::milli>(finish - start).count();
-  std::cout << outputLabel << ": cliques=" << cliqueCount
-            << "  maxSize=" << maxCliqueSize
-            << "  minSize=" << minCliqueSize << "  checks=" << checksCount
-            << "  degeneracy=" << degeneracy
-            << "  portfolio="
-            << (enableAdvancedRules
-                    ? "dense"
-                    : (enableTailKernels
-                           ? "lowdeg"
-                           : (enableLocalBitset ? "local" : "baseline")))
-            << "  siblingEvents=" << siblingEvents
-            << "  siblingBranches=" << siblingBranchesBefore << "->"
-            << siblingBranchesAfter
-            << "  tiny=" << tinyKernelCalls
-            << "  local=" << localBitsetHandoffs
-            << "  plex3=" << plex3Terminals
-            << "  xdom=" << xDominanceRemoved
-            << "  universal=" << universalPForces
-            << "  lowDegree=" << degreeZeroTerminals << "/"
-            << degreeOneTerminals
-            << "  time=" << std::fixed << std::setprecision(3) << ms << " ms"
-            << std::endl;
+  printSummary(outputLabel,
+               std::chrono::duration<double, std::milli>(finish - start)
+                   .count());
+}
+
+void FastListBK::reportRuntimeCounters(double ms) const {
+  fastListCounters.run.report(checksCount, cliqueCount, ms);
+  if (!countersEnabled())
+    return;
+  const FastListCounters &c = fastListCounters;
+  CounterShard &shard = localCounterShard();
+  c.siblingEvents.add(shard, siblingEvents);
+  c.siblingBranchesBefore.add(shard, siblingBranchesBefore);
+  c.siblingBranchesAfter.add(shard, siblingBranchesAfter);
+  c.tinyKernelCalls.add(shard, tinyKernelCalls);
+  c.localBitsetHandoffs.add(shard, localBitsetHandoffs);
+  c.localBitsetChecks.add(shard, localBitsetChecks);
+  c.plex3Terminals.add(shard, plex3Terminals);
+  c.plex3Cliques.add(shard, plex3Cliques);
+  c.xDominanceRemoved.add(shard, xDominanceRemoved);
+  c.universalPForces.add(shard, universalPForces);
+  c.degreeZeroTerminals.add(shard, degreeZeroTerminals);
+  c.degreeOneTerminals.add(shard, degreeOneTerminals);
+  c.dynamicDegreeZero.add(shard, dynamicDegreeZero);
+  c.dynamicDegreeOne.add(shard, dynamicDegreeOne);
+  c.idleXRemoved.add(shard, idleXRemoved);
+  c.edgeRootsFiltered.add(shard, edgeRootsFiltered);
+  c.ownedEdgeNodes.add(shard, ownedEdgeNodes);
 #ifdef FASTLIST_OPPORTUNITY_PROFILE
-  printOpportunityProfile();
+  reportOpportunityProfile();
 #endif
 }
+
+void FastListBK::printSummary(const std::string &outputLabel,
+                              double ms) const {
+  reportRuntimeCounters(ms);
+  if (summaryOutput)
+    std::cout << outputLabel << ": cliques=" << cliqueCount
+              << "  maxSize=" << maxCliqueSize
+              << "  minSize=" << minCliqueSize << "  checks=" << checksCount
+              << "  degeneracy=" << degeneracy
+              << "  portfolio="
+              << (enableAdvancedRules
+                      ? "dense"
+                      : (enableTailKernels
+                             ? "lowdeg"
+                             : (enableLocalBitset ? "local" : "baseline")))
+              << "  siblingEvents=" << siblingEvents
+              << "  siblingBranches=" << siblingBranchesBefore << "->"
+              << siblingBranchesAfter
+              << "  tiny=" << tinyKernelCalls
+              << "  local=" << localBitsetHandoffs
+              << "  plex3=" << plex3Terminals
+              << "  xdom=" << xDominanceRemoved
+              << "  universal=" << universalPForces
+              << "  lowDegree=" << degreeZeroTerminals << "/"
+              << degreeOneTerminals
+              << "  dynamic=" << dynamicDegreeZero << "/" << dynamicDegreeOne
+              << "/" << idleXRemoved
+              << "  time=" << std::fixed << std::setprecision(3) << ms << " ms"
+              << std::endl;
+}
+
+ull FastListBK::findMaximalCliquesContaining(ui v) {
+  if (v >= graph.n)
+    throw std::out_of_range("anchored query vertex is not in the graph");
+  if (!portfolioReady)
+    selectPortfolio();
+  resetSearchStatistics();
+
+  // R = {v}, P = N(v), X = empty: exactly the maximal cliques through v.
+  Level &root = levels[1];
+  root.p.assign(graph.neighbors.begin() + graph.offset[v],
+                graph.neighbors.begin() + graph.offset[v + 1]);
+  root.x.clear();
+  for (ui w : root.p)
+    label[w] = 1;
+  runAnchoredQuery({v});
+  return cliqueCount;
+}
+
+ull FastListBK::findMaximalCliquesContaining(ui u, ui v) {
+  if (u >= graph.n || v >= graph.n)
+    throw std::out_of_range("anchored query vertex is not in the graph");
+  if (u == v)
+    throw std::invalid_argument("anchored edge query needs two vertices");
+  if (!portfolioReady)
+    selectPortfolio();
+  resetSearchStatistics();
+  if (!adjacency.contains(u, v))
+    return 0;
+
+  // R = {u, v}, P = N(u) intersect N(v), scanned from the shorter list.
+  if (graph.degree[u] > graph.degree[v])
+    std::swap(u, v);
+  Level &root = levels[1];
+  root.p.clear();
+  root.x.clear();
+  for (ui at = graph.offset[u]; at < graph.offset[u + 1]; ++at) {
+    const ui w = graph.neighbors[at];
+    if (w != v && adjacency.contains(v, w)) {
+      root.p.push_back(w);
+      label[w] = 1;
+    }
+  }
+  runAnchoredQuery({std::min(u, v), std::max(u, v)});
+  return cliqueCount;
+}
+
+void FastListBK::runAnchoredQuery(const std::vector<ui> &anchor) {
+  Level &root = levels[1];
+  const std::vector<ui> candidates = root.p;
+  if (needsCliqueStack())
+    cliqueStack = anchor;
+  enumerateRoot(static_cast<ui>(anchor.size()));
+  cliqueStack.clear();
+  for (ui w : candidates)
+    label[w] = 0;
+}
+
+ull FastListBK::findMaximalCliquesFromRoots(const std::vector<ui> &order,
+                                            const std::vector<ui> &roots) {
+  if (order.size() != graph.n)
+    throw std::invalid_argument("root order must rank every vertex");
+  if (!portfolioReady)
+    selectPortfolio();
+  resetSearchStatistics();
+  for (ui u : roots) {
+    if (u >= graph.n)
+      throw std::out_of_range("root vertex is not in the graph");
+    runOrderedRoot(u, order);
+  }
+  return cliqueCount;
+}
+
+bool FastListBK::ownedCandidatesClean(const std::vector<ui> &p, ui ownerRank,
+                                      const TrussDecomposition &truss) const {
+  for (size_t i = 0; i < p.size(); ++i) {
+    for (size_t j = i + 1; j < p.size(); ++j) {
+      if (adjacency.contains(p[i], p[j]) &&
+          truss.rank[truss.edgeId(graph, p[i], p[j])] < ownerRank)
+        return false;
+    }
+  }
+  return true;
+}
+
+void FastListBK::enumerateOwned(ui depth, ui cliqueSize, ui ownerRank,
+                                const TrussDecomposition &truss) {
+  Level &level = levels[depth];
+  if (ownedCandidatesClean(level.p, ownerRank, truss)) {
+    enumerateRoot(cliqueSize, depth);
+    return;
+  }
+  incrementSearchStateOrThrow(checksCount);
+  if (budget != nullptr &&
+      budget->exhausted(checksCount, cliqueCount, nextBudgetClock))
+    return;
+  if (depth == 1)
+    ++edgeRootsFiltered;
+  ++ownedEdgeNodes;
+
+  // P spans an edge ranked before the owner, so the continuations here are
+  // the cliques of P's later-ranked edges that no vertex of P or X extends in
+  // the original graph. A Tomita pivot over original adjacency stays sound:
+  // a continuation inside N(pivot) is extended by the pivot itself.
+  const ui pSize = static_cast<ui>(level.p.size());
+  ui pivot = level.p.front();
+  ui best = 0;
+  bool havePivot = false;
+  for (ui u : level.x) {
+    const ui score = neighborsInPBaseline(u, depth, level.p);
+    if (score == pSize)
+      return;
+    if (!havePivot || score > best) {
+      pivot = u;
+      best = score;
+      havePivot = true;
+    }
+  }
+  for (ui u : level.p) {
+    const ui score = neighborsInPBaseline(u, depth, level.p);
+    if (!havePivot || score > best) {
+      pivot = u;
+      best = score;
+      havePivot = true;
+    }
+  }
+
+  level.branch.clear();
+  level.processedRoots.clear();
+  for (ui u : level.p) {
+    if (!adjacency.contains(pivot, u))
+      level.branch.push_back(u);
+  }
+
+  const int pLabel = static_cast<int>(depth);
+  const int childLabel = static_cast<int>(depth + 1);
+  std::vector<ui> promoted;
+  for (ui u : level.branch) {
+    Level &child = levels[depth + 1];
+    child.p.clear();
+    child.x.clear();
+    promoted.clear();
+    // A live neighbor joined by an earlier-ranked edge cannot share a clique
+    // owned here, but it still extends one in the original graph: it moves
+    // to X instead of being dropped.
+    for (ui v : level.p) {
+      if (v == u || !adjacency.contains(u, v))
+        continue;
+      if (label[v] == -pLabel) {
+        child.x.push_back(v);
+        label[v] = -childLabel;
+      } else if (truss.rank[truss.edgeId(graph, u, v)] > ownerRank) {
+        child.p.push_back(v);
+        label[v] = childLabel;
+      } else {
+        child.x.push_back(v);
+        promoted.push_back(v);
+        label[v] = -childLabel;
+      }
+    }
+    for (ui v : level.x) {
+      if (label[v] == -pLabel && adjacency.contains(u, v)) {
+        child.x.push_back(v);
+        label[v] = -childLabel;
+      }
+    }
+
+    if (needsCliqueStack())
+      cliqueStack.push_back(u);
+    enumerateOwned(depth + 1, cliqueSize + 1, ownerRank, truss);
+    if (needsCliqueStack())
+      cliqueStack.pop_back();
+
+    for (ui v : child.p)
+      label[v] = pLabel;
+    for (ui v : child.x)
+      label[v] = -pLabel;
+    for (ui v : promoted)
+      label[v] = pLabel;
+    label[u] = -pLabel;
+    level.processedRoots.push_back(u);
+  }
+
+  for (ui u : level.processedRoots)
+    label[u] = pLabel;
+}
+
+void FastListBK::runOwnedEdge(ui e, const TrussDecomposition &truss) {
+  ui u = truss.edges[e].first;
+  ui v = truss.edges[e].second;
+  const ui ownerRank = truss.rank[e];
+  Level &root = levels[1];
+  root.p.clear();
+  root.x.clear();
+
+  // P and X partition N(u) intersect N(v), scanned from the shorter row.
+  if (graph.degree[u] > graph.degree[v])
+    std::swap(u, v);
+  for (ui at = graph.offset[u]; at < graph.offset[u + 1]; ++at) {
+    const ui w = graph.neighbors[at];
+    if (w == v || !adjacency.contains(v, w))
+      continue;
+    if (truss.rank[truss.slotEdge[at]] > ownerRank &&
+        truss.rank[truss.edgeId(graph, v, w)] > ownerRank) {
+      root.p.push_back(w);
+      label[w] = 1;
+    } else {
+      root.x.push_back(w);
+      label[w] = -1;
+    }
+  }
+  maxEdgeRootP = std::max(maxEdgeRootP, static_cast<ui>(root.p.size()));
+
+  std::vector<ui> touched = root.p;
+  touched.insert(touched.end(), root.x.begin(), root.x.end());
+  if (needsCliqueStack())
+    cliqueStack = {std::min(u, v), std::max(u, v)};
+  enumerateOwned(1, 2, ownerRank, truss);
+  cliqueStack.clear();
+  for (ui w : touched)
+    label[w] = 0;
+}
+
+void FastListBK::findAllMaximalCliquesFromEdges(
+    const TrussDecomposition &truss, const std::string &outputLabel) {
+  if (truss.slotEdge.size() != graph.neighbors.size())
+    throw std::invalid_argument("truss decomposition is for another graph");
+  resetSearchStatistics();
+  std::fill(label.begin(), label.end(), 0);
+
+  const auto start = std::chrono::high_resolution_clock::now();
+  if (!portfolioReady)
+    selectPortfolio();
+  ScopedPerfRegion perf(fastListCounters.searchPerf);
+  for (ui u = 0; u < graph.n; ++u) {
+    if (graph.degree[u] == 0)
+      runOrderedRoot(u, rank);
+  }
+  for (ui e : truss.order) {
+    if (budget != nullptr &&
+        budget->exhausted(checksCount, cliqueCount, nextBudgetClock))
+      break;
+    runOwnedEdge(e, truss);
+  }
+  perf.stop();
+
+  const auto finish = std::chrono::high_resolution_clock::now();
+  printSummary(outputLabel,
+               std::chrono::duration<double, std::milli>(finish - start)
+                   .count());
+}
@@ -11,10 +11,12 @@ private:
   const std::vector<ui> &vertices;
   const std::vector<ui> *cliquePrefix;
   const FastCliqueSink *cliqueSink;
+  const FastFactorizedSink *factorizedSink;
   ui minCliqueSize;
   std::array<ull, 64> neighbors{};
   FastLocalBitsetResult result;
   std::vector<std::vector<ui>> pendingCliques;
+  std::vector<FastFactorizedCliques> pendingRecords;
   bool overflow = false;
 
   static ui popcount(ull bits) {
@@ -47,6 +49,13 @@ private:
       return false;
     }
     result.cliqueCount = combined;
+    if (result.sizeHistogram.size() <= size)
+      result.sizeHistogram.resize(size + 1, 0);
+    if (!tryAddUll(result.sizeHistogram[size], count, combined)) {
+      overflow = true;
+      return false;
+    }
+    result.sizeHistogram[size] = combined;
     result.maxCliqueSize = std::max(result.maxCliqueSize, size);
     result.found = true;
     return true;
@@ -64,22 +73,68 @@ private:
     }
   }
 
+  void appendVertices(ull selected, std::vector<ui> &destination) const {
+    while (selected != 0) {
+      const ui index = static_cast<ui>(__builtin_ctzll(selected));
+      destination.push_back(vertices[index]);
+      selected &= selected - 1;
+    }
+  }
+
+  FastFactorizedCliques newRecord(ull forced) const {
+    FastFactorizedCliques record;
+    if (cliquePrefix != nullptr)
+      record.prefix = *cliquePrefix;
+    appendVertices(forced, record.forced);
+    record.minCliqueSize = minCliqueSize;
+    record.cliqueCount = 1;
+    record.maxCliqueSize =
+        static_cast<ui>(record.prefix.size() + record.forced.size());
+    return record;
+  }
+
   void materialize(ull selected) {
+    if (factorizedSink != nullptr) {
+      pendingRecords.push_back(newRecord(selected));
+      return;
+    }
     if (cliqueSink == nullptr)
       return;
 
     std::vector<ui> clique;
     if (cliquePrefix != nullptr)
       clique = *cliquePrefix;
-    while (selected != 0) {
-      const ui index = static_cast<ui>(__builtin_ctzll(selected));
-      clique.push_back(vertices[index]);
-      selected &= selected - 1;
-    }
+    appendVertices(selected, clique);
     std::sort(clique.begin(), clique.end());
     pendingCliques.push_back(std::move(clique));
   }
 
+  // Record form of materializeMatching: isolated complement vertices join the
+  // forced set and each missing edge of G[P] becomes one pair.
+  void factorizeMatching(ull selected, ull remaining, ull count,
+                         ui maximalSize) {
+    FastFactorizedCliques record = newRecord(0);
+    while (remaining != 0) {
+      const ui index = static_cast<ui>(__builtin_ctzll(remaining));
+      const ull bit = 1ULL << index;
+      remaining &= ~bit;
+      const ull nonNeighbors = remaining & ~neighbors[index];
+      if (nonNeighbors == 0) {
+        selected |= bit;
+        continue;
+      }
+      const ull mate = nonNeighbors & (~nonNeighbors + 1);
+      remaining &= ~mate;
+      record.pairs.push_back(
+          {vertices[index],
+           vertices[static_cast<ui>(__builtin_ctzll(mate))]});
+    }
+    appendVertices(selected, record.forced);
+    record.cliqueCount = count;
+    record.maxCliqueSize = maximalSize;
+    pendingRecords.push_back(std::move(record));
+  }
+
   void materializeMatching(ull selected, ull remaining) {
     if (remaining == 0) {
       materialize(selected);
@@ -204,7 +259,9 @@ private:
       const ull count = 1ULL << missingEdges;
       if (addCliques(count, maximalSize)) {
         saveWitness(chosen | matchingWitness(p));
-        if (cliqueSink != nullptr)
+        if (factorizedSink != nullptr)
+          factorizeMatching(chosen, p, count, maximalSize);
+        else if (cliqueSink != nullptr)
           materializeMatching(chosen, p);
       }
       return;
@@ -227,9 +284,10 @@ public:
   OneWordSubtreeSolver(const FastAdjacencyHash &adjacency,
                        const std::vector<ui> &localVertices,
                        const std::vector<ui> *prefix, ui outputThreshold,
-                       const FastCliqueSink *outputSink)
+                       const FastCliqueSink *outputSink,
+                       const FastFactorizedSink *recordSink)
       : vertices(localVertices), cliquePrefix(prefix), cliqueSink(outputSink),
-        minCliqueSize(std::max<ui>(1, outputThreshold)) {
+        factorizedSink(recordSink), minCliqueSize(std::max<ui>(1, outputThreshold)) {
     for (ui i = 0; i < vertices.size(); ++i) {
       ull mask = 0;
       for (ui j = 0; j < vertices.size(); ++j) {
@@ -258,8 +316,13 @@ public:
       result.found = false;
       result.cliqueCount = 0;
       result.maxCliqueSize = 0;
+      result.sizeHistogram.clear();
       result.witness.clear();
       pendingCliques.clear();
+      pendingRecords.clear();
+    } else if (factorizedSink != nullptr) {
+      for (const FastFactorizedCliques &record : pendingRecords)
+        (*factorizedSink)(record);
     } else if (cliqueSink != nullptr) {
       for (const std::vector<ui> &clique : pendingCliques)
         (*cliqueSink)(clique);
@@ -274,7 +337,8 @@ FastLocalBitsetResult solveFastLocalBitsetSubtree(
     const FastAdjacencyHash &adjacency, const std::vector<ui> &p,
     const std::vector<ui> &x, ui cliqueSize,
     const std::vector<ui> *cliquePrefix, ui minCliqueSize,
-    const FastCliqueSink *cliqueSink) {
+    const FastCliqueSink *cliqueSink,
+    const FastFactorizedSink *factorizedSink) {
   FastLocalBitsetResult declined;
   if (p.size() > 64 || x.size() > 64 - p.size())
     return declined;
@@ -285,6 +349,6 @@ FastLocalBitsetResult solveFastLocalBitsetSubtree(
   vertices.insert(vertices.end(), x.begin(), x.end());
 
   OneWordSubtreeSolver solver(adjacency, vertices, cliquePrefix,
-                              minCliqueSize, cliqueSink);
+                              minCliqueSize, cliqueSink, factorizedSink);
   return solver.run(static_cast<ui>(p.size()), cliqueSize);
 }
@@ -7,11 +7,12 @@
 
 namespace {
 
-constexpr size_t SMALL_SIZE_LIMIT = 2;
-
+// Counts maximal independent sets by their number of selected vertices. The
+// full distribution lets one pass serve every output threshold and the exact
+// per-size clique histogram.
 struct Counts {
   ull total = 0;
-  std::array<ull, SMALL_SIZE_LIMIT + 1> bySize{};
+  std::vector<ull> bySize;
 };
 
 struct ComponentStats {
@@ -22,8 +23,8 @@ struct ComponentStats {
 Counts singletonSequence(ui selected) {
   Counts result;
   result.total = 1;
-  if (selected <= SMALL_SIZE_LIMIT)
-    result.bySize[selected] = 1;
+  result.bySize.assign(selected + 1, 0);
+  result.bySize[selected] = 1;
   return result;
 }
 
@@ -34,8 +35,9 @@ bool appendCounts(Counts &destination, const Counts &source,
     return false;
   destination.total = sum;
 
-  for (size_t selected = 0;
-       selected + selectedIncrement <= SMALL_SIZE_LIMIT; ++selected) {
+  if (destination.bySize.size() < source.bySize.size() + selectedIncrement)
+    destination.bySize.resize(source.bySize.size() + selectedIncrement, 0);
+  for (size_t selected = 0; selected < source.bySize.size(); ++selected) {
     const size_t target = selected + selectedIncrement;
     if (!tryAddUll(destination.bySize[target], source.bySize[selected], sum))
       return false;
@@ -152,13 +154,14 @@ bool countCycle(size_t length, ComponentStats &result) {
   return true;
 }
 
-bool combineSmallCounts(
-    const std::array<ull, SMALL_SIZE_LIMIT + 1> &left,
-    const std::array<ull, SMALL_SIZE_LIMIT + 1> &right,
-    std::array<ull, SMALL_SIZE_LIMIT + 1> &result) {
-  result.fill(0);
-  for (size_t i = 0; i <= SMALL_SIZE_LIMIT; ++i) {
-    for (size_t j = 0; i + j <= SMALL_SIZE_LIMIT; ++j) {
+// Product of independent components: sizes add, so distributions convolve.
+bool combineCounts(const std::vector<ull> &left,
+                   const std::vector<ull> &right, std::vector<ull> &result) {
+  result.assign(left.size() + right.size() - 1, 0);
+  for (size_t i = 0; i < left.size(); ++i) {
+    if (left[i] == 0)
+      continue;
+    for (size_t j = 0; j < right.size(); ++j) {
       ull product = 0;
       ull sum = 0;
       if (!tryMultiplyUll(left[i], right[j], product) ||
@@ -216,15 +219,10 @@ template <typename Contains>
 FastPlex3Result solveFastPlex3SubtreeImpl(
     Contains contains, const std::vector<ui> &p,
     ui cliqueSize, const std::vector<ui> *cliquePrefix,
-    ui minCliqueSize, const FastCliqueSink *cliqueSink) {
+    ui minCliqueSize, const FastCliqueSink *cliqueSink,
+    const FastFactorizedSink *factorizedSink) {
   FastPlex3Result result;
   minCliqueSize = std::max<ui>(1, minCliqueSize);
-  // The dynamic program retains exact counts for candidate extensions of
-  // sizes 0, 1, and 2 so the default tau=3 filter is constant-space.  Larger
-  // output thresholds fall back to ordinary BK rather than changing either
-  // the complement-degree-two recognition rule or its hot-path footprint.
-  if (minCliqueSize > SMALL_SIZE_LIMIT + 1)
-    return result;
   const size_t pSize = p.size();
   if (pSize > std::numeric_limits<ui>::max())
     return result;
@@ -247,7 +245,7 @@ FastPlex3Result solveFastPlex3SubtreeImpl(
   }
 
   ull totalCount = 1;
-  std::array<ull, SMALL_SIZE_LIMIT + 1> smallCounts{{1, 0, 0}};
+  std::vector<ull> sizeCounts{1};
   ui maximumCandidateSize = 0;
   std::vector<ui> maximumCandidates;
   maximumCandidates.reserve(pSize);
@@ -257,6 +255,14 @@ FastPlex3Result solveFastPlex3SubtreeImpl(
   std::vector<size_t> component;
   std::vector<size_t> order;
   std::vector<std::vector<std::vector<ui>>> componentSelections;
+  FastFactorizedCliques factorized;
+  if (factorizedSink != nullptr) {
+    // A record supersedes materialization; the sink is never combined with
+    // the per-clique hook for the same terminal.
+    cliqueSink = nullptr;
+    if (cliquePrefix != nullptr)
+      factorized.prefix = *cliquePrefix;
+  }
   stack.reserve(pSize);
   component.reserve(pSize);
   order.reserve(pSize);
@@ -317,7 +323,20 @@ FastPlex3Result solveFastPlex3SubtreeImpl(
     if (!(cycle ? countCycle(order.size(), stats)
                 : countPath(order.size(), stats)))
       return result;
-    if (cliqueSink != nullptr) {
+    if (factorizedSink != nullptr) {
+      // Isolated complement vertices are in every continuation and a single
+      // missing edge contributes exactly one of its endpoints.
+      if (order.size() == 1) {
+        factorized.forced.push_back(p[order.front()]);
+      } else if (order.size() == 2 && !cycle) {
+        factorized.pairs.push_back({p[order[0]], p[order[1]]});
+      } else {
+        factorized.components.emplace_back();
+        factorized.components.back().cycle = cycle;
+        for (size_t vertex : order)
+          factorized.components.back().vertices.push_back(p[vertex]);
+      }
+    } else if (cliqueSink != nullptr) {
       componentSelections.emplace_back();
       enumerateComponentSelections(order, cycle, p,
                                    componentSelections.back());
@@ -330,11 +349,10 @@ FastPlex3Result solveFastPlex3SubtreeImpl(
       return result;
     totalCount = combinedTotal;
 
-    std::array<ull, SMALL_SIZE_LIMIT + 1> combinedSmall{};
-    if (!combineSmallCounts(smallCounts, stats.counts.bySize,
-                            combinedSmall))
+    std::vector<ull> combinedSizes;
+    if (!combineCounts(sizeCounts, stats.counts.bySize, combinedSizes))
       return result;
-    smallCounts = combinedSmall;
+    sizeCounts.swap(combinedSizes);
 
     if (stats.maximumSize >
         std::numeric_limits<ui>::max() - maximumCandidateSize)
@@ -354,19 +372,22 @@ FastPlex3Result solveFastPlex3SubtreeImpl(
   const ui maximumCliqueSize = cliqueSize + maximumCandidateSize;
 
   ull excluded = 0;
-  if (cliqueSize < minCliqueSize) {
-    const ui maximumExcludedCandidateSize =
-        minCliqueSize - 1 - cliqueSize;
-    for (ui selected = 0; selected <= maximumExcludedCandidateSize;
-         ++selected) {
-      ull sum = 0;
-      if (!tryAddUll(excluded, smallCounts[selected], sum))
-        return result;
-      excluded = sum;
+  result.sizeHistogram.assign(cliqueSize + sizeCounts.size(), 0);
+  for (size_t selected = 0; selected < sizeCounts.size(); ++selected) {
+    const size_t size = cliqueSize + selected;
+    if (size >= minCliqueSize) {
+      result.sizeHistogram[size] = sizeCounts[selected];
+      continue;
     }
+    ull sum = 0;
+    if (!tryAddUll(excluded, sizeCounts[selected], sum))
+      return result;
+    excluded = sum;
   }
   if (excluded > totalCount)
     return result;
+  while (!result.sizeHistogram.empty() && result.sizeHistogram.back() == 0)
+    result.sizeHistogram.pop_back();
 
   result.handled = true;
   result.cliqueCount = totalCount - excluded;
@@ -380,6 +401,14 @@ FastPlex3Result solveFastPlex3SubtreeImpl(
   result.witness.insert(result.witness.end(), maximumCandidates.begin(),
                         maximumCandidates.end());
 
+  if (factorizedSink != nullptr) {
+    factorized.minCliqueSize = minCliqueSize;
+    factorized.cliqueCount = result.cliqueCount;
+    factorized.maxCliqueSize = result.maxCliqueSize;
+    (*factorizedSink)(factorized);
+    return result;
+  }
+
   if (cliqueSink != nullptr) {
     std::vector<std::vector<ui>> pendingCliques;
     std::vector<ui> extension;
@@ -418,18 +447,20 @@ FastPlex3Result solveFastPlex3SubtreeImpl(
 FastPlex3Result solveFastPlex3Subtree(
     const FastAdjacencyHash &adjacency, const std::vector<ui> &p,
     ui cliqueSize, const std::vector<ui> *cliquePrefix,
-    ui minCliqueSize, const FastCliqueSink *cliqueSink) {
+    ui minCliqueSize, const FastCliqueSink *cliqueSink,
+    const FastFactorizedSink *factorizedSink) {
   return solveFastPlex3SubtreeImpl(
       [&](ui u, ui v) { return adjacency.contains(u, v); }, p, cliqueSize,
-      cliquePrefix, minCliqueSize, cliqueSink);
+      cliquePrefix, minCliqueSize, cliqueSink, factorizedSink);
 }
 
 FastPlex3Result solveFastPlex3Subtree(
     const std::vector<std::unordered_set<ui>> &adjacency,
     const std::vector<ui> &p, ui cliqueSize,
     const std::vector<ui> *cliquePrefix, ui minCliqueSize,
-    const FastCliqueSink *cliqueSink) {
+    const FastCliqueSink *cliqueSink,
+    const FastFactorizedSink *factorizedSink) {
   return solveFastPlex3SubtreeImpl(
       [&](ui u, ui v) { return adjacency[u].count(v) != 0; }, p, cliqueSize,
-      cliquePrefix, minCliqueSize, cliqueSink);
+      cliquePrefix, minCliqueSize, cliqueSink, factorizedSink);
 }
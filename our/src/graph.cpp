@@ -1,5 +1,8 @@
 #include "../inc/graph.h"
+#include "../inc/fast_adj_hash.h"
+#include "../inc/perf_counters.h"
 #include <numeric>
+#include <stdexcept>
 
 namespace {
 class FastIntScanner {
@@ -101,11 +104,11 @@ public:
 };
 } // namespace
 
-Graph::Graph() : n(0), m(0), kmax(0), adjacencySorted(false) {}
+Graph::Graph() : n(0), m(0), adjacencySorted(false) {}
 
 Graph::Graph(ui vertexCount,
              const std::vector<std::pair<ui, ui>> &edges)
-    : n(vertexCount), m(0), kmax(0), adjacencySorted(true) {
+    : n(vertexCount), m(0), adjacencySorted(true) {
   std::vector<std::vector<ui>> rows(n);
   for (const auto &[u, v] : edges) {
     if (u >= n || v >= n || u == v)
@@ -130,7 +133,46 @@ Graph::Graph(ui vertexCount,
   m = static_cast<ui>(neighbors.size() / 2);
 }
 
-Graph::Graph(std::string path) : n(0), m(0), kmax(0), adjacencySorted(false) {
+Graph::Graph(ui vertexCount, std::vector<ui> rowOffsets,
+             std::vector<ui> adjacency)
+    : n(vertexCount), m(0), offset(std::move(rowOffsets)),
+      neighbors(std::move(adjacency)), adjacencySorted(true) {
+  if (offset.size() != static_cast<size_t>(n) + 1 || offset[0] != 0 ||
+      offset[n] != neighbors.size())
+    throw std::invalid_argument(
+        "CSR offsets must have n + 1 entries from 0 to the neighbor count");
+  if (neighbors.size() % 2 != 0)
+    throw std::invalid_argument("CSR rows must list every edge twice");
+  degree.assign(n, 0);
+  for (ui v = 0; v < n; v++) {
+    if (offset[v + 1] < offset[v])
+      throw std::invalid_argument("CSR offsets must be nondecreasing");
+    degree[v] = offset[v + 1] - offset[v];
+    auto first = neighbors.begin() + offset[v];
+    auto last = neighbors.begin() + offset[v + 1];
+    std::sort(first, last);
+    for (auto it = first; it != last; ++it) {
+      if (*it >= n || *it == v || (it != first && *it == *(it - 1)))
+        throw std::invalid_argument(
+            "CSR row " + std::to_string(v) +
+            " has an out-of-range, self-loop or repeated neighbor");
+    }
+  }
+  for (ui v = 0; v < n; v++) {
+    for (ui j = offset[v]; j < offset[v + 1]; j++) {
+      const ui u = neighbors[j];
+      if (!std::binary_search(neighbors.begin() + offset[u],
+                              neighbors.begin() + offset[u + 1], v))
+        throw std::invalid_argument("CSR edge " + std::to_string(v) + "-" +
+                                    std::to_string(u) +
+                                    " is missing from row " +
+                                    std::to_string(u));
+    }
+  }
+  m = static_cast<ui>(neighbors.size() / 2);
+}
+
+Graph::Graph(std::string path) : n(0), m(0), adjacencySorted(false) {
   FastIntScanner scanner(path);
 
   if (!scanner.isOpen()) {
@@ -143,26 +185,46 @@ Graph::Graph(std::string path) : n(0), m(0), kmax(0), adjacencySorted(false) {
     offset.resize(n + 1, 0);
     neighbors.resize(2 * m);
     degree.resize(n, 0);
+    // Rows must list vertices 0..n-1 in order; ids and the entry count are
+    // checked before every write, so a malformed file throws instead of
+    // corrupting the rows. Rows missing at the end are empty.
     ui vertex, neigh;
     bool rowsSorted = true;
-    for (ui row = 0; row < n; row++) {
+    ui row = 0;
+    for (; row < n; row++) {
       if (!scanner.readUint(vertex))
         break;
+      if (vertex != row)
+        throw std::invalid_argument("graph " + path + ": row " +
+                                    std::to_string(row) + " lists vertex " +
+                                    std::to_string(vertex));
       bool haveLastNeigh = false;
       ui lastNeigh = 0;
       while (scanner.readUintOnLine(neigh)) {
         if (vertex == neigh)
           continue;
+        if (neigh >= n)
+          throw std::invalid_argument("graph " + path + ": neighbor " +
+                                      std::to_string(neigh) + " of vertex " +
+                                      std::to_string(vertex) +
+                                      " is not below n");
         if (haveLastNeigh && neigh < lastNeigh)
           rowsSorted = false;
         lastNeigh = neigh;
         haveLastNeigh = true;
-        neighbors[offset[vertex] + offset[vertex + 1]] = neigh;
+        const size_t at = static_cast<size_t>(offset[vertex]) +
+                          offset[vertex + 1];
+        if (at >= neighbors.size())
+          throw std::invalid_argument("graph " + path +
+                                      ": more than 2m adjacency entries");
+        neighbors[at] = neigh;
         offset[vertex + 1]++;
       }
       degree[vertex] = offset[vertex + 1];
       offset[vertex + 1] += offset[vertex];
     }
+    for (; row < n; row++)
+      offset[row + 1] = offset[row];
     adjacencySorted = rowsSorted;
   }
 
@@ -200,81 +262,59 @@ void Graph::sortAdjacency() {
   adjacencySorted = true;
 }
 
-void Graph::getListingOrder(std::vector<ui> &arr) {
-  /* Rettrun an array with each index storing the listing order based on the
-  core value. Listing order is a unique number. high core values get low listing
-  order*/
-  corePeelSequence.resize(n);
-  coreDecompose(corePeelSequence);
-
-  for (size_t i = 0; i < n; ++i) {
-    arr[corePeelSequence[i]] = i + 1;
+namespace {
+bool twoColorable(const Graph &g) {
+  vector<int> color(g.n, -1);
+  vector<ui> queue;
+  queue.reserve(g.n);
+  for (ui s = 0; s < g.n; s++) {
+    if (color[s] != -1)
+      continue;
+    color[s] = 0;
+    queue.clear();
+    queue.push_back(s);
+    for (size_t head = 0; head < queue.size(); head++) {
+      ui u = queue[head];
+      for (ui i = g.offset[u]; i < g.offset[u + 1]; i++) {
+        ui v = g.neighbors[i];
+        if (color[v] == -1) {
+          color[v] = color[u] ^ 1;
+          queue.push_back(v);
+        } else if (color[v] == color[u]) {
+          return false;
+        }
+      }
+    }
   }
+  return true;
 }
+} // namespace
 
-void Graph::coreDecompose(std::vector<ui> &arr) {
-  /* Peeling algorithm to find the core values of each vertex.
-     Returns the peeling sequence i.e. verticies in increaseing order of core
-     values. */
-  core.resize(n);
-  if (n == 0) {
-    kmax = 0;
-    return;
-  }
-
-  int maxDegree = *std::max_element(degree.begin(), degree.end());
-  if (debug) std::cout << "Max Degree=" << maxDegree << std::endl;
-
-  // Initialize bins
-  std::vector<ui> bins(maxDegree + 1, 0);
-  for (ui deg : degree) {
-    bins[deg]++;
-  }
-
-  // Compute bin positions
-  std::vector<int> bin_positions(maxDegree + 1, 0);
-  std::partial_sum(bins.begin(), bins.end(), bin_positions.begin());
-
-  // Initialize position and sortedVertex arrays
-  std::vector<ui> position(n);
-  std::vector<ui> sortedVertex(n);
-
-  for (ui v = 0; v < n; v++) {
-    position[v] = --bin_positions[degree[v]]; // Assign position
-    sortedVertex[position[v]] = v;            // Place vertex in sorted list
-  }
+const FastAdjacencyHash &Graph::adjacencyHash() const {
+  return adjacencyCache.get([this] {
+    static const PerfRegion adjacencyPerfRegion("adjacency_hash", false);
+    ScopedPerfRegion perf(adjacencyPerfRegion);
+    return FastAdjacencyHash(*this);
+  });
+}
 
-  // Perform core decomposition
-  for (int i = 0; i < n; i++) {
-    ui v = sortedVertex[i];
-    core[v] = degree[v]; // Assign core value
-    arr[n - i - 1] = v;  // Assign peel sequence
+bool Graph::isBipartite() const {
+  return bipartiteVerdict.get([this] { return twoColorable(*this); });
+}
 
-    // Update degrees of neighbors
-    for (int j = offset[v]; j < offset[v + 1]; j++) {
-      ui u = neighbors[j];
-      if (degree[u] > degree[v]) {
-        ui du = degree[u];
-        ui pu = position[u];
-        ui pw = bin_positions[du];
-        ui w = sortedVertex[pw];
+void Graph::recordBipartite(bool bipartite) const {
+  bipartiteVerdict.set(std::make_shared<const bool>(bipartite));
+}
 
-        if (u != w) {
-          position[u] = pw;
-          sortedVertex[pu] = w;
-          position[w] = pu;
-          sortedVertex[pw] = u;
-        }
+void Graph::recordChordal(bool chordal) const {
+  chordalVerdict.set(std::make_shared<const bool>(chordal));
+}
 
-        bin_positions[du]++;
-        degree[u]--;
-      }
-    }
-  }
+void Graph::adoptCoreDecomposition(CoreDecomposition cores) {
+  coreCache.set(std::make_shared<const CoreDecomposition>(std::move(cores)));
+}
 
-  kmax = core[0]; // Initialize with first element
-  for (ui val : core) {
-    if (val > kmax)
-      kmax = val;
-  }
+void Graph::adoptAdjacencyHash(
+    std::shared_ptr<const FastAdjacencyHash> adjacency) {
+  adjacencyCache.set(std::move(adjacency));
 }
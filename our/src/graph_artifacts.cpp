@@ -0,0 +1,358 @@
+#include "../inc/graph_artifacts.h"
+#include "../inc/fast_adj_hash.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr char ARTIFACT_MAGIC[8] = {'B', 'K', 'G', 'R', 'A', 'P', 'H', '1'};
+constexpr std::uint32_t ARTIFACT_VERSION = 1;
+
+enum ArtifactSection : unsigned {
+  SECTION_CSR = 1U << 0,
+  SECTION_CORE = 1U << 1,
+  SECTION_ADJACENCY = 1U << 2,
+  SECTION_BIPARTITE = 1U << 3,
+  SECTION_CHORDAL = 1U << 4,
+};
+
+struct ArtifactHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t sections;
+  std::uint64_t contentHash;
+  std::uint64_t contentBytes;
+  std::uint32_t n;
+  std::uint32_t m;
+  std::uint64_t neighborCount;
+  std::uint32_t adjacencySorted;
+  std::uint32_t degeneracy;
+  std::uint64_t rowCount;
+  std::uint64_t bucketCount;
+  std::uint32_t rowBytes;
+  std::uint32_t bucketBytes;
+  std::uint8_t bipartite;
+  std::uint8_t chordal;
+  std::uint8_t padding[6];
+};
+
+// A read-only private mapping of a whole file, unmapped on scope exit.
+class MappedFile {
+private:
+  const unsigned char *data = nullptr;
+  size_t size = 0;
+
+public:
+  explicit MappedFile(const std::string &path) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+      return;
+    const off_t end = ::lseek(fd, 0, SEEK_END);
+    if (end > 0) {
+      void *mapped = ::mmap(nullptr, static_cast<size_t>(end), PROT_READ,
+                            MAP_PRIVATE, fd, 0);
+      if (mapped != MAP_FAILED) {
+        data = static_cast<const unsigned char *>(mapped);
+        size = static_cast<size_t>(end);
+      }
+    }
+    ::close(fd);
+  }
+  ~MappedFile() {
+    if (data != nullptr)
+      ::munmap(const_cast<unsigned char *>(data), size);
+  }
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  bool isOpen() const { return data != nullptr; }
+  const unsigned char *bytes() const { return data; }
+  size_t byteCount() const { return size; }
+};
+
+// Word-at-a-time multiply-xorshift hash; a cache key, not a checksum.
+ull hashBytes(const unsigned char *data, size_t size) {
+  ull hash = 0x9e3779b97f4a7c15ULL ^ size;
+  auto mix = [&](ull word) {
+    hash = (hash ^ word) * 0xbf58476d1ce4e5b9ULL;
+    hash ^= hash >> 29;
+  };
+  size_t at = 0;
+  for (; at + sizeof(ull) <= size; at += sizeof(ull)) {
+    ull word;
+    std::memcpy(&word, data + at, sizeof(ull));
+    mix(word);
+  }
+  ull tail = 0;
+  std::memcpy(&tail, data + at, size - at);
+  mix(tail);
+  hash = (hash ^ (hash >> 31)) * 0x94d049bb133111ebULL;
+  return hash ^ (hash >> 32);
+}
+
+unsigned presentSections(const Graph &graph) {
+  unsigned sections = SECTION_CSR;
+  if (graph.cachedCoreDecomposition() != nullptr)
+    sections |= SECTION_CORE;
+  if (graph.cachedAdjacencyHash() != nullptr)
+    sections |= SECTION_ADJACENCY;
+  if (graph.knownBipartite() != nullptr)
+    sections |= SECTION_BIPARTITE;
+  if (graph.knownChordal() != nullptr)
+    sections |= SECTION_CHORDAL;
+  return sections;
+}
+
+// Sequential reader over the mapped payload; every take() is bounds-checked
+// so a truncated or foreign file is rejected instead of read past its end.
+class PayloadReader {
+private:
+  const unsigned char *cursor;
+  const unsigned char *end;
+
+public:
+  PayloadReader(const unsigned char *begin, const unsigned char *finish)
+      : cursor(begin), end(finish) {}
+
+  const unsigned char *take(size_t bytes) {
+    if (static_cast<size_t>(end - cursor) < bytes)
+      throw std::runtime_error("graph artifact is truncated");
+    const unsigned char *at = cursor;
+    cursor += bytes;
+    return at;
+  }
+  void copyTo(std::vector<ui> &out, size_t count) {
+    out.resize(count);
+    std::memcpy(out.data(), take(count * sizeof(ui)), count * sizeof(ui));
+  }
+  bool atEnd() const { return cursor == end; }
+};
+
+// A damaged artifact must not reach the engines, which index rows and
+// vertices without bounds checks: offsets start at 0, never decrease and end
+// at 2m, degrees match the rows and every neighbor is a vertex.
+void checkCsrOrThrow(const Graph &graph) {
+  if (graph.offset.front() != 0 ||
+      graph.offset.back() != 2 * static_cast<ull>(graph.m))
+    throw std::runtime_error("graph artifact CSR is inconsistent");
+  for (ui v = 0; v < graph.n; ++v) {
+    if (graph.offset[v + 1] < graph.offset[v] ||
+        graph.degree[v] != graph.offset[v + 1] - graph.offset[v])
+      throw std::runtime_error("graph artifact CSR is inconsistent");
+  }
+  for (ui w : graph.neighbors) {
+    if (w >= graph.n)
+      throw std::runtime_error("graph artifact neighbor is out of range");
+  }
+}
+
+// The peel order must be a permutation of the vertices with rank its
+// inverse.
+void checkCoresOrThrow(const CoreDecomposition &cores, ui n) {
+  for (ui i = 0; i < n; ++i) {
+    const ui v = cores.peelOrder[i];
+    if (v >= n || cores.rank[v] != i)
+      throw std::runtime_error("graph artifact core order is inconsistent");
+  }
+}
+
+void writeOrThrow(int fd, const void *data, size_t bytes) {
+  const char *at = static_cast<const char *>(data);
+  while (bytes != 0) {
+    const ssize_t written = ::write(fd, at, bytes);
+    if (written < 0) {
+      if (errno == EINTR)
+        continue;
+      throw std::runtime_error(std::string("graph artifact write failed: ") +
+                               std::strerror(errno));
+    }
+    at += written;
+    bytes -= static_cast<size_t>(written);
+  }
+}
+
+void writeVector(int fd, const std::vector<ui> &values) {
+  writeOrThrow(fd, values.data(), values.size() * sizeof(ui));
+}
+
+} // namespace
+
+GraphArtifactCache::GraphArtifactCache(std::string cacheDirectory)
+    : directory(std::move(cacheDirectory)), contentHash(0), contentBytes(0),
+      storedSections(0), loadedSorted(false), hit(false) {
+  if (directory.empty())
+    throw std::invalid_argument("graph artifact directory is empty");
+}
+
+std::string GraphArtifactCache::artifactPath() const {
+  char name[64];
+  std::snprintf(name, sizeof(name), "%016llx-%llu.bkg", contentHash,
+                contentBytes);
+  return directory + "/" + name;
+}
+
+bool GraphArtifactCache::restore(Graph &graph) {
+  MappedFile artifact(artifactPath());
+  if (!artifact.isOpen() || artifact.byteCount() < sizeof(ArtifactHeader))
+    return false;
+  ArtifactHeader header;
+  std::memcpy(&header, artifact.bytes(), sizeof(header));
+  if (std::memcmp(header.magic, ARTIFACT_MAGIC, sizeof(ARTIFACT_MAGIC)) != 0 ||
+      header.version != ARTIFACT_VERSION ||
+      header.contentHash != contentHash ||
+      header.contentBytes != contentBytes ||
+      (header.sections & SECTION_CSR) == 0 ||
+      header.rowBytes != FastAdjacencyHash::ROW_BYTES ||
+      header.bucketBytes != FastAdjacencyHash::BUCKET_BYTES ||
+      header.neighborCount != 2 * static_cast<ull>(header.m))
+    return false;
+
+  PayloadReader payload(artifact.bytes() + sizeof(header),
+                        artifact.bytes() + artifact.byteCount());
+  graph.n = header.n;
+  graph.m = header.m;
+  graph.adjacencySorted = header.adjacencySorted != 0;
+  payload.copyTo(graph.offset, static_cast<size_t>(header.n) + 1);
+  payload.copyTo(graph.neighbors, header.neighborCount);
+  payload.copyTo(graph.degree, header.n);
+  checkCsrOrThrow(graph);
+
+  if ((header.sections & SECTION_CORE) != 0) {
+    CoreDecomposition cores;
+    payload.copyTo(cores.peelOrder, header.n);
+    payload.copyTo(cores.rank, header.n);
+    payload.copyTo(cores.core, header.n);
+    cores.degeneracy = header.degeneracy;
+    checkCoresOrThrow(cores, header.n);
+    graph.adoptCoreDecomposition(std::move(cores));
+  }
+  if ((header.sections & SECTION_ADJACENCY) != 0) {
+    const size_t rowBytes = header.rowCount * FastAdjacencyHash::ROW_BYTES;
+    const size_t bucketBytes =
+        header.bucketCount * FastAdjacencyHash::BUCKET_BYTES;
+    const unsigned char *rows = payload.take(rowBytes);
+    const unsigned char *buckets = payload.take(bucketBytes);
+    if (header.rowCount != header.n)
+      throw std::runtime_error("graph artifact adjacency rows mismatch");
+    graph.adoptAdjacencyHash(std::make_shared<const FastAdjacencyHash>(
+        rows, header.rowCount, buckets, header.bucketCount));
+  }
+  if ((header.sections & SECTION_BIPARTITE) != 0)
+    graph.recordBipartite(header.bipartite != 0);
+  if ((header.sections & SECTION_CHORDAL) != 0)
+    graph.recordChordal(header.chordal != 0);
+  if (!payload.atEnd())
+    throw std::runtime_error("graph artifact has trailing bytes");
+  storedSections = header.sections;
+  return true;
+}
+
+Graph GraphArtifactCache::load(const std::string &path) {
+  hit = false;
+  storedSections = 0;
+  {
+    MappedFile input(path);
+    if (!input.isOpen())
+      return Graph(path);
+    contentHash = hashBytes(input.bytes(), input.byteCount());
+    contentBytes = input.byteCount();
+  }
+
+  // A stale or damaged artifact, including one whose CSR or core order fails
+  // validation, is ignored and overwritten by store().
+  try {
+    Graph graph;
+    if (restore(graph)) {
+      hit = true;
+      graph.filePath = path;
+      loadedSorted = graph.adjacencySorted;
+      return graph;
+    }
+  } catch (const std::exception &) {
+    storedSections = 0;
+  }
+  Graph parsed(path);
+  parsed.filePath = path;
+  loadedSorted = parsed.adjacencySorted;
+  return parsed;
+}
+
+void GraphArtifactCache::store(const Graph &graph) const {
+  // A graph re-sorted in place no longer has the file's CSR order, and its
+  // artifact would change the tie order of later runs.
+  if (contentBytes == 0 || graph.adjacencySorted != loadedSorted)
+    return;
+  const unsigned sections = presentSections(graph);
+  if ((sections & ~storedSections) == 0)
+    return;
+
+  ArtifactHeader header{};
+  std::memcpy(header.magic, ARTIFACT_MAGIC, sizeof(ARTIFACT_MAGIC));
+  header.version = ARTIFACT_VERSION;
+  header.sections = sections;
+  header.contentHash = contentHash;
+  header.contentBytes = contentBytes;
+  header.n = graph.n;
+  header.m = graph.m;
+  header.neighborCount = graph.neighbors.size();
+  header.adjacencySorted = graph.adjacencySorted ? 1 : 0;
+  header.rowBytes = FastAdjacencyHash::ROW_BYTES;
+  header.bucketBytes = FastAdjacencyHash::BUCKET_BYTES;
+  const CoreDecomposition *cores = graph.cachedCoreDecomposition();
+  const FastAdjacencyHash *adjacency = graph.cachedAdjacencyHash();
+  if (cores != nullptr)
+    header.degeneracy = cores->degeneracy;
+  if (adjacency != nullptr) {
+    header.rowCount = adjacency->rowCount();
+    header.bucketCount = adjacency->bucketCount();
+  }
+  if (const bool *bipartite = graph.knownBipartite())
+    header.bipartite = *bipartite ? 1 : 0;
+  if (const bool *chordal = graph.knownChordal())
+    header.chordal = *chordal ? 1 : 0;
+
+  if (::mkdir(directory.c_str(), 0777) != 0 && errno != EEXIST)
+    throw std::runtime_error("cannot create graph artifact directory " +
+                             directory);
+  const std::string target = artifactPath();
+  const std::string temporary =
+      target + ".tmp." + std::to_string(static_cast<long>(::getpid()));
+  const int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (fd < 0)
+    throw std::runtime_error("cannot write graph artifact " + temporary);
+  try {
+    writeOrThrow(fd, &header, sizeof(header));
+    writeVector(fd, graph.offset);
+    writeVector(fd, graph.neighbors);
+    writeVector(fd, graph.degree);
+    if (cores != nullptr) {
+      writeVector(fd, cores->peelOrder);
+      writeVector(fd, cores->rank);
+      writeVector(fd, cores->core);
+    }
+    if (adjacency != nullptr) {
+      writeOrThrow(fd, adjacency->rowBytes(),
+                   adjacency->rowCount() * FastAdjacencyHash::ROW_BYTES);
+      writeOrThrow(fd, adjacency->bucketBytes(),
+                   adjacency->bucketCount() * FastAdjacencyHash::BUCKET_BYTES);
+    }
+  } catch (...) {
+    ::close(fd);
+    ::unlink(temporary.c_str());
+    throw;
+  }
+  ::close(fd);
+  if (::rename(temporary.c_str(), target.c_str()) != 0) {
+    ::unlink(temporary.c_str());
+    throw std::runtime_error("cannot publish graph artifact " + target);
+  }
+}
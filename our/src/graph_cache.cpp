@@ -0,0 +1,91 @@
+#include "../inc/graph_cache.h"
+#include "../inc/graph_artifacts.h"
+
+#include <stdexcept>
+
+GraphCache::GraphCache(size_t cacheCapacity, std::string artifacts)
+    : capacity(std::max<size_t>(1, cacheCapacity)),
+      artifactDirectory(std::move(artifacts)), hits(0), misses(0) {}
+
+void GraphCache::prepare(Graph &g) {
+  g.sortAdjacency();
+  g.coreDecomposition();
+  g.adjacencyHash();
+}
+
+std::shared_ptr<Graph> GraphCache::acquire(const std::string &path,
+                                           bool *hit) {
+  // Graph(path) exits the process on an unreadable file, so that is checked
+  // first.
+  struct stat info {};
+  if (stat(path.c_str(), &info) != 0 || !S_ISREG(info.st_mode) ||
+      !std::ifstream(path))
+    throw std::runtime_error("cannot read graph " + path);
+  const ull bytes = static_cast<ull>(info.st_size);
+  const long long modifiedNs =
+      static_cast<long long>(info.st_mtim.tv_sec) * 1000000000LL +
+      info.st_mtim.tv_nsec;
+
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = index.find(path);
+    if (found != index.end()) {
+      Entry &entry = *found->second;
+      if (entry.bytes == bytes && entry.modifiedNs == modifiedNs) {
+        entries.splice(entries.begin(), entries, found->second);
+        ++hits;
+        if (hit != nullptr)
+          *hit = true;
+        return entry.graph;
+      }
+      entries.erase(found->second);
+      index.erase(found);
+    }
+    ++misses;
+  }
+  if (hit != nullptr)
+    *hit = false;
+
+  std::shared_ptr<Graph> graph;
+  if (artifactDirectory.empty()) {
+    graph = std::make_shared<Graph>(path);
+    prepare(*graph);
+  } else {
+    GraphArtifactCache artifacts(artifactDirectory);
+    graph = std::make_shared<Graph>(artifacts.load(path));
+    prepare(*graph);
+    artifacts.store(*graph);
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  auto found = index.find(path);
+  if (found != index.end() && found->second->bytes == bytes &&
+      found->second->modifiedNs == modifiedNs)
+    return found->second->graph;
+  if (found != index.end()) {
+    entries.erase(found->second);
+    index.erase(found);
+  }
+  entries.push_front({path, bytes, modifiedNs, graph});
+  index[path] = entries.begin();
+  while (entries.size() > capacity) {
+    index.erase(entries.back().path);
+    entries.pop_back();
+  }
+  return graph;
+}
+
+size_t GraphCache::size() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return entries.size();
+}
+
+ull GraphCache::getHits() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return hits;
+}
+
+ull GraphCache::getMisses() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return misses;
+}
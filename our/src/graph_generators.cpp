@@ -0,0 +1,334 @@
+#include "../inc/graph_generators.h"
+
+#include <random>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+using EdgeList = std::vector<std::pair<ui, ui>>;
+
+void checkProbability(double p, const char *name) {
+  if (!(p >= 0.0 && p <= 1.0))
+    throw std::invalid_argument(std::string(name) + " must lie in [0, 1]");
+}
+
+// Batagelj-Brandes skipping over the pairs (w, v), w < v, of vertices
+// first..first + n - 1.
+void appendErdosRenyiEdges(EdgeList &edges, ui first, ui n, double p,
+                           std::mt19937_64 &random) {
+  if (n < 2 || p <= 0.0)
+    return;
+  if (p >= 1.0) {
+    for (ui v = 1; v < n; ++v) {
+      for (ui w = 0; w < v; ++w)
+        edges.emplace_back(first + w, first + v);
+    }
+    return;
+  }
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  const double logMiss = std::log1p(-p);
+  long long v = 1;
+  long long w = -1;
+  while (v < static_cast<long long>(n)) {
+    const double skip = std::floor(std::log1p(-uniform(random)) / logMiss);
+    w += 1 + static_cast<long long>(std::min(skip, 9.0e18));
+    while (w >= v && v < static_cast<long long>(n)) {
+      w -= v;
+      ++v;
+    }
+    if (v < static_cast<long long>(n))
+      edges.emplace_back(first + static_cast<ui>(w), first + static_cast<ui>(v));
+  }
+}
+
+// Lookup of "key=value" spec fields that rejects unused keys.
+class SpecFields {
+private:
+  std::string family;
+  std::vector<std::pair<std::string, std::string>> fields;
+  std::vector<bool> used;
+
+  const std::string *raw(const std::string &key) {
+    for (size_t i = 0; i < fields.size(); ++i) {
+      if (fields[i].first == key) {
+        used[i] = true;
+        return &fields[i].second;
+      }
+    }
+    return nullptr;
+  }
+
+public:
+  explicit SpecFields(const std::string &spec) {
+    const size_t colon = spec.find(':');
+    family = spec.substr(0, colon);
+    if (colon == std::string::npos)
+      return;
+    std::stringstream stream(spec.substr(colon + 1));
+    std::string field;
+    while (std::getline(stream, field, ',')) {
+      const size_t equals = field.find('=');
+      if (equals == std::string::npos || equals == 0)
+        throw std::invalid_argument("malformed generator field: " + field);
+      fields.emplace_back(field.substr(0, equals), field.substr(equals + 1));
+      used.push_back(false);
+    }
+  }
+
+  const std::string &getFamily() const { return family; }
+
+  double number(const std::string &key, const double *fallback = nullptr) {
+    const std::string *value = raw(key);
+    if (value == nullptr) {
+      if (fallback == nullptr)
+        throw std::invalid_argument(family + " generator needs " + key);
+      return *fallback;
+    }
+    size_t parsed = 0;
+    const double result = std::stod(*value, &parsed);
+    if (parsed != value->size())
+      throw std::invalid_argument("bad number for " + key + ": " + *value);
+    return result;
+  }
+
+  ui count(const std::string &key) {
+    const double value = number(key);
+    if (value < 0 || value > UINT_MAX || value != std::floor(value))
+      throw std::invalid_argument(key + " must be a non-negative integer");
+    return static_cast<ui>(value);
+  }
+
+  ull seed() {
+    const std::string *value = raw("seed");
+    return value == nullptr ? 1 : std::stoull(*value);
+  }
+
+  void finish() const {
+    for (size_t i = 0; i < fields.size(); ++i) {
+      if (!used[i])
+        throw std::invalid_argument("unknown " + family +
+                                    " generator key: " + fields[i].first);
+    }
+  }
+};
+
+} // namespace
+
+Graph generateErdosRenyi(ui n, double p, ull seed) {
+  checkProbability(p, "p");
+  std::mt19937_64 random(seed);
+  EdgeList edges;
+  appendErdosRenyiEdges(edges, 0, n, p, random);
+  return Graph(n, edges);
+}
+
+Graph generateBarabasiAlbert(ui n, ui edgesPerVertex, ull seed) {
+  if (edgesPerVertex == 0)
+    throw std::invalid_argument("Barabasi-Albert needs edgesPerVertex > 0");
+  std::mt19937_64 random(seed);
+  EdgeList edges;
+  // Every edge endpoint once, so a uniform pick is degree-proportional.
+  std::vector<ui> endpoints;
+  const ui seedVertices = std::min<ui>(n, edgesPerVertex + 1);
+  for (ui v = 1; v < seedVertices; ++v) {
+    for (ui w = 0; w < v; ++w) {
+      edges.emplace_back(w, v);
+      endpoints.push_back(w);
+      endpoints.push_back(v);
+    }
+  }
+  std::vector<ui> chosen;
+  for (ui v = seedVertices; v < n; ++v) {
+    chosen.clear();
+    std::uniform_int_distribution<size_t> pick(0, endpoints.size() - 1);
+    while (chosen.size() < edgesPerVertex) {
+      const ui target = endpoints[pick(random)];
+      if (std::find(chosen.begin(), chosen.end(), target) == chosen.end())
+        chosen.push_back(target);
+    }
+    for (ui target : chosen) {
+      edges.emplace_back(target, v);
+      endpoints.push_back(target);
+      endpoints.push_back(v);
+    }
+  }
+  return Graph(n, edges);
+}
+
+Graph generateRmat(ui scale, ui edgeFactor, double a, double b, double c,
+                   ull seed) {
+  if (scale == 0 || scale > 31)
+    throw std::invalid_argument("R-MAT scale must lie in [1, 31]");
+  checkProbability(a, "a");
+  checkProbability(b, "b");
+  checkProbability(c, "c");
+  if (a + b + c > 1.0)
+    throw std::invalid_argument("R-MAT needs a + b + c <= 1");
+  const ui n = 1U << scale;
+  const ull edgeCount = static_cast<ull>(edgeFactor) * n;
+  std::mt19937_64 random(seed);
+  std::uniform_real_distribution<double> uniform(0.0, 1.0);
+  EdgeList edges;
+  edges.reserve(edgeCount);
+  for (ull e = 0; e < edgeCount; ++e) {
+    ui u = 0;
+    ui v = 0;
+    for (ui bit = 0; bit < scale; ++bit) {
+      const double r = uniform(random);
+      u <<= 1;
+      v <<= 1;
+      if (r < a) {
+      } else if (r < a + b) {
+        v |= 1;
+      } else if (r < a + b + c) {
+        u |= 1;
+      } else {
+        u |= 1;
+        v |= 1;
+      }
+    }
+    edges.emplace_back(u, v);
+  }
+  // Without relabelling the high-degree vertices cluster at small ids.
+  std::vector<ui> relabel(n);
+  for (ui v = 0; v < n; ++v)
+    relabel[v] = v;
+  std::shuffle(relabel.begin(), relabel.end(), random);
+  for (auto &[u, v] : edges) {
+    u = relabel[u];
+    v = relabel[v];
+  }
+  return Graph(n, edges);
+}
+
+Graph generatePlantedCores(ui n, double backgroundP, ui coreCount,
+                           ui coreSize, double coreDensity, ull seed) {
+  checkProbability(backgroundP, "backgroundP");
+  checkProbability(coreDensity, "coreDensity");
+  if (static_cast<ull>(coreCount) * coreSize > n)
+    throw std::invalid_argument("planted cores do not fit in n vertices");
+  std::mt19937_64 random(seed);
+  EdgeList edges;
+  appendErdosRenyiEdges(edges, 0, n, backgroundP, random);
+
+  std::vector<ui> vertices(n);
+  for (ui v = 0; v < n; ++v)
+    vertices[v] = v;
+  std::shuffle(vertices.begin(), vertices.end(), random);
+  EdgeList coreEdges;
+  for (ui core = 0; core < coreCount; ++core) {
+    coreEdges.clear();
+    appendErdosRenyiEdges(coreEdges, 0, coreSize, coreDensity, random);
+    const ui *members = vertices.data() + static_cast<size_t>(core) * coreSize;
+    for (const auto &[u, v] : coreEdges)
+      edges.emplace_back(members[u], members[v]);
+  }
+  return Graph(n, edges);
+}
+
+Graph generateMoonMoser(ui parts) {
+  if (parts > UINT_MAX / 3)
+    throw std::invalid_argument("Moon-Moser part count too large");
+  const ui n = 3 * parts;
+  EdgeList edges;
+  for (ui u = 0; u < n; ++u) {
+    for (ui v = (u / 3 + 1) * 3; v < n; ++v)
+      edges.emplace_back(u, v);
+  }
+  return Graph(n, edges);
+}
+
+Graph generateTwinHeavy(ui baseN, double baseP, ui classSize,
+                        double trueTwinFraction, ull seed) {
+  checkProbability(baseP, "baseP");
+  checkProbability(trueTwinFraction, "trueTwinFraction");
+  if (classSize == 0 ||
+      static_cast<ull>(baseN) * classSize > static_cast<ull>(UINT_MAX))
+    throw std::invalid_argument("twin-heavy class size out of range");
+  std::mt19937_64 random(seed);
+  EdgeList baseEdges;
+  appendErdosRenyiEdges(baseEdges, 0, baseN, baseP, random);
+
+  EdgeList edges;
+  std::bernoulli_distribution trueTwins(trueTwinFraction);
+  for (ui b = 0; b < baseN; ++b) {
+    if (!trueTwins(random))
+      continue;
+    for (ui i = 1; i < classSize; ++i) {
+      for (ui j = 0; j < i; ++j)
+        edges.emplace_back(b * classSize + j, b * classSize + i);
+    }
+  }
+  for (const auto &[a, b] : baseEdges) {
+    for (ui i = 0; i < classSize; ++i) {
+      for (ui j = 0; j < classSize; ++j)
+        edges.emplace_back(a * classSize + i, b * classSize + j);
+    }
+  }
+  return Graph(baseN * classSize, edges);
+}
+
+Graph generateChordal(ui n, ui maxCliqueSize, ull seed) {
+  if (maxCliqueSize < 2)
+    throw std::invalid_argument("chordal generator needs maxCliqueSize >= 2");
+  std::mt19937_64 random(seed);
+  EdgeList edges;
+  // earlierClique[v] is v plus its earlier neighbors, a clique.
+  std::vector<std::vector<ui>> earlierClique(n);
+  std::vector<ui> pool;
+  for (ui v = 0; v < n; ++v) {
+    std::vector<ui> &clique = earlierClique[v];
+    if (v > 0) {
+      const ui u = std::uniform_int_distribution<ui>(0, v - 1)(random);
+      pool.assign(earlierClique[u].begin(), earlierClique[u].end() - 1);
+      std::shuffle(pool.begin(), pool.end(), random);
+      const size_t extra = std::uniform_int_distribution<size_t>(
+          0, std::min<size_t>(pool.size(), maxCliqueSize - 2))(random);
+      clique.assign(pool.begin(), pool.begin() + extra);
+      clique.push_back(u);
+      for (ui w : clique)
+        edges.emplace_back(w, v);
+    }
+    clique.push_back(v);
+  }
+  return Graph(n, edges);
+}
+
+Graph generateGraphFromSpec(const std::string &spec) {
+  SpecFields fields(spec);
+  const std::string &family = fields.getFamily();
+  Graph g;
+  if (family == "gnp") {
+    g = generateErdosRenyi(fields.count("n"), fields.number("p"),
+                           fields.seed());
+  } else if (family == "ba") {
+    g = generateBarabasiAlbert(fields.count("n"), fields.count("k"),
+                               fields.seed());
+  } else if (family == "rmat") {
+    const double a = 0.57, b = 0.19, c = 0.19, edgeFactor = 16;
+    g = generateRmat(fields.count("scale"),
+                     static_cast<ui>(fields.number("ef", &edgeFactor)),
+                     fields.number("a", &a), fields.number("b", &b),
+                     fields.number("c", &c), fields.seed());
+  } else if (family == "planted") {
+    g = generatePlantedCores(fields.count("n"), fields.number("p"),
+                             fields.count("cores"), fields.count("size"),
+                             fields.number("density"), fields.seed());
+  } else if (family == "moonmoser") {
+    g = generateMoonMoser(fields.count("parts"));
+  } else if (family == "twins") {
+    const double half = 0.5;
+    g = generateTwinHeavy(fields.count("n"), fields.number("p"),
+                          fields.count("size"), fields.number("true", &half),
+                          fields.seed());
+  } else if (family == "chordal") {
+    g = generateChordal(fields.count("n"), fields.count("omega"),
+                        fields.seed());
+  } else {
+    throw std::invalid_argument("unknown generator family: " + family);
+  }
+  fields.finish();
+  g.filePath = spec;
+  return g;
+}
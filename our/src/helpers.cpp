@@ -1,5 +1,7 @@
 #include "../inc/helpers.h"
 #include "../inc/fast_plex3.h"
+#include "../inc/perf_counters.h"
+#include "../inc/runtime_counters.h"
 #include <chrono>
 #include <functional>
 #include <iomanip>
@@ -7,92 +9,45 @@
 // Returns peelSeq index of verticies by core value
 // peelSeq[0] = highest-core vertex, peelSeq[n-1] = lowest.
 static vector<ui> computePeelSeq(const Graph &g, ui *degeneracy = nullptr) {
-  ui n = g.n;
+  const CoreDecomposition &cores = g.coreDecomposition();
   if (degeneracy != nullptr)
-    *degeneracy = 0;
-  if (n == 0)
-    return {};
-
-  vector<ui> deg(g.degree.begin(), g.degree.end());
-  ui maxDeg = *max_element(deg.begin(), deg.end());
-  ui maxCore = 0;
-
-  vector<ui> bins(maxDeg + 1, 0);
-  for (ui d : deg)
-    bins[d]++;
-  vector<ui> binStart(maxDeg + 1, 0);
-  partial_sum(bins.begin(), bins.end() - 1, binStart.begin() + 1);
-
-  vector<ui> pos(n), sorted(n);
-  for (ui v = 0; v < n; v++) {
-    pos[v] = binStart[deg[v]]++;
-    sorted[pos[v]] = v;
-  }
-  for (ui d = 0; d <= maxDeg; d++)
-    binStart[d] -= bins[d]; // reset to start of each bin
-
-  vector<ui> peelSeq(n);
-  for (ui i = 0; i < n; i++) {
-    ui v = sorted[i];
-    maxCore = max(maxCore, deg[v]);
-    peelSeq[n - 1 - i] = v; // ascending peel order → descending in array
-    for (ui j = g.offset[v]; j < g.offset[v + 1]; j++) {
-      ui u = g.neighbors[j];
-      if (deg[u] > deg[v]) {
-        ui du = deg[u];
-        ui pu = pos[u];
-        ui pw = binStart[du];
-        ui w = sorted[pw];
-        if (u != w) {
-          pos[u] = pw;
-          sorted[pu] = w;
-          pos[w] = pu;
-          sorted[pw] = u;
-        }
-        binStart[du]++;
-        deg[u]--;
-      }
-    }
-  }
-  if (degeneracy != nullptr)
-    *degeneracy = maxCore;
-  return peelSeq;
+    *degeneracy = cores.degeneracy;
+  return vector<ui>(cores.peelOrder.rbegin(), cores.peelOrder.rend());
 }
 
-ui graphDegeneracy(const Graph &g) {
-  ui degeneracy = 0;
-  computePeelSeq(g, &degeneracy);
-  return degeneracy;
-}
+ui graphDegeneracy(const Graph &g) { return g.coreDecomposition().degeneracy; }
 
-static bool graphIsBipartite(const Graph &g) {
-  vector<int> color(g.n, -1);
-  vector<ui> queue;
-  queue.reserve(g.n);
-  for (ui s = 0; s < g.n; s++) {
-    if (color[s] != -1)
-      continue;
-    color[s] = 0;
-    queue.clear();
-    queue.push_back(s);
-    for (size_t head = 0; head < queue.size(); head++) {
-      ui u = queue[head];
-      for (ui i = g.offset[u]; i < g.offset[u + 1]; i++) {
-        ui v = g.neighbors[i];
-        if (color[v] == -1) {
-          color[v] = color[u] ^ 1;
-          queue.push_back(v);
-        } else if (color[v] == color[u]) {
-          return false;
-        }
-      }
-    }
-  }
-  return true;
+bool adaptiveUsesBitsetBK(const Graph &g) {
+  const ull words = (g.n + 63) >> 6;
+  const ull denseBytes = (ull)g.n * words * sizeof(ull);
+  const double avgDegree =
+      g.n == 0 ? 0.0 : (2.0 * static_cast<double>(g.m)) / g.n;
+  ui maxDegree = 0;
+  ui zeroDegree = 0;
+  for (ui d : g.degree) {
+    maxDegree = max(maxDegree, d);
+    if (d == 0)
+      zeroDegree++;
+  }
+  const bool cheapModuleDense = g.n <= 16000 && avgDegree >= 6.0 &&
+                                maxDegree >= 90 && zeroDegree * 4 >= g.n;
+  const bool denseCoreCandidate = !cheapModuleDense &&
+                                  denseBytes <= (64ULL << 20) &&
+                                  avgDegree >= 3.0 && maxDegree >= 90;
+  const ui degeneracy = denseCoreCandidate ? graphDegeneracy(g) : 0;
+  return denseBytes <= (64ULL << 20) &&
+         (g.n <= 1000 || (g.n <= 8000 && avgDegree >= 10.0) ||
+          (g.n <= 10000 && avgDegree >= 14.0) || cheapModuleDense ||
+          (g.n <= 16000 && avgDegree >= 6.0 && maxDegree >= 90 &&
+           degeneracy >= 45) ||
+          (g.n <= 16000 && avgDegree >= 40.0) ||
+          (g.n <= 18000 && avgDegree >= 44.0) || avgDegree >= 46.0 ||
+          degeneracy >= 64);
 }
 
 static bool detectMaxDegreeTwoGraph(const Graph &g, ull &cliqueCount,
-                                    ui &maxCliqueSize) {
+                                    ui &maxCliqueSize,
+                                    CliqueSizeHistogram &histogram) {
   for (ui d : g.degree) {
     if (d > 2)
       return false;
@@ -104,6 +59,7 @@ static bool detectMaxDegreeTwoGraph(const Graph &g, ull &cliqueCount,
 
   cliqueCount = 0;
   maxCliqueSize = 0;
+  histogram.clear();
   for (ui start = 0; start < g.n; start++) {
     if (seen[start])
       continue;
@@ -127,6 +83,7 @@ static bool detectMaxDegreeTwoGraph(const Graph &g, ull &cliqueCount,
     if (queue.size() == 3 && degreeSum == 6) {
       cliqueCount++;
       maxCliqueSize = 3;
+      addCliqueSizeCountOrThrow(histogram, 3, 1);
     }
   }
   return true;
@@ -146,13 +103,15 @@ static bool shouldDetectCliqueComponentsGraph(const Graph &g) {
 }
 
 static bool detectCliqueComponentsGraph(const Graph &g, ull &cliqueCount,
-                                        ui &maxCliqueSize) {
+                                        ui &maxCliqueSize,
+                                        CliqueSizeHistogram &histogram) {
   vector<char> seen(g.n, 0);
   vector<ui> queue;
   queue.reserve(g.n);
 
   cliqueCount = 0;
   maxCliqueSize = 0;
+  histogram.clear();
   for (ui start = 0; start < g.n; start++) {
     if (seen[start])
       continue;
@@ -179,15 +138,18 @@ static bool detectCliqueComponentsGraph(const Graph &g, ull &cliqueCount,
     if (size >= 3) {
       cliqueCount++;
       maxCliqueSize = max(maxCliqueSize, (ui)size);
+      addCliqueSizeCountOrThrow(histogram, size, 1);
     }
   }
   return true;
 }
 
-static bool detectChordalGraph(const Graph &g, ull &cliqueCount,
-                               ui &maxCliqueSize) {
+static bool solveChordalGraph(const Graph &g, ull &cliqueCount,
+                              ui &maxCliqueSize,
+                              CliqueSizeHistogram &histogram) {
   cliqueCount = 0;
   maxCliqueSize = 0;
+  histogram.clear();
   const ui n = g.n;
   if (n == 0)
     return true;
@@ -302,11 +264,30 @@ static bool detectChordalGraph(const Graph &g, ull &cliqueCount,
       containing[v].push_back(id);
     cliqueCount++;
     maxCliqueSize = max(maxCliqueSize, (ui)bag.size());
+    addCliqueSizeCountOrThrow(histogram, bag.size(), 1);
   }
 
   return true;
 }
 
+// The chordality verdict is a property of the graph alone, so it is kept on
+// the Graph; a known non-chordal graph skips the MCS pass.
+static bool detectChordalGraph(const Graph &g, ull &cliqueCount,
+                               ui &maxCliqueSize,
+                               CliqueSizeHistogram &histogram) {
+  const bool *known = g.knownChordal();
+  if (known != nullptr && !*known) {
+    cliqueCount = 0;
+    maxCliqueSize = 0;
+    histogram.clear();
+    return false;
+  }
+  const bool chordal =
+      solveChordalGraph(g, cliqueCount, maxCliqueSize, histogram);
+  g.recordChordal(chordal);
+  return chordal;
+}
+
 static ui nextClosedValue(const Graph &g, ui v, ui &idx, bool &selfPending) {
   const ui end = g.offset[v + 1];
   if (selfPending && (idx == end || v < g.neighbors[idx])) {
@@ -382,9 +363,11 @@ static bool externalNeighborhoodEqual(const Graph &g, const vector<ui> &classOf,
 }
 
 static bool solveTwinModuleQuotientGraph(const Graph &g, ull &quotientCount,
-                                         ui &quotientMaxSize) {
+                                         ui &quotientMaxSize,
+                                         CliqueSizeHistogram &histogram) {
   quotientCount = 0;
   quotientMaxSize = 0;
+  histogram.clear();
   const ui n = g.n;
   if (n == 0)
     return false;
@@ -549,6 +532,7 @@ static bool solveTwinModuleQuotientGraph(const Graph &g, ull &quotientCount,
           if (xEmpty && rWeight > 2) {
             quotientCount += multiplicity;
             quotientMaxSize = max(quotientMaxSize, rWeight);
+            addCliqueSizeCountOrThrow(histogram, rWeight, multiplicity);
           }
           return;
         }
@@ -639,6 +623,8 @@ PivotBK::PivotBK(Graph &g, DegOrder order) {
   cliqueCount = 0;
   maxCliqueSize = 0;
   checksCount = 0;
+  summaryOutput = true;
+  budget = nullptr;
 
   vector<ui> perm(n);
 
@@ -717,6 +703,9 @@ ui PivotBK::choosePivot(const vector<ui> &P, const vector<ui> &X) {
 void PivotBK::bronKerboschRecursive(vector<ui> &R, vector<ui> &P,
                                     vector<ui> &X) {
   checksCount++;
+  if (budget != nullptr &&
+      budget->exhausted(checksCount, cliqueCount, nextBudgetClock))
+    return;
 
   // Basic pruning: check if P and X are empty
   // Clique found
@@ -727,6 +716,7 @@ void PivotBK::bronKerboschRecursive(vector<ui> &R, vector<ui> &P,
     // Found a maximal clique
     cliqueCount++;
     maxCliqueSize = max(maxCliqueSize, (ui)R.size());
+    addCliqueSizeCountOrThrow(cliqueSizeHistogram, R.size(), 1);
     return;
   }
 
@@ -768,6 +758,19 @@ void PivotBK::bronKerboschRecursive(vector<ui> &R, vector<ui> &P,
     X.insert(lower_bound(X.begin(), X.end(), v), v);
   }
 }
+namespace {
+const EngineRunCounters pivotBkCounters("pivotbk");
+const EngineRunCounters bitsetBkCounters("bitsetbk");
+const EngineRunCounters localBitsetBkCounters("localbitsetbk");
+const PerfRegion pivotBkSearchPerf("pivotbk.search", false);
+const PerfRegion bitsetBkSearchPerf("bitsetbk.search", false);
+const PerfRegion bitsetBkPivotPerf("bitsetbk.pivot", true);
+const PerfRegion localBitsetBkSearchPerf("localbitsetbk.search", false);
+const PerfRegion localBitsetBkRootPerf("localbitsetbk.root_build", true);
+const PerfRegion localBitsetBkPivotPerf("localbitsetbk.pivot", true);
+const PerfRegion localBitsetBkIntersectPerf("localbitsetbk.intersect", true);
+} // namespace
+
 void PivotBK::findAllMaximalCliques() {
   vector<ui> R;
   vector<ui> X;
@@ -779,12 +782,18 @@ void PivotBK::findAllMaximalCliques() {
   cliqueCount = 0;
   maxCliqueSize = 0;
   checksCount = 0;
+  cliqueSizeHistogram.clear();
 
   auto t0 = chrono::high_resolution_clock::now();
+  ScopedPerfRegion perf(pivotBkSearchPerf);
   bronKerboschRecursive(R, P, X);
+  perf.stop();
   auto t1 = chrono::high_resolution_clock::now();
   double ms = chrono::duration<double, milli>(t1 - t0).count();
+  pivotBkCounters.report(checksCount, cliqueCount, ms);
 
+  if (!summaryOutput)
+    return;
   cout << "Total Maximal Cliques Found: " << cliqueCount << endl;
   cout << "Maximum Clique Size: " << maxCliqueSize << endl;
   cout << "Total Vertex-Set Checks: " << checksCount << endl;
@@ -793,6 +802,9 @@ void PivotBK::findAllMaximalCliques() {
 
 BitsetBK::BitsetBK(Graph &g) {
   n = g.n;
+  summaryOutput = true;
+  rootCosts = nullptr;
+  budget = nullptr;
   degeneracy = 0;
   lowDegreeGraph = false;
   lowDegreeCliqueCount = 0;
@@ -826,7 +838,8 @@ BitsetBK::BitsetBK(Graph &g) {
   depthActive.reserve(n + 1);
 
   lowDegreeGraph =
-      detectMaxDegreeTwoGraph(g, lowDegreeCliqueCount, lowDegreeMaxSize);
+      detectMaxDegreeTwoGraph(g, lowDegreeCliqueCount, lowDegreeMaxSize,
+                              cliqueSizeHistogram);
   if (lowDegreeGraph)
     return;
 
@@ -834,23 +847,26 @@ BitsetBK::BitsetBK(Graph &g) {
     cliqueComponents = true;
     cliqueComponentCount = 1;
     cliqueComponentMaxSize = n;
+    addCliqueSizeCountOrThrow(cliqueSizeHistogram, n, 1);
     return;
   }
 
-  bipartite = graphIsBipartite(g);
+  bipartite = g.isBipartite();
   if (bipartite)
     return;
 
   if (shouldDetectCliqueComponentsGraph(g)) {
     cliqueComponents =
         detectCliqueComponentsGraph(g, cliqueComponentCount,
-                                    cliqueComponentMaxSize);
+                                    cliqueComponentMaxSize,
+                                    cliqueSizeHistogram);
     if (cliqueComponents)
       return;
   }
 
   if (n <= 12000) {
-    chordalGraph = detectChordalGraph(g, chordalCliqueCount, chordalMaxSize);
+    chordalGraph = detectChordalGraph(g, chordalCliqueCount, chordalMaxSize,
+                                      cliqueSizeHistogram);
     if (chordalGraph)
       return;
   }
@@ -878,19 +894,19 @@ BitsetBK::BitsetBK(Graph &g) {
   twinModuleQuotient =
       n >= 1000 && avgDegree >= 128.0 &&
       solveTwinModuleQuotient(twinModuleQuotientCount,
-                              twinModuleQuotientMaxSize);
+                              twinModuleQuotientMaxSize, cliqueSizeHistogram);
   if (twinModuleQuotient)
     return;
   falseTwinQuotient =
       n >= 2000 && avgDegree >= 128.0 &&
       solveFalseTwinQuotient(falseTwinQuotientCount,
-                             falseTwinQuotientMaxSize);
+                             falseTwinQuotientMaxSize, cliqueSizeHistogram);
   if (falseTwinQuotient)
     return;
   trueTwinQuotient =
       n >= 2000 && avgDegree >= 128.0 &&
       solveTrueTwinQuotient(trueTwinQuotientCount,
-                            trueTwinQuotientMaxSize);
+                            trueTwinQuotientMaxSize, cliqueSizeHistogram);
   if (trueTwinQuotient)
     return;
   if (n <= 4096 || g.m * 4ULL >= (ull)n * (n - 1) / 2)
@@ -907,9 +923,11 @@ bool BitsetBK::isConnected(ui u, ui v) const {
 }
 
 bool BitsetBK::solveTwinModuleQuotient(ull &quotientCount,
-                                       ui &quotientMaxSize) const {
+                                       ui &quotientMaxSize,
+                                       CliqueSizeHistogram &histogram) const {
   quotientCount = 0;
   quotientMaxSize = 0;
+  histogram.clear();
 
   auto closedWord = [&](ui v, ui wi) {
     ull word = neighbors(v)[wi];
@@ -1100,6 +1118,7 @@ bool BitsetBK::solveTwinModuleQuotient(ull &quotientCount,
           if (xEmpty && rWeight > 2) {
             quotientCount += multiplicity;
             quotientMaxSize = max(quotientMaxSize, rWeight);
+            addCliqueSizeCountOrThrow(histogram, rWeight, multiplicity);
           }
           return;
         }
@@ -1164,9 +1183,11 @@ bool BitsetBK::solveTwinModuleQuotient(ull &quotientCount,
 }
 
 bool BitsetBK::solveFalseTwinQuotient(ull &quotientCount,
-                                      ui &quotientMaxSize) const {
+                                      ui &quotientMaxSize,
+                                      CliqueSizeHistogram &histogram) const {
   quotientCount = 0;
   quotientMaxSize = 0;
+  histogram.clear();
 
   vector<ui> vertices(n);
   iota(vertices.begin(), vertices.end(), 0);
@@ -1244,6 +1265,7 @@ bool BitsetBK::solveFalseTwinQuotient(ull &quotientCount,
           if (xEmpty && rSize > 2) {
             quotientCount += multiplicity;
             quotientMaxSize = max(quotientMaxSize, rSize);
+            addCliqueSizeCountOrThrow(histogram, rSize, multiplicity);
           }
           return;
         }
@@ -1308,9 +1330,11 @@ bool BitsetBK::solveFalseTwinQuotient(ull &quotientCount,
 }
 
 bool BitsetBK::solveTrueTwinQuotient(ull &quotientCount,
-                                     ui &quotientMaxSize) const {
+                                     ui &quotientMaxSize,
+                                     CliqueSizeHistogram &histogram) const {
   quotientCount = 0;
   quotientMaxSize = 0;
+  histogram.clear();
 
   auto closedWord = [&](ui v, ui wi) {
     ull word = neighbors(v)[wi];
@@ -1417,6 +1441,7 @@ bool BitsetBK::solveTrueTwinQuotient(ull &quotientCount,
           if (xEmpty && rWeight > 2) {
             quotientCount++;
             quotientMaxSize = max(quotientMaxSize, rWeight);
+            addCliqueSizeCountOrThrow(histogram, rWeight, 1);
           }
           return;
         }
@@ -1494,62 +1519,28 @@ void BitsetBK::detectCompleteMultipartite() {
     state.second += next.second;
   };
 
-    auto smallMaximalCounts = [&](const vector<ui> &component) {
-    array<ull, 3> small{};
-    const ui size = (ui)component.size();
-
-    for (ui i = 0; i < size; i++) {
-      ui a = component[i];
-      bool dominates = true;
-      for (ui w : component) {
-        if (w != a && isConnected(a, w)) {
-          dominates = false;
-          break;
-        }
-      }
-      if (dominates)
-        small[1]++;
-    }
-
-    for (ui i = 0; i < size; i++) {
-      ui a = component[i];
-      for (ui j = i + 1; j < size; j++) {
-        ui b = component[j];
-        if (!isConnected(a, b))
-          continue;
-        bool dominates = true;
-        for (ui w : component) {
-          if (w == a || w == b)
-            continue;
-          if (isConnected(a, w) && isConnected(b, w)) {
-            dominates = false;
-            break;
-          }
-        }
-        if (dominates)
-          small[2]++;
-      }
-    }
-      return small;
-    };
-
+  // bySize[k] counts the maximal independent sets of size k, so products of
+  // summaries are polynomial products and the final one is the clique-size
+  // distribution of the whole graph.
   struct MisSummary {
     ull count = 0;
     ui maxSize = 0;
-    array<ull, 3> small{0, 0, 0};
+    vector<ull> bySize;
   };
 
   auto emptySummary = [](const MisSummary &summary) {
     return summary.count == 0 && summary.maxSize == 0 &&
-           summary.small[0] == 0 && summary.small[1] == 0 &&
-           summary.small[2] == 0;
+           all_of(summary.bySize.begin(), summary.bySize.end(),
+                  [](ull c) { return c == 0; });
   };
 
   auto addSummary = [](MisSummary &dst, const MisSummary &src) {
     dst.count += src.count;
     dst.maxSize = max(dst.maxSize, src.maxSize);
-    for (ui i = 0; i <= 2; i++)
-      dst.small[i] += src.small[i];
+    if (dst.bySize.size() < src.bySize.size())
+      dst.bySize.resize(src.bySize.size(), 0);
+    for (size_t i = 0; i < src.bySize.size(); i++)
+      dst.bySize[i] += src.bySize[i];
   };
 
   auto multiplySummary = [&](const MisSummary &a, const MisSummary &b) {
@@ -1558,85 +1549,76 @@ void BitsetBK::detectCompleteMultipartite() {
       return out;
     out.count = a.count * b.count;
     out.maxSize = a.maxSize + b.maxSize;
-      for (ui i = 0; i <= 2; i++) {
-        for (ui j = 0; i + j <= 2; j++)
-          out.small[i + j] += a.small[i] * b.small[j];
-      }
-      return out;
-    };
+    out.bySize.assign(a.bySize.size() + b.bySize.size() - 1, 0);
+    for (size_t i = 0; i < a.bySize.size(); i++) {
+      if (a.bySize[i] == 0)
+        continue;
+      for (size_t j = 0; j < b.bySize.size(); j++)
+        out.bySize[i + j] += a.bySize[i] * b.bySize[j];
+    }
+    return out;
+  };
 
   auto singletonSummary = [](ui size) {
     MisSummary out;
     out.count = 1;
     out.maxSize = size;
-    if (size <= 2)
-      out.small[size] = 1;
+    out.bySize.assign(size + 1, 0);
+    out.bySize[size] = 1;
     return out;
   };
 
-  auto solvePath = [](ui len) {
-    map<pair<int, int>, pair<ull, ui>> dp;
-    auto addState = [](map<pair<int, int>, pair<ull, ui>> &states,
-                       pair<int, int> key, ull count, ui maxSize) {
-      auto &slot = states[key];
-      slot.first += count;
-      slot.second = max(slot.second, maxSize);
-    };
-
-    addState(dp, {0, 0}, 1, 0);
-    addState(dp, {1, 1}, 1, 1);
+  auto solvePath = [&](ui len) {
+    map<pair<int, int>, MisSummary> dp;
+    dp[{0, 0}] = singletonSummary(0);
+    dp[{1, 1}] = singletonSummary(1);
     for (ui i = 1; i < len; i++) {
-      map<pair<int, int>, pair<ull, ui>> next;
+      map<pair<int, int>, MisSummary> next;
       for (auto &entry : dp) {
         int prevBit = entry.first.first;
         int prevDom = entry.first.second;
-        ull ways = entry.second.first;
-        ui best = entry.second.second;
         for (int bit = 0; bit <= 1; bit++) {
           if (prevBit && bit)
             continue;
           if (!prevDom && !bit)
             continue;
           int dom = bit || prevBit;
-          addState(next, {bit, dom}, ways, best + bit);
+          addSummary(next[{bit, dom}],
+                     multiplySummary(entry.second, singletonSummary(bit)));
         }
       }
       dp.swap(next);
     }
 
-    pair<ull, ui> result{0, 0};
+    MisSummary result;
     for (auto &entry : dp) {
       if (!entry.first.second)
         continue;
-      result.first += entry.second.first;
-      result.second = max(result.second, entry.second.second);
+      addSummary(result, entry.second);
     }
     return result;
   };
 
-    auto solveCycle = [](ui len) {
-    pair<ull, ui> result{0, 0};
+    auto solveCycle = [&](ui len) {
+    MisSummary result;
     for (int first = 0; first <= 1; first++) {
       for (int second = 0; second <= 1; second++) {
         if (first && second)
           continue;
-        map<pair<int, int>, pair<ull, ui>> dp;
-        dp[{first, second}] = {1, (ui)(first + second)};
+        map<pair<int, int>, MisSummary> dp;
+        dp[{first, second}] = singletonSummary((ui)(first + second));
         for (ui i = 2; i < len; i++) {
-          map<pair<int, int>, pair<ull, ui>> next;
+          map<pair<int, int>, MisSummary> next;
           for (auto &entry : dp) {
             int prevPrev = entry.first.first;
             int prev = entry.first.second;
-            ull ways = entry.second.first;
-            ui best = entry.second.second;
             for (int bit = 0; bit <= 1; bit++) {
               if (prev && bit)
                 continue;
               if (!prev && !prevPrev && !bit)
                 continue;
-              auto &slot = next[{prev, bit}];
-              slot.first += ways;
-              slot.second = max(slot.second, best + bit);
+              addSummary(next[{prev, bit}],
+                         multiplySummary(entry.second, singletonSummary(bit)));
             }
           }
           dp.swap(next);
@@ -1651,8 +1633,7 @@ void BitsetBK::detectCompleteMultipartite() {
             continue;
           if (!first && !second && !last)
             continue;
-          result.first += entry.second.first;
-          result.second = max(result.second, entry.second.second);
+          addSummary(result, entry.second);
         }
       }
     }
@@ -2051,7 +2032,7 @@ void BitsetBK::detectCompleteMultipartite() {
 
   ull totalCount = 0;
   ui bestParts = 0;
-  array<ull, 3> totalSmall{1, 0, 0};
+  vector<ull> totalBySize{1};
   bool handledAny = false;
   bool firstComponent = true;
 
@@ -2104,47 +2085,40 @@ void BitsetBK::detectCompleteMultipartite() {
         complementCycle = false;
     }
 
-      pair<ull, ui> partResult{0, 0};
-      array<ull, 3> partSmall{};
+      MisSummary part;
       if (compSize == 1) {
-        partResult = {1, 1};
-        partSmall[1] = 1;
+        part = singletonSummary(1);
       } else if (complementClique) {
-        partResult = {(ull)compSize, 1};
-        partSmall[1] = compSize;
+        part = singletonSummary(1);
+        part.count = compSize;
+        part.bySize[1] = compSize;
       } else if (maxCompDegree <= 2) {
         if (complementCycle)
-          partResult = solveCycle(compSize);
+          part = solveCycle(compSize);
         else if (degreeOne == 2)
-          partResult = solvePath(compSize);
+          part = solvePath(compSize);
         else
           return;
-        partSmall = smallMaximalCounts(verts);
     } else if (compEdges == (ull)compSize - 1) {
-      MisSummary treeResult = solveTree(compAdj);
-      if (treeResult.maxSize == 0)
+      part = solveTree(compAdj);
+      if (part.maxSize == 0)
         return;
-      partResult = {treeResult.count, treeResult.maxSize};
-      partSmall = treeResult.small;
     } else if (compEdges == (ull)compSize) {
-      MisSummary cycleResult = solveUnicyclic(compAdj);
-      if (cycleResult.maxSize == 0)
+      part = solveUnicyclic(compAdj);
+      if (part.maxSize == 0)
         return;
-      partResult = {cycleResult.count, cycleResult.maxSize};
-      partSmall = cycleResult.small;
     } else {
-      MisSummary coreResult = solveSmallCore(compAdj);
-      if (coreResult.maxSize == 0)
+      part = solveSmallCore(compAdj);
+      if (part.maxSize == 0)
         return;
-      partResult = {coreResult.count, coreResult.maxSize};
-      partSmall = coreResult.small;
     }
+      pair<ull, ui> partResult{part.count, part.maxSize};
 
       handledAny = true;
       if (firstComponent) {
       totalCount = partResult.first;
       bestParts = partResult.second;
-      totalSmall = partSmall;
+      totalBySize = part.bySize;
       firstComponent = false;
     } else {
       pair<ull, ui> state{totalCount, bestParts};
@@ -2152,20 +2126,24 @@ void BitsetBK::detectCompleteMultipartite() {
       totalCount = state.first;
       bestParts = state.second;
 
-      array<ull, 3> nextSmall{};
-      for (ui a = 0; a <= 2; a++) {
-        for (ui b = 0; b + a <= 2; b++)
-          nextSmall[a + b] += totalSmall[a] * partSmall[b];
+      vector<ull> nextBySize(totalBySize.size() + part.bySize.size() - 1, 0);
+      for (size_t a = 0; a < totalBySize.size(); a++) {
+        for (size_t b = 0; b < part.bySize.size(); b++)
+          nextBySize[a + b] += totalBySize[a] * part.bySize[b];
       }
-      totalSmall = nextSmall;
+      totalBySize.swap(nextBySize);
     }
   }
 
+  cliqueSizeHistogram.clear();
   if (!handledAny || bestParts <= 2) {
     totalCount = 0;
     bestParts = 0;
   } else {
-    totalCount -= totalSmall[0] + totalSmall[1] + totalSmall[2];
+    for (ui size = 0; size <= 2 && size < totalBySize.size(); size++)
+      totalCount -= totalBySize[size];
+    for (size_t size = 3; size < totalBySize.size(); size++)
+      addCliqueSizeCountOrThrow(cliqueSizeHistogram, size, totalBySize[size]);
   }
 
   completeMultipartite = handledAny;
@@ -2239,6 +2217,7 @@ bool BitsetBK::tryComplementMatching(const vector<ull> &P,
     count *= 2ULL;
   cliqueCount += count;
   maxCliqueSize = max(maxCliqueSize, rSize + extensionSize);
+  addCliqueSizeCountOrThrow(cliqueSizeHistogram, rSize + extensionSize, count);
   return true;
 }
 
@@ -2346,27 +2325,32 @@ bool BitsetBK::tryComplementDegreeTwo(const vector<ull> &P,
     }
   }
 
+  // Each state maps a requirement mask to the number of selections of every
+  // size, so the accepted state yields the clique-size distribution directly.
   const size_t stateLimit = 1u << 18;
-  using StateMap = unordered_map<ull, pair<ull, ui>>;
-  auto addState = [&](StateMap &states, ull mask, ull count,
-                      ui selected) -> bool {
+  using StateMap = unordered_map<ull, vector<ull>>;
+  const vector<ull> one{1};
+  auto addState = [&](StateMap &states, ull mask, const vector<ull> &bySelected,
+                      ui shift) -> bool {
     auto it = states.find(mask);
     if (it == states.end()) {
       if (states.size() >= stateLimit)
         return false;
-      states.emplace(mask, make_pair(count, selected));
-    } else {
-      it->second.first += count;
-      it->second.second = max(it->second.second, selected);
+      it = states.emplace(mask, vector<ull>()).first;
     }
+    vector<ull> &slot = it->second;
+    if (slot.size() < bySelected.size() + shift)
+      slot.resize(bySelected.size() + shift, 0);
+    for (size_t i = 0; i < bySelected.size(); i++)
+      slot[i + shift] += bySelected[i];
     return true;
   };
 
   auto solvePath = [&](const vector<ui> &path, StateMap &out) -> bool {
     array<StateMap, 4> states;
-    if (!addState(states[0], 0, 1, 0))
+    if (!addState(states[0], 0, one, 0))
       return false;
-    if (!addState(states[3], vertexHit[path[0]], 1, 1))
+    if (!addState(states[3], vertexHit[path[0]], one, 1))
       return false;
 
     for (ui i = 1; i < path.size(); i++) {
@@ -2384,8 +2368,7 @@ bool BitsetBK::tryComplementDegreeTwo(const vector<ull> &P,
             const ui nextState = (bit << 1) | (dom ? 1 : 0);
             const ull mask = bit ? (entry.first | vertexHit[path[i]])
                                  : entry.first;
-            const ui selected = entry.second.second + bit;
-            if (!addState(next[nextState], mask, entry.second.first, selected))
+            if (!addState(next[nextState], mask, entry.second, bit))
               return false;
           }
         }
@@ -2397,8 +2380,7 @@ bool BitsetBK::tryComplementDegreeTwo(const vector<ull> &P,
       if ((state & 1) == 0)
         continue;
       for (const auto &entry : states[state]) {
-        if (!addState(out, entry.first, entry.second.first,
-                      entry.second.second))
+        if (!addState(out, entry.first, entry.second, 0))
           return false;
       }
     }
@@ -2418,7 +2400,7 @@ bool BitsetBK::tryComplementDegreeTwo(const vector<ull> &P,
           initMask |= vertexHit[cycle[0]];
         if (second)
           initMask |= vertexHit[cycle[1]];
-        if (!addState(states[(first << 1) | second], initMask, 1, initSize))
+        if (!addState(states[(first << 1) | second], initMask, one, initSize))
           return false;
 
         for (ui i = 2; i < len; i++) {
@@ -2435,9 +2417,7 @@ bool BitsetBK::tryComplementDegreeTwo(const vector<ull> &P,
                 const ui nextState = (prev << 1) | bit;
                 const ull mask = bit ? (entry.first | vertexHit[cycle[i]])
                                      : entry.first;
-                const ui selected = entry.second.second + bit;
-                if (!addState(next[nextState], mask, entry.second.first,
-                              selected))
+                if (!addState(next[nextState], mask, entry.second, bit))
                   return false;
               }
             }
@@ -2455,8 +2435,7 @@ bool BitsetBK::tryComplementDegreeTwo(const vector<ull> &P,
           if (!first && !second && !last)
             continue;
           for (const auto &entry : states[state]) {
-            if (!addState(out, entry.first, entry.second.first,
-                          entry.second.second))
+            if (!addState(out, entry.first, entry.second, 0))
               return false;
           }
         }
@@ -2466,7 +2445,7 @@ bool BitsetBK::tryComplementDegreeTwo(const vector<ull> &P,
   };
 
   StateMap total;
-  total.emplace(0, make_pair(1, 0));
+  total.emplace(0, one);
   vector<char> seen(pSize, 0);
   vector<ui> queue;
   vector<ui> component;
@@ -2492,7 +2471,7 @@ bool BitsetBK::tryComplementDegreeTwo(const vector<ull> &P,
 
     StateMap part;
     if (component.size() == 1) {
-      if (!addState(part, vertexHit[component[0]], 1, 1))
+      if (!addState(part, vertexHit[component[0]], one, 1))
         return false;
     } else {
       ui degreeOne = 0;
@@ -2552,12 +2531,15 @@ bool BitsetBK::tryComplementDegreeTwo(const vector<ull> &P,
     }
 
     StateMap nextTotal;
+    vector<ull> product;
     for (const auto &left : total) {
       for (const auto &right : part) {
         const ull mask = left.first | right.first;
-        const ull count = left.second.first * right.second.first;
-        const ui selected = left.second.second + right.second.second;
-        if (!addState(nextTotal, mask, count, selected))
+        product.assign(left.second.size() + right.second.size() - 1, 0);
+        for (size_t a = 0; a < left.second.size(); a++)
+          for (size_t b = 0; b < right.second.size(); b++)
+            product[a + b] += left.second[a] * right.second[b];
+        if (!addState(nextTotal, mask, product, 0))
           return false;
       }
     }
@@ -2567,8 +2549,15 @@ bool BitsetBK::tryComplementDegreeTwo(const vector<ull> &P,
   auto it = total.find(allMask);
   if (it == total.end())
     return true;
-  cliqueCount += it->second.first;
-  maxCliqueSize = max(maxCliqueSize, rSize + it->second.second);
+  const vector<ull> &bySelected = it->second;
+  for (size_t selected = 0; selected < bySelected.size(); selected++) {
+    if (bySelected[selected] == 0)
+      continue;
+    cliqueCount += bySelected[selected];
+    maxCliqueSize = max(maxCliqueSize, rSize + (ui)selected);
+    addCliqueSizeCountOrThrow(cliqueSizeHistogram, rSize + selected,
+                              bySelected[selected]);
+  }
   return true;
 }
 
@@ -2622,10 +2611,14 @@ void BitsetBK::bronKerboschRecursive(ui rSize, ui depth) {
   vector<ull> &X = depthX[depth];
   vector<ui> &active = depthActive[depth];
   checksCount++;
+  if (budget != nullptr &&
+      budget->exhausted(checksCount, cliqueCount, nextBudgetClock))
+    return;
   if (isEmpty(P, active)) {
     if (isEmpty(X, active) && rSize > 2) {
       cliqueCount++;
       maxCliqueSize = max(maxCliqueSize, rSize);
+      addCliqueSizeCountOrThrow(cliqueSizeHistogram, rSize, 1);
     }
     return;
   }
@@ -2633,7 +2626,9 @@ void BitsetBK::bronKerboschRecursive(ui rSize, ui depth) {
   ui pSize = 0;
   int minPScore = 0;
   bool xExtendsP = false;
+  ScopedPerfRegion pivotPerf(bitsetBkPivotPerf);
   ui pivot = choosePivot(P, X, active, pSize, minPScore, xExtendsP);
+  pivotPerf.stop();
   if (rSize + pSize <= 2)
     return;
   if (minPScore >= (int)pSize - 2 && isEmpty(X, active) &&
@@ -2648,6 +2643,7 @@ void BitsetBK::bronKerboschRecursive(ui rSize, ui depth) {
       if (cSize > 2) {
         cliqueCount++;
         maxCliqueSize = max(maxCliqueSize, cSize);
+        addCliqueSizeCountOrThrow(cliqueSizeHistogram, cSize, 1);
       }
     }
     return;
@@ -2700,76 +2696,63 @@ void BitsetBK::findAllMaximalCliques() {
   if (lowDegreeGraph) {
     cliqueCount = lowDegreeCliqueCount;
     maxCliqueSize = lowDegreeMaxSize;
-    double ms = 0.0;
-    cout << "BitsetBK: cliques=" << cliqueCount
-         << "  maxSize=" << maxCliqueSize << "  checks=" << checksCount
-         << "  time=" << fixed << setprecision(3) << ms << " ms" << endl;
+    printSummary(0.0);
     return;
   }
   if (chordalGraph) {
     cliqueCount = chordalCliqueCount;
     maxCliqueSize = chordalMaxSize;
-    double ms = 0.0;
-    cout << "BitsetBK: cliques=" << cliqueCount
-         << "  maxSize=" << maxCliqueSize << "  checks=" << checksCount
-         << "  time=" << fixed << setprecision(3) << ms << " ms" << endl;
+    printSummary(0.0);
     return;
   }
   if (cliqueComponents) {
     cliqueCount = cliqueComponentCount;
     maxCliqueSize = cliqueComponentMaxSize;
-    double ms = 0.0;
-    cout << "BitsetBK: cliques=" << cliqueCount
-         << "  maxSize=" << maxCliqueSize << "  checks=" << checksCount
-         << "  time=" << fixed << setprecision(3) << ms << " ms" << endl;
+    printSummary(0.0);
     return;
   }
   if (degeneracy < 2 || bipartite) {
-    double ms = 0.0;
-    cout << "BitsetBK: cliques=" << cliqueCount
-         << "  maxSize=" << maxCliqueSize << "  checks=" << checksCount
-         << "  time=" << fixed << setprecision(3) << ms << " ms" << endl;
+    cliqueSizeHistogram.clear();
+    printSummary(0.0);
     return;
   }
   if (twinModuleQuotient) {
     cliqueCount = twinModuleQuotientCount;
     maxCliqueSize = twinModuleQuotientMaxSize;
-    double ms = 0.0;
-    cout << "BitsetBK: cliques=" << cliqueCount
-         << "  maxSize=" << maxCliqueSize << "  checks=" << checksCount
-         << "  time=" << fixed << setprecision(3) << ms << " ms" << endl;
+    printSummary(0.0);
     return;
   }
   if (falseTwinQuotient) {
     cliqueCount = falseTwinQuotientCount;
     maxCliqueSize = falseTwinQuotientMaxSize;
-    double ms = 0.0;
-    cout << "BitsetBK: cliques=" << cliqueCount
-         << "  maxSize=" << maxCliqueSize << "  checks=" << checksCount
-         << "  time=" << fixed << setprecision(3) << ms << " ms" << endl;
+    printSummary(0.0);
     return;
   }
   if (trueTwinQuotient) {
     cliqueCount = trueTwinQuotientCount;
     maxCliqueSize = trueTwinQuotientMaxSize;
-    double ms = 0.0;
-    cout << "BitsetBK: cliques=" << cliqueCount
-         << "  maxSize=" << maxCliqueSize << "  checks=" << checksCount
-         << "  time=" << fixed << setprecision(3) << ms << " ms" << endl;
+    printSummary(0.0);
     return;
   }
   if (completeMultipartite) {
     cliqueCount = completeMultipartiteCount;
     maxCliqueSize = completeMultipartiteParts;
-    double ms = 0.0;
-    cout << "BitsetBK: cliques=" << cliqueCount
-         << "  maxSize=" << maxCliqueSize << "  checks=" << checksCount
-         << "  time=" << fixed << setprecision(3) << ms << " ms" << endl;
+    printSummary(0.0);
     return;
   }
 
+  // Detectors that declined the graph may have left a partial histogram.
+  cliqueSizeHistogram.clear();
   ensureDepth(0);
-  for (ui v : order) {
+  if (!rootSchedule.empty() && rootSchedule.size() != n)
+    throw invalid_argument("root schedule must list every vertex once");
+  ScopedPerfRegion perf(bitsetBkSearchPerf);
+  completedRoots.clear();
+  for (ui v : rootSchedule.empty() ? order : rootSchedule) {
+    if (budget != nullptr &&
+        budget->exhausted(checksCount, cliqueCount, nextBudgetClock))
+      break;
+    RootCostScope cost(rootCosts, v, checksCount, cliqueCount);
     vector<ull> &P = depthP[0];
     vector<ull> &X = depthX[0];
     vector<ui> &active = depthActive[0];
@@ -2796,15 +2779,23 @@ void BitsetBK::findAllMaximalCliques() {
         word &= word - 1;
       }
     }
-    if (pSize < 2)
-      continue;
-    if (!hasEdgeInP(P, active))
-      continue;
-    bronKerboschRecursive(1, 0);
+    if (pSize >= 2 && hasEdgeInP(P, active))
+      bronKerboschRecursive(1, 0);
+    if (budget != nullptr && !budget->isExhausted())
+      completedRoots.push_back(v);
   }
+  perf.stop();
   auto t1 = chrono::high_resolution_clock::now();
   double ms = chrono::duration<double, milli>(t1 - t0).count();
 
+  printSummary(ms);
+}
+
+void BitsetBK::printSummary(double ms) const {
+  // Every exit of findAllMaximalCliques passes through here.
+  bitsetBkCounters.report(checksCount, cliqueCount, ms);
+  if (!summaryOutput)
+    return;
   cout << "BitsetBK: cliques=" << cliqueCount << "  maxSize=" << maxCliqueSize
        << "  checks=" << checksCount << "  time=" << fixed << setprecision(3)
        << ms << " ms" << endl;
@@ -2812,6 +2803,9 @@ void BitsetBK::findAllMaximalCliques() {
 
 LocalBitsetBK::LocalBitsetBK(Graph &g) {
   n = g.n;
+  summaryOutput = true;
+  rootCosts = nullptr;
+  budget = nullptr;
   degeneracy = 0;
   graph = &g;
   lowDegreeGraph = false;
@@ -2839,7 +2833,8 @@ LocalBitsetBK::LocalBitsetBK(Graph &g) {
   depthCand.reserve(n + 1);
 
   lowDegreeGraph =
-      detectMaxDegreeTwoGraph(g, lowDegreeCliqueCount, lowDegreeMaxSize);
+      detectMaxDegreeTwoGraph(g, lowDegreeCliqueCount, lowDegreeMaxSize,
+                              cliqueSizeHistogram);
   if (lowDegreeGraph)
     return;
 
@@ -2847,10 +2842,11 @@ LocalBitsetBK::LocalBitsetBK(Graph &g) {
     cliqueComponents = true;
     cliqueComponentCount = 1;
     cliqueComponentMaxSize = n;
+    addCliqueSizeCountOrThrow(cliqueSizeHistogram, n, 1);
     return;
   }
 
-  bipartite = graphIsBipartite(g);
+  bipartite = g.isBipartite();
   if (bipartite)
     return;
 
@@ -2863,7 +2859,8 @@ LocalBitsetBK::LocalBitsetBK(Graph &g) {
   const bool chordalCandidate =
       n <= 12000 || (n <= 50000 && avgDegree >= 20.0 && avgDegree <= 80.0);
   if (chordalCandidate) {
-    chordalGraph = detectChordalGraph(g, chordalCliqueCount, chordalMaxSize);
+    chordalGraph = detectChordalGraph(g, chordalCliqueCount, chordalMaxSize,
+                                      cliqueSizeHistogram);
     if (chordalGraph)
       return;
   }
@@ -2875,7 +2872,8 @@ LocalBitsetBK::LocalBitsetBK(Graph &g) {
     g.sortAdjacency();
     twinModuleQuotient =
         solveTwinModuleQuotientGraph(g, twinModuleQuotientCount,
-                                     twinModuleQuotientMaxSize);
+                                     twinModuleQuotientMaxSize,
+                                     cliqueSizeHistogram);
     if (twinModuleQuotient)
       return;
   }
@@ -2905,7 +2903,8 @@ bool LocalBitsetBK::shouldDetectCliqueComponents(const Graph &g) const {
 bool LocalBitsetBK::detectCliqueComponents(const Graph &g) {
   cliqueComponents =
       detectCliqueComponentsGraph(g, cliqueComponentCount,
-                                  cliqueComponentMaxSize);
+                                  cliqueComponentMaxSize,
+                                  cliqueSizeHistogram);
   return cliqueComponents;
 }
 
@@ -3040,11 +3039,15 @@ void LocalBitsetBK::bronKerboschRecursive(ui rSize, ui depth) {
   vector<ull> &P = depthP[depth];
   vector<ui> &X = depthX[depth];
   checksCount++;
+  if (budget != nullptr &&
+      budget->exhausted(checksCount, cliqueCount, nextBudgetClock))
+    return;
 
   if (isEmpty(P)) {
     if (X.empty() && rSize > 2) {
       cliqueCount++;
       maxCliqueSize = max(maxCliqueSize, rSize);
+      addCliqueSizeCountOrThrow(cliqueSizeHistogram, rSize, 1);
     }
     return;
   }
@@ -3052,7 +3055,9 @@ void LocalBitsetBK::bronKerboschRecursive(ui rSize, ui depth) {
   ui pSize = 0;
   int minPScore = 0;
   bool localXExtendsP = false;
+  ScopedPerfRegion pivotPerf(localBitsetBkPivotPerf);
   ui pivot = choosePivot(P, X, pSize, minPScore, localXExtendsP);
+  pivotPerf.stop();
   if (rSize + pSize <= 2)
     return;
   if (minPScore == (int)pSize - 1) {
@@ -3061,6 +3066,7 @@ void LocalBitsetBK::bronKerboschRecursive(ui rSize, ui depth) {
       if (cSize > 2) {
         cliqueCount++;
         maxCliqueSize = max(maxCliqueSize, cSize);
+        addCliqueSizeCountOrThrow(cliqueSizeHistogram, cSize, 1);
       }
     }
     return;
@@ -3078,6 +3084,7 @@ void LocalBitsetBK::bronKerboschRecursive(ui rSize, ui depth) {
       ull idxBit = 1ULL << bit;
       candidates[wi] &= candidates[wi] - 1;
 
+      ScopedPerfRegion intersectPerf(localBitsetBkIntersectPerf);
       const ull *nbrs = localNeighbors(idx);
       vector<ull> &newP = depthP[depth + 1];
       for (ui aw = 0; aw < localWords; aw++)
@@ -3106,6 +3113,7 @@ void LocalBitsetBK::bronKerboschRecursive(ui rSize, ui depth) {
           }
         }
       }
+      intersectPerf.stop();
 
       bronKerboschRecursive(rSize + 1, depth + 1);
 
@@ -3172,6 +3180,7 @@ bool LocalBitsetBK::buildRoot(ui root) {
     if (allPIsClique) {
       cliqueCount++;
       maxCliqueSize = max(maxCliqueSize, localSize + 1);
+      addCliqueSizeCountOrThrow(cliqueSizeHistogram, localSize + 1, 1);
       return false;
     }
 
@@ -3218,6 +3227,7 @@ bool LocalBitsetBK::buildRoot(ui root) {
       if (!extended) {
         cliqueCount++;
         maxCliqueSize = max(maxCliqueSize, cliqueSize + 1);
+        addCliqueSizeCountOrThrow(cliqueSizeHistogram, cliqueSize + 1, 1);
       }
     }
     return false;
@@ -3257,6 +3267,7 @@ bool LocalBitsetBK::buildRoot(ui root) {
       if (allPIsClique) {
         cliqueCount++;
         maxCliqueSize = max(maxCliqueSize, localSize + 1);
+        addCliqueSizeCountOrThrow(cliqueSizeHistogram, localSize + 1, 1);
         return false;
       }
     }
@@ -3305,182 +3316,112 @@ void LocalBitsetBK::findAllMaximalCliques() {
   if (lowDegreeGraph) {
     cliqueCount = lowDegreeCliqueCount;
     maxCliqueSize = lowDegreeMaxSize;
-    double ms = 0.0;
-    cout << "LocalBitsetBK: cliques=" << cliqueCount
-         << "  maxSize=" << maxCliqueSize << "  checks=" << checksCount
-         << "  time=" << fixed << setprecision(3) << ms << " ms" << endl;
+    printSummary(0.0);
     return;
   }
   if (chordalGraph) {
     cliqueCount = chordalCliqueCount;
     maxCliqueSize = chordalMaxSize;
-    double ms = 0.0;
-    cout << "LocalBitsetBK: cliques=" << cliqueCount
-         << "  maxSize=" << maxCliqueSize << "  checks=" << checksCount
-         << "  time=" << fixed << setprecision(3) << ms << " ms" << endl;
+    printSummary(0.0);
     return;
   }
   if (twinModuleQuotient) {
     cliqueCount = twinModuleQuotientCount;
     maxCliqueSize = twinModuleQuotientMaxSize;
-    double ms = 0.0;
-    cout << "LocalBitsetBK: cliques=" << cliqueCount
-         << "  maxSize=" << maxCliqueSize << "  checks=" << checksCount
-         << "  time=" << fixed << setprecision(3) << ms << " ms" << endl;
+    printSummary(0.0);
     return;
   }
   if (cliqueComponents) {
     cliqueCount = cliqueComponentCount;
     maxCliqueSize = cliqueComponentMaxSize;
-    double ms = 0.0;
-    cout << "LocalBitsetBK: cliques=" << cliqueCount
-         << "  maxSize=" << maxCliqueSize << "  checks=" << checksCount
-         << "  time=" << fixed << setprecision(3) << ms << " ms" << endl;
+    printSummary(0.0);
     return;
   }
   if (degeneracy < 2 || bipartite) {
-    double ms = 0.0;
-    cout << "LocalBitsetBK: cliques=" << cliqueCount
-         << "  maxSize=" << maxCliqueSize << "  checks=" << checksCount
-         << "  time=" << fixed << setprecision(3) << ms << " ms" << endl;
+    cliqueSizeHistogram.clear();
+    printSummary(0.0);
     return;
   }
 
-  for (ui root : order) {
-    if (buildRoot(root))
+  // Detectors that declined the graph may have left a partial histogram.
+  cliqueSizeHistogram.clear();
+  if (!rootSchedule.empty() && rootSchedule.size() != n)
+    throw invalid_argument("root schedule must list every vertex once");
+  ScopedPerfRegion perf(localBitsetBkSearchPerf);
+  completedRoots.clear();
+  for (ui root : rootSchedule.empty() ? order : rootSchedule) {
+    if (budget != nullptr &&
+        budget->exhausted(checksCount, cliqueCount, nextBudgetClock))
+      break;
+    RootCostScope cost(rootCosts, root, checksCount, cliqueCount);
+    ScopedPerfRegion rootPerf(localBitsetBkRootPerf);
+    const bool built = buildRoot(root);
+    rootPerf.stop();
+    if (built)
       bronKerboschRecursive(1, 0);
+    if (budget != nullptr && !budget->isExhausted())
+      completedRoots.push_back(root);
   }
+  perf.stop();
   auto t1 = chrono::high_resolution_clock::now();
   double ms = chrono::duration<double, milli>(t1 - t0).count();
 
+  printSummary(ms);
+}
+
+void LocalBitsetBK::printSummary(double ms) const {
+  // Every exit of findAllMaximalCliques passes through here.
+  localBitsetBkCounters.report(checksCount, cliqueCount, ms);
+  if (!summaryOutput)
+    return;
   cout << "LocalBitsetBK: cliques=" << cliqueCount
        << "  maxSize=" << maxCliqueSize << "  checks=" << checksCount
        << "  time=" << fixed << setprecision(3) << ms << " ms" << endl;
 }
 
-// ReorderSib profiling
-struct RSibProf {
-  double rCall_ms = 0, enumerate_ms = 0, collect_ms = 0, solver_ms = 0;
-  double minimal_ms = 0, commonExp_ms = 0, buildHit_ms = 0;
-  double intersect_ms = 0, setdiff_ms = 0, unionset_ms = 0, encode_ms = 0;
-  double pivot_ms = 0, sibling_ms = 0, dedup_ms = 0;
-  double reorderSkip_ms = 0, reorderBuild_ms = 0, cliqueRecord_ms = 0;
-  double dominance_ms = 0, siblingPlan_ms = 0, branchBuild_ms = 0;
-  long rCall_n = 0, enumerate_n = 0, collect_n = 0, solver_n = 0;
-  long minimal_n = 0, commonExp_n = 0, buildHit_n = 0;
-  long intersect_n = 0, setdiff_n = 0, unionset_n = 0, encode_n = 0;
-  long pivot_n = 0, sibling_n = 0, dedup_n = 0;
-  long reorderSkip_n = 0, reorderBuild_n = 0, cliqueRecord_n = 0;
-  long dominance_n = 0, siblingPlan_n = 0, branchBuild_n = 0;
-  ull solver_hsize_sum = 0, solver_esize_sum = 0;
-  ull solver_compat_eligible = 0, solver_compat_survivors = 0;
-  long solver_h_gt63 = 0, solver_h_gt128 = 0;
-  long solver_h_le8 = 0, solver_h_le16 = 0, solver_h_le32 = 0;
-  long solver_h_le63 = 0, solver_h_le128 = 0, solver_h_gt128_bucket = 0;
-  void reset() { *this = RSibProf{}; }
-  void print(double total_ms) const {
-    auto pct = [&](double v) {
-      return total_ms > 0 ? 100.0 * v / total_ms : 0.0;
-    };
-    const vector<pair<const char *, pair<double, long>>> rows = {
-        {"rCall local logic", {rCall_ms, rCall_n}},
-        {"enumerate local logic", {enumerate_ms, enumerate_n}},
-        {"collectCoveringCliques", {collect_ms, collect_n}},
-        {"dominance pruning", {dominance_ms, dominance_n}},
-        {"buildHitSets", {buildHit_ms, buildHit_n}},
-        {"sibling planning", {siblingPlan_ms, siblingPlan_n}},
-        {"solver", {solver_ms, solver_n}},
-        {"minimalByInclusion", {minimal_ms, minimal_n}},
-        {"commonExpand", {commonExp_ms, commonExp_n}},
-        {"sibling branch build", {branchBuild_ms, branchBuild_n}},
-        {"branch dedup", {dedup_ms, dedup_n}},
-        {"reorder skip tests", {reorderSkip_ms, reorderSkip_n}},
-        {"reorder branch rebuild", {reorderBuild_ms, reorderBuild_n}},
-        {"leaf recording", {cliqueRecord_ms, cliqueRecord_n}},
-        {"pivot selection", {pivot_ms, pivot_n}},
-        {"intersect/intersectInto", {intersect_ms, intersect_n}},
-        {"setDiff", {setdiff_ms, setdiff_n}},
-        {"unionSet", {unionset_ms, unionset_n}},
-        {"encodeClique", {encode_ms, encode_n}},
-        {"sibling phase local", {sibling_ms, sibling_n}},
-    };
-    double profiled_ms = 0.0;
-    for (const auto &row : rows)
-      profiled_ms += row.second.first;
-    const double other_ms = max(0.0, total_ms - profiled_ms);
-
-    printf(
-        "\n── ReorderSib cost breakdown ─────────────────────────────────\n");
-    for (const auto &row : rows) {
-      printf("  %-30s %9.3f ms  %5.1f%%  calls=%ld\n", row.first,
-             row.second.first, pct(row.second.first), row.second.second);
-    }
-    printf("  %-30s %9.3f ms  %5.1f%%\n", "other / untimed", other_ms,
-           pct(other_ms));
-    printf("  %-30s %9.3f ms  %5.1f%%\n", "PROFILED subtotal", profiled_ms,
-           pct(profiled_ms));
-    printf("  %-30s %9.3f ms  %5.1f%%\n", "TOTAL (wall)", total_ms, 100.0);
-    if (solver_n > 0) {
-      const double avgE = static_cast<double>(solver_esize_sum) / solver_n;
-      const double avgH = static_cast<double>(solver_hsize_sum) / solver_n;
-      const double compatPct =
-          solver_compat_eligible > 0
-              ? 100.0 * static_cast<double>(solver_compat_survivors) /
-                    solver_compat_eligible
-              : 0.0;
-      printf("\n  Solver stats\n");
-      printf("  %-30s %.2f\n", "avg |E|", avgE);
-      printf("  %-30s %.2f\n", "avg hSize", avgH);
-      printf("  %-30s %ld\n", "calls with hSize > 63", solver_h_gt63);
-      printf("  %-30s %ld\n", "calls with hSize > 128", solver_h_gt128);
-      printf("  %-30s %llu / %llu  (%4.1f%%)\n",
-             "compat survivors / eligible",
-             solver_compat_survivors, solver_compat_eligible, compatPct);
-      printf("  %-30s <=8:%ld  9-16:%ld  17-32:%ld\n", "hSize buckets",
-             solver_h_le8, solver_h_le16, solver_h_le32);
-      printf("  %-30s 33-63:%ld  64-128:%ld  >128:%ld\n", "",
-             solver_h_le63, solver_h_le128, solver_h_gt128_bucket);
-    }
-    printf("──────────────────────────────────────────────────────────────\n");
-  }
-};
-static RSibProf rsp;
-
-#if PROFILING
-struct ScopedTimer {
-  using clock = chrono::high_resolution_clock;
-  using duration = clock::duration;
-  static thread_local ScopedTimer *current;
-
-  chrono::high_resolution_clock::time_point t0;
-  duration child = duration::zero();
-  double &acc;
-  long &cnt;
-  ScopedTimer *parent;
-
-  ScopedTimer(double &a, long &c)
-      : t0(clock::now()), acc(a), cnt(c), parent(current) {
-    current = this;
-  }
-
-  ~ScopedTimer() {
-    const duration elapsed = clock::now() - t0;
-    duration self = elapsed - child;
-    if (self < duration::zero())
-      self = duration::zero();
-    acc += chrono::duration<double, milli>(self).count();
-    ++cnt;
-    current = parent;
-    if (parent != nullptr)
-      parent->child += elapsed;
-  }
-};
-thread_local ScopedTimer *ScopedTimer::current = nullptr;
-#else
-struct ScopedTimer {
-  ScopedTimer(double &, long &) {}
+// ReorderSib runtime timers and solver statistics.
+namespace {
+struct ReorderSibCounters {
+  EngineRunCounters run{"reordersib"};
+  EngineRunCounters pureRun{"reordersib_pure"};
+  PerfRegion searchPerf{"reordersib.search", false};
+  PerfRegion pureSearchPerf{"reordersib_pure.search", false};
+  RuntimeTimer rCall{"reordersib.rcall"};
+  RuntimeTimer enumerate{"reordersib.enumerate"};
+  RuntimeTimer collect{"reordersib.collect_covering_cliques"};
+  RuntimeTimer dominance{"reordersib.dominance_pruning"};
+  RuntimeTimer buildHit{"reordersib.build_hit_sets"};
+  RuntimeTimer siblingPlan{"reordersib.sibling_planning"};
+  RuntimeTimer solver{"reordersib.solver"};
+  RuntimeTimer minimal{"reordersib.minimal_by_inclusion"};
+  RuntimeTimer commonExp{"reordersib.common_expand"};
+  RuntimeTimer branchBuild{"reordersib.sibling_branch_build"};
+  RuntimeTimer dedup{"reordersib.branch_dedup"};
+  RuntimeTimer reorderSkip{"reordersib.reorder_skip_tests"};
+  RuntimeTimer reorderBuild{"reordersib.reorder_branch_rebuild"};
+  RuntimeTimer cliqueRecord{"reordersib.leaf_recording"};
+  RuntimeTimer pivot{"reordersib.pivot_selection"};
+  RuntimeTimer intersect{"reordersib.intersect"};
+  RuntimeTimer setdiff{"reordersib.set_diff"};
+  RuntimeTimer unionset{"reordersib.union_set"};
+  RuntimeTimer encode{"reordersib.encode_clique"};
+  RuntimeTimer sibling{"reordersib.sibling_phase"};
+  RuntimeCounter solverCalls{"reordersib.solver.calls"};
+  RuntimeCounter solverESizeSum{"reordersib.solver.esize_sum"};
+  RuntimeCounter solverHSizeSum{"reordersib.solver.hsize_sum"};
+  RuntimeCounter solverCompatEligible{"reordersib.solver.compat_eligible"};
+  RuntimeCounter solverCompatSurvivors{"reordersib.solver.compat_survivors"};
+  // hSize buckets <=8, 9-16, 17-32, 33-63, 64-128 and >128.
+  RuntimeCounter solverHSizeBuckets[6] = {
+      RuntimeCounter("reordersib.solver.hsize_le8"),
+      RuntimeCounter("reordersib.solver.hsize_le16"),
+      RuntimeCounter("reordersib.solver.hsize_le32"),
+      RuntimeCounter("reordersib.solver.hsize_le63"),
+      RuntimeCounter("reordersib.solver.hsize_le128"),
+      RuntimeCounter("reordersib.solver.hsize_gt128")};
 };
-#endif
+const ReorderSibCounters rsibCounters;
+} // namespace
 
 // ReorderSib Implementation
 ReorderSib::ReorderSib(Graph &g, DegOrder order, SibMethod method,
@@ -3499,6 +3440,8 @@ ReorderSib::ReorderSib(Graph &g, DegOrder order, SibMethod method,
   checksCount = 0;
   solverWorkBudget = 0;
   solverBudgetFallbacks = 0;
+  searchBudget = nullptr;
+  summaryOutput = true;
 
   this->method = method;
   cliquesByVertexByLevel.resize(n);
@@ -3549,7 +3492,7 @@ ReorderSib::ReorderSib(Graph &g, DegOrder order, SibMethod method,
 }
 
 vector<ui> ReorderSib::intersect(const vector<ui> &A, const vector<ui> &B) {
-  ScopedTimer _t(rsp.intersect_ms, rsp.intersect_n);
+  ScopedRuntimeTimer _t(rsibCounters.intersect);
   vector<ui> C;
   C.reserve(min(A.size(), B.size()));
   if (A.size() * 8 < B.size()) {
@@ -3580,7 +3523,7 @@ vector<ui> ReorderSib::intersect(const vector<ui> &A, const vector<ui> &B) {
 
 void ReorderSib::intersectInto(vector<ui> &out, const vector<ui> &A,
                                const vector<ui> &B) {
-  ScopedTimer _t(rsp.intersect_ms, rsp.intersect_n);
+  ScopedRuntimeTimer _t(rsibCounters.intersect);
   out.clear();
   const size_t need = min(A.size(), B.size());
   if (out.capacity() < need)
@@ -3614,7 +3557,7 @@ void ReorderSib::intersectInto(vector<ui> &out, const vector<ui> &A,
 void ReorderSib::intersectExcludingInto(vector<ui> &out, const vector<ui> &A,
                                         const vector<ui> &B,
                                         const vector<ui> &exclude) {
-  ScopedTimer _t(rsp.intersect_ms, rsp.intersect_n);
+  ScopedRuntimeTimer _t(rsibCounters.intersect);
   out.clear();
   const size_t need = min(A.size(), B.size());
   if (out.capacity() < need)
@@ -3653,7 +3596,7 @@ void ReorderSib::intersectExcludingInto(vector<ui> &out, const vector<ui> &A,
 }
 
 vector<ui> ReorderSib::setDiff(const vector<ui> &A, const vector<ui> &B) {
-  ScopedTimer _t(rsp.setdiff_ms, rsp.setdiff_n);
+  ScopedRuntimeTimer _t(rsibCounters.setdiff);
   vector<ui> C;
   C.reserve(A.size());
   ui i = 0, j = 0;
@@ -3672,7 +3615,7 @@ vector<ui> ReorderSib::setDiff(const vector<ui> &A, const vector<ui> &B) {
 
 void ReorderSib::setDiffInto(vector<ui> &out, const vector<ui> &A,
                              const vector<ui> &B) {
-  ScopedTimer _t(rsp.setdiff_ms, rsp.setdiff_n);
+  ScopedRuntimeTimer _t(rsibCounters.setdiff);
   out.clear();
   if (out.capacity() < A.size())
     out.reserve(A.size());
@@ -3691,7 +3634,7 @@ void ReorderSib::setDiffInto(vector<ui> &out, const vector<ui> &A,
 }
 
 vector<ui> ReorderSib::unionSet(const vector<ui> &A, const vector<ui> &B) {
-  ScopedTimer _t(rsp.unionset_ms, rsp.unionset_n);
+  ScopedRuntimeTimer _t(rsibCounters.unionset);
   vector<ui> U;
   U.reserve(A.size() + B.size());
   ui i = 0, j = 0;
@@ -3717,7 +3660,7 @@ vector<ui> ReorderSib::unionSet(const vector<ui> &A, const vector<ui> &B) {
 
 void ReorderSib::unionInto(vector<ui> &out, const vector<ui> &A,
                            const vector<ui> &B) {
-  ScopedTimer _t(rsp.unionset_ms, rsp.unionset_n);
+  ScopedRuntimeTimer _t(rsibCounters.unionset);
   out.clear();
   const size_t need = A.size() + B.size();
   if (out.capacity() < need)
@@ -3764,30 +3707,27 @@ void ReorderSib::insertSortedVertex(vector<ui> &out, const vector<ui> &base,
 }
 
 void ReorderSib::recordSolverCallStats(ui eSize, ui hSize) {
-  rsp.solver_esize_sum += eSize;
-  rsp.solver_hsize_sum += hSize;
-  if (hSize > 63)
-    rsp.solver_h_gt63++;
-  if (hSize > 128)
-    rsp.solver_h_gt128++;
-
-  if (hSize <= 8)
-    rsp.solver_h_le8++;
-  else if (hSize <= 16)
-    rsp.solver_h_le16++;
-  else if (hSize <= 32)
-    rsp.solver_h_le32++;
-  else if (hSize <= 63)
-    rsp.solver_h_le63++;
-  else if (hSize <= 128)
-    rsp.solver_h_le128++;
-  else
-    rsp.solver_h_gt128_bucket++;
+  if (!countersEnabled())
+    return;
+  CounterShard &shard = localCounterShard();
+  rsibCounters.solverCalls.add(shard, 1);
+  rsibCounters.solverESizeSum.add(shard, eSize);
+  rsibCounters.solverHSizeSum.add(shard, hSize);
+  const size_t bucket = hSize <= 8     ? 0
+                        : hSize <= 16  ? 1
+                        : hSize <= 32  ? 2
+                        : hSize <= 63  ? 3
+                        : hSize <= 128 ? 4
+                                       : 5;
+  rsibCounters.solverHSizeBuckets[bucket].add(shard, 1);
 }
 
 void ReorderSib::recordSolverCompatStats(ull eligible, ull survivors) {
-  rsp.solver_compat_eligible += eligible;
-  rsp.solver_compat_survivors += survivors;
+  if (!countersEnabled())
+    return;
+  CounterShard &shard = localCounterShard();
+  rsibCounters.solverCompatEligible.add(shard, eligible);
+  rsibCounters.solverCompatSurvivors.add(shard, survivors);
 }
 
 bool ReorderSib::hitsAll(const vector<ui> &S,
@@ -3809,7 +3749,7 @@ bool ReorderSib::hitsAll(const vector<ui> &S,
 // After choosing a sibling set S, only vertices still in E and adjacent to
 // every vertex of S can continue to grow the branch.
 vector<ui> ReorderSib::commonExpand(const vector<ui> &E, const vector<ui> &S) {
-  ScopedTimer _t(rsp.commonExp_ms, rsp.commonExp_n);
+  ScopedRuntimeTimer _t(rsibCounters.commonExp);
   if (S.empty())
     return E;
   if (S.size() == 1) {
@@ -3837,7 +3777,7 @@ vector<ui> ReorderSib::commonExpand(const vector<ui> &E, const vector<ui> &S) {
 // Find previously discovered cliques that already contain M.
 vector<ui> ReorderSib::collectCoveringCliques(const vector<ui> &M,
                                               const vector<ui> &E, ui level) {
-  ScopedTimer _t(rsp.collect_ms, rsp.collect_n);
+  ScopedRuntimeTimer _t(rsibCounters.collect);
   vector<ui> result;
   if (M.empty())
     return result;
@@ -3944,7 +3884,7 @@ vector<ui> ReorderSib::collectCoveringCliques(const vector<ui> &M,
 // filters: every emitted clique containing M must be visible before FindOne
 // may run.
 vector<ui> ReorderSib::collectAllCoveringCliques(const vector<ui> &M) {
-  ScopedTimer _t(rsp.collect_ms, rsp.collect_n);
+  ScopedRuntimeTimer _t(rsibCounters.collect);
   vector<ui> result;
   if (M.empty())
     return result;
@@ -3974,7 +3914,7 @@ vector<ui> ReorderSib::collectAllCoveringCliques(const vector<ui> &M) {
 vector<vector<ui>> ReorderSib::buildHitSets(const vector<ui> &E,
                                             const vector<ui> &cliqueIds,
                                             ui maxHitSets) {
-  ScopedTimer _t(rsp.buildHit_ms, rsp.buildHit_n);
+  ScopedRuntimeTimer _t(rsibCounters.buildHit);
 
   // When capping, keep the cliques with the most overlap with E — those produce
   // the smallest hit sets (E \ C), which are the tightest constraints.
@@ -4015,7 +3955,7 @@ vector<vector<ui>> ReorderSib::singletonBranches(const vector<ui> &E) {
 // the same sibling split with a smaller branch seed.
 vector<vector<ui>>
 ReorderSib::minimalByInclusion(vector<vector<ui>> solutions) {
-  ScopedTimer _t(rsp.minimal_ms, rsp.minimal_n);
+  ScopedRuntimeTimer _t(rsibCounters.minimal);
   for (vector<ui> &S : solutions)
     sort(S.begin(), S.end());
   sort(solutions.begin(), solutions.end());
@@ -4044,7 +3984,7 @@ ReorderSib::minimalByInclusion(vector<vector<ui>> solutions) {
 // mathematically a no-op here; keep the hook but skip the quadratic subset
 // scan.
 vector<ui> ReorderSib::pruneByDominance(const vector<ui> &cliqueIds) {
-  ScopedTimer _t(rsp.dominance_ms, rsp.dominance_n);
+  ScopedRuntimeTimer _t(rsibCounters.dominance);
   return cliqueIds;
 }
 
@@ -4054,7 +3994,7 @@ vector<ui> ReorderSib::pruneByDominance(const vector<ui> &cliqueIds) {
 vector<vector<ui>>
 ReorderSib::generateSiblingSetsFromCliques(const vector<ui> &E,
                                            const vector<ui> &cliqueIds) {
-  ScopedTimer _t(rsp.siblingPlan_ms, rsp.siblingPlan_n);
+  ScopedRuntimeTimer _t(rsibCounters.siblingPlan);
   if (cliqueIds.empty())
     return singletonBranches(E);
 
@@ -4106,7 +4046,7 @@ vector<vector<ui>> ReorderSib::generateExactSiblingSets(
 vector<vector<ui>>
 ReorderSib::backtrackingBranchBound(const vector<ui> &E,
                                     const vector<vector<ui>> &hitSets) {
-  ScopedTimer _t(rsp.solver_ms, rsp.solver_n);
+  ScopedRuntimeTimer _t(rsibCounters.solver);
   recordSolverCallStats((ui)E.size(), (ui)hitSets.size());
   vector<vector<ui>> solutions;
   vector<ui> current;
@@ -4178,7 +4118,7 @@ vector<vector<ui>>
 ReorderSib::efficientHittingSet(const vector<ui> &inputE,
                                 const vector<vector<ui>> &inputHitSets,
                                 bool *usePivotFallback) {
-  ScopedTimer _t(rsp.solver_ms, rsp.solver_n);
+  ScopedRuntimeTimer _t(rsibCounters.solver);
   if (usePivotFallback != nullptr)
     *usePivotFallback = false;
 
@@ -4923,6 +4863,9 @@ void ReorderSib::enumerateAllPureBranch(const vector<ui> &M,
 void ReorderSib::enumerateAllPureBranchRecursive(
     vector<ui> &R, vector<ui> P, vector<ui> X) {
   incrementSearchStateOrThrow(checksCount);
+  if (searchBudget != nullptr &&
+      searchBudget->exhausted(checksCount, cliqueCount, nextBudgetClock))
+    return;
   if (R.size() + P.size() < minCliqueSize)
     return;
 
@@ -5026,7 +4969,7 @@ void ReorderSib::enumerateAllPureBranchRecursive(
 }
 
 static string encodeClique(const vector<ui> &C) {
-  ScopedTimer _t(rsp.encode_ms, rsp.encode_n);
+  ScopedRuntimeTimer _t(rsibCounters.encode);
   return string(reinterpret_cast<const char *>(C.data()), C.size() * sizeof(ui));
 }
 
@@ -5059,6 +5002,7 @@ bool ReorderSib::recordPureClique(vector<ui> C) {
   emittedCliqueKeys.insert(key);
   allCliques.push_back(std::move(C));
   maxCliqueSize = max(maxCliqueSize, allCliques.back().size());
+  addCliqueSizeCountOrThrow(cliqueSizeHistogram, allCliques.back().size(), 1);
   for (ui v : allCliques.back()) {
     if (cliquesByVertexByLevel[v].empty())
       cliquesByVertexByLevel[v].resize(1);
@@ -5089,7 +5033,7 @@ bool ReorderSib::branchSpaceInsideClique(const vector<ui> &M,
 // the resulting branch seeds (mustin, expandTo).
 void ReorderSib::rCall(vector<vector<ui>> mustin, vector<vector<ui>> expandTo,
                        ui level, vector<char> fullSkipCheck) {
-  ScopedTimer _t(rsp.rCall_ms, rsp.rCall_n);
+  ScopedRuntimeTimer _t(rsibCounters.rCall);
   if (fullSkipCheck.size() != mustin.size())
     fullSkipCheck.assign(mustin.size(), 0);
 
@@ -5111,7 +5055,7 @@ void ReorderSib::rCall(vector<vector<ui>> mustin, vector<vector<ui>> expandTo,
   }
 
   if (level != 0 && !expandTo.empty() && !expandTo[0].empty()) {
-    ScopedTimer _tSibling(rsp.sibling_ms, rsp.sibling_n);
+    ScopedRuntimeTimer _tSibling(rsibCounters.sibling);
     vector<ui> baseM = mustin[0];
     vector<ui> baseE = expandTo[0];
 
@@ -5132,7 +5076,7 @@ void ReorderSib::rCall(vector<vector<ui>> mustin, vector<vector<ui>> expandTo,
     expandTo.reserve(branchReserve);
     fullSkipCheck.reserve(branchReserve);
     {
-      ScopedTimer _tBuild(rsp.branchBuild_ms, rsp.branchBuild_n);
+      ScopedRuntimeTimer _tBuild(rsibCounters.branchBuild);
       for (const vector<ui> &S : siblingSets) {
         vector<ui> baseMustin;
         if (S.size() == 1)
@@ -5163,7 +5107,7 @@ void ReorderSib::rCall(vector<vector<ui>> mustin, vector<vector<ui>> expandTo,
     // "9 then 5").  Only possible when covering cliques exist; singleton
     // branches always have distinct mustins so the dedup is skipped.
     if (hasCoveringCliques) {
-      ScopedTimer _tDedup(rsp.dedup_ms, rsp.dedup_n);
+      ScopedRuntimeTimer _tDedup(rsibCounters.dedup);
       unordered_map<ull, vector<ui>> mustinIndex;
       vector<vector<ui>> dedupMustin;
       vector<vector<ui>> dedupExpand;
@@ -5244,7 +5188,7 @@ void ReorderSib::commitCliqueAndReorder(
     vector<vector<ui>> &expandTo, vector<char> &fullSkipCheck, ui treeIndex,
     ui level, bool &done) {
   {
-    ScopedTimer _tRecord(rsp.cliqueRecord_ms, rsp.cliqueRecord_n);
+    ScopedRuntimeTimer _tRecord(rsibCounters.cliqueRecord);
     sort(C.begin(), C.end());
     if (allCliques.size() > numeric_limits<ui>::max())
       throw overflow_error("materialized clique index exceeds uint32_t");
@@ -5263,6 +5207,7 @@ void ReorderSib::commitCliqueAndReorder(
       cout << "}" << endl;
     }
     maxCliqueSize = max(maxCliqueSize, C.size());
+    addCliqueSizeCountOrThrow(cliqueSizeHistogram, C.size(), 1);
     ui cliqueIdx = (ui)allCliques.size();
     allCliques.push_back(C);
     for (ui v : C) {
@@ -5286,7 +5231,7 @@ void ReorderSib::commitCliqueAndReorder(
   for (ui i = treeIndex; i < (ui)mustin.size(); i++) {
     bool skipBranch = false;
     {
-      ScopedTimer _tSkip(rsp.reorderSkip_ms, rsp.reorderSkip_n);
+      ScopedRuntimeTimer _tSkip(rsibCounters.reorderSkip);
       if (i < fullSkipCheck.size() && fullSkipCheck[i]) {
         skipBranch = branchSpaceInsideClique(mustin[i], expandTo[i], C);
       } else {
@@ -5300,7 +5245,7 @@ void ReorderSib::commitCliqueAndReorder(
     vector<ui> reorderedExpand;
     bool usesFullSkip = false;
     {
-      ScopedTimer _tBuild(rsp.reorderBuild_ms, rsp.reorderBuild_n);
+      ScopedRuntimeTimer _tBuild(rsibCounters.reorderBuild);
       usesFullSkip = i < fullSkipCheck.size() && fullSkipCheck[i];
       if (usesFullSkip) {
         unionInto(scratchMerged, C, expandTo[i]);
@@ -5354,7 +5299,7 @@ void ReorderSib::enumerate(vector<ui> &R, const vector<ui> &P,
                            vector<vector<ui>> &expandTo,
                            vector<char> &fullSkipCheck, ui treeIndex, ui level,
                            bool &done) {
-  ScopedTimer _t(rsp.enumerate_ms, rsp.enumerate_n);
+  ScopedRuntimeTimer _t(rsibCounters.enumerate);
   const ui depth = enumDepth++;
   struct DepthGuard {
     ui &d;
@@ -5393,7 +5338,7 @@ void ReorderSib::enumerate(vector<ui> &R, const vector<ui> &P,
   int minPScore = (int)pSize;
   bool pivotFromX = false;
   {
-    ScopedTimer _tPivot(rsp.pivot_ms, rsp.pivot_n);
+    ScopedRuntimeTimer _tPivot(rsibCounters.pivot);
     for (ui v : P)
       lab[v] = 1;
     for (ui v : X)
@@ -5488,10 +5433,10 @@ void ReorderSib::enumerate(vector<ui> &R, const vector<ui> &P,
 }
 
 void ReorderSib::findAllMaximalCliques() {
-  rsp.reset();
   cliqueCount = externalCliqueCount;
   dupBlocked = 0;
   maxCliqueSize = externalMaxCliqueSize;
+  cliqueSizeHistogram = externalCliqueSizeHistogram;
   checksCount = 0;
   solverBudgetFallbacks = 0;
   allCliques.clear();
@@ -5516,23 +5461,25 @@ void ReorderSib::findAllMaximalCliques() {
   // (normal branches),  true we check using whole mustin[i] and expandTo[i] in
   // C. (sibling brnahces)
   vector<char> fullSkipCheck(n, 0);
+  ScopedPerfRegion perf(rsibCounters.searchPerf);
   rCall(std::move(mustin), std::move(expandTo), 0, std::move(fullSkipCheck));
+  perf.stop();
   auto t1 = chrono::high_resolution_clock::now();
   double ms = chrono::duration<double, milli>(t1 - t0).count();
 
+  rsibCounters.run.report(checksCount, cliqueCount, ms);
+  if (!summaryOutput)
+    return;
   cout << fixed << setprecision(3) << "ReorderSib: cliques=" << cliqueCount
        << "  dups=" << dupBlocked << "  maxSize=" << maxCliqueSize
        << "  checks=" << checksCount << "  time=" << ms << " ms" << endl;
-#if PROFILING
-  rsp.print(ms);
-#endif
 }
 
 void ReorderSib::findAllMaximalCliquesPure() {
-  rsp.reset();
   cliqueCount = externalCliqueCount;
   dupBlocked = 0;
   maxCliqueSize = externalMaxCliqueSize;
+  cliqueSizeHistogram = externalCliqueSizeHistogram;
   checksCount = 0;
   solverBudgetFallbacks = 0;
   allCliques.clear();
@@ -5549,8 +5496,22 @@ void ReorderSib::findAllMaximalCliquesPure() {
     worklist.push_back({{v}, adjList2[v]});
   }
 
+  // Root v starts at stack slot n - 1 - v and everything pushed while it
+  // runs sits above it, so once the stack has shrunk to size s, the roots in
+  // slots s and up are complete.
+  size_t lowestStack = worklist.size();
+  completedRoots.clear();
+
   auto t0 = chrono::high_resolution_clock::now();
+  ScopedPerfRegion perf(rsibCounters.pureSearchPerf);
   while (!worklist.empty()) {
+    if (searchBudget != nullptr) {
+      if (searchBudget->isExhausted())
+        break;
+      lowestStack = min(lowestStack, worklist.size());
+      if (searchBudget->exhausted(checksCount, cliqueCount, nextBudgetClock))
+        break;
+    }
     PureBranch branch = std::move(worklist.back());
     worklist.pop_back();
 
@@ -5584,15 +5545,22 @@ void ReorderSib::findAllMaximalCliquesPure() {
       worklist.push_back({std::move(nextM), std::move(nextQ)});
     }
   }
+  perf.stop();
   auto t1 = chrono::high_resolution_clock::now();
   const double ms = chrono::duration<double, milli>(t1 - t0).count();
+  if (searchBudget != nullptr) {
+    if (!searchBudget->isExhausted())
+      lowestStack = worklist.size();
+    for (ui v = 0; v + lowestStack < n; v++)
+      completedRoots.push_back(internalToOriginal[v]);
+  }
 
+  rsibCounters.pureRun.report(checksCount, cliqueCount, ms);
+  if (!summaryOutput)
+    return;
   cout << fixed << setprecision(3) << "PureReorderSib: cliques=" << cliqueCount
        << "  dups=" << dupBlocked << "  maxSize=" << maxCliqueSize
        << "  minSize=" << minCliqueSize << "  checks=" << checksCount
        << "  budgetFallbacks=" << solverBudgetFallbacks
        << "  time=" << ms << " ms" << endl;
-#if PROFILING
-  rsp.print(ms);
-#endif
 }
@@ -0,0 +1,406 @@
+#include "../inc/incremental_cliques.h"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+#include <unordered_set>
+
+namespace {
+ull edgeKey(ui u, ui v) {
+  if (u > v)
+    std::swap(u, v);
+  return (static_cast<ull>(u) << 32) | v;
+}
+
+// |a intersect b| for sorted a and b; a long b is probed by binary search.
+size_t commonCount(const std::vector<ui> &a, const std::vector<ui> &b) {
+  size_t count = 0;
+  if (b.size() > 8 * a.size()) {
+    for (ui v : a)
+      count += std::binary_search(b.begin(), b.end(), v);
+    return count;
+  }
+  size_t i = 0;
+  size_t j = 0;
+  while (i < a.size() && j < b.size()) {
+    if (a[i] < b[j]) {
+      ++i;
+    } else if (b[j] < a[i]) {
+      ++j;
+    } else {
+      ++count;
+      ++i;
+      ++j;
+    }
+  }
+  return count;
+}
+
+void intersectInto(std::vector<ui> &out, const std::vector<ui> &a,
+                   const std::vector<ui> &b) {
+  out.clear();
+  std::set_intersection(a.begin(), a.end(), b.begin(), b.end(),
+                        std::back_inserter(out));
+}
+
+void insertSorted(std::vector<ui> &row, ui v) {
+  row.insert(std::lower_bound(row.begin(), row.end(), v), v);
+}
+
+void eraseSorted(std::vector<ui> &row, ui v) {
+  row.erase(std::lower_bound(row.begin(), row.end(), v));
+}
+} // namespace
+
+IncrementalCliqueIndex::IncrementalCliqueIndex(
+    const Graph &g, std::vector<std::vector<ui>> initialCliques,
+    ui outputThreshold)
+    : n(g.n), edgeCount(0), rows(g.n),
+      minCliqueSize(std::max<ui>(1, outputThreshold)), cliquesByVertex(g.n),
+      localVertices(nullptr), localWords(0) {
+  for (ui u = 0; u < n; ++u) {
+    std::vector<ui> &row = rows[u];
+    row.assign(g.neighbors.begin() + g.offset[u],
+               g.neighbors.begin() + g.offset[u + 1]);
+    if (!g.adjacencySorted)
+      std::sort(row.begin(), row.end());
+    edgeCount += row.size();
+  }
+  edgeCount /= 2;
+  cliques.reserve(initialCliques.size());
+  for (std::vector<ui> &clique : initialCliques) {
+    for (ui v : clique) {
+      if (v >= n)
+        throw std::out_of_range("stored clique vertex is not in the graph");
+    }
+    addClique(std::move(clique));
+  }
+}
+
+bool IncrementalCliqueIndex::hasEdge(ui u, ui v) const {
+  if (rows[u].size() > rows[v].size())
+    std::swap(u, v);
+  return std::binary_search(rows[u].begin(), rows[u].end(), v);
+}
+
+void IncrementalCliqueIndex::addClique(std::vector<ui> clique) {
+  std::sort(clique.begin(), clique.end());
+  if (cliques.size() >= std::numeric_limits<ui>::max())
+    throw std::overflow_error("incremental clique index exceeds 2^32 cliques");
+  const ui id = static_cast<ui>(cliques.size());
+  for (ui v : clique)
+    cliquesByVertex[v].push_back(id);
+  addCliqueSizeCountOrThrow(cliqueSizeHistogram, clique.size(), 1);
+  cliques.push_back(std::move(clique));
+}
+
+// Drops the dead ids from the lists of their vertices, then moves the live
+// cliques above the final size into the holes below it and renumbers them in
+// one pass over their vertices' lists. Every list is rewritten at most twice
+// per batch, however many of its cliques die, so a hub's long list is not
+// searched once per removed clique.
+ull IncrementalCliqueIndex::removeCliquesTouching(
+    const std::vector<ui> &vertices) {
+  std::vector<ui> dead;
+  for (ui v : vertices)
+    dead.insert(dead.end(), cliquesByVertex[v].begin(),
+                cliquesByVertex[v].end());
+  std::sort(dead.begin(), dead.end());
+  dead.erase(std::unique(dead.begin(), dead.end()), dead.end());
+  if (dead.empty())
+    return 0;
+
+  auto sortedUnique = [](std::vector<ui> &values) {
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+  };
+  if (deadMark.size() < cliques.size())
+    deadMark.resize(cliques.size(), 0);
+  std::vector<ui> touched;
+  for (ui id : dead) {
+    deadMark[id] = 1;
+    touched.insert(touched.end(), cliques[id].begin(), cliques[id].end());
+    --cliqueSizeHistogram[cliques[id].size()];
+  }
+  trimCliqueSizeHistogram(cliqueSizeHistogram);
+  sortedUnique(touched);
+  for (ui v : touched) {
+    std::vector<ui> &ids = cliquesByVertex[v];
+    ids.erase(std::remove_if(ids.begin(), ids.end(),
+                             [&](ui id) { return deadMark[id] != 0; }),
+              ids.end());
+  }
+
+  const ui finalSize = static_cast<ui>(cliques.size() - dead.size());
+  std::vector<ui> relocated(dead.size());
+  touched.clear();
+  auto hole = dead.begin();
+  for (ui id = finalSize; id < cliques.size(); ++id) {
+    if (deadMark[id] != 0)
+      continue;
+    // As many live cliques sit above finalSize as dead ones below it.
+    relocated[id - finalSize] = *hole;
+    touched.insert(touched.end(), cliques[id].begin(), cliques[id].end());
+    cliques[*hole++] = std::move(cliques[id]);
+  }
+  cliques.resize(finalSize);
+  for (ui id : dead)
+    deadMark[id] = 0;
+  sortedUnique(touched);
+  for (ui v : touched) {
+    for (ui &id : cliquesByVertex[v]) {
+      if (id >= finalSize)
+        id = relocated[id - finalSize];
+    }
+  }
+  return dead.size();
+}
+
+IncrementalCliqueDelta IncrementalCliqueIndex::applyEdgeDelta(
+    const std::vector<std::pair<ui, ui>> &inserted,
+    const std::vector<std::pair<ui, ui>> &deleted) {
+  for (const auto &edges : {&inserted, &deleted}) {
+    for (const auto &[u, v] : *edges) {
+      if (u >= n || v >= n)
+        throw std::out_of_range("edge delta vertex is not in the graph");
+    }
+  }
+
+  IncrementalCliqueDelta delta;
+  std::unordered_set<ull> removedEdges;
+  std::unordered_set<ull> addedEdges;
+  for (const auto &[u, v] : deleted) {
+    if (u != v && hasEdge(u, v))
+      removedEdges.insert(edgeKey(u, v));
+  }
+  for (const auto &[u, v] : inserted) {
+    if (u == v)
+      continue;
+    const ull key = edgeKey(u, v);
+    // Deleting then re-inserting an existing edge leaves it unchanged.
+    if (removedEdges.erase(key) == 0 && !hasEdge(u, v))
+      addedEdges.insert(key);
+  }
+  delta.deletedEdges = removedEdges.size();
+  delta.insertedEdges = addedEdges.size();
+  if (removedEdges.empty() && addedEdges.empty())
+    return delta;
+
+  std::vector<ui> affected;
+  affected.reserve(2 * (removedEdges.size() + addedEdges.size()));
+  for (const auto *keys : {&removedEdges, &addedEdges}) {
+    for (ull key : *keys) {
+      affected.push_back(static_cast<ui>(key >> 32));
+      affected.push_back(static_cast<ui>(key & 0xffffffffULL));
+    }
+  }
+  std::sort(affected.begin(), affected.end());
+  affected.erase(std::unique(affected.begin(), affected.end()),
+                 affected.end());
+  delta.affectedVertices = affected.size();
+
+  for (ull key : removedEdges) {
+    const ui u = static_cast<ui>(key >> 32);
+    const ui v = static_cast<ui>(key & 0xffffffffULL);
+    eraseSorted(rows[u], v);
+    eraseSorted(rows[v], u);
+  }
+  for (ull key : addedEdges) {
+    const ui u = static_cast<ui>(key >> 32);
+    const ui v = static_cast<ui>(key & 0xffffffffULL);
+    insertSorted(rows[u], v);
+    insertSorted(rows[v], u);
+  }
+  edgeCount = edgeCount - removedEdges.size() + addedEdges.size();
+
+  delta.removedCliques = removeCliquesTouching(affected);
+
+  found.clear();
+  std::vector<ui> earlier;
+  earlier.reserve(affected.size());
+  for (ui v : affected) {
+    findCliquesContaining(v, earlier);
+    earlier.push_back(v);
+  }
+  delta.addedCliques = found.size();
+  for (std::vector<ui> &clique : found)
+    addClique(std::move(clique));
+  return delta;
+}
+
+void IncrementalCliqueIndex::findCliquesContaining(
+    ui v, const std::vector<ui> &excluded) {
+  // The search runs on N(v) relabelled 0..deg(v)-1 in sorted order, so every
+  // set below stays inside v's neighborhood however large the graph is.
+  const std::vector<ui> &local = rows[v];
+  const ui size = static_cast<ui>(local.size());
+  const bool useBits = size <= LOCAL_BITSET_LIMIT;
+  localWords = (size + 63) / 64;
+  if (useBits)
+    localBits.assign(static_cast<size_t>(size) * localWords, 0);
+  else if (localRows.size() < size)
+    localRows.resize(size);
+  for (ui i = 0; i < size; ++i) {
+    const std::vector<ui> &row = rows[local[i]];
+    auto link = [&](ui j) {
+      if (useBits)
+        localBits[static_cast<size_t>(i) * localWords + j / 64] |=
+            1ULL << (j % 64);
+      else
+        localRows[i].push_back(j);
+    };
+    if (!useBits)
+      localRows[i].clear();
+    if (row.size() < local.size()) {
+      for (ui w : row) {
+        const auto at = std::lower_bound(local.begin(), local.end(), w);
+        if (at != local.end() && *at == w)
+          link(static_cast<ui>(at - local.begin()));
+      }
+    } else {
+      for (ui j = 0; j < size; ++j)
+        if (std::binary_search(row.begin(), row.end(), local[j]))
+          link(j);
+    }
+  }
+
+  // A clique through v has at most deg(v) + 1 vertices, so the levels are
+  // sized up front and the references held during the recursion stay valid.
+  if (levels.size() < static_cast<size_t>(size) + 2)
+    levels.resize(static_cast<size_t>(size) + 2);
+  SearchLevel &root = levels[1];
+  root.p.clear();
+  root.x.clear();
+  if (useBits)
+    root.bits.assign(3 * static_cast<size_t>(localWords), 0);
+  size_t next = 0;
+  for (ui i = 0; i < size; ++i) {
+    while (next < excluded.size() && excluded[next] < local[i])
+      ++next;
+    const bool isExcluded =
+        next < excluded.size() && excluded[next] == local[i];
+    if (useBits)
+      root.bits[(isExcluded ? 2 * localWords : 0) + i / 64] |= 1ULL << (i % 64);
+    else
+      (isExcluded ? root.x : root.p).push_back(i);
+  }
+  localVertices = &local;
+  cliqueStack.assign(1, v);
+  if (useBits)
+    expandBits(1);
+  else
+    expand(1);
+  cliqueStack.clear();
+  localVertices = nullptr;
+}
+
+void IncrementalCliqueIndex::expand(ui depth) {
+  SearchLevel &level = levels[depth];
+  if (level.p.empty()) {
+    if (level.x.empty() && cliqueStack.size() >= minCliqueSize)
+      found.push_back(cliqueStack);
+    return;
+  }
+  if (cliqueStack.size() + level.p.size() < minCliqueSize)
+    return;
+
+  // Tomita pivot: the vertex of P or X with the most neighbors in P.
+  ui pivot = level.p.front();
+  size_t best = 0;
+  for (const std::vector<ui> *side : {&level.p, &level.x}) {
+    for (ui u : *side) {
+      const size_t covered = commonCount(level.p, localRows[u]);
+      if (covered > best) {
+        best = covered;
+        pivot = u;
+      }
+    }
+  }
+  const std::vector<ui> &pivotRow = localRows[pivot];
+  level.candidates.clear();
+  std::set_difference(level.p.begin(), level.p.end(), pivotRow.begin(),
+                      pivotRow.end(), std::back_inserter(level.candidates));
+
+  SearchLevel &child = levels[depth + 1];
+  for (ui u : level.candidates) {
+    intersectInto(child.p, level.p, localRows[u]);
+    intersectInto(child.x, level.x, localRows[u]);
+    cliqueStack.push_back((*localVertices)[u]);
+    expand(depth + 1);
+    cliqueStack.pop_back();
+    eraseSorted(level.p, u);
+    insertSorted(level.x, u);
+  }
+}
+
+// Same search as expand on bit rows.
+void IncrementalCliqueIndex::expandBits(ui depth) {
+  SearchLevel &level = levels[depth];
+  const ui words = localWords;
+  ull *p = level.bits.data();
+  ull *candidates = p + words;
+  ull *x = p + 2 * words;
+  ui pSize = 0;
+  bool xEmpty = true;
+  for (ui w = 0; w < words; ++w) {
+    pSize += static_cast<ui>(__builtin_popcountll(p[w]));
+    xEmpty = xEmpty && x[w] == 0;
+  }
+  if (pSize == 0) {
+    if (xEmpty && cliqueStack.size() >= minCliqueSize)
+      found.push_back(cliqueStack);
+    return;
+  }
+  if (cliqueStack.size() + pSize < minCliqueSize)
+    return;
+
+  auto row = [&](ui u) {
+    return localBits.data() + static_cast<size_t>(u) * words;
+  };
+  ui pivot = 0;
+  ui best = 0;
+  bool pivotFound = false;
+  for (ui w = 0; w < words && best < pSize; ++w) {
+    ull remaining = p[w] | x[w];
+    while (remaining != 0 && best < pSize) {
+      const ui u = w * 64 + static_cast<ui>(__builtin_ctzll(remaining));
+      remaining &= remaining - 1;
+      const ull *bits = row(u);
+      ui covered = 0;
+      for (ui k = 0; k < words; ++k)
+        covered += static_cast<ui>(__builtin_popcountll(p[k] & bits[k]));
+      if (!pivotFound || covered > best) {
+        pivotFound = true;
+        best = covered;
+        pivot = u;
+      }
+    }
+  }
+  const ull *pivotBits = row(pivot);
+  for (ui w = 0; w < words; ++w)
+    candidates[w] = p[w] & ~pivotBits[w];
+
+  SearchLevel &child = levels[depth + 1];
+  if (child.bits.size() < 3 * static_cast<size_t>(words))
+    child.bits.resize(3 * static_cast<size_t>(words));
+  ull *childP = child.bits.data();
+  ull *childX = childP + 2 * words;
+  for (ui w = 0; w < words; ++w) {
+    while (candidates[w] != 0) {
+      const ull bit = candidates[w] & (~candidates[w] + 1);
+      candidates[w] ^= bit;
+      const ui u = w * 64 + static_cast<ui>(__builtin_ctzll(bit));
+      const ull *bits = row(u);
+      for (ui k = 0; k < words; ++k) {
+        childP[k] = p[k] & bits[k];
+        childX[k] = x[k] & bits[k];
+      }
+      cliqueStack.push_back((*localVertices)[u]);
+      expandBits(depth + 1);
+      cliqueStack.pop_back();
+      p[w] ^= bit;
+      x[w] |= bit;
+    }
+  }
+}
@@ -0,0 +1,407 @@
+#include "../inc/json.h"
+
+#include <cerrno>
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+void writeJsonString(std::ostream &out, const std::string &text) {
+  static const char HEX[] = "0123456789abcdef";
+  out << '"';
+  for (unsigned char c : text) {
+    switch (c) {
+    case '"':
+      out << "\\\"";
+      break;
+    case '\\':
+      out << "\\\\";
+      break;
+    case '\n':
+      out << "\\n";
+      break;
+    case '\r':
+      out << "\\r";
+      break;
+    case '\t':
+      out << "\\t";
+      break;
+    default:
+      if (c < 0x20)
+        out << "\\u00" << HEX[c >> 4] << HEX[c & 15];
+      else
+        out << c;
+    }
+  }
+  out << '"';
+}
+
+JsonWriter::JsonWriter(std::ostream &output)
+    : out(output), awaitingValue(false) {}
+
+void JsonWriter::beforeValue() {
+  if (awaitingValue) {
+    awaitingValue = false;
+    return;
+  }
+  if (firstInScope.empty())
+    return;
+  if (objectScope.back())
+    throw std::logic_error("JSON object member written without a key");
+  if (!firstInScope.back())
+    out << ',';
+  firstInScope.back() = false;
+}
+
+JsonWriter &JsonWriter::beginObject() {
+  beforeValue();
+  out << '{';
+  firstInScope.push_back(true);
+  objectScope.push_back(true);
+  return *this;
+}
+
+JsonWriter &JsonWriter::endObject() {
+  if (objectScope.empty() || !objectScope.back() || awaitingValue)
+    throw std::logic_error("unbalanced JSON object");
+  firstInScope.pop_back();
+  objectScope.pop_back();
+  out << '}';
+  return *this;
+}
+
+JsonWriter &JsonWriter::beginArray() {
+  beforeValue();
+  out << '[';
+  firstInScope.push_back(true);
+  objectScope.push_back(false);
+  return *this;
+}
+
+JsonWriter &JsonWriter::endArray() {
+  if (objectScope.empty() || objectScope.back())
+    throw std::logic_error("unbalanced JSON array");
+  firstInScope.pop_back();
+  objectScope.pop_back();
+  out << ']';
+  return *this;
+}
+
+JsonWriter &JsonWriter::key(const std::string &name) {
+  if (objectScope.empty() || !objectScope.back() || awaitingValue)
+    throw std::logic_error("JSON key outside an object");
+  if (!firstInScope.back())
+    out << ',';
+  firstInScope.back() = false;
+  writeJsonString(out, name);
+  out << ':';
+  awaitingValue = true;
+  return *this;
+}
+
+JsonWriter &JsonWriter::value(const std::string &text) {
+  beforeValue();
+  writeJsonString(out, text);
+  return *this;
+}
+
+JsonWriter &JsonWriter::value(const char *text) {
+  return value(std::string(text));
+}
+
+JsonWriter &JsonWriter::value(double number) {
+  beforeValue();
+  if (!std::isfinite(number)) {
+    out << "null";
+    return *this;
+  }
+  // Shortest of 15 or 17 significant digits that reads back exactly.
+  std::ostringstream formatted;
+  formatted << std::setprecision(15) << number;
+  if (std::strtod(formatted.str().c_str(), nullptr) != number) {
+    formatted.str("");
+    formatted << std::setprecision(17) << number;
+  }
+  out << formatted.str();
+  return *this;
+}
+
+JsonWriter &JsonWriter::value(ull number) {
+  beforeValue();
+  out << number;
+  return *this;
+}
+
+JsonWriter &JsonWriter::value(long long number) {
+  beforeValue();
+  out << number;
+  return *this;
+}
+
+JsonWriter &JsonWriter::value(bool flag) {
+  beforeValue();
+  out << (flag ? "true" : "false");
+  return *this;
+}
+
+JsonWriter &JsonWriter::rawNumber(const std::string &token) {
+  beforeValue();
+  out << token;
+  return *this;
+}
+
+JsonWriter &JsonWriter::null() {
+  beforeValue();
+  out << "null";
+  return *this;
+}
+
+const JsonValue *JsonValue::find(const std::string &name) const {
+  if (type != Type::OBJECT)
+    return nullptr;
+  for (const auto &[memberName, member] : members) {
+    if (memberName == name)
+      return &member;
+  }
+  return nullptr;
+}
+
+double JsonValue::asNumber() const {
+  if (type != Type::NUMBER)
+    throw std::invalid_argument("JSON value is not a number");
+  return std::strtod(text.c_str(), nullptr);
+}
+
+ull JsonValue::asUnsigned() const {
+  if (type != Type::NUMBER || text.empty() || text[0] == '-' ||
+      text.find_first_of(".eE") != std::string::npos)
+    throw std::invalid_argument("JSON value is not an unsigned integer");
+  errno = 0;
+  const ull parsed = std::strtoull(text.c_str(), nullptr, 10);
+  if (errno == ERANGE)
+    throw std::invalid_argument("JSON integer out of range: " + text);
+  return parsed;
+}
+
+const std::string &JsonValue::asString() const {
+  if (type != Type::STRING)
+    throw std::invalid_argument("JSON value is not a string");
+  return text;
+}
+
+bool JsonValue::asBool() const {
+  if (type != Type::BOOLEAN)
+    throw std::invalid_argument("JSON value is not a boolean");
+  return boolean;
+}
+
+namespace {
+
+class JsonParser {
+private:
+  const std::string &source;
+  size_t at;
+
+  [[noreturn]] void fail(const char *what) const {
+    throw std::invalid_argument(std::string("JSON parse error at byte ") +
+                                std::to_string(at) + ": " + what);
+  }
+
+  void skipSpace() {
+    while (at < source.size() &&
+           (source[at] == ' ' || source[at] == '\t' || source[at] == '\n' ||
+            source[at] == '\r'))
+      ++at;
+  }
+
+  void expect(const char *literal) {
+    for (const char *c = literal; *c != '\0'; ++c, ++at) {
+      if (at >= source.size() || source[at] != *c)
+        fail("unexpected literal");
+    }
+  }
+
+  void appendUtf8(std::string &out, unsigned codePoint) {
+    if (codePoint < 0x80) {
+      out += static_cast<char>(codePoint);
+    } else if (codePoint < 0x800) {
+      out += static_cast<char>(0xC0 | (codePoint >> 6));
+      out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    } else {
+      out += static_cast<char>(0xE0 | (codePoint >> 12));
+      out += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+      out += static_cast<char>(0x80 | (codePoint & 0x3F));
+    }
+  }
+
+  std::string parseString() {
+    if (source[at] != '"')
+      fail("expected string");
+    ++at;
+    std::string out;
+    while (true) {
+      if (at >= source.size())
+        fail("unterminated string");
+      const char c = source[at++];
+      if (c == '"')
+        return out;
+      if (c != '\\') {
+        out += c;
+        continue;
+      }
+      if (at >= source.size())
+        fail("unterminated escape");
+      const char escaped = source[at++];
+      switch (escaped) {
+      case '"':
+      case '\\':
+      case '/':
+        out += escaped;
+        break;
+      case 'b':
+        out += '\b';
+        break;
+      case 'f':
+        out += '\f';
+        break;
+      case 'n':
+        out += '\n';
+        break;
+      case 'r':
+        out += '\r';
+        break;
+      case 't':
+        out += '\t';
+        break;
+      case 'u': {
+        if (at + 4 > source.size())
+          fail("short unicode escape");
+        const unsigned codePoint =
+            static_cast<unsigned>(std::stoul(source.substr(at, 4), nullptr, 16));
+        at += 4;
+        appendUtf8(out, codePoint);
+        break;
+      }
+      default:
+        fail("unknown escape");
+      }
+    }
+  }
+
+  JsonValue parseNumber() {
+    const size_t start = at;
+    if (source[at] == '-')
+      ++at;
+    while (at < source.size() &&
+           (std::isdigit(static_cast<unsigned char>(source[at])) ||
+            source[at] == '.' || source[at] == 'e' || source[at] == 'E' ||
+            source[at] == '+' || source[at] == '-'))
+      ++at;
+    JsonValue number;
+    number.type = JsonValue::Type::NUMBER;
+    number.text = source.substr(start, at - start);
+    char *end = nullptr;
+    std::strtod(number.text.c_str(), &end);
+    if (number.text.empty() || end != number.text.c_str() + number.text.size())
+      fail("malformed number");
+    return number;
+  }
+
+public:
+  explicit JsonParser(const std::string &document) : source(document), at(0) {}
+
+  JsonValue parseValue() {
+    skipSpace();
+    if (at >= source.size())
+      fail("unexpected end of input");
+    JsonValue parsed;
+    const char c = source[at];
+    if (c == '{') {
+      parsed.type = JsonValue::Type::OBJECT;
+      ++at;
+      skipSpace();
+      if (at < source.size() && source[at] == '}') {
+        ++at;
+        return parsed;
+      }
+      while (true) {
+        skipSpace();
+        if (at >= source.size())
+          fail("unterminated object");
+        std::string name = parseString();
+        skipSpace();
+        if (at >= source.size() || source[at] != ':')
+          fail("expected ':'");
+        ++at;
+        parsed.members.emplace_back(std::move(name), parseValue());
+        skipSpace();
+        if (at < source.size() && source[at] == ',') {
+          ++at;
+          continue;
+        }
+        if (at < source.size() && source[at] == '}') {
+          ++at;
+          return parsed;
+        }
+        fail("expected ',' or '}'");
+      }
+    }
+    if (c == '[') {
+      parsed.type = JsonValue::Type::ARRAY;
+      ++at;
+      skipSpace();
+      if (at < source.size() && source[at] == ']') {
+        ++at;
+        return parsed;
+      }
+      while (true) {
+        parsed.items.push_back(parseValue());
+        skipSpace();
+        if (at < source.size() && source[at] == ',') {
+          ++at;
+          continue;
+        }
+        if (at < source.size() && source[at] == ']') {
+          ++at;
+          return parsed;
+        }
+        fail("expected ',' or ']'");
+      }
+    }
+    if (c == '"') {
+      parsed.type = JsonValue::Type::STRING;
+      parsed.text = parseString();
+      return parsed;
+    }
+    if (c == 't') {
+      expect("true");
+      parsed.type = JsonValue::Type::BOOLEAN;
+      parsed.boolean = true;
+      return parsed;
+    }
+    if (c == 'f') {
+      expect("false");
+      parsed.type = JsonValue::Type::BOOLEAN;
+      return parsed;
+    }
+    if (c == 'n') {
+      expect("null");
+      return parsed;
+    }
+    return parseNumber();
+  }
+
+  void finish() {
+    skipSpace();
+    if (at != source.size())
+      fail("trailing characters");
+  }
+};
+
+} // namespace
+
+JsonValue parseJson(const std::string &document) {
+  JsonParser parser(document);
+  JsonValue parsed = parser.parseValue();
+  parser.finish();
+  return parsed;
+}
@@ -0,0 +1,308 @@
+#include "k_clique_lister.h"
+#include "checked_count.h"
+#include "fast_list_bk.h"
+#include "parallel_for.h"
+
+#include <chrono>
+#include <iomanip>
+#include <limits>
+
+namespace {
+
+constexpr ui ABSENT = std::numeric_limits<ui>::max();
+
+void addKCliqueCountOrThrow(ull &count, ull increment) {
+  ull sum = 0;
+  if (!tryAddUll(count, increment, sum))
+    throw std::overflow_error(
+        "k-clique count exceeds the uint64_t output range");
+  count = sum;
+}
+
+ui popcount(ull bits) { return static_cast<ui>(__builtin_popcountll(bits)); }
+
+} // namespace
+
+// Per-thread scratch. levelBits[d] / levelLists[d] hold the candidates after
+// d vertices below the root have been chosen; rows[i] is the set of local
+// vertices after i (in rank order) that are adjacent to local vertex i.
+struct KCliqueLister::Worker {
+  ull count = 0;
+  // Budget bookkeeping: recursion calls, the call count at which this
+  // worker next reads the clock, the count when the current root started and
+  // the roots finished before the budget ran out.
+  ull nodes = 0;
+  ull nextBudgetClock = 0;
+  ull rootStartCount = 0;
+  std::vector<ui> completedRoots;
+  ull bitsetRoots = 0;
+  ull listRoots = 0;
+  ui words = 0;
+  std::vector<ui> local;
+  std::vector<ui> localIndex;
+  std::vector<ull> rows;
+  std::vector<std::vector<ull>> levelBits;
+  std::vector<std::vector<ui>> levelLists;
+  std::vector<ui> clique;
+  std::vector<ui> sorted;
+};
+
+KCliqueLister::KCliqueLister(const Graph &g, ui k)
+    : graph(g), adjacency(g.adjacencyHash()), k(k), degeneracy(0),
+      threads(configuredThreadCount()), cliqueCount(0), bitsetRoots(0),
+      listRoots(0), summaryOutput(true), rootCosts(nullptr),
+      budget(nullptr), committedCliques(0) {
+  if (k == 0)
+    throw std::invalid_argument("k-clique size must be at least 1");
+  buildOrientation();
+}
+
+void KCliqueLister::buildOrientation() {
+  const CoreDecomposition &cores = graph.coreDecomposition();
+  rank = cores.rank;
+  degeneracy = cores.degeneracy;
+  outOffset.assign(static_cast<size_t>(graph.n) + 1, 0);
+  for (ui u = 0; u < graph.n; ++u) {
+    ui out = 0;
+    for (ui at = graph.offset[u]; at < graph.offset[u + 1]; ++at)
+      if (rank[graph.neighbors[at]] > rank[u])
+        ++out;
+    outOffset[u + 1] = outOffset[u] + out;
+  }
+  outNeighbors.resize(outOffset[graph.n]);
+  for (ui u = 0; u < graph.n; ++u) {
+    ui next = outOffset[u];
+    for (ui at = graph.offset[u]; at < graph.offset[u + 1]; ++at) {
+      const ui v = graph.neighbors[at];
+      if (rank[v] > rank[u])
+        outNeighbors[next++] = v;
+    }
+    // Rank order makes "later in the list" coincide with "higher rank", so
+    // each candidate only needs the candidates after it.
+    std::sort(outNeighbors.begin() + outOffset[u],
+              outNeighbors.begin() + outOffset[u + 1],
+              [&](ui a, ui b) { return rank[a] < rank[b]; });
+  }
+}
+
+void KCliqueLister::emit(Worker &worker) {
+  worker.sorted = worker.clique;
+  std::sort(worker.sorted.begin(), worker.sorted.end());
+  std::lock_guard<std::mutex> lock(sinkMutex);
+  cliqueSink(worker.sorted);
+}
+
+void KCliqueLister::buildRootBitsets(Worker &worker, ui root) {
+  const ui begin = outOffset[root];
+  const ui size = outOffset[root + 1] - begin;
+  worker.local.assign(outNeighbors.begin() + begin,
+                      outNeighbors.begin() + begin + size);
+  worker.words = (size + 63) >> 6;
+  worker.rows.assign(static_cast<size_t>(size) * worker.words, 0);
+  for (ui i = 0; i < size; ++i)
+    worker.localIndex[worker.local[i]] = i;
+
+  for (ui i = 0; i < size; ++i) {
+    const ui u = worker.local[i];
+    ull *row = worker.rows.data() + static_cast<size_t>(i) * worker.words;
+    const ui outDegree = outOffset[u + 1] - outOffset[u];
+    if (outDegree <= size - i - 1) {
+      for (ui at = outOffset[u]; at < outOffset[u + 1]; ++at) {
+        const ui j = worker.localIndex[outNeighbors[at]];
+        if (j != ABSENT)
+          row[j >> 6] |= 1ULL << (j & 63);
+      }
+    } else {
+      for (ui j = i + 1; j < size; ++j)
+        if (adjacency.contains(u, worker.local[j]))
+          row[j >> 6] |= 1ULL << (j & 63);
+    }
+  }
+
+  for (ui v : worker.local)
+    worker.localIndex[v] = ABSENT;
+}
+
+bool KCliqueLister::budgetExhausted(Worker &worker) {
+  // Other workers' in-flight roots are not visible here, so a clique limit
+  // can be overshot by up to one root per worker.
+  return budget->exhausted(++worker.nodes,
+                           committedCliques.load(std::memory_order_relaxed) +
+                               worker.count - worker.rootStartCount,
+                           worker.nextBudgetClock);
+}
+
+void KCliqueLister::countBitsets(Worker &worker, ui depth, ui need) {
+  if (budget != nullptr && budgetExhausted(worker))
+    return;
+  const ui words = worker.words;
+  const std::vector<ull> &candidates = worker.levelBits[depth];
+
+  if (need == 1 && !cliqueSink) {
+    ull found = 0;
+    for (ui wi = 0; wi < words; ++wi)
+      found += popcount(candidates[wi]);
+    addKCliqueCountOrThrow(worker.count, found);
+    return;
+  }
+  if (need == 2 && !cliqueSink) {
+    // Last two levels in one pass: each candidate contributes its later
+    // neighbors among the candidates.
+    ull found = 0;
+    for (ui wi = 0; wi < words; ++wi) {
+      ull word = candidates[wi];
+      while (word) {
+        const ui i = (wi << 6) + static_cast<ui>(__builtin_ctzll(word));
+        word &= word - 1;
+        const ull *row =
+            worker.rows.data() + static_cast<size_t>(i) * words;
+        for (ui aw = wi; aw < words; ++aw)
+          found += popcount(candidates[aw] & row[aw]);
+      }
+      addKCliqueCountOrThrow(worker.count, found);
+      found = 0;
+    }
+    return;
+  }
+
+  std::vector<ull> &child = worker.levelBits[depth + 1];
+  for (ui wi = 0; wi < words; ++wi) {
+    ull word = candidates[wi];
+    while (word) {
+      const ui i = (wi << 6) + static_cast<ui>(__builtin_ctzll(word));
+      word &= word - 1;
+      worker.clique.push_back(worker.local[i]);
+      if (need == 1) {
+        addKCliqueCountOrThrow(worker.count, 1);
+        emit(worker);
+      } else {
+        const ull *row =
+            worker.rows.data() + static_cast<size_t>(i) * words;
+        ui childSize = 0;
+        for (ui aw = 0; aw < wi; ++aw)
+          child[aw] = 0;
+        for (ui aw = wi; aw < words; ++aw) {
+          child[aw] = candidates[aw] & row[aw];
+          childSize += popcount(child[aw]);
+        }
+        if (childSize >= need - 1)
+          countBitsets(worker, depth + 1, need - 1);
+      }
+      worker.clique.pop_back();
+    }
+  }
+}
+
+void KCliqueLister::countLists(Worker &worker, ui depth, ui need) {
+  if (budget != nullptr && budgetExhausted(worker))
+    return;
+  const std::vector<ui> &candidates = worker.levelLists[depth];
+  if (need == 1 && !cliqueSink) {
+    addKCliqueCountOrThrow(worker.count, candidates.size());
+    return;
+  }
+
+  std::vector<ui> &child = worker.levelLists[depth + 1];
+  for (size_t i = 0; i < candidates.size(); ++i) {
+    const ui v = candidates[i];
+    worker.clique.push_back(v);
+    if (need == 1) {
+      addKCliqueCountOrThrow(worker.count, 1);
+      emit(worker);
+    } else if (candidates.size() - i - 1 >= need - 1) {
+      child.clear();
+      for (size_t j = i + 1; j < candidates.size(); ++j)
+        if (adjacency.contains(v, candidates[j]))
+          child.push_back(candidates[j]);
+      if (child.size() >= need - 1)
+        countLists(worker, depth + 1, need - 1);
+    }
+    worker.clique.pop_back();
+  }
+}
+
+void KCliqueLister::processRoot(Worker &worker, ui root) {
+  worker.clique.assign(1, root);
+  if (k == 1) {
+    addKCliqueCountOrThrow(worker.count, 1);
+    if (cliqueSink)
+      emit(worker);
+    return;
+  }
+
+  const ui outDegree = outOffset[root + 1] - outOffset[root];
+  if (outDegree < k - 1)
+    return;
+  if (outDegree <= BITSET_LIMIT) {
+    ++worker.bitsetRoots;
+    buildRootBitsets(worker, root);
+    for (std::vector<ull> &level : worker.levelBits)
+      level.resize(worker.words);
+    std::vector<ull> &all = worker.levelBits[0];
+    std::fill(all.begin(), all.end(), ~0ULL);
+    if ((outDegree & 63) != 0)
+      all[worker.words - 1] = (1ULL << (outDegree & 63)) - 1;
+    countBitsets(worker, 0, k - 1);
+  } else {
+    ++worker.listRoots;
+    worker.levelLists[0].assign(outNeighbors.begin() + outOffset[root],
+                                outNeighbors.begin() + outOffset[root + 1]);
+    countLists(worker, 0, k - 1);
+  }
+}
+
+void KCliqueLister::listAllCliques() {
+  cliqueCount = 0;
+  bitsetRoots = 0;
+  listRoots = 0;
+  const auto start = std::chrono::steady_clock::now();
+
+  const unsigned workerCount =
+      std::max(1u, std::min<unsigned>(threads, std::max<ui>(graph.n, 1)));
+  std::vector<Worker> workers(workerCount);
+  for (Worker &worker : workers) {
+    worker.localIndex.assign(graph.n, ABSENT);
+    worker.levelBits.resize(k);
+    worker.levelLists.resize(k);
+  }
+  if (!rootSchedule.empty() && rootSchedule.size() != graph.n)
+    throw std::invalid_argument("root schedule must list every vertex once");
+  const ull noChecks = 0;
+  committedCliques.store(0);
+  completedRoots.clear();
+  parallelFor(graph.n, workerCount, 16, [&](unsigned id, size_t index) {
+    Worker &worker = workers[id];
+    if (budget != nullptr && budgetExhausted(worker))
+      return;
+    const ui root =
+        rootSchedule.empty() ? static_cast<ui>(index) : rootSchedule[index];
+    RootCostScope cost(rootCosts, root, noChecks, worker.count);
+    processRoot(worker, root);
+    if (budget == nullptr)
+      return;
+    committedCliques.fetch_add(worker.count - worker.rootStartCount,
+                               std::memory_order_relaxed);
+    worker.rootStartCount = worker.count;
+    if (!budget->isExhausted())
+      worker.completedRoots.push_back(root);
+  });
+  for (const Worker &worker : workers) {
+    addKCliqueCountOrThrow(cliqueCount, worker.count);
+    bitsetRoots += worker.bitsetRoots;
+    listRoots += worker.listRoots;
+    completedRoots.insert(completedRoots.end(), worker.completedRoots.begin(),
+                          worker.completedRoots.end());
+  }
+  std::sort(completedRoots.begin(), completedRoots.end());
+
+  if (!summaryOutput)
+    return;
+  const double ms = std::chrono::duration<double, std::milli>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+  std::cout << "KCliqueLister: k=" << k << "  cliques=" << cliqueCount
+            << "  degeneracy=" << degeneracy << "  threads=" << workerCount
+            << "  bitsetRoots=" << bitsetRoots << "  listRoots=" << listRoots
+            << "  time=" << std::fixed << std::setprecision(3) << ms << " ms"
+            << std::endl;
+}
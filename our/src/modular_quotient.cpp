@@ -0,0 +1,347 @@
+#include "../inc/modular_quotient.h"
+#include "../inc/fast_list_bk.h"
+
+#include <numeric>
+
+namespace {
+ull mixKey(ull x) {
+  x += 0x9e3779b97f4a7c15ULL;
+  x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+  return x ^ (x >> 31);
+}
+
+bool sameOpenNeighborhood(const Graph &g, ui a, ui b) {
+  return g.degree[a] == g.degree[b] &&
+         std::equal(g.neighbors.begin() + g.offset[a],
+                    g.neighbors.begin() + g.offset[a + 1],
+                    g.neighbors.begin() + g.offset[b]);
+}
+
+// N[a] == N[b] on sorted rows: a and b are adjacent and agree elsewhere.
+bool sameClosedNeighborhood(const Graph &g, ui a, ui b) {
+  if (g.degree[a] != g.degree[b])
+    return false;
+  ui ai = g.offset[a], bi = g.offset[b];
+  const ui ae = g.offset[a + 1], be = g.offset[b + 1];
+  bool adjacent = false;
+  while (true) {
+    if (ai < ae && g.neighbors[ai] == b) {
+      adjacent = true;
+      ++ai;
+    }
+    if (bi < be && g.neighbors[bi] == a)
+      ++bi;
+    const bool hasA = ai < ae;
+    const bool hasB = bi < be;
+    if (!hasA || !hasB)
+      return adjacent && hasA == hasB;
+    if (g.neighbors[ai++] != g.neighbors[bi++])
+      return false;
+  }
+}
+
+void convolveOrThrow(const CliqueSizeHistogram &left,
+                     const CliqueSizeHistogram &right,
+                     CliqueSizeHistogram &out) {
+  out.assign(left.size() + right.size() - 1, 0);
+  for (size_t i = 0; i < left.size(); ++i) {
+    if (left[i] == 0)
+      continue;
+    for (size_t j = 0; j < right.size(); ++j) {
+      ull product = 0;
+      if (!tryMultiplyUll(left[i], right[j], product))
+        throw std::overflow_error(
+            "maximal-clique count exceeds the uint64_t output range");
+      addCliqueCountOrThrow(out[i + j], product);
+    }
+  }
+}
+
+// The size of a module with exactly one maximal clique, or 0.
+ui singleCliqueSize(const CliqueSizeHistogram &histogram) {
+  ui size = 0;
+  for (size_t s = 0; s < histogram.size(); ++s) {
+    if (histogram[s] == 0)
+      continue;
+    if (size != 0 || histogram[s] != 1)
+      return 0;
+    size = static_cast<ui>(s);
+  }
+  return size;
+}
+
+const CliqueSizeHistogram &moduleCliquesOf(const TwinModuleQuotient &quotient,
+                                           ui q) {
+  static const CliqueSizeHistogram singleVertex{0, 1};
+  const CliqueSizeHistogram &cliques = quotient.moduleCliques[q];
+  return cliques.empty() ? singleVertex : cliques;
+}
+
+// Groups vertices by hash in an open-addressing table (linear time), then
+// splits each group into exact classes; only classes with two or more
+// members are returned.
+template <typename Same>
+void collectTwinClasses(const std::vector<ull> &hash, Same same,
+                        std::vector<std::vector<ui>> &classes) {
+  const ui n = static_cast<ui>(hash.size());
+  size_t capacity = 1;
+  while (capacity < 2 * static_cast<size_t>(n))
+    capacity <<= 1;
+  const size_t mask = capacity - 1;
+  std::vector<ui> slotHead(capacity, UINT_MAX);
+  std::vector<ui> nextInGroup(n, UINT_MAX);
+  for (ui v = 0; v < n; ++v) {
+    size_t slot = hash[v] & mask;
+    while (slotHead[slot] != UINT_MAX && hash[slotHead[slot]] != hash[v])
+      slot = (slot + 1) & mask;
+    if (slotHead[slot] == UINT_MAX) {
+      slotHead[slot] = v;
+    } else {
+      nextInGroup[v] = nextInGroup[slotHead[slot]];
+      nextInGroup[slotHead[slot]] = v;
+    }
+  }
+
+  std::vector<ui> group;
+  std::vector<ui> rest;
+  for (ui head : slotHead) {
+    if (head == UINT_MAX || nextInGroup[head] == UINT_MAX)
+      continue;
+    group.clear();
+    for (ui v = head; v != UINT_MAX; v = nextInGroup[v])
+      group.push_back(v);
+    // A hash collision leaves some members unmatched; they seed the next
+    // class, so an honest group is verified in one pass.
+    while (group.size() > 1) {
+      std::vector<ui> twins{group[0]};
+      rest.clear();
+      for (size_t k = 1; k < group.size(); ++k)
+        (same(group[0], group[k]) ? twins : rest).push_back(group[k]);
+      if (twins.size() > 1)
+        classes.push_back(std::move(twins));
+      group.swap(rest);
+    }
+  }
+}
+} // namespace
+
+TwinModuleQuotient buildTwinModuleQuotient(const Graph &g) {
+  TwinModuleQuotient result;
+  result.quotient = g;
+  result.quotient.sortAdjacency();
+  result.nodes.resize(g.n);
+  result.moduleRoot.resize(g.n);
+  result.moduleCliques.resize(g.n);
+  for (ui v = 0; v < g.n; ++v) {
+    result.nodes[v].vertex = v;
+    result.moduleRoot[v] = v;
+  }
+
+  std::vector<ull> key;
+  std::vector<ull> openHash;
+  std::vector<ull> closedHash;
+  while (true) {
+    Graph &current = result.quotient;
+    const ui n = current.n;
+    key.resize(n);
+    for (ui v = 0; v < n; ++v)
+      key[v] = mixKey((static_cast<ull>(result.rounds) << 32) | v);
+    openHash.resize(n);
+    closedHash.resize(n);
+    for (ui v = 0; v < n; ++v) {
+      ull hash = mixKey(current.degree[v]);
+      for (ui at = current.offset[v]; at < current.offset[v + 1]; ++at)
+        hash += key[current.neighbors[at]];
+      openHash[v] = hash;
+      closedHash[v] = hash + key[v];
+    }
+
+    // A vertex cannot have both a true and a false twin: a true twin c of a
+    // lies in N(a) = N(b) for any false twin b, so b would be in N[c] = N[a].
+    std::vector<std::vector<ui>> falseClasses;
+    std::vector<std::vector<ui>> trueClasses;
+    collectTwinClasses(
+        openHash,
+        [&](ui a, ui b) { return sameOpenNeighborhood(current, a, b); },
+        falseClasses);
+    collectTwinClasses(
+        closedHash,
+        [&](ui a, ui b) { return sameClosedNeighborhood(current, a, b); },
+        trueClasses);
+
+    ull merged = 0;
+    for (const auto *classes : {&falseClasses, &trueClasses}) {
+      for (const std::vector<ui> &members : *classes)
+        merged += members.size() - 1;
+    }
+    // Later rounds must still pay for their rebuild.
+    if (merged == 0 || (result.rounds > 0 && merged * 64 < n))
+      break;
+    ++result.rounds;
+
+    std::vector<ui> newId(n, UINT_MAX);
+    std::vector<ui> nextRoot;
+    std::vector<CliqueSizeHistogram> nextCliques;
+    std::vector<ui> representative;
+    CliqueSizeHistogram product;
+    auto mergeClass = [&](const std::vector<ui> &members, bool series) {
+      const ui id = static_cast<ui>(representative.size());
+      TwinModuleNode node;
+      node.kind = series ? TwinModuleNode::SERIES : TwinModuleNode::PARALLEL;
+      CliqueSizeHistogram cliques;
+      for (ui v : members) {
+        newId[v] = id;
+        node.children.push_back(result.moduleRoot[v]);
+        const CliqueSizeHistogram &child = moduleCliquesOf(result, v);
+        if (cliques.empty()) {
+          cliques = child;
+        } else if (series) {
+          convolveOrThrow(cliques, child, product);
+          cliques.swap(product);
+        } else {
+          mergeCliqueSizeHistogramOrThrow(cliques, child);
+        }
+      }
+      nextRoot.push_back(static_cast<ui>(result.nodes.size()));
+      result.nodes.push_back(std::move(node));
+      nextCliques.push_back(std::move(cliques));
+      representative.push_back(members[0]);
+    };
+    for (const std::vector<ui> &members : falseClasses)
+      mergeClass(members, false);
+    for (const std::vector<ui> &members : trueClasses)
+      mergeClass(members, true);
+    result.falseTwinMerges += falseClasses.size();
+    result.trueTwinMerges += trueClasses.size();
+    for (ui v = 0; v < n; ++v) {
+      if (newId[v] != UINT_MAX)
+        continue;
+      newId[v] = static_cast<ui>(representative.size());
+      nextRoot.push_back(result.moduleRoot[v]);
+      nextCliques.push_back(std::move(result.moduleCliques[v]));
+      representative.push_back(v);
+    }
+
+    // Twins share their outside neighbors, so a representative's row,
+    // renamed and deduplicated, is the module's row.
+    const ui nextN = static_cast<ui>(representative.size());
+    Graph next;
+    next.n = nextN;
+    next.offset.assign(nextN + 1, 0);
+    next.degree.assign(nextN, 0);
+    next.neighbors.reserve(current.neighbors.size());
+    std::vector<ui> seen(nextN, UINT_MAX);
+    for (ui q = 0; q < nextN; ++q) {
+      const ui r = representative[q];
+      const size_t rowStart = next.neighbors.size();
+      seen[q] = q;
+      for (ui at = current.offset[r]; at < current.offset[r + 1]; ++at) {
+        const ui w = newId[current.neighbors[at]];
+        if (seen[w] != q) {
+          seen[w] = q;
+          next.neighbors.push_back(w);
+        }
+      }
+      std::sort(next.neighbors.begin() + rowStart, next.neighbors.end());
+      next.degree[q] = static_cast<ui>(next.neighbors.size() - rowStart);
+      next.offset[q + 1] = static_cast<ui>(next.neighbors.size());
+    }
+    next.m = next.offset[nextN] / 2;
+    next.adjacencySorted = true;
+    result.quotient = std::move(next);
+    result.moduleRoot.swap(nextRoot);
+    result.moduleCliques.swap(nextCliques);
+  }
+  return result;
+}
+
+ModularQuotientSolver::ModularQuotientSolver(const Graph &g,
+                                             ui outputThreshold)
+    : graph(g), minCliqueSize(std::max<ui>(1, outputThreshold)),
+      decomposition(buildTwinModuleQuotient(g)), cliqueCount(0),
+      maxCliqueSize(0), quotientCliques(0) {}
+
+// pending holds tree nodes still to contribute a clique. A series node
+// contributes one clique per child, a parallel node one clique of one child.
+void ModularQuotientSolver::expandModules(std::vector<ui> &pending,
+                                          std::vector<ui> &clique) const {
+  if (pending.empty()) {
+    if (clique.size() >= minCliqueSize) {
+      std::vector<ui> sorted = clique;
+      std::sort(sorted.begin(), sorted.end());
+      cliqueSink(sorted);
+    }
+    return;
+  }
+  const ui id = pending.back();
+  pending.pop_back();
+  const TwinModuleNode &node = decomposition.nodes[id];
+  if (node.kind == TwinModuleNode::LEAF) {
+    clique.push_back(node.vertex);
+    expandModules(pending, clique);
+    clique.pop_back();
+  } else if (node.kind == TwinModuleNode::SERIES) {
+    pending.insert(pending.end(), node.children.begin(), node.children.end());
+    expandModules(pending, clique);
+    pending.resize(pending.size() - node.children.size());
+  } else {
+    for (ui child : node.children) {
+      pending.push_back(child);
+      expandModules(pending, clique);
+      pending.pop_back();
+    }
+  }
+  pending.push_back(id);
+}
+
+void ModularQuotientSolver::findAllMaximalCliques() {
+  cliqueCount = 0;
+  maxCliqueSize = 0;
+  quotientCliques = 0;
+  cliqueSizeHistogram.clear();
+
+  const Graph &quotient = decomposition.quotient;
+  FastListBK engine(quotient, false, 1);
+  CliqueSizeHistogram product;
+  CliqueSizeHistogram next;
+  std::vector<ui> pending;
+  std::vector<ui> clique;
+  engine.setCliqueSink([&](const std::vector<ui> &members) {
+    ++quotientCliques;
+    // Modules with a single maximal clique only shift the sizes.
+    ui shift = 0;
+    product.assign(1, 1);
+    for (ui q : members) {
+      const ui single = singleCliqueSize(moduleCliquesOf(decomposition, q));
+      if (single != 0) {
+        shift += single;
+        continue;
+      }
+      convolveOrThrow(product, moduleCliquesOf(decomposition, q), next);
+      product.swap(next);
+    }
+    if (shift + product.size() - 1 < minCliqueSize)
+      return;
+    for (size_t s = 0; s < product.size(); ++s) {
+      const size_t size = s + shift;
+      if (product[s] == 0 || size < minCliqueSize)
+        continue;
+      addCliqueCountOrThrow(cliqueCount, product[s]);
+      addCliqueSizeCountOrThrow(cliqueSizeHistogram, size, product[s]);
+      maxCliqueSize = std::max(maxCliqueSize, static_cast<ui>(size));
+    }
+    if (cliqueSink) {
+      pending.clear();
+      for (ui q : members)
+        pending.push_back(decomposition.moduleRoot[q]);
+      expandModules(pending, clique);
+    }
+  });
+
+  std::vector<ui> roots(quotient.n);
+  std::iota(roots.begin(), roots.end(), 0);
+  engine.findMaximalCliquesFromRoots(quotient.coreDecomposition().rank,
+                                     roots);
+  trimCliqueSizeHistogram(cliqueSizeHistogram);
+}
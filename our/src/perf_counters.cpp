@@ -0,0 +1,268 @@
+#include "../inc/perf_counters.h"
+#include "../inc/runtime_counters.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <unordered_map>
+
+namespace perf_counters_detail {
+std::atomic<bool> enabled(false);
+} // namespace perf_counters_detail
+
+namespace {
+
+struct PerfEventSpec {
+  const char *name;
+  uint32_t type;
+  uint64_t config;
+};
+
+// Indexed by PerfEvent. The cache-miss event is the generic hardware cache
+// miss count, which the kernel maps to last-level cache misses.
+const PerfEventSpec PERF_EVENT_SPECS[PERF_EVENT_COUNT] = {
+    {"task_clock_ns", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK},
+    {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"llc_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {"branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}};
+
+int openPerfEvent(const PerfEventSpec &spec, int groupFd) {
+  perf_event_attr attr{};
+  attr.size = sizeof(attr);
+  attr.type = spec.type;
+  attr.config = spec.config;
+  attr.disabled = groupFd == -1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format = PERF_FORMAT_GROUP;
+  return static_cast<int>(
+      syscall(SYS_perf_event_open, &attr, 0, -1, groupFd, 0));
+}
+
+// The calling thread's event group. slot[e] is event e's position in a
+// group read, or -1 when it did not open.
+class PerfThreadGroup {
+public:
+  bool attempted = false;
+  int leader = -1;
+  int firstError = 0;
+  std::vector<int> fds;
+  std::array<int, PERF_EVENT_COUNT> slot{};
+
+  void open() {
+    attempted = true;
+    slot.fill(-1);
+    for (size_t e = 0; e < PERF_EVENT_COUNT; ++e) {
+      const int fd = openPerfEvent(PERF_EVENT_SPECS[e], leader);
+      if (fd < 0) {
+        if (firstError == 0)
+          firstError = errno;
+        continue;
+      }
+      if (leader == -1)
+        leader = fd;
+      slot[e] = static_cast<int>(fds.size());
+      fds.push_back(fd);
+    }
+    if (leader != -1) {
+      ioctl(leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+      ioctl(leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+    }
+  }
+
+  bool read(std::array<ull, PERF_EVENT_COUNT> &values) const {
+    if (leader == -1)
+      return false;
+    // PERF_FORMAT_GROUP: the event count, then one value per event.
+    ull buffer[1 + PERF_EVENT_COUNT];
+    const ssize_t bytes = ::read(leader, buffer, sizeof(buffer));
+    if (bytes < static_cast<ssize_t>(sizeof(ull) * (1 + fds.size())))
+      return false;
+    for (size_t e = 0; e < PERF_EVENT_COUNT; ++e)
+      values[e] = slot[e] < 0 ? 0 : buffer[1 + slot[e]];
+    return true;
+  }
+
+  ~PerfThreadGroup() {
+    for (int fd : fds)
+      close(fd);
+  }
+};
+
+thread_local PerfThreadGroup threadGroup;
+// xorshift state for choosing the sampled kernel entries.
+thread_local ull sampleState = 0x9e3779b97f4a7c15ULL;
+
+PerfThreadGroup &localPerfGroup() {
+  if (!threadGroup.attempted)
+    threadGroup.open();
+  return threadGroup;
+}
+
+bool kernelEntrySampled() {
+  sampleState ^= sampleState << 13;
+  sampleState ^= sampleState >> 7;
+  sampleState ^= sampleState << 17;
+  return sampleState % PERF_KERNEL_SAMPLE_PERIOD == 0;
+}
+
+std::array<std::atomic<bool>, PERF_EVENT_COUNT> availableEvents{};
+
+struct PerfRegionList {
+  std::mutex mutex;
+  std::vector<std::string> names;
+};
+
+PerfRegionList &perfRegionList() {
+  static PerfRegionList *list = new PerfRegionList;
+  return *list;
+}
+
+} // namespace
+
+const char *perfEventName(PerfEvent event) {
+  return PERF_EVENT_SPECS[static_cast<size_t>(event)].name;
+}
+
+bool enablePerfCounters(std::string *reason) {
+  const PerfThreadGroup &group = localPerfGroup();
+  std::string missing;
+  for (size_t e = 0; e < PERF_EVENT_COUNT; ++e) {
+    availableEvents[e].store(group.slot[e] >= 0, std::memory_order_relaxed);
+    if (group.slot[e] < 0)
+      missing += std::string(missing.empty() ? "" : ", ") +
+                 PERF_EVENT_SPECS[e].name;
+  }
+  if (reason != nullptr)
+    *reason = missing.empty() ? std::string()
+                              : missing + " unavailable: " +
+                                    std::strerror(group.firstError);
+  if (group.leader == -1)
+    return false;
+  perf_counters_detail::enabled.store(true, std::memory_order_relaxed);
+  return true;
+}
+
+void disablePerfCounters() {
+  perf_counters_detail::enabled.store(false, std::memory_order_relaxed);
+}
+
+bool perfEventAvailable(PerfEvent event) {
+  return availableEvents[static_cast<size_t>(event)].load(
+      std::memory_order_relaxed);
+}
+
+PerfRegion::PerfRegion(const std::string &name, bool isKernel)
+    : entriesId(registerCounter("perf." + name + ".entries", false)),
+      samplesId(registerCounter("perf." + name + ".samples", false)),
+      kernel(isKernel) {
+  for (size_t e = 0; e < PERF_EVENT_COUNT; ++e)
+    eventIds[e] =
+        registerCounter("perf." + name + "." + PERF_EVENT_SPECS[e].name, false);
+  PerfRegionList &list = perfRegionList();
+  std::lock_guard<std::mutex> lock(list.mutex);
+  if (std::find(list.names.begin(), list.names.end(), name) ==
+      list.names.end())
+    list.names.push_back(name);
+}
+
+void ScopedPerfRegion::begin(const PerfRegion &measured) {
+  ++localCounterShard().values[measured.entriesId];
+  if (measured.kernel && !kernelEntrySampled())
+    return;
+  if (localPerfGroup().read(start))
+    region = &measured;
+}
+
+void ScopedPerfRegion::finish() {
+  std::array<ull, PERF_EVENT_COUNT> end{};
+  const bool read = localPerfGroup().read(end);
+  CounterShard &shard = localCounterShard();
+  if (read) {
+    for (size_t e = 0; e < PERF_EVENT_COUNT; ++e)
+      shard.values[region->eventIds[e]] += end[e] - start[e];
+    ++shard.values[region->samplesId];
+  }
+  region = nullptr;
+}
+
+std::vector<PerfRegionTotals> collectPerfRegions() {
+  std::unordered_map<std::string, ull> totals;
+  for (const CounterTotal &total : collectCounters())
+    totals.emplace(total.name, total.value);
+  auto total = [&](const std::string &name) {
+    const auto found = totals.find(name);
+    return found == totals.end() ? 0 : found->second;
+  };
+
+  std::vector<std::string> names;
+  {
+    PerfRegionList &list = perfRegionList();
+    std::lock_guard<std::mutex> lock(list.mutex);
+    names = list.names;
+  }
+  std::vector<PerfRegionTotals> regions;
+  for (const std::string &name : names) {
+    PerfRegionTotals region{name, total("perf." + name + ".entries"),
+                            total("perf." + name + ".samples"), {}};
+    if (region.entries == 0)
+      continue;
+    for (size_t e = 0; e < PERF_EVENT_COUNT; ++e)
+      region.values[e] =
+          total("perf." + name + "." + PERF_EVENT_SPECS[e].name);
+    regions.push_back(std::move(region));
+  }
+  return regions;
+}
+
+void printPerfRegions(std::ostream &out) {
+  auto event = [&](PerfEvent which, const PerfRegionTotals &region) {
+    if (perfEventAvailable(which))
+      out << region.values[static_cast<size_t>(which)];
+    else
+      out << "n/a";
+  };
+  for (const PerfRegionTotals &region : collectPerfRegions()) {
+    const double taskClockMs =
+        static_cast<double>(
+            region.values[static_cast<size_t>(PerfEvent::TASK_CLOCK)]) /
+        1e6;
+    const ull cycles = region.values[static_cast<size_t>(PerfEvent::CYCLES)];
+    const ull instructions =
+        region.values[static_cast<size_t>(PerfEvent::INSTRUCTIONS)];
+    out << "PerfCounters: region=" << region.name
+        << "  entries=" << region.entries << "  samples=" << region.samples
+        << "  taskClock=";
+    if (perfEventAvailable(PerfEvent::TASK_CLOCK))
+      out << std::fixed << std::setprecision(3) << taskClockMs << " ms";
+    else
+      out << "n/a";
+    out << "  cycles=";
+    event(PerfEvent::CYCLES, region);
+    out << "  instructions=";
+    event(PerfEvent::INSTRUCTIONS, region);
+    out << "  ipc=";
+    if (cycles != 0)
+      out << std::fixed << std::setprecision(3)
+          << static_cast<double>(instructions) / static_cast<double>(cycles);
+    else
+      out << "n/a";
+    out << "  cyclesPerSample=";
+    if (cycles != 0 && region.samples != 0)
+      out << cycles / region.samples;
+    else
+      out << "n/a";
+    out << "  llcMisses=";
+    event(PerfEvent::LLC_MISSES, region);
+    out << "  branchMisses=";
+    event(PerfEvent::BRANCH_MISSES, region);
+    out << '\n';
+  }
+  out.flush();
+}
@@ -1,8 +1,8 @@
 #include "../inc/rmce_reduction.h"
+#include "../inc/parallel_for.h"
+#include "../inc/triangle_support.h"
 
 #include <limits>
-#include <queue>
-#include <set>
 #include <stdexcept>
 
 namespace {
@@ -13,6 +13,115 @@ void incrementOrThrow(ull &value, const char *what) {
   ++value;
 }
 
+// The input graph as a mutable CSR. Rows are sorted and duplicate-free;
+// deleting an edge tombstones it by id, so both directions see the change,
+// and support[e] tracks the live triangles on edge e.
+class MutableCsr {
+public:
+  vector<ui> offset;
+  vector<ui> neighbors;
+  vector<ui> slotEdge;
+  vector<ui> liveDegree;
+  vector<ui> support;
+  vector<unsigned char> edgeAlive;
+
+  explicit MutableCsr(const Graph &graph) {
+    const ui n = graph.n;
+    offset.assign(n + 1, 0);
+    neighbors.reserve(graph.neighbors.size());
+    for (ui v = 0; v < n; ++v) {
+      const size_t rowStart = neighbors.size();
+      for (ui at = graph.offset[v]; at < graph.offset[v + 1]; ++at) {
+        if (graph.neighbors[at] != v)
+          neighbors.push_back(graph.neighbors[at]);
+      }
+      if (!graph.adjacencySorted)
+        sort(neighbors.begin() + rowStart, neighbors.end());
+      neighbors.erase(unique(neighbors.begin() + rowStart, neighbors.end()),
+                      neighbors.end());
+      offset[v + 1] = static_cast<ui>(neighbors.size());
+    }
+    liveDegree.resize(n);
+    for (ui v = 0; v < n; ++v)
+      liveDegree[v] = offset[v + 1] - offset[v];
+
+    const ui edges = numberCsrEdges(offset, neighbors, slotEdge);
+    edgeAlive.assign(edges, 1);
+    support.assign(edges, 0);
+  }
+
+  ui edgeId(ui u, ui v) const {
+    const auto first = neighbors.begin() + offset[u];
+    const auto last = neighbors.begin() + offset[u + 1];
+    const auto at = lower_bound(first, last, v);
+    if (at == last || *at != v)
+      return UINT_MAX;
+    const ui id = slotEdge[at - neighbors.begin()];
+    return edgeAlive[id] != 0 ? id : UINT_MAX;
+  }
+
+  void liveNeighbors(ui u, vector<ui> &out) const {
+    out.clear();
+    for (ui at = offset[u]; at < offset[u + 1]; ++at) {
+      if (edgeAlive[slotEdge[at]] != 0)
+        out.push_back(neighbors[at]);
+    }
+  }
+
+  // Exact per-edge triangle counts along (degree, id)-oriented edges.
+  void countTriangles(unsigned threads) {
+    countEdgeTriangles(
+        offset, neighbors, slotEdge,
+        [&](ui a, ui b) {
+          return liveDegree[a] < liveDegree[b] ||
+                 (liveDegree[a] == liveDegree[b] && a < b);
+        },
+        support, threads);
+  }
+
+  // Deletes edge {a, b} and the triangles on it, scanning the shorter row.
+  void removeEdge(ui a, ui b) {
+    const ui id = edgeId(a, b);
+    if (id == UINT_MAX)
+      return;
+    edgeAlive[id] = 0;
+    --liveDegree[a];
+    --liveDegree[b];
+    if (support[id] == 0)
+      return;
+    support[id] = 0;
+    if (offset[a + 1] - offset[a] > offset[b + 1] - offset[b])
+      swap(a, b);
+    for (ui at = offset[a]; at < offset[a + 1]; ++at) {
+      const ui ac = slotEdge[at];
+      if (edgeAlive[ac] == 0)
+        continue;
+      const ui bc = edgeId(b, neighbors[at]);
+      if (bc == UINT_MAX)
+        continue;
+      --support[ac];
+      --support[bc];
+    }
+  }
+};
+
+struct DirectCliqueKey {
+  ui members[3];
+  bool operator==(const DirectCliqueKey &other) const {
+    return members[0] == other.members[0] && members[1] == other.members[1] &&
+           members[2] == other.members[2];
+  }
+};
+
+struct DirectCliqueKeyHash {
+  size_t operator()(const DirectCliqueKey &key) const {
+    ull hash = key.members[0];
+    hash = hash * 0x9e3779b97f4a7c15ULL + key.members[1];
+    hash = hash * 0x9e3779b97f4a7c15ULL + key.members[2];
+    return static_cast<size_t>(hash ^ (hash >> 29));
+  }
+};
+
 } // namespace
 
 RmceReductionResult applyRmceReduction(const Graph &graph, ui minCliqueSize,
@@ -20,98 +129,78 @@ RmceReductionResult applyRmceReduction(const Graph &graph, ui minCliqueSize,
   const ui n = graph.n;
   minCliqueSize = max<ui>(1, minCliqueSize);
 
-  vector<set<ui>> adjacency(n);
-  vector<ui> originalDegree(n, 0);
+  MutableCsr csr(graph);
   vector<unsigned char> active(n, 1);
-  for (ui v = 0; v < n; ++v) {
-    adjacency[v].insert(graph.neighbors.begin() + graph.offset[v],
-                        graph.neighbors.begin() + graph.offset[v + 1]);
-    adjacency[v].erase(v);
-    originalDegree[v] = static_cast<ui>(adjacency[v].size());
-  }
+  vector<ui> originalDegree(csr.liveDegree);
+  csr.countTriangles(configuredThreadCount());
 
   RmceReductionResult result;
-  set<vector<ui>> emitted;
-  auto emit = [&](vector<ui> clique) {
-    sort(clique.begin(), clique.end());
-    if (clique.size() < minCliqueSize) {
+  unordered_set<DirectCliqueKey, DirectCliqueKeyHash> emitted;
+  // Direct outputs have at most three vertices; absent slots hold UINT_MAX.
+  auto emit = [&](ui a, ui b = UINT_MAX, ui c = UINT_MAX) {
+    DirectCliqueKey key{{a, b, c}};
+    sort(key.members, key.members + 3);
+    const size_t size = 1 + (b != UINT_MAX) + (c != UINT_MAX);
+    if (size < minCliqueSize) {
       incrementOrThrow(result.counters.discardedUnderThreshold,
                        "RMCE under-threshold counter exceeds uint64_t");
       return;
     }
     if (collectCliqueIdentities) {
-      if (!emitted.insert(clique).second) {
+      if (!emitted.insert(key).second) {
         incrementOrThrow(result.counters.duplicateDirectOutputs,
                          "RMCE duplicate counter exceeds uint64_t");
         return;
       }
-      result.directlyEmittedCliques.push_back(clique);
+      result.directlyEmittedCliques.emplace_back(key.members,
+                                                 key.members + size);
     }
     incrementOrThrow(result.directlyEmittedCount,
                      "RMCE direct output count exceeds uint64_t");
     incrementOrThrow(result.counters.directlyEmitted,
                      "RMCE direct output counter exceeds uint64_t");
-    result.maximumCliqueSize = max(result.maximumCliqueSize, clique.size());
+    result.maximumCliqueSize = max(result.maximumCliqueSize, size);
+    addCliqueSizeCountOrThrow(result.directlyEmittedHistogram, size, 1);
   };
 
-  queue<ui> lowDegree;
+  // FIFO over a flat buffer; the order fixes which rule each vertex meets,
+  // so the peel stays sequential and deterministic.
+  vector<ui> lowDegree;
+  size_t lowDegreeHead = 0;
   vector<unsigned char> queued(n, 0);
   auto enqueueIfLow = [&](ui v) {
-    if (v < n && active[v] != 0 && adjacency[v].size() <= 2 &&
-        queued[v] == 0) {
+    if (v < n && active[v] != 0 && csr.liveDegree[v] <= 2 && queued[v] == 0) {
       queued[v] = 1;
-      lowDegree.push(v);
+      lowDegree.push_back(v);
     }
   };
   for (ui v = 0; v < n; ++v)
     enqueueIfLow(v);
 
   auto removeEdge = [&](ui u, ui v) {
-    adjacency[u].erase(v);
-    adjacency[v].erase(u);
+    csr.removeEdge(u, v);
     enqueueIfLow(u);
     enqueueIfLow(v);
   };
 
-  auto commonNeighborCount = [&](ui u, ui v) {
-    const set<ui> &a = adjacency[u];
-    const set<ui> &b = adjacency[v];
-    auto i = a.begin();
-    auto j = b.begin();
-    ui count = 0;
-    while (i != a.end() && j != b.end()) {
-      if (*i < *j) {
-        ++i;
-      } else if (*j < *i) {
-        ++j;
-      } else {
-        if (active[*i] != 0)
-          ++count;
-        ++i;
-        ++j;
-      }
-    }
-    return count;
-  };
-
+  vector<ui> neighbors;
   auto processLowDegree = [&]() {
     bool changed = false;
-    while (!lowDegree.empty()) {
-      const ui u = lowDegree.front();
-      lowDegree.pop();
+    while (lowDegreeHead < lowDegree.size()) {
+      const ui u = lowDegree[lowDegreeHead++];
       queued[u] = 0;
-      if (active[u] == 0 || adjacency[u].size() > 2)
+      if (active[u] == 0 || csr.liveDegree[u] > 2)
         continue;
 
       changed = true;
-      const vector<ui> neighbors(adjacency[u].begin(), adjacency[u].end());
+      csr.liveNeighbors(u, neighbors);
       if (neighbors.empty()) {
         incrementOrThrow(result.counters.degree0Vertices,
                          "RMCE degree-zero counter exceeds uint64_t");
         // Vertices isolated by earlier reductions are silent because their
         // incident maximal cliques have already been emitted.
         if (originalDegree[u] == 0)
-          emit({u});
+          emit(u);
         active[u] = 0;
         continue;
       }
@@ -120,10 +209,9 @@ RmceReductionResult applyRmceReduction(const Graph &graph, ui minCliqueSize,
         incrementOrThrow(result.counters.degree1Vertices,
                          "RMCE degree-one counter exceeds uint64_t");
         const ui v = neighbors[0];
-        emit({u, v});
+        emit(u, v);
         removeEdge(u, v);
         active[u] = 0;
-        adjacency[u].clear();
         enqueueIfLow(v);
         continue;
       }
@@ -132,43 +220,46 @@ RmceReductionResult applyRmceReduction(const Graph &graph, ui minCliqueSize,
                        "RMCE degree-two counter exceeds uint64_t");
       const ui v = neighbors[0];
       const ui w = neighbors[1];
-      const bool vwEdge = adjacency[v].find(w) != adjacency[v].end();
-      if (!vwEdge) {
-        emit({u, v});
-        emit({u, w});
+      const ui vw = csr.edgeId(v, w);
+      if (vw == UINT_MAX) {
+        emit(u, v);
+        emit(u, w);
       } else {
-        emit({u, v, w});
-        if (commonNeighborCount(v, w) == 1)
+        emit(u, v, w);
+        // u is the only common neighbor left, so {v, w} is in no other
+        // maximal clique.
+        if (csr.support[vw] == 1)
           removeEdge(v, w);
       }
       removeEdge(u, v);
       removeEdge(u, w);
       active[u] = 0;
-      adjacency[u].clear();
       enqueueIfLow(v);
       enqueueIfLow(w);
     }
+    if (lowDegreeHead == lowDegree.size()) {
+      lowDegree.clear();
+      lowDegreeHead = 0;
+    }
     return changed;
   };
 
   // Removing a non-triangle edge can expose another low-degree vertex, so
   // alternate both global RMCE phases until neither changes the graph.
+  // Supports are maintained under deletion, and deleting a support-0 edge
+  // breaks no triangle, so one sweep finds every non-triangle edge.
   while (true) {
     bool changed = processLowDegree();
-    vector<pair<ui, ui>> edges;
     for (ui u = 0; u < n; ++u) {
-      if (active[u] == 0)
-        continue;
-      for (ui v : adjacency[u])
-        if (u < v && active[v] != 0)
-          edges.emplace_back(u, v);
-    }
-    for (const auto &[u, v] : edges) {
-      if (active[u] == 0 || active[v] == 0 ||
-          adjacency[u].find(v) == adjacency[u].end())
+      if (active[u] == 0 || csr.liveDegree[u] == 0)
         continue;
-      if (commonNeighborCount(u, v) == 0) {
-        emit({u, v});
+      for (ui at = csr.offset[u]; at < csr.offset[u + 1]; ++at) {
+        const ui v = csr.neighbors[at];
+        const ui id = csr.slotEdge[at];
+        if (v <= u || active[v] == 0 || csr.edgeAlive[id] == 0 ||
+            csr.support[id] != 0)
+          continue;
+        emit(u, v);
         incrementOrThrow(result.counters.nontriangleEdges,
                          "RMCE non-triangle counter exceeds uint64_t");
         removeEdge(u, v);
@@ -181,24 +272,30 @@ RmceReductionResult applyRmceReduction(const Graph &graph, ui minCliqueSize,
 
   vector<ui> oldToNew(n, UINT_MAX);
   for (ui old = 0; old < n; ++old) {
-    if (active[old] != 0 && !adjacency[old].empty()) {
+    if (active[old] != 0 && csr.liveDegree[old] != 0) {
       oldToNew[old] = static_cast<ui>(result.residualToOriginal.size());
       result.residualToOriginal.push_back(old);
     }
   }
 
-  vector<pair<ui, ui>> residualEdges;
-  for (ui oldU = 0; oldU < n; ++oldU) {
-    const ui u = oldToNew[oldU];
-    if (u == UINT_MAX)
-      continue;
-    for (ui oldV : adjacency[oldU]) {
-      const ui v = oldToNew[oldV];
-      if (v != UINT_MAX && u < v)
-        residualEdges.emplace_back(u, v);
+  // Renaming is monotone, so the residual rows come out sorted.
+  Graph &residual = result.graph;
+  residual.n = static_cast<ui>(result.residualToOriginal.size());
+  residual.offset.assign(residual.n + 1, 0);
+  residual.degree.assign(residual.n, 0);
+  for (ui u = 0; u < residual.n; ++u) {
+    const ui old = result.residualToOriginal[u];
+    for (ui at = csr.offset[old]; at < csr.offset[old + 1]; ++at) {
+      if (csr.edgeAlive[csr.slotEdge[at]] == 0)
+        continue;
+      const ui v = oldToNew[csr.neighbors[at]];
+      if (v != UINT_MAX)
+        residual.neighbors.push_back(v);
     }
+    residual.offset[u + 1] = static_cast<ui>(residual.neighbors.size());
+    residual.degree[u] = residual.offset[u + 1] - residual.offset[u];
   }
-  result.graph =
-      Graph(static_cast<ui>(result.residualToOriginal.size()), residualEdges);
+  residual.m = static_cast<ui>(residual.neighbors.size() / 2);
+  residual.adjacencySorted = true;
   return result;
 }
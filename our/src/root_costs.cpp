@@ -0,0 +1,141 @@
+#include "../inc/root_costs.h"
+
+#include <iomanip>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+
+const char *const ROOT_COSTS_HEADER = "# bk root costs n=";
+
+} // namespace
+
+std::vector<ui> costSortedRoots(const std::vector<RootCost> &costs) {
+  std::vector<ui> roots;
+  for (ui root = 0; root < costs.size(); ++root) {
+    const RootCost &cost = costs[root];
+    if (cost.ns != 0 || cost.checks != 0 || cost.cliques != 0)
+      roots.push_back(root);
+  }
+  std::sort(roots.begin(), roots.end(), [&](ui a, ui b) {
+    if (costs[a].ns != costs[b].ns)
+      return costs[a].ns > costs[b].ns;
+    if (costs[a].checks != costs[b].checks)
+      return costs[a].checks > costs[b].checks;
+    return a < b;
+  });
+  return roots;
+}
+
+void printRootCostReport(std::ostream &out, const std::vector<RootCost> &costs,
+                         size_t topN) {
+  const std::vector<ui> roots = costSortedRoots(costs);
+  ull totalNs = 0;
+  ull totalChecks = 0;
+  ull totalCliques = 0;
+  for (ui root : roots) {
+    totalNs += costs[root].ns;
+    totalChecks += costs[root].checks;
+    totalCliques += costs[root].cliques;
+  }
+
+  // Heaviest roots needed to reach each fraction of the total time.
+  const double fractions[] = {0.5, 0.9, 0.99};
+  size_t covering[3] = {0, 0, 0};
+  ull cumulative = 0;
+  size_t next = 0;
+  for (size_t i = 0; i < roots.size() && next < 3; ++i) {
+    cumulative += costs[roots[i]].ns;
+    while (next < 3 && static_cast<double>(cumulative) >=
+                           fractions[next] * static_cast<double>(totalNs)) {
+      covering[next] = i + 1;
+      ++next;
+    }
+  }
+  auto share = [&](size_t count) {
+    ull ns = 0;
+    for (size_t i = 0; i < count && i < roots.size(); ++i)
+      ns += costs[roots[i]].ns;
+    return totalNs == 0 ? 0.0
+                        : 100.0 * static_cast<double>(ns) /
+                              static_cast<double>(totalNs);
+  };
+  const size_t onePercent = std::max<size_t>(1, roots.size() / 100);
+  const size_t tenPercent = std::max<size_t>(1, roots.size() / 10);
+
+  out << std::fixed << std::setprecision(3) << "RootCosts: roots="
+      << roots.size() << "  checks=" << totalChecks
+      << "  cliques=" << totalCliques
+      << "  time=" << static_cast<double>(totalNs) / 1e6 << " ms"
+      << "  rootsFor50%=" << covering[0] << "  rootsFor90%=" << covering[1]
+      << "  rootsFor99%=" << covering[2] << std::setprecision(1)
+      << "  top1%Share=" << (roots.empty() ? 0.0 : share(onePercent)) << '%'
+      << "  top10%Share=" << (roots.empty() ? 0.0 : share(tenPercent))
+      << "%\n";
+  for (size_t i = 0; i < topN && i < roots.size(); ++i) {
+    const RootCost &cost = costs[roots[i]];
+    out << std::setprecision(3) << "RootCost: rank=" << i + 1
+        << "  root=" << roots[i] << "  checks=" << cost.checks
+        << "  cliques=" << cost.cliques
+        << "  time=" << static_cast<double>(cost.ns) / 1e6 << " ms"
+        << std::setprecision(1) << "  share="
+        << (totalNs == 0 ? 0.0
+                         : 100.0 * static_cast<double>(cost.ns) /
+                               static_cast<double>(totalNs))
+        << "%\n";
+  }
+  out.flush();
+}
+
+void writeRootCosts(const std::string &path,
+                    const std::vector<RootCost> &costs) {
+  std::ofstream out(path);
+  if (!out)
+    throw std::runtime_error("cannot write root costs " + path);
+  out << ROOT_COSTS_HEADER << costs.size() << '\n';
+  for (ui root : costSortedRoots(costs))
+    out << root << ' ' << costs[root].checks << ' ' << costs[root].cliques
+        << ' ' << costs[root].ns << '\n';
+  if (!out)
+    throw std::runtime_error("root costs write failed: " + path);
+}
+
+std::vector<ui> readRootOrder(const std::string &path, ui n) {
+  std::ifstream in(path);
+  if (!in)
+    throw std::runtime_error("cannot read root order " + path);
+  std::string line;
+  const std::string header = ROOT_COSTS_HEADER;
+  if (!std::getline(in, line) || line.compare(0, header.size(), header) != 0)
+    throw std::runtime_error(path + " is not a root cost dump");
+  if (line.substr(header.size()) != std::to_string(n))
+    throw std::runtime_error(path + " was recorded on a graph with " +
+                             line.substr(header.size()) + " vertices, not " +
+                             std::to_string(n));
+
+  std::vector<ui> order;
+  std::vector<char> listed(n, 0);
+  size_t lineNumber = 1;
+  while (std::getline(in, line)) {
+    ++lineNumber;
+    if (line.empty())
+      continue;
+    std::istringstream fields(line);
+    ull root = 0;
+    if (!(fields >> root) || root >= n)
+      throw std::runtime_error(path + ":" + std::to_string(lineNumber) +
+                               ": expected a root below " +
+                               std::to_string(n));
+    if (listed[root])
+      throw std::runtime_error(path + ":" + std::to_string(lineNumber) +
+                               ": root " + std::to_string(root) +
+                               " is listed twice");
+    listed[root] = 1;
+    order.push_back(static_cast<ui>(root));
+  }
+  for (ui v = 0; v < n; ++v) {
+    if (!listed[v])
+      order.push_back(v);
+  }
+  return order;
+}
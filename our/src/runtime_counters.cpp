@@ -0,0 +1,226 @@
+#include "../inc/runtime_counters.h"
+#include "../inc/json.h"
+
+#include <iomanip>
+#include <memory>
+#include <stdexcept>
+#include <unordered_map>
+
+namespace runtime_counters_detail {
+std::atomic<int> level(static_cast<int>(CounterLevel::OFF));
+} // namespace runtime_counters_detail
+
+namespace {
+
+struct CounterRegistry {
+  std::mutex mutex;
+  std::vector<std::string> names;
+  std::vector<bool> timers;
+  std::unordered_map<std::string, ui> ids;
+  std::vector<std::unique_ptr<CounterShard>> shards;
+  std::vector<CounterShard *> freeShards;
+};
+
+// Leaked on purpose: worker threads may return their shards while static
+// destructors run at exit.
+CounterRegistry &counterRegistry() {
+  static CounterRegistry *registry = new CounterRegistry;
+  return *registry;
+}
+
+struct ShardLease {
+  CounterShard *shard = nullptr;
+
+  ~ShardLease() {
+    if (shard == nullptr)
+      return;
+    CounterRegistry &registry = counterRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.freeShards.push_back(shard);
+  }
+};
+
+thread_local ShardLease shardLease;
+thread_local ScopedRuntimeTimer *currentScope = nullptr;
+
+} // namespace
+
+CounterLevel parseCounterLevel(const std::string &text) {
+  if (text == "off" || text == "0")
+    return CounterLevel::OFF;
+  if (text == "counters" || text == "1")
+    return CounterLevel::COUNTERS;
+  if (text == "timers" || text == "2")
+    return CounterLevel::TIMERS;
+  throw std::invalid_argument(
+      "counter level must be off, counters or timers: " + text);
+}
+
+const char *counterLevelName(CounterLevel level) {
+  switch (level) {
+  case CounterLevel::OFF:
+    return "off";
+  case CounterLevel::COUNTERS:
+    return "counters";
+  case CounterLevel::TIMERS:
+    return "timers";
+  }
+  return "off";
+}
+
+void setCounterLevel(CounterLevel level) {
+  runtime_counters_detail::level.store(static_cast<int>(level),
+                                       std::memory_order_relaxed);
+}
+
+CounterShard &localCounterShard() {
+  if (shardLease.shard != nullptr)
+    return *shardLease.shard;
+  CounterRegistry &registry = counterRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  if (!registry.freeShards.empty()) {
+    shardLease.shard = registry.freeShards.back();
+    registry.freeShards.pop_back();
+  } else {
+    registry.shards.push_back(std::make_unique<CounterShard>());
+    shardLease.shard = registry.shards.back().get();
+  }
+  return *shardLease.shard;
+}
+
+ui registerCounter(const std::string &name, bool timer) {
+  CounterRegistry &registry = counterRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  const auto found = registry.ids.find(name);
+  if (found != registry.ids.end()) {
+    if (registry.timers[found->second] != timer)
+      throw std::logic_error("counter registered as both counter and timer: " +
+                             name);
+    return found->second;
+  }
+  if (registry.names.size() >= RUNTIME_COUNTER_CAPACITY)
+    throw std::length_error("too many runtime counters registered");
+  const ui id = static_cast<ui>(registry.names.size());
+  registry.names.push_back(name);
+  registry.timers.push_back(timer);
+  registry.ids.emplace(name, id);
+  return id;
+}
+
+void RuntimeTimer::record(std::chrono::nanoseconds elapsed) const {
+  if (!timersEnabled())
+    return;
+  CounterShard &shard = localCounterShard();
+  shard.values[id] +=
+      static_cast<ull>(std::max<long long>(0, elapsed.count()));
+  ++shard.events[id];
+}
+
+void RuntimeTimer::recordMillis(double ms) const {
+  record(std::chrono::nanoseconds(static_cast<long long>(ms * 1e6)));
+}
+
+void ScopedRuntimeTimer::begin() {
+  shard = &localCounterShard();
+  parent = currentScope;
+  currentScope = this;
+  start = Clock::now();
+}
+
+void ScopedRuntimeTimer::finish() {
+  const Clock::duration elapsed = Clock::now() - start;
+  const Clock::duration self = elapsed - nested;
+  shard->values[id] += static_cast<ull>(std::max<long long>(
+      0, std::chrono::duration_cast<std::chrono::nanoseconds>(self).count()));
+  ++shard->events[id];
+  currentScope = parent;
+  if (parent != nullptr)
+    parent->nested += elapsed;
+}
+
+EngineRunCounters::EngineRunCounters(const std::string &engine)
+    : runs(engine + ".runs"), checks(engine + ".checks"),
+      cliques(engine + ".cliques"), search(engine + ".search") {}
+
+void EngineRunCounters::report(ull checksCount, ull cliqueCount,
+                               double ms) const {
+  if (!countersEnabled())
+    return;
+  CounterShard &shard = localCounterShard();
+  runs.add(shard, 1);
+  checks.add(shard, checksCount);
+  cliques.add(shard, cliqueCount);
+  search.recordMillis(ms);
+}
+
+std::vector<CounterTotal> collectCounters() {
+  CounterRegistry &registry = counterRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  std::vector<CounterTotal> totals;
+  for (size_t id = 0; id < registry.names.size(); ++id) {
+    CounterTotal total{registry.names[id], registry.timers[id], 0, 0};
+    for (const std::unique_ptr<CounterShard> &shard : registry.shards) {
+      total.value += shard->values[id];
+      total.events += shard->events[id];
+    }
+    if (total.value != 0 || total.events != 0)
+      totals.push_back(std::move(total));
+  }
+  return totals;
+}
+
+void resetCounters() {
+  CounterRegistry &registry = counterRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  for (const std::unique_ptr<CounterShard> &shard : registry.shards) {
+    shard->values.fill(0);
+    shard->events.fill(0);
+  }
+}
+
+void writeCounterTotals(JsonWriter &json,
+                        const std::vector<CounterTotal> &totals) {
+  json.key("counters").beginObject();
+  for (const CounterTotal &total : totals) {
+    if (!total.timer)
+      json.field(total.name, total.value);
+  }
+  json.endObject();
+  json.key("timers").beginObject();
+  for (const CounterTotal &total : totals) {
+    if (!total.timer)
+      continue;
+    json.key(total.name).beginObject();
+    json.field("ms", static_cast<double>(total.value) / 1e6);
+    json.field("calls", total.events);
+    json.endObject();
+  }
+  json.endObject();
+}
+
+void writeCountersJson(JsonWriter &json) {
+  const std::vector<CounterTotal> totals = collectCounters();
+  size_t threads = 0;
+  {
+    CounterRegistry &registry = counterRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    threads = registry.shards.size();
+  }
+  json.beginObject();
+  json.field("level", counterLevelName(counterLevel()));
+  json.field("threads", static_cast<ull>(threads));
+  writeCounterTotals(json, totals);
+  json.endObject();
+}
+
+void printCounters(std::ostream &out) {
+  for (const CounterTotal &total : collectCounters()) {
+    if (total.timer)
+      out << "timer " << total.name << ' ' << std::fixed
+          << std::setprecision(3) << static_cast<double>(total.value) / 1e6
+          << " ms calls=" << total.events << '\n';
+    else
+      out << "counter " << total.name << ' ' << total.value << '\n';
+  }
+  out.flush();
+}
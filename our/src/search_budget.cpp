@@ -0,0 +1,41 @@
+#include "../inc/search_budget.h"
+
+#include <limits>
+
+const char *searchBudgetStopName(SearchBudgetStop stop) {
+  switch (stop) {
+  case SearchBudgetStop::TIME:
+    return "time";
+  case SearchBudgetStop::CHECKS:
+    return "checks";
+  case SearchBudgetStop::CLIQUES:
+    return "cliques";
+  default:
+    return "none";
+  }
+}
+
+SearchBudget::SearchBudget(const SearchBudgetLimits &limits)
+    : checkLimit(limits.checks != 0 ? limits.checks
+                                    : std::numeric_limits<ull>::max()),
+      cliqueLimit(limits.cliques != 0 ? limits.cliques
+                                      : std::numeric_limits<ull>::max()),
+      timed(limits.wallMs > 0), stop(0) {
+  if (timed)
+    deadline = Clock::now() +
+               std::chrono::duration_cast<Clock::duration>(
+                   std::chrono::duration<double, std::milli>(limits.wallMs));
+}
+
+bool SearchBudget::expire(SearchBudgetStop reason) {
+  int none = 0;
+  stop.compare_exchange_strong(none, static_cast<int>(reason));
+  return true;
+}
+
+bool SearchBudget::clockExpired(ull checks, ull &nextClockCheck) {
+  nextClockCheck = checks + CLOCK_INTERVAL;
+  if (Clock::now() < deadline)
+    return false;
+  return expire(SearchBudgetStop::TIME);
+}
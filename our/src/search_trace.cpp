@@ -0,0 +1,178 @@
+#include "../inc/search_trace.h"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+constexpr char TRACE_MAGIC[8] = {'B', 'K', 'T', 'R', 'A', 'C', 'E', '1'};
+constexpr std::uint32_t TRACE_VERSION = 1;
+constexpr size_t TRACE_FLUSH_RECORDS = 4096;
+
+const char *const KERNEL_NAMES[SEARCH_TRACE_KERNEL_COUNT] = {
+    "branch", "leaf", "blocked", "x_universal", "p_clique", "matching",
+    "reduced", "low_degree", "tiny", "plex3", "universal_p", "local_bitset"};
+
+// splitmix64 finalizer: spreads consecutive vertex ids over the sample.
+ull mixRoot(ull value) {
+  value += 0x9e3779b97f4a7c15ULL;
+  value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+  return value ^ (value >> 31);
+}
+
+} // namespace
+
+const char *searchTraceKernelName(SearchTraceKernel kernel) {
+  const size_t index = static_cast<size_t>(kernel);
+  return index < SEARCH_TRACE_KERNEL_COUNT ? KERNEL_NAMES[index] : "unknown";
+}
+
+SearchTraceWriter::SearchTraceWriter(const std::string &tracePath,
+                                     SearchTraceOptions traceOptions)
+    : out(tracePath, std::ios::binary | std::ios::trunc), path(tracePath),
+      options(std::move(traceOptions)), origin(Clock::now()),
+      currentRoot(SEARCH_TRACE_NONE), nextNode(0), records(0),
+      tracedRoots(0), droppedNodes(0), closed(false) {
+  if (!out)
+    throw std::runtime_error("cannot write search trace " + path);
+  if (options.rootSamplePeriod == 0)
+    throw std::invalid_argument(
+        "search trace sample period must be positive");
+  std::sort(options.roots.begin(), options.roots.end());
+  buffer.reserve(TRACE_FLUSH_RECORDS);
+  writeHeader();
+}
+
+SearchTraceWriter::~SearchTraceWriter() {
+  try {
+    close();
+  } catch (const std::exception &error) {
+    cerr << "Search trace not completed: " << error.what() << endl;
+  }
+}
+
+void SearchTraceWriter::writeHeader() {
+  SearchTraceHeader header{};
+  std::memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+  header.version = TRACE_VERSION;
+  header.recordSize = sizeof(SearchTraceRecord);
+  header.rootSamplePeriod = options.rootSamplePeriod;
+  header.rootListSize = static_cast<std::uint32_t>(options.roots.size());
+  header.records = records;
+  header.tracedRoots = tracedRoots;
+  header.droppedNodes = droppedNodes;
+  out.write(reinterpret_cast<const char *>(&header), sizeof(header));
+}
+
+void SearchTraceWriter::flush() {
+  out.write(reinterpret_cast<const char *>(buffer.data()),
+            static_cast<std::streamsize>(buffer.size() *
+                                         sizeof(SearchTraceRecord)));
+  buffer.clear();
+  if (!out)
+    throw std::runtime_error("search trace write failed: " + path);
+}
+
+bool SearchTraceWriter::beginRoot(ui root) {
+  if (closed || records >= options.maxRecords)
+    return false;
+  const bool sampled =
+      options.roots.empty()
+          ? mixRoot(root) % options.rootSamplePeriod == 0
+          : std::binary_search(options.roots.begin(), options.roots.end(),
+                               root);
+  if (!sampled)
+    return false;
+  currentRoot = root;
+  nextNode = 0;
+  ++tracedRoots;
+  return true;
+}
+
+void SearchTraceWriter::endRoot() {
+  currentRoot = SEARCH_TRACE_NONE;
+  if (buffer.size() >= TRACE_FLUSH_RECORDS)
+    flush();
+}
+
+void SearchTraceWriter::close() {
+  if (closed)
+    return;
+  closed = true;
+  flush();
+  out.seekp(0);
+  writeHeader();
+  out.close();
+  if (!out)
+    throw std::runtime_error("search trace write failed: " + path);
+}
+
+void SearchTraceScope::begin(ui depth, size_t p, size_t x,
+                             SearchTraceLane lane) {
+  // Ordinals are assigned on entry, so once the cap is reached every later
+  // node is dropped and no recorded node refers to a missing parent.
+  if (writer->records + writer->open.size() >= writer->options.maxRecords) {
+    ++writer->droppedNodes;
+    writer = nullptr;
+    return;
+  }
+  record = SearchTraceRecord{};
+  record.root = writer->currentRoot;
+  record.node = writer->nextNode++;
+  record.parent = SEARCH_TRACE_NONE;
+  if (!writer->open.empty()) {
+    SearchTraceRecord &parent = writer->open.back()->record;
+    record.parent = parent.node;
+    ++parent.children;
+  }
+  record.depth = static_cast<std::uint16_t>(std::min<ui>(depth, 65535));
+  record.p = static_cast<std::uint32_t>(p);
+  record.x = static_cast<std::uint32_t>(x);
+  record.pivotScore = SEARCH_TRACE_NONE;
+  record.kernel = SearchTraceKernel::BRANCH;
+  record.lane = lane;
+  record.checks = *checks;
+  record.cliques = *cliques;
+  writer->open.push_back(this);
+  record.startNs = static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          SearchTraceWriter::Clock::now() - writer->origin)
+          .count());
+}
+
+void SearchTraceScope::finish() {
+  const std::uint64_t endNs = static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+          SearchTraceWriter::Clock::now() - writer->origin)
+          .count());
+  record.durationNs = endNs - record.startNs;
+  record.checks = *checks - record.checks;
+  record.cliques = *cliques - record.cliques;
+  writer->open.pop_back();
+  writer->buffer.push_back(record);
+  ++writer->records;
+}
+
+SearchTrace readSearchTrace(const std::string &path) {
+  std::ifstream in(path, std::ios::binary);
+  if (!in)
+    throw std::runtime_error("cannot read search trace " + path);
+  SearchTrace trace{};
+  if (!in.read(reinterpret_cast<char *>(&trace.header),
+               sizeof(trace.header)) ||
+      std::memcmp(trace.header.magic, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0)
+    throw std::runtime_error(path + " is not a search trace");
+  if (trace.header.version != TRACE_VERSION ||
+      trace.header.recordSize != sizeof(SearchTraceRecord))
+    throw std::runtime_error(path + " has unsupported trace version " +
+                             std::to_string(trace.header.version));
+  trace.records.resize(trace.header.records);
+  const std::streamsize bytes = static_cast<std::streamsize>(
+      trace.records.size() * sizeof(SearchTraceRecord));
+  if (!in.read(reinterpret_cast<char *>(trace.records.data()), bytes))
+    throw std::runtime_error(path + " is truncated");
+  if (in.peek() != std::ifstream::traits_type::eof())
+    throw std::runtime_error(path + " has trailing bytes");
+  return trace;
+}
@@ -0,0 +1,74 @@
+#include "../inc/triangle_support.h"
+#include "../inc/parallel_for.h"
+
+ui numberCsrEdges(const vector<ui> &offset, const vector<ui> &neighbors,
+                  vector<ui> &slotEdge, vector<pair<ui, ui>> *edges) {
+  const ui n = static_cast<ui>(offset.size() - 1);
+  // Row v lists its smaller neighbors first, in increasing order, which is
+  // the order in which the u < v pass reaches them.
+  slotEdge.assign(neighbors.size(), UINT_MAX);
+  vector<ui> cursor(offset.begin(), offset.end() - 1);
+  ui count = 0;
+  for (ui u = 0; u < n; ++u) {
+    for (ui at = offset[u]; at < offset[u + 1]; ++at) {
+      const ui v = neighbors[at];
+      if (u < v) {
+        slotEdge[at] = count;
+        slotEdge[cursor[v]++] = count;
+        if (edges != nullptr)
+          edges->emplace_back(u, v);
+        ++count;
+      }
+    }
+  }
+  return count;
+}
+
+void countEdgeTriangles(const vector<ui> &offset, const vector<ui> &neighbors,
+                        const vector<ui> &slotEdge,
+                        const std::function<bool(ui, ui)> &ranksBelow,
+                        vector<ui> &support, unsigned threads) {
+  const ui n = static_cast<ui>(offset.size() - 1);
+  vector<ui> outOffset(n + 1, 0);
+  vector<ui> outNeighbor;
+  vector<ui> outEdge;
+  outNeighbor.reserve(support.size());
+  outEdge.reserve(support.size());
+  for (ui u = 0; u < n; ++u) {
+    for (ui at = offset[u]; at < offset[u + 1]; ++at) {
+      const ui v = neighbors[at];
+      if (ranksBelow(u, v)) {
+        outNeighbor.push_back(v);
+        outEdge.push_back(slotEdge[at]);
+      }
+    }
+    outOffset[u + 1] = static_cast<ui>(outNeighbor.size());
+  }
+
+  if (threads == 0)
+    threads = 1;
+  vector<vector<ui>> markByWorker(threads);
+  parallelFor(n, threads, 256, [&](unsigned worker, size_t index) {
+    const ui u = static_cast<ui>(index);
+    if (outOffset[u] == outOffset[u + 1])
+      return;
+    vector<ui> &mark = markByWorker[worker];
+    if (mark.empty())
+      mark.assign(n, UINT_MAX);
+    for (ui at = outOffset[u]; at < outOffset[u + 1]; ++at)
+      mark[outNeighbor[at]] = outEdge[at];
+    for (ui at = outOffset[u]; at < outOffset[u + 1]; ++at) {
+      const ui v = outNeighbor[at];
+      for (ui bt = outOffset[v]; bt < outOffset[v + 1]; ++bt) {
+        const ui uw = mark[outNeighbor[bt]];
+        if (uw == UINT_MAX)
+          continue;
+        __atomic_fetch_add(&support[outEdge[at]], 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&support[uw], 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&support[outEdge[bt]], 1, __ATOMIC_RELAXED);
+      }
+    }
+    for (ui at = outOffset[u]; at < outOffset[u + 1]; ++at)
+      mark[outNeighbor[at]] = UINT_MAX;
+  });
+}
@@ -0,0 +1,173 @@
+#include "../inc/truss_decomposition.h"
+#include "../inc/parallel_for.h"
+#include "../inc/triangle_support.h"
+
+#include <stdexcept>
+
+ui TrussDecomposition::edgeId(const Graph &graph, ui u, ui v) const {
+  if (graph.degree[u] > graph.degree[v])
+    std::swap(u, v);
+  const auto first = graph.neighbors.begin() + graph.offset[u];
+  const auto last = graph.neighbors.begin() + graph.offset[u + 1];
+  const auto at = lower_bound(first, last, v);
+  if (at == last || *at != v)
+    return UINT_MAX;
+  return slotEdge[at - graph.neighbors.begin()];
+}
+
+TrussDecomposition computeTrussDecomposition(const Graph &graph) {
+  if (!graph.adjacencySorted)
+    throw invalid_argument("truss decomposition needs sorted adjacency rows");
+
+  const ui n = graph.n;
+  const unsigned threads = max(1u, configuredThreadCount());
+  TrussDecomposition truss;
+
+  const ui edgeCount = numberCsrEdges(graph.offset, graph.neighbors,
+                                      truss.slotEdge, &truss.edges);
+  vector<ui> support(edgeCount, 0);
+  countEdgeTriangles(
+      graph.offset, graph.neighbors, truss.slotEdge,
+      [&](ui a, ui b) {
+        return graph.degree[a] < graph.degree[b] ||
+               (graph.degree[a] == graph.degree[b] && a < b);
+      },
+      support, threads);
+
+  // Frontier-parallel peel (PKT). Level k jumps to the least live support;
+  // its frontier is every live edge at k and is peeled in rounds. A round
+  // destroys each live triangle on a frontier edge once: both other edges
+  // lose it when neither is in the frontier, and when one is, the smaller
+  // frontier id charges the remaining edge. Supports never drop below k, so
+  // an edge joins the next round exactly when it falls from k + 1 to k.
+  // Every round is sorted by id, which keeps the order independent of the
+  // thread count. Live edges wait in buckets by support: an edge lowered
+  // but still above k is rebucketed when the level ends, and stale entries
+  // are skipped, so finding each level costs the entries it holds rather
+  // than a scan of every live edge.
+  constexpr unsigned char LIVE = 0, FRONTIER = 1, PEELED = 2;
+  vector<unsigned char> state(edgeCount, LIVE);
+  ui maxSupport = 0;
+  for (ui e = 0; e < edgeCount; ++e)
+    maxSupport = max(maxSupport, support[e]);
+  vector<vector<ui>> bucket(static_cast<size_t>(maxSupport) + 1);
+  vector<ui> bucketedAt(edgeCount);
+  for (ui e = 0; e < edgeCount; ++e) {
+    bucket[support[e]].push_back(e);
+    bucketedAt[e] = support[e];
+  }
+  vector<ui> frontier;
+  vector<vector<ui>> nextByWorker(threads);
+  vector<vector<ui>> loweredByWorker(threads);
+  vector<vector<ui>> markByWorker(threads);
+  truss.trussNumber.assign(edgeCount, 0);
+  truss.order.reserve(edgeCount);
+
+  auto lower = [&](ui f, ui level, unsigned worker) {
+    if (__atomic_load_n(&support[f], __ATOMIC_RELAXED) <= level)
+      return;
+    const ui before = __atomic_fetch_sub(&support[f], 1, __ATOMIC_RELAXED);
+    if (before == level + 1)
+      nextByWorker[worker].push_back(f);
+    else if (before <= level)
+      __atomic_fetch_add(&support[f], 1, __ATOMIC_RELAXED);
+    else
+      loweredByWorker[worker].push_back(f);
+  };
+
+  for (ui level = 0; level <= maxSupport; ++level) {
+    frontier.clear();
+    // An entry is stale once its edge was rebucketed lower, and every such
+    // edge has been peeled by the time its old bucket comes up.
+    for (ui e : bucket[level]) {
+      if (state[e] == LIVE)
+        frontier.push_back(e);
+    }
+    vector<ui>().swap(bucket[level]);
+    if (frontier.empty())
+      continue;
+
+    while (!frontier.empty()) {
+      sort(frontier.begin(), frontier.end());
+      for (ui e : frontier)
+        state[e] = FRONTIER;
+      parallelFor(frontier.size(), threads, 64,
+                  [&](unsigned worker, size_t index) {
+        const ui e = frontier[index];
+        ui a = truss.edges[e].first;
+        ui b = truss.edges[e].second;
+        if (graph.degree[a] > graph.degree[b])
+          swap(a, b);
+        // Triangles of e: the shorter row against b's row, through a marked
+        // row when b is not much longer, otherwise by binary search.
+        const bool marked = graph.degree[b] <= 8 * graph.degree[a];
+        vector<ui> &mark = markByWorker[worker];
+        if (marked) {
+          if (mark.empty())
+            mark.assign(n, UINT_MAX);
+          for (ui at = graph.offset[b]; at < graph.offset[b + 1]; ++at)
+            mark[graph.neighbors[at]] = truss.slotEdge[at];
+        }
+        const auto rowB = graph.neighbors.begin() + graph.offset[b];
+        const auto endB = graph.neighbors.begin() + graph.offset[b + 1];
+        for (ui at = graph.offset[a]; at < graph.offset[a + 1]; ++at) {
+          const ui w = graph.neighbors[at];
+          const ui f = truss.slotEdge[at];
+          if (w == b || state[f] == PEELED)
+            continue;
+          ui g = UINT_MAX;
+          if (marked) {
+            g = mark[w];
+          } else {
+            const auto hit = lower_bound(rowB, endB, w);
+            if (hit != endB && *hit == w)
+              g = truss.slotEdge[hit - graph.neighbors.begin()];
+          }
+          if (g == UINT_MAX || state[g] == PEELED)
+            continue;
+          if (state[f] == LIVE && state[g] == LIVE) {
+            lower(f, level, worker);
+            lower(g, level, worker);
+          } else if (state[f] == LIVE) {
+            if (e < g)
+              lower(f, level, worker);
+          } else if (state[g] == LIVE) {
+            if (e < f)
+              lower(g, level, worker);
+          }
+        }
+        if (marked) {
+          for (ui at = graph.offset[b]; at < graph.offset[b + 1]; ++at)
+            mark[graph.neighbors[at]] = UINT_MAX;
+        }
+      });
+
+      for (ui e : frontier) {
+        state[e] = PEELED;
+        truss.trussNumber[e] = level + 2;
+        truss.order.push_back(e);
+      }
+      truss.maxTruss = max(truss.maxTruss, level + 2);
+      frontier.clear();
+      for (vector<ui> &next : nextByWorker) {
+        frontier.insert(frontier.end(), next.begin(), next.end());
+        next.clear();
+      }
+    }
+
+    for (vector<ui> &lowered : loweredByWorker) {
+      for (ui f : lowered) {
+        if (state[f] == LIVE && bucketedAt[f] != support[f]) {
+          bucket[support[f]].push_back(f);
+          bucketedAt[f] = support[f];
+        }
+      }
+      lowered.clear();
+    }
+  }
+
+  truss.rank.resize(edgeCount);
+  for (ui i = 0; i < edgeCount; ++i)
+    truss.rank[truss.order[i]] = i;
+  return truss;
+}
@@ -0,0 +1,511 @@
+// Long-running enumeration service: reads jobs as JSON lines and runs them
+// concurrently on one worker pool. Loaded graphs are kept in an LRU cache,
+// so repeated jobs on a graph skip parsing and the derived-structure builds.
+//
+//   bk_batch [--socket PATH] [--threads N] [--cache GRAPHS]
+//
+// Jobs come from stdin, or with --socket from any number of connections to
+// a UNIX stream socket at PATH. Each job's result line goes to where the job
+// came from. Results are written as jobs finish, so they carry the job's id
+// (or its line number when it has none). On stdin EOF the remaining jobs
+// finish and a summary goes to stderr; the socket server runs until it is
+// killed. --threads defaults to BK_THREADS or the hardware concurrency and
+// --cache to 32 graphs. BK_ARTIFACT_CACHE backs cache misses as it does for
+// bk_algorithm.
+//
+// A job is one object:
+//   {"id": 7, "graph": "data/gen_small_001.txt", "engine": "fast_list",
+//    "minCliqueSize": 3, "cliques": true}
+// "graph" names a file in bk_algorithm's format. An inline graph is given
+// as "n" and "edges": [[u, v], ...] instead; inline graphs are not cached.
+// "engine" is an engine name from clique_enumeration.h or a bk_algorithm
+// mode number (default fast_list). "order" (0-2) and "method" (0-1) take
+// bk_algorithm's ord and meth values. "solverWorkBudget" and "threads" (the
+// k-clique workers, default 1 because jobs already share the pool) map to
+// EnumerationOptions. "budgetMs", "budgetChecks" and "budgetCliques" set
+// the job's search budget (search_budget.h). "cliques": true adds every
+// reported clique to the result. A result line reports the counts, the size
+// histogram, the load, setup and search times and the engine counters, or
+// "ok": false with an "error" message. A run the budget stopped has
+// "complete": false, its stop reason and the roots that finished; its
+// counts and cliques are partial.
+#include "../inc/clique_enumeration.h"
+#include "../inc/graph_cache.h"
+#include "../inc/json.h"
+#include "../inc/parallel_for.h"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <sstream>
+#include <stdexcept>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct BatchOptions {
+  std::string socketPath;
+  unsigned threads = configuredThreadCount();
+  size_t cacheGraphs = 32;
+};
+
+// Fixed worker threads over a bounded job queue; submit() blocks while the
+// queue is full, so a fast reader cannot queue unbounded work.
+class JobPool {
+private:
+  std::mutex mutex;
+  std::condition_variable jobReady;
+  std::condition_variable spaceOrIdle;
+  std::deque<std::function<void()>> queue;
+  size_t capacity;
+  size_t running;
+  bool stopping;
+  std::vector<std::thread> workers;
+
+  void work() {
+    for (;;) {
+      std::function<void()> job;
+      {
+        std::unique_lock<std::mutex> lock(mutex);
+        jobReady.wait(lock, [&] { return stopping || !queue.empty(); });
+        if (queue.empty())
+          return;
+        job = std::move(queue.front());
+        queue.pop_front();
+        ++running;
+      }
+      spaceOrIdle.notify_all();
+      job();
+      {
+        std::lock_guard<std::mutex> lock(mutex);
+        --running;
+      }
+      spaceOrIdle.notify_all();
+    }
+  }
+
+public:
+  explicit JobPool(unsigned threads)
+      : capacity(4 * static_cast<size_t>(std::max(1u, threads))), running(0),
+        stopping(false) {
+    for (unsigned worker = 0; worker < std::max(1u, threads); ++worker)
+      workers.emplace_back([this] { work(); });
+  }
+  ~JobPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      stopping = true;
+    }
+    jobReady.notify_all();
+    for (std::thread &worker : workers)
+      worker.join();
+  }
+  JobPool(const JobPool &) = delete;
+  JobPool &operator=(const JobPool &) = delete;
+
+  void submit(std::function<void()> job) {
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      spaceOrIdle.wait(lock, [&] { return queue.size() < capacity; });
+      queue.push_back(std::move(job));
+    }
+    jobReady.notify_one();
+  }
+  // Waits until every submitted job has finished.
+  void drain() {
+    std::unique_lock<std::mutex> lock(mutex);
+    spaceOrIdle.wait(lock, [&] { return queue.empty() && running == 0; });
+  }
+};
+
+// Where a job's result line goes: stdout or the job's socket connection.
+class ResultChannel {
+private:
+  std::mutex mutex;
+  int fd;
+  bool closed;
+
+public:
+  // fd < 0 writes to stdout; a socket fd is closed with the channel.
+  explicit ResultChannel(int socketFd) : fd(socketFd), closed(false) {}
+  ~ResultChannel() {
+    if (fd >= 0)
+      close(fd);
+  }
+  ResultChannel(const ResultChannel &) = delete;
+  ResultChannel &operator=(const ResultChannel &) = delete;
+
+  void writeLine(const std::string &line) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (fd < 0) {
+      cout << line << '\n' << std::flush;
+      return;
+    }
+    if (closed)
+      return;
+    const std::string framed = line + '\n';
+    size_t sent = 0;
+    while (sent < framed.size()) {
+      const ssize_t count = send(fd, framed.data() + sent,
+                                 framed.size() - sent, MSG_NOSIGNAL);
+      if (count < 0 && errno == EINTR)
+        continue;
+      if (count <= 0) {
+        // The client went away; its remaining results are dropped.
+        closed = true;
+        return;
+      }
+      sent += static_cast<size_t>(count);
+    }
+  }
+};
+
+struct BatchJob {
+  std::string graphPath;
+  ui inlineVertices = 0;
+  std::vector<std::pair<ui, ui>> inlineEdges;
+  EnumerationOptions options;
+  bool listCliques = false;
+};
+
+ui asVertex(const JsonValue &value, const char *field) {
+  const ull parsed = value.asUnsigned();
+  if (parsed >= UINT_MAX)
+    throw std::invalid_argument(std::string(field) + " is out of range");
+  return static_cast<ui>(parsed);
+}
+
+BatchJob parseJob(const JsonValue &document) {
+  if (!document.isObject())
+    throw std::invalid_argument("a job must be a JSON object");
+  BatchJob job;
+  job.options.threads = 1;
+  bool hasVertices = false;
+  bool hasEdges = false;
+  for (const auto &[name, value] : document.members) {
+    if (name == "id") {
+      if (value.type != JsonValue::Type::STRING &&
+          value.type != JsonValue::Type::NUMBER)
+        throw std::invalid_argument("id must be a string or a number");
+    } else if (name == "graph") {
+      job.graphPath = value.asString();
+    } else if (name == "n") {
+      job.inlineVertices = asVertex(value, "n");
+      hasVertices = true;
+    } else if (name == "edges") {
+      if (!value.isArray())
+        throw std::invalid_argument("edges must be an array of pairs");
+      for (const JsonValue &edge : value.items) {
+        if (!edge.isArray() || edge.items.size() != 2)
+          throw std::invalid_argument("edges must be an array of pairs");
+        job.inlineEdges.emplace_back(asVertex(edge.items[0], "edge"),
+                                     asVertex(edge.items[1], "edge"));
+      }
+      hasEdges = true;
+    } else if (name == "engine") {
+      job.options.engine = parseEnumerationEngine(
+          value.type == JsonValue::Type::NUMBER ? value.text
+                                                : value.asString());
+    } else if (name == "minCliqueSize") {
+      job.options.minCliqueSize = asVertex(value, "minCliqueSize");
+    } else if (name == "order") {
+      const ull order = value.asUnsigned();
+      if (order > 2)
+        throw std::invalid_argument("order must be 0, 1 or 2");
+      job.options.order = static_cast<DegOrder>(order);
+    } else if (name == "method") {
+      const ull method = value.asUnsigned();
+      if (method > 1)
+        throw std::invalid_argument("method must be 0 or 1");
+      job.options.method = static_cast<SibMethod>(method);
+    } else if (name == "solverWorkBudget") {
+      job.options.solverWorkBudget = value.asUnsigned();
+    } else if (name == "budgetMs") {
+      const double ms = value.asNumber();
+      if (!(ms >= 0))
+        throw std::invalid_argument("budgetMs must not be negative");
+      job.options.budget.wallMs = ms;
+    } else if (name == "budgetChecks") {
+      job.options.budget.checks = value.asUnsigned();
+    } else if (name == "budgetCliques") {
+      job.options.budget.cliques = value.asUnsigned();
+    } else if (name == "threads") {
+      const ull threads = value.asUnsigned();
+      if (threads == 0 || threads > 1024)
+        throw std::invalid_argument("threads must be in 1..1024");
+      job.options.threads = static_cast<unsigned>(threads);
+    } else if (name == "cliques") {
+      job.listCliques = value.asBool();
+    } else {
+      throw std::invalid_argument("unknown job field: " + name);
+    }
+  }
+  const bool fileGraph = !job.graphPath.empty() && !hasVertices && !hasEdges;
+  const bool inlineGraph = job.graphPath.empty() && hasVertices && hasEdges;
+  if (!fileGraph && !inlineGraph)
+    throw std::invalid_argument(
+        "a job needs either \"graph\" or both \"n\" and \"edges\"");
+  for (const auto &[u, v] : job.inlineEdges) {
+    if (u >= job.inlineVertices || v >= job.inlineVertices)
+      throw std::invalid_argument("edge endpoint is not below n");
+  }
+  return job;
+}
+
+void writeId(JsonWriter &json, const JsonValue &id, size_t lineNumber) {
+  json.key("id");
+  if (id.type == JsonValue::Type::STRING)
+    json.value(id.text);
+  else if (id.type == JsonValue::Type::NUMBER)
+    json.rawNumber(id.text);
+  else
+    json.value(static_cast<ull>(lineNumber));
+}
+
+double elapsedMs(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
+class BatchService {
+private:
+  GraphCache cache;
+  JobPool pool;
+  std::atomic<ull> completed;
+  std::atomic<ull> failed;
+
+  std::string runJob(const std::string &line, size_t lineNumber) {
+    std::ostringstream out;
+    JsonWriter json(out);
+    JsonValue id;
+    try {
+      const JsonValue document = parseJson(line);
+      // The id is echoed even when the rest of the job is rejected.
+      if (const JsonValue *given = document.find("id"))
+        id = *given;
+      const BatchJob job = parseJob(document);
+      const auto loadStart = Clock::now();
+      bool cacheHit = false;
+      std::shared_ptr<Graph> graph;
+      if (!job.graphPath.empty()) {
+        graph = cache.acquire(job.graphPath, &cacheHit);
+      } else {
+        graph = std::make_shared<Graph>(job.inlineVertices, job.inlineEdges);
+        GraphCache::prepare(*graph);
+      }
+      const double loadMs = elapsedMs(loadStart);
+
+      std::vector<std::vector<ui>> cliques;
+      FastCliqueSink sink;
+      if (job.listCliques)
+        sink = [&](const std::vector<ui> &clique) {
+          cliques.push_back(clique);
+        };
+      const EnumerationResult result =
+          enumerateCliques(*graph, job.options, sink);
+
+      json.beginObject();
+      writeId(json, id, lineNumber);
+      json.field("ok", true)
+          .field("engine", enumerationEngineName(job.options.engine))
+          .field("n", graph->n)
+          .field("m", graph->m)
+          .field("cacheHit", cacheHit)
+          .field("loadMs", loadMs)
+          .field("setupMs", result.setupMs)
+          .field("searchMs", result.searchMs)
+          .field("cliqueCount", result.cliqueCount)
+          .field("maxCliqueSize", result.maxCliqueSize)
+          .field("checks", result.checks)
+          .field("complete", result.complete);
+      if (!result.complete) {
+        json.field("stopReason", searchBudgetStopName(result.stopReason));
+        json.key("completedRoots").beginArray();
+        for (ui root : result.completedRoots)
+          json.value(root);
+        json.endArray();
+      }
+      json.key("sizeHistogram").beginArray();
+      for (ull count : result.sizeHistogram)
+        json.value(count);
+      json.endArray();
+      json.key("counters").beginObject();
+      for (const auto &[name, value] : result.counters)
+        json.field(name, value);
+      json.endObject();
+      if (job.listCliques) {
+        json.key("cliques").beginArray();
+        for (const std::vector<ui> &clique : cliques) {
+          json.beginArray();
+          for (ui vertex : clique)
+            json.value(vertex);
+          json.endArray();
+        }
+        json.endArray();
+      }
+      json.endObject();
+      ++completed;
+      return out.str();
+    } catch (const std::exception &error) {
+      ++failed;
+      std::ostringstream failure;
+      JsonWriter errorJson(failure);
+      errorJson.beginObject();
+      writeId(errorJson, id, lineNumber);
+      errorJson.field("ok", false).field("error", error.what());
+      errorJson.endObject();
+      return failure.str();
+    }
+  }
+
+public:
+  BatchService(const BatchOptions &options, const char *artifactDirectory)
+      : cache(options.cacheGraphs,
+              artifactDirectory == nullptr ? "" : artifactDirectory),
+        pool(options.threads), completed(0), failed(0) {}
+
+  void submit(std::string line, size_t lineNumber,
+              std::shared_ptr<ResultChannel> channel) {
+    pool.submit([this, line = std::move(line), lineNumber,
+                 channel = std::move(channel)] {
+      channel->writeLine(runJob(line, lineNumber));
+    });
+  }
+
+  void serveStream(std::istream &in) {
+    auto channel = std::make_shared<ResultChannel>(-1);
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(in, line)) {
+      ++lineNumber;
+      if (line.find_first_not_of(" \t\r") != std::string::npos)
+        submit(line, lineNumber, channel);
+    }
+    pool.drain();
+  }
+
+  // Reads one connection's jobs; the channel outlives the reader until the
+  // connection's last result is written.
+  void serveConnection(int fd) {
+    auto channel = std::make_shared<ResultChannel>(fd);
+    std::string pending;
+    char buffer[65536];
+    size_t lineNumber = 0;
+    for (;;) {
+      const ssize_t count = recv(fd, buffer, sizeof(buffer), 0);
+      if (count < 0 && errno == EINTR)
+        continue;
+      if (count <= 0)
+        break;
+      pending.append(buffer, static_cast<size_t>(count));
+      size_t begin = 0;
+      for (size_t end; (end = pending.find('\n', begin)) != std::string::npos;
+           begin = end + 1) {
+        ++lineNumber;
+        std::string line = pending.substr(begin, end - begin);
+        if (line.find_first_not_of(" \t\r") != std::string::npos)
+          submit(std::move(line), lineNumber, channel);
+      }
+      pending.erase(0, begin);
+    }
+    if (pending.find_first_not_of(" \t\r") != std::string::npos)
+      submit(std::move(pending), lineNumber + 1, channel);
+  }
+
+  void serveSocket(const std::string &path) {
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(address.sun_path))
+      throw std::invalid_argument("socket path is too long: " + path);
+    std::strcpy(address.sun_path, path.c_str());
+    // Only a stale socket is replaced, never another kind of file.
+    struct stat info {};
+    if (lstat(path.c_str(), &info) == 0 && S_ISSOCK(info.st_mode))
+      unlink(path.c_str());
+    const int server = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (server < 0 ||
+        bind(server, reinterpret_cast<const sockaddr *>(&address),
+             sizeof(address)) != 0 ||
+        listen(server, 64) != 0)
+      throw std::runtime_error("cannot listen on " + path + ": " +
+                               std::strerror(errno));
+    cerr << "bk_batch: listening on " << path << endl;
+    for (;;) {
+      const int client = accept(server, nullptr, nullptr);
+      if (client < 0) {
+        if (errno == EINTR || errno == ECONNABORTED)
+          continue;
+        throw std::runtime_error(std::string("accept failed: ") +
+                                 std::strerror(errno));
+      }
+      std::thread([this, client] { serveConnection(client); }).detach();
+    }
+  }
+
+  void printSummary() const {
+    cerr << "bk_batch: jobs=" << completed + failed << "  failed=" << failed
+         << "  graphsCached=" << cache.size()
+         << "  cacheHits=" << cache.getHits()
+         << "  cacheMisses=" << cache.getMisses() << endl;
+  }
+};
+
+[[noreturn]] void usage(const std::string &problem) {
+  cerr << "bk_batch: " << problem << "\n"
+       << "Usage: bk_batch [--socket PATH] [--threads N] [--cache GRAPHS]"
+       << endl;
+  exit(1);
+}
+
+ull parseCount(const std::string &flag, const std::string &text) {
+  char *end = nullptr;
+  errno = 0;
+  const unsigned long long parsed = strtoull(text.c_str(), &end, 10);
+  if (text.empty() || text[0] < '0' || text[0] > '9' || errno == ERANGE ||
+      *end != '\0' || parsed == 0)
+    usage(flag + " needs a positive integer");
+  return parsed;
+}
+
+} // namespace
+
+int main(int argc, const char *argv[]) {
+  BatchOptions options;
+  for (int i = 1; i < argc; ++i) {
+    const std::string flag = argv[i];
+    if (i + 1 >= argc)
+      usage("missing value for " + flag);
+    const std::string value = argv[++i];
+    if (flag == "--socket")
+      options.socketPath = value;
+    else if (flag == "--threads")
+      options.threads =
+          static_cast<unsigned>(std::min<ull>(1024, parseCount(flag, value)));
+    else if (flag == "--cache")
+      options.cacheGraphs = parseCount(flag, value);
+    else
+      usage("unknown option " + flag);
+  }
+
+  try {
+    BatchService service(options, getenv("BK_ARTIFACT_CACHE"));
+    if (!options.socketPath.empty()) {
+      service.serveSocket(options.socketPath);
+    } else {
+      service.serveStream(std::cin);
+      service.printSummary();
+    }
+  } catch (const std::exception &error) {
+    cerr << "bk_batch: " << error.what() << endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,156 @@
+// Converts a search trace written by bk_algorithm (BK_TRACE=<path>) for
+// viewing or analysis.
+//
+//   bk_trace <trace> chrome|csv [output]
+//
+// chrome writes Chrome trace event JSON (chrome://tracing, Perfetto) with
+// one track per traced root and one complete event per node, named after
+// the kernel that resolved it. csv writes one row per node in preorder,
+// adding the node's self time (its duration minus its traced children's).
+#include "../inc/json.h"
+#include "../inc/search_trace.h"
+
+#include <stdexcept>
+
+namespace {
+
+const char *laneName(SearchTraceLane lane) {
+  return lane == SearchTraceLane::BASELINE ? "baseline" : "enumerate";
+}
+
+// A root's records are contiguous and end with its root node.
+struct RootSpan {
+  size_t begin;
+  size_t end;
+};
+
+std::vector<RootSpan> rootSpans(const std::vector<SearchTraceRecord> &records) {
+  std::vector<RootSpan> spans;
+  size_t begin = 0;
+  for (size_t i = 0; i < records.size(); ++i) {
+    if (records[i].parent == SEARCH_TRACE_NONE) {
+      spans.push_back({begin, i + 1});
+      begin = i + 1;
+    }
+  }
+  if (begin != records.size())
+    spans.push_back({begin, records.size()});
+  return spans;
+}
+
+void writeChrome(std::ostream &out, const SearchTrace &trace) {
+  JsonWriter json(out);
+  json.beginObject();
+  json.field("displayTimeUnit", "ns");
+  json.key("traceEvents").beginArray();
+  for (const RootSpan &span : rootSpans(trace.records)) {
+    const ui root = trace.records[span.end - 1].root;
+    json.beginObject();
+    json.field("name", "thread_name");
+    json.field("ph", "M");
+    json.field("pid", 1);
+    json.field("tid", root);
+    json.key("args").beginObject();
+    json.field("name", "root " + std::to_string(root));
+    json.endObject();
+    json.endObject();
+  }
+  for (const SearchTraceRecord &record : trace.records) {
+    json.beginObject();
+    json.field("name", searchTraceKernelName(record.kernel));
+    json.field("cat", laneName(record.lane));
+    json.field("ph", "X");
+    json.field("ts", static_cast<double>(record.startNs) / 1e3);
+    json.field("dur", static_cast<double>(record.durationNs) / 1e3);
+    json.field("pid", 1);
+    json.field("tid", record.root);
+    json.key("args").beginObject();
+    json.field("node", record.node);
+    if (record.parent != SEARCH_TRACE_NONE)
+      json.field("parent", record.parent);
+    json.field("depth", record.depth);
+    json.field("p", record.p);
+    json.field("x", record.x);
+    if (record.pivotScore != SEARCH_TRACE_NONE)
+      json.field("pivotScore", record.pivotScore);
+    json.field("children", record.children);
+    json.field("checks", static_cast<ull>(record.checks));
+    json.field("cliques", static_cast<ull>(record.cliques));
+    json.endObject();
+    json.endObject();
+  }
+  json.endArray();
+  json.endObject();
+  out << '\n';
+}
+
+void writeCsv(std::ostream &out, const SearchTrace &trace) {
+  out << "root,node,parent,depth,p,x,pivot_score,kernel,lane,children,"
+         "checks,cliques,start_ns,duration_ns,self_ns\n";
+  std::vector<const SearchTraceRecord *> byNode;
+  std::vector<ull> childNs;
+  for (const RootSpan &span : rootSpans(trace.records)) {
+    byNode.assign(span.end - span.begin, nullptr);
+    childNs.assign(span.end - span.begin, 0);
+    for (size_t i = span.begin; i < span.end; ++i) {
+      const SearchTraceRecord &record = trace.records[i];
+      if (record.node >= byNode.size())
+        throw std::runtime_error("search trace node ordinal out of range");
+      byNode[record.node] = &record;
+      if (record.parent != SEARCH_TRACE_NONE && record.parent < childNs.size())
+        childNs[record.parent] += record.durationNs;
+    }
+    for (size_t node = 0; node < byNode.size(); ++node) {
+      const SearchTraceRecord *record = byNode[node];
+      if (record == nullptr)
+        continue;
+      out << record->root << ',' << record->node << ',';
+      if (record->parent != SEARCH_TRACE_NONE)
+        out << record->parent;
+      out << ',' << record->depth << ',' << record->p << ',' << record->x
+          << ',';
+      if (record->pivotScore != SEARCH_TRACE_NONE)
+        out << record->pivotScore;
+      out << ',' << searchTraceKernelName(record->kernel) << ','
+          << laneName(record->lane) << ',' << record->children << ','
+          << record->checks << ',' << record->cliques << ','
+          << record->startNs << ',' << record->durationNs << ','
+          << (record->durationNs - std::min<ull>(record->durationNs,
+                                                 childNs[node]))
+          << '\n';
+    }
+  }
+}
+
+} // namespace
+
+int main(int argc, const char *argv[]) {
+  if (argc < 3 || argc > 4 ||
+      (std::string(argv[2]) != "chrome" && std::string(argv[2]) != "csv")) {
+    cerr << "Usage: bk_trace <trace> chrome|csv [output]" << endl;
+    return 1;
+  }
+  try {
+    const SearchTrace trace = readSearchTrace(argv[1]);
+    std::ofstream file;
+    if (argc == 4) {
+      file.open(argv[3]);
+      if (!file)
+        throw std::runtime_error(std::string("cannot write ") + argv[3]);
+    }
+    std::ostream &out = argc == 4 ? file : cout;
+    if (std::string(argv[2]) == "chrome")
+      writeChrome(out, trace);
+    else
+      writeCsv(out, trace);
+    if (!out)
+      throw std::runtime_error("output write failed");
+    if (trace.header.droppedNodes != 0)
+      cerr << "bk_trace: " << trace.header.droppedNodes
+           << " nodes past the record limit were not traced" << endl;
+  } catch (const std::exception &error) {
+    cerr << "bk_trace: " << error.what() << endl;
+    return 1;
+  }
+  return 0;
+}
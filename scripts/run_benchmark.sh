@@ -118,7 +118,7 @@ build_target() {
 }
 
 build_target pure "$repo_root/our" bk_algorithm \
-  -DREORDERSIB_PROFILING=OFF -DPURE_HITSET_VARIANT=128 || exit 2
+  -DPURE_HITSET_VARIANT=128 || exit 2
 build_target hbbmc_faithful "$repo_root/compare/HBBMCPaperFaithful" \
   hbbmc_faithful || exit 2
 